@@ -0,0 +1,128 @@
+/*
+ * Algorithm Comparison - A/B Scheduling on Identical Arrival Traces
+ *
+ * Headless mode that replays one arrival trace against several scheduling
+ * algorithms, one thread per algorithm, in virtual time: no sleeps, no
+ * ncurses, no shared simulation state. Each replication (seed) generates a
+ * fresh trace with the same inter-arrival rules as vehicle_generator_loop(),
+ * or takes the arrivals of a recorded vehicle trace (--trace) or of a
+ * detector replay (--replay) and redraws only the crossing times; a
+ * replayed trace also caps the duration at the span of its arrivals.
+ *
+ * The replay mirrors the live loop: each decision picks a lane with the
+ * same select_lane_*() functions schedule_next_lane() uses (see
+ * scheduling_policy.h), a lane change costs CONTEXT_SWITCH_TIME, and the
+ * chosen lane's head vehicle crosses before the next decision, in the
+ * shared 2-4 s crossing time plus one second for heavy vehicles. Policy
+ * state (levels, round-robin position) is per replay, in virtual time.
+ * Vehicles keep a movement and class: recorded ones from a trace, else
+ * drawn with the live generator's shares. Two pacing delays of the live
+ * dashboard are left out because they only exist to make it watchable:
+ * the SIMULATION_UPDATE_INTERVAL sleep between decisions and the extra
+ * second context_switch() adds to each lane change.
+ *
+ * Because every algorithm sees the same arrivals, per-seed differences are
+ * paired: the report gives each metric's mean with a 95% Student-t
+ * confidence interval, and each algorithm's delta against the first
+ * (baseline) algorithm with a paired-t interval. With a single seed the
+ * report falls back to compare_algorithm_performance().
+ *
+ * A ComparisonWorker runs single replications of one algorithm on the
+ * caller's thread, for drivers that schedule replications themselves
+ * (--replications).
+ *
+ * A ReplayIntersection is the same replay driven from outside, for models
+ * of several intersections (--network): the caller adds arrivals in time
+ * order and advances it window by window, and ReplayHooks let it hold a
+ * lane whose head vehicle has nowhere to go and see every vehicle enter
+ * and clear the box.
+ */
+
+#ifndef ALGORITHM_COMPARISON_H
+#define ALGORITHM_COMPARISON_H
+
+#include <stdbool.h>
+#include "scheduler.h"
+#include "performance_metrics.h"
+
+#define COMPARE_MAX_ALGORITHMS 3
+#define COMPARE_MAX_SEEDS 100
+#define COMPARE_DEFAULT_SEEDS 10
+#define COMPARE_NUM_METRICS 7
+
+typedef struct {
+    SchedulingAlgorithm algorithms[COMPARE_MAX_ALGORITHMS];   // First is the baseline
+    int num_algorithms;
+    int seeds;                  // Replications, each on its own arrival trace
+    unsigned int base_seed;
+    int duration_seconds;       // Virtual time per replication
+    int min_arrival_rate;       // Seconds between arrivals, as in the live generator
+    int max_arrival_rate;
+    int time_quantum;           // Unused: like the live loop, a decision serves one vehicle
+    const char* trace_file;     // Replay arrivals from a vehicle trace, NULL = generate
+} AlgorithmComparisonConfig;
+
+// One replay of one algorithm on one trace
+typedef struct {
+    SchedulingAlgorithm algorithm;
+    double vehicles_per_minute;
+    double avg_wait_time;       // Mean of per-lane mean waits, as the dashboard
+    double p95_wait_time;
+    double fairness_index;
+    double utilization;         // Fraction of virtual time a vehicle was crossing
+    double context_switches_per_minute;
+    double spillback_vehicles;  // Served after waiting upstream of a full lane
+    int vehicles_arrived;
+    int vehicles_left_queued;
+} ComparisonRunResult;
+
+// One vehicle of a replay. Generated and loaded arrivals have tag -1; a
+// caller that adds its own arrivals sets the movement and class and labels
+// them as it likes
+typedef struct {
+    long long arrival_ns;
+    long long crossing_ns;
+    int lane_id;
+    VehicleMovement movement;
+    VehicleClass vehicle_class;
+    int tag;
+    long long origin_ns;        // When the caller's model first saw the vehicle
+} ReplayVehicle;
+
+// A lane whose head vehicle can_depart() refuses is not given green;
+// depart() runs as a vehicle enters the box, cleared() as
+// it leaves
+typedef struct {
+    bool (*can_depart)(void* context, const ReplayVehicle* vehicle);
+    void (*depart)(void* context, const ReplayVehicle* vehicle, long long now_ns);
+    void (*cleared)(void* context, const ReplayVehicle* vehicle, long long now_ns);
+    void* context;
+} ReplayHooks;
+
+// Replay context for running single replications on other threads
+typedef struct ComparisonWorker ComparisonWorker;
+typedef struct ReplayIntersection ReplayIntersection;
+
+void init_algorithm_comparison_config(AlgorithmComparisonConfig* config);
+bool parse_comparison_algorithms(const char* list, AlgorithmComparisonConfig* config);
+
+int run_algorithm_comparison(const AlgorithmComparisonConfig* config);
+
+ComparisonWorker* create_comparison_worker();
+void destroy_comparison_worker(ComparisonWorker* worker);
+bool run_comparison_replication(ComparisonWorker* worker, const AlgorithmComparisonConfig* config,
+                                SchedulingAlgorithm algorithm, unsigned int seed,
+                                ComparisonRunResult* result);
+ReplayIntersection* create_replay_intersection(const AlgorithmComparisonConfig* config,
+                                               SchedulingAlgorithm algorithm,
+                                               unsigned int crossing_seed, const ReplayHooks* hooks);
+void destroy_replay_intersection(ReplayIntersection* intersection);
+bool add_replay_arrival(ReplayIntersection* intersection, const ReplayVehicle* vehicle);
+void advance_replay_intersection(ReplayIntersection* intersection, long long until_ns);
+void finish_replay_intersection(ReplayIntersection* intersection, ComparisonRunResult* result);
+
+const char* get_comparison_metric_name(int metric);
+double get_comparison_metric(const ComparisonRunResult* result, int metric);
+double t_quantile_95(int df);
+
+#endif
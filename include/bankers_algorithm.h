@@ -4,13 +4,22 @@
  * Implements the Banker's algorithm for safe resource allocation in traffic intersection.
  * Prevents deadlocks by checking resource allocation safety before granting access.
  *
- * Resource Model: Intersection quadrants (4 quadrants for 4-way intersection)
- * Lanes: 4 traffic approaches (North, South, East, West)
+ * Resource Model: Intersection quadrants, one per approach (see intersection_geometry.h)
+ * Lanes: every lane of the active geometry; num_lanes x num_quadrants of
+ * each matrix is in use
  *
  * Safety Conditions:
  * - Request <= Need (lane hasn't exceeded max claims)
  * - Request <= Available (sufficient free resources)
  * - Allocation results in safe state (all lanes can complete)
+ *
+ * A lane's request is the quadrant set of its head vehicle's movement
+ * (calculate_movement_quadrants). A lane's standing maximum claim is the
+ * union of the quadrants of every movement it carries but the U-turn
+ * (calculate_maximum_quadrants); a U-turn sweeps every quadrant, and
+ * claiming it standing would let only one lane hold anything at a time.
+ * A lane holding nothing may still request a U-turn: request_resources()
+ * raises its claim to the request until deallocate_resources().
  */
 
 #ifndef BANKERS_ALGORITHM_H
@@ -19,26 +28,15 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include "lane_process.h"
-
-#define NUM_QUADRANTS 4
-#ifndef NUM_LANES
-#define NUM_LANES 4
-#endif
-#define LANE_NORTH 0
-#define LANE_SOUTH 1
-#define LANE_EAST 2
-#define LANE_WEST 3
-
-#define QUADRANT_NE 0
-#define QUADRANT_NW 1
-#define QUADRANT_SW 2
-#define QUADRANT_SE 3
+#include "intersection_geometry.h"
 
 typedef struct {
-    int available[NUM_QUADRANTS];
-    int maximum[NUM_LANES][NUM_QUADRANTS];
-    int allocation[NUM_LANES][NUM_QUADRANTS];
-    int need[NUM_LANES][NUM_QUADRANTS];
+    int num_lanes;
+    int num_quadrants;
+    int available[MAX_QUADRANTS];
+    int maximum[MAX_LANES][MAX_QUADRANTS];
+    int allocation[MAX_LANES][MAX_QUADRANTS];
+    int need[MAX_LANES][MAX_QUADRANTS];
     pthread_mutex_t resource_lock;
     bool safe_state;
     int deadlock_preventions;
@@ -47,22 +45,23 @@ typedef struct {
 void init_bankers_state(BankersState* state);
 void destroy_bankers_state(BankersState* state);
 BankersState* get_global_bankers_state();
-bool request_resources(BankersState* state, int lane_id, int request[NUM_QUADRANTS]);
+bool request_resources(BankersState* state, int lane_id, int request[MAX_QUADRANTS]);
 bool is_safe_state(BankersState* state);
-bool safety_algorithm(BankersState* state, bool finish[NUM_LANES]);
-void allocate_resources(BankersState* state, int lane_id, int allocation[NUM_QUADRANTS]);
+bool safety_algorithm(BankersState* state, bool finish[MAX_LANES]);
+void allocate_resources(BankersState* state, int lane_id, int allocation[MAX_QUADRANTS]);
 void deallocate_resources(BankersState* state, int lane_id);
-void update_available_resources(BankersState* state, int available[NUM_QUADRANTS]);
-void calculate_needed_quadrants(LaneProcess* lane, int need[NUM_QUADRANTS]);
-void calculate_maximum_quadrants(int lane_id, int maximum[NUM_QUADRANTS]);
-bool are_quadrants_available(BankersState* state, int request[NUM_QUADRANTS]);
+void update_available_resources(BankersState* state, int available[MAX_QUADRANTS]);
+void calculate_needed_quadrants(LaneProcess* lane, int need[MAX_QUADRANTS]);
+void calculate_movement_quadrants(int lane_id, VehicleMovement movement, int quadrants[MAX_QUADRANTS]);
+void calculate_maximum_quadrants(int lane_id, int maximum[MAX_QUADRANTS]);
+bool are_quadrants_available(BankersState* state, int request[MAX_QUADRANTS]);
 bool can_lane_finish(BankersState* state, int lane_id);
-bool check_resource_request(BankersState* state, int lane_id, int request[NUM_QUADRANTS]);
+bool check_resource_request(BankersState* state, int lane_id, int request[MAX_QUADRANTS]);
 bool is_deadlock_possible(BankersState* state);
-void calculate_straight_movement_quadrants(int lane_id, int quadrants[NUM_QUADRANTS]);
-void calculate_left_turn_quadrants(int lane_id, int quadrants[NUM_QUADRANTS]);
-void calculate_right_turn_quadrants(int lane_id, int quadrants[NUM_QUADRANTS]);
-void calculate_u_turn_quadrants(int lane_id, int quadrants[NUM_QUADRANTS]);
+void calculate_straight_movement_quadrants(int lane_id, int quadrants[MAX_QUADRANTS]);
+void calculate_left_turn_quadrants(int lane_id, int quadrants[MAX_QUADRANTS]);
+void calculate_right_turn_quadrants(int lane_id, int quadrants[MAX_QUADRANTS]);
+void calculate_u_turn_quadrants(int lane_id, int quadrants[MAX_QUADRANTS]);
 void print_bankers_state(BankersState* state);
 void print_lane_allocation(BankersState* state, int lane_id);
 void print_available_quadrants(BankersState* state);
@@ -0,0 +1,175 @@
+/*
+ * Checkpoint - Save and Restore of a Running Simulation
+ *
+ * Writes the simulation state to a versioned binary file (--checkpoint) and
+ * loads it back into a freshly initialised system before the threads start
+ * (--restore): lane
+ * state and queued vehicles, the scheduler (algorithm, quantum, current
+ * lane, emergency preemption state) with the multilevel and round-robin
+ * policies' per-lane tables, the Banker's state, the emergency system,
+ * the performance metrics, the scenario and replay clocks, the run's
+ * elapsed and remaining time and the random number stream.
+ *
+ * A checkpoint is taken by the simulation thread between time slices (or
+ * after the threads have stopped), when no lane is crossing, so the
+ * intersection itself holds nothing. Monotonic timestamps (vehicle
+ * arrivals, emergency times) and wall-clock times are saved as they were
+ * and shifted on restore by how far each clock has moved, so waits and
+ * elapsed time carry on where they left off. The random stream is
+ * reseeded from rand() at the checkpoint and the seed saved, so every run
+ * restored from one file draws the same stream. Display history (Gantt,
+ * signal history, metric time series) starts empty after a restore.
+ *
+ * File layout: CheckpointHeader, then sections of CheckpointSection plus
+ * 'size' bytes. A section whose size does not match this build's struct
+ * is rejected; a file for another geometry is refused.
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#include "scheduler.h"
+#include "emergency_system.h"
+
+#define CHECKPOINT_MAGIC "TGCK"
+#define CHECKPOINT_VERSION 1
+
+typedef enum {
+    CHECKPOINT_LANES = 1,           // CheckpointLane per lane, each followed by its vehicles
+    CHECKPOINT_SCHEDULER = 2,
+    CHECKPOINT_MULTILEVEL = 3,
+    CHECKPOINT_ROUND_ROBIN = 4,
+    CHECKPOINT_BANKERS = 5,
+    CHECKPOINT_EMERGENCY = 6,
+    CHECKPOINT_METRICS = 7,         // PerformanceMetrics up to its time series
+    CHECKPOINT_END = 8
+} CheckpointSectionType;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t header_size;
+    int32_t num_lanes;
+    char geometry[64];
+    int64_t wall_time;              // time() at the checkpoint
+    int64_t monotonic_ns;           // monotonic_now_ns() at the checkpoint
+    int32_t elapsed_seconds;
+    int32_t remaining_seconds;
+    uint32_t random_seed;           // srand() seed the run continues with
+    int32_t total_vehicles_generated;
+    int64_t scenario_elapsed_ns;
+    int64_t replay_elapsed_ns;
+} CheckpointHeader;
+
+typedef struct {
+    uint32_t type;                  // CheckpointSectionType
+    uint32_t size;                  // Bytes that follow
+} CheckpointSection;
+
+typedef struct {
+    int32_t queued;                 // VehicleRecords that follow
+    int32_t max_queue_length;
+    int32_t state;
+    int32_t priority;
+    int32_t waiting_time;
+    int64_t last_arrival_time;
+    int64_t last_service_time;
+    int32_t total_vehicles_served;
+    int32_t total_waiting_time;
+    int32_t requested_quadrants;
+    int32_t allocated_quadrants;
+    int32_t enqueue_count;
+    int32_t dequeue_count;
+    int32_t overflow_count;
+    int32_t spillback_count;
+    int32_t peak_size;
+} CheckpointLane;
+
+typedef struct {
+    int32_t algorithm;
+    int32_t time_quantum;
+    int32_t current_lane;
+    int32_t total_context_switches;
+    int64_t last_schedule_time;
+    bool preempt_pending;
+    bool preclear_pending;
+    int32_t preempt_lane;
+    int64_t preempt_detected_ns;
+    int64_t preempt_arrival_ns;
+    int32_t emergency_green_lane;
+    int64_t emergency_green_ns;
+    int32_t total_preemptions;
+    int32_t total_preclears;
+    LatencyHistogram decision_latency_ns;
+} CheckpointScheduler;
+
+typedef struct {
+    int32_t level;
+    int32_t consecutive_runs;
+    int64_t last_promotion;
+    int64_t last_demotion;
+    int32_t time_in_current_level;
+} CheckpointLanePriority;
+
+typedef struct {
+    bool initialized;
+    CheckpointLanePriority lanes[MAX_LANES];
+} CheckpointMultilevel;
+
+typedef struct {
+    int32_t priority;
+    int64_t last_service_time;
+    int32_t service_count;
+    bool in_ready_queue;
+} CheckpointLaneRoundRobin;
+
+typedef struct {
+    bool initialized;
+    int32_t round_robin_index;
+    CheckpointLaneRoundRobin lanes[MAX_LANES];
+} CheckpointRoundRobin;
+
+typedef struct {
+    int32_t available[MAX_QUADRANTS];
+    int32_t maximum[MAX_LANES][MAX_QUADRANTS];
+    int32_t allocation[MAX_LANES][MAX_QUADRANTS];
+    int32_t need[MAX_LANES][MAX_QUADRANTS];
+    bool safe_state;
+    int32_t deadlock_preventions;
+} CheckpointBankers;
+
+typedef struct {
+    EmergencyVehicle current_emergency;
+    EmergencyQueueEntry pending[EMERGENCY_QUEUE_CAPACITY];
+    int32_t pending_count;
+    int64_t next_sequence;
+    int32_t emergencies_queued;
+    int32_t emergencies_dropped;
+    float max_queue_delay;
+    LatencyHistogram queue_delay_ns;
+    bool emergency_mode;
+    int64_t emergency_start_time;
+    int32_t total_emergencies_handled;
+    float total_emergency_response_time;
+    float average_response_time;
+} CheckpointEmergency;
+
+bool save_checkpoint(const char* path);
+bool load_checkpoint(const char* path);
+bool restore_checkpoint(int* remaining_seconds);
+
+void request_checkpoint();
+void set_checkpoint_schedule(const char* path, int interval_seconds);
+void checkpoint_tick();
+void save_final_checkpoint(time_t planned_end_time);
+
+// Per-policy tables, kept by the policy files; times shifted by 'wall_shift'
+void save_multilevel_checkpoint(CheckpointMultilevel* state);
+void restore_multilevel_checkpoint(const CheckpointMultilevel* state, time_t wall_shift);
+void save_round_robin_checkpoint(CheckpointRoundRobin* state);
+void restore_round_robin_checkpoint(const CheckpointRoundRobin* state, time_t wall_shift);
+
+#endif
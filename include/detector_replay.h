@@ -0,0 +1,107 @@
+/*
+ * Detector Replay - Arrivals from Loop-Detector Count Files
+ *
+ * Replays recorded detector data as the arrival source instead of the
+ * random generator: the live simulation sleeps the recorded gaps divided by
+ * the replay speed, and --compare takes the same arrivals in virtual time.
+ * Replay time starts at the first record; timestamps may use any origin.
+ *
+ * CSV, one record per line ('#' starts a comment, a header line is
+ * skipped):
+ *   <time>,<lane>[,<count>[,<interval seconds>]]
+ * <time> is seconds (fractions allowed), "HH:MM[:SS]" or
+ * "YYYY-MM-DD[ T]HH:MM[:SS]". <lane> is a lane id, a lane name or an
+ * approach name; an approach's vehicles take its lanes in turn. Without a
+ * count the line is one actuation. A count is spread evenly over the
+ * interval that follows its time (DETECTOR_DEFAULT_INTERVAL if left out),
+ * so per-lane count bins replay as steady flows.
+ *
+ * Binary: DetectorFileHeader, then DetectorRecord[] to end of file, native
+ * endian, records with the same meaning as the CSV columns.
+ *
+ * Either way the file is memory-mapped and read front to back: only the
+ * current line is copied out, and the kernel is told access is sequential,
+ * so a month of data does not have to fit in memory. Records should be in
+ * time order; one that goes back in time is replayed at the time reached
+ * and counted.
+ */
+
+#ifndef DETECTOR_REPLAY_H
+#define DETECTOR_REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "intersection_geometry.h"
+
+#define DETECTOR_MAGIC "TGDC"
+#define DETECTOR_VERSION 1
+#define DETECTOR_DEFAULT_INTERVAL 60
+#define DETECTOR_LINE_MAX 256
+
+typedef struct {
+    char magic[4];
+    uint16_t version;
+    uint16_t record_size;
+} DetectorFileHeader;
+
+typedef struct {
+    int64_t timestamp_ns;
+    uint16_t lane_id;
+    uint16_t count;                 // Vehicles; 1 with interval 0 is one actuation
+    uint32_t interval_ms;           // Spread 'count' evenly over this long
+} DetectorRecord;
+
+// One record, parsed and relative to the first
+typedef struct {
+    long long time_ns;
+    int lane_id;                    // -1: approach-level, see 'approach'
+    int approach;
+    int count;
+    long long interval_ns;
+} DetectorCount;
+
+// A count being spread over its interval
+typedef struct {
+    int remaining;
+    long long next_ns;
+    long long step_ns;
+} DetectorSpread;
+
+typedef struct {
+    char path[128];
+    const char* data;               // Read-only mapping of the whole file
+    size_t size;
+    size_t offset;                  // Next unread byte
+    bool binary;
+    int line_number;
+
+    bool have_origin;
+    long long origin_ns;            // Time of the first record
+    long long record_ns;            // Latest record time, relative to origin
+    bool have_next;
+    DetectorCount next;             // Read, not yet spread
+
+    DetectorSpread spreads[MAX_LANES];
+    int approach_turn[MAX_APPROACHES];  // Next lane for approach-level records
+
+    long long records;
+    long long vehicles;
+    long long skipped;              // Malformed lines and unknown lanes
+    long long out_of_order;
+} DetectorReplay;
+
+typedef struct {
+    long long time_ns;              // Since the first record
+    int lane_id;
+} DetectorArrival;
+
+bool open_detector_replay(DetectorReplay* replay, const char* path);
+void close_detector_replay(DetectorReplay* replay);
+bool next_detector_arrival(DetectorReplay* replay, DetectorArrival* arrival);
+
+void set_detector_replay(DetectorReplay* replay, double speed);
+DetectorReplay* get_detector_replay();
+double get_detector_replay_speed();
+
+#endif
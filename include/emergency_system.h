@@ -11,7 +11,21 @@
  * - Response time tracking and statistics
  * - Emergency queue management for multiple simultaneous requests
  *
- * Integration: Works with scheduler and synchronization modules for signal override
+ * Simultaneous emergencies wait in a bounded binary min-heap stored inside
+ * EmergencySystem (no allocation). The heap key is the expected arrival time
+ * (detection + approach_time) plus EMERGENCY_PRIORITY_SPACING seconds per
+ * priority level below the highest, so higher-priority vehicles are served
+ * first but any queued emergency is overtaken only by vehicles expected
+ * within a bounded window after it. Ties are served in detection order.
+ *
+ * Integration: Works with scheduler and synchronization modules for signal override.
+ * Once a scheduler is attached, each dispatched emergency asks the scheduler
+ * for green on its lane and releases it on clearance. approach_time decides
+ * how: an emergency detected far enough out gets a planned pre-clear that
+ * drains its lane before arrival; otherwise it preempts (all-red, then
+ * green). The crossing starts once the vehicle has arrived and has green.
+ * On clearance the detection, green and clear timestamps are reported to the
+ * attached PerformanceMetrics as per-type response-time histograms.
  */
 
 #ifndef EMERGENCY_SYSTEM_H
@@ -19,7 +33,14 @@
 
 #include <time.h>
 #include <stdbool.h>
+#include <pthread.h>
 #include "lane_process.h"
+#include "latency_histogram.h"
+#include "scheduler.h"
+#include "performance_metrics.h"
+
+#define EMERGENCY_QUEUE_CAPACITY 16
+#define EMERGENCY_PRIORITY_SPACING 10.0
 
 typedef enum {
     EMERGENCY_NONE = 0,
@@ -37,10 +58,31 @@ typedef struct {
     time_t timestamp;
     bool active;
     int vehicle_id;
+    long long detected_ns;      // Monotonic time the emergency was reported
+    long long arrival_ns;       // Expected arrival at the stop line (detection + approach)
+    long long green_ns;         // Lane turned green for this vehicle
+    long long crossing_start_ns; // Arrived with green, 0 until then
+    float queue_delay;          // Seconds spent waiting behind other emergencies
 } EmergencyVehicle;
 
 typedef struct {
+    EmergencyVehicle vehicle;
+    double key;                 // Expected arrival + priority spacing (seconds)
+    long long sequence;         // Detection order, breaks key ties
+} EmergencyQueueEntry;
+
+typedef struct {
+    pthread_mutex_t lock;       // Guards the current emergency and the queue
     EmergencyVehicle current_emergency;
+    EmergencyQueueEntry pending[EMERGENCY_QUEUE_CAPACITY];
+    int pending_count;
+    long long next_sequence;
+    int emergencies_queued;
+    int emergencies_dropped;
+    float max_queue_delay;
+    LatencyHistogram queue_delay_ns;
+    Scheduler* scheduler;       // Receives preemption requests, may be NULL
+    PerformanceMetrics* metrics; // Receives per-type response times, may be NULL
     bool emergency_mode;
     time_t emergency_start_time;
     int total_emergencies_handled;
@@ -53,10 +95,13 @@ void init_emergency_system(EmergencySystem* system);
 void destroy_emergency_system(EmergencySystem* system);
 void reset_emergency_system(EmergencySystem* system);
 EmergencySystem* get_global_emergency_system();
+void attach_emergency_scheduler(EmergencySystem* system, Scheduler* scheduler);
+void attach_emergency_metrics(EmergencySystem* system, PerformanceMetrics* metrics);
 
 bool detect_emergency_vehicle(LaneProcess* lane);
-EmergencyVehicle* generate_random_emergency();
+EmergencyVehicle generate_random_emergency();
 void add_emergency_vehicle(EmergencySystem* system, EmergencyVehicle* emergency);
+int get_pending_emergency_count(EmergencySystem* system);
 
 void preempt_for_emergency(EmergencySystem* system, EmergencyVehicle* emergency);
 void handle_emergency_clearance(EmergencySystem* system);
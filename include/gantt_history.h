@@ -0,0 +1,61 @@
+/*
+ * Gantt History - Multi-Resolution Record of Lane Green Intervals
+ *
+ * Every execution record (lane, start, end, vehicles served) is folded
+ * into GANTT_LEVELS rings of time buckets. Level k buckets cover 2^k
+ * seconds, so level 0 holds the last ~17 minutes at 1 s per bucket and
+ * level 11 the last ~24 days at ~34 minutes per bucket. A bucket keeps,
+ * per lane, how many of its seconds were green: equal to the bucket width
+ * means green throughout (the minimum), non-zero means green at some
+ * point (the maximum). It also keeps the vehicles served in slices that
+ * ended in it and the busiest single second (served_peak).
+ *
+ * A view at 2^k seconds per screen column reads one level-k bucket per
+ * column, so drawing costs the same for a minute of history as for hours.
+ *
+ * One writer at a time (a private mutex) publishes through a sequence
+ * counter; readers copy buckets without locks and retry if a write
+ * overlapped, as with the simulation snapshot.
+ */
+
+#ifndef GANTT_HISTORY_H
+#define GANTT_HISTORY_H
+
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+#include "intersection_geometry.h"
+
+#define GANTT_LEVELS 12
+#define GANTT_LEVEL_BUCKETS 1024
+#define GANTT_LANES MAX_LANES
+
+typedef struct {
+    long long id;                               // Bucket number (time >> level), -1 = empty
+    unsigned short green_seconds[GANTT_LANES];  // Seconds of the bucket each lane was green
+    int served;                                 // Vehicles served in slices ending here
+    int served_peak;                            // Most vehicles served in one second
+} GanttBucket;
+
+typedef struct {
+    GanttBucket buckets[GANTT_LEVELS][GANTT_LEVEL_BUCKETS];
+    unsigned int sequence;                      // Odd while a record is being folded in
+    pthread_mutex_t write_lock;                 // Serializes writers only
+    long long intervals_recorded;
+} GanttHistory;
+
+GanttHistory* create_gantt_history();
+void destroy_gantt_history(GanttHistory* history);
+
+void gantt_record_interval(GanttHistory* history, int lane_id, time_t start_time,
+                           time_t end_time, int vehicles_processed);
+
+// Copy 'count' level-'level' buckets starting at bucket number 'first_id';
+// buckets that were never written or have been overwritten come back with
+// id -1 and zero counts. Returns false if the arguments are out of range.
+bool gantt_read_buckets(GanttHistory* history, int level, long long first_id,
+                        int count, GanttBucket* out);
+
+long long gantt_intervals_recorded(GanttHistory* history);
+
+#endif
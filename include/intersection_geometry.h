@@ -0,0 +1,82 @@
+/*
+ * Intersection Geometry - Approaches, Lanes and Conflict Quadrants
+ *
+ * Describes the junction being simulated: its approaches (legs), each at a
+ * compass bearing with one or more lanes, and the movements each lane may
+ * carry. Lane ids number the lanes of every approach in the order the
+ * approaches are listed, median lane first, so the schedulers, the
+ * Banker's state and the UI all work over one contiguous array of
+ * num_lanes lanes.
+ *
+ * The box is split into one quadrant per approach: quadrant q is the
+ * corner between approach q and its clockwise neighbour. Traffic keeps
+ * right, so a movement from approach A to exit E sweeps the corners
+ * counter-clockwise from A round to E: a right turn one, a four-way
+ * through movement two, a left turn three and a U-turn all of them. A
+ * movement's exit is the approach whose bearing is nearest its heading;
+ * with none within GEOMETRY_EXIT_TOLERANCE degrees the movement does not
+ * exist there (the stem of a T-junction has no through movement).
+ *
+ * Geometry file, one approach per line ('#' starts a comment):
+ *   approach <name> <bearing> <lanes> [<movements> ...]
+ * The bearing is where the approach lies seen from the centre (north 0,
+ * east 90). Movements are letters from L S R U, one group per lane from
+ * the median outwards. Left out, a single lane carries every movement; on
+ * wider approaches the median lane takes L S U, the kerb lane S R and any
+ * lane between them S.
+ *
+ * Built-in presets: four-way (the default: North, South, East and West
+ * with one lane each, lane ids as LANE_NORTH..LANE_WEST), t-junction,
+ * five-leg and four-way-dual.
+ */
+
+#ifndef INTERSECTION_GEOMETRY_H
+#define INTERSECTION_GEOMETRY_H
+
+#include <stdbool.h>
+#include "queue.h"
+
+#define MAX_APPROACHES 8
+#define MAX_LANES 16
+#define MAX_QUADRANTS MAX_APPROACHES
+#define GEOMETRY_NAME_LENGTH 16
+#define GEOMETRY_EXIT_TOLERANCE 60
+#define DEFAULT_GEOMETRY "four-way"
+
+typedef struct {
+    char name[GEOMETRY_NAME_LENGTH];
+    int bearing;                        // Degrees clockwise from north
+    int first_lane;                     // Lane id of the median lane
+    int num_lanes;
+    int exits[NUM_MOVEMENTS];           // Approach each movement leaves by, -1 if none
+} GeometryApproach;
+
+typedef struct {
+    char name[GEOMETRY_NAME_LENGTH];    // Approach name, numbered on multi-lane approaches
+    int approach;
+    int movements;                      // Bit (1 << VehicleMovement) per movement carried
+    int quadrants[NUM_MOVEMENTS];       // Quadrant bitmask each movement sweeps
+} GeometryLane;
+
+typedef struct {
+    char name[64];                      // Preset name or file path
+    int num_approaches;
+    GeometryApproach approaches[MAX_APPROACHES];
+    int num_lanes;
+    GeometryLane lanes[MAX_LANES];
+    int num_quadrants;
+    int all_quadrants;                  // Bitmask of every quadrant
+} IntersectionGeometry;
+
+bool load_intersection_geometry(IntersectionGeometry* geometry, const char* spec);
+void set_intersection_geometry(const IntersectionGeometry* geometry);
+const IntersectionGeometry* get_intersection_geometry();
+
+int get_num_lanes();
+const char* get_geometry_lane_name(int lane_id);
+int get_movement_quadrant_mask(int lane_id, VehicleMovement movement);
+bool lane_allows_movement(int lane_id, VehicleMovement movement);
+VehicleMovement fit_movement_to_lane(int lane_id, VehicleMovement wanted);
+void print_intersection_geometry(const IntersectionGeometry* geometry);
+
+#endif
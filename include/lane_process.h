@@ -1,9 +1,10 @@
 /*
  * Lane Process - Traffic Lane State Management
  *
- * Manages individual traffic lane processes representing North, South, East, and West
- * approaches to an intersection. Each lane maintains vehicle queue, state tracking,
- * performance metrics, and intersection resource allocation.
+ * Manages individual traffic lane processes, one per lane of the active
+ * intersection geometry (North, South, East and West by default). Each lane
+ * maintains vehicle queue, state tracking, performance metrics, and
+ * intersection resource allocation.
  *
  * Lane States: WAITING, READY, RUNNING, BLOCKED
  * Resources: Requested and allocated intersection quadrants
@@ -14,6 +15,15 @@
  * - Performance tracking (wait times, throughput)
  * - Thread-safe synchronization with mutex and condition variables
  * - Intersection quadrant allocation for deadlock-free crossing
+ *
+ * Queued vehicles carry a turning movement and a class, drawn by
+ * pick_vehicle_movement()/pick_vehicle_class() from the shares below; the
+ * head vehicle's movement decides which quadrants the lane requests.
+ *
+ * max_queue_length is the lane's storage. Lanes set up with
+ * init_lane_process_with_pool() keep queuing past it (spillback, see
+ * queue.h) until the shared pool's memory cap; add_vehicle_record_to_lane()
+ * returns false only for an arrival that was dropped.
  */
 
 #ifndef LANE_PROCESS_H
@@ -22,9 +32,16 @@
 #include <pthread.h>
 #include <time.h>
 #include "queue.h"
+#include "intersection_geometry.h"
 
 #define BATCH_EXIT_SIZE 3
 
+// Turning mix and fleet mix, in percent of arrivals (the rest go straight / are cars)
+#define TURN_SHARE_LEFT 20
+#define TURN_SHARE_RIGHT 20
+#define TURN_SHARE_U_TURN 2
+#define HEAVY_VEHICLE_SHARE 8
+
 typedef enum {
     WAITING = 0,
     READY = 1,
@@ -39,7 +56,8 @@ typedef struct {
     int max_queue_length;
     LaneState state;
     int priority;
-    int waiting_time;
+    int waiting_time;               // Seconds since ready_since_ns, as of the last decision
+    long long ready_since_ns;       // Monotonic; became READY or lost green
     pthread_t thread_id;
     pthread_mutex_t queue_lock;
     pthread_cond_t queue_cond;
@@ -52,13 +70,22 @@ typedef struct {
 } LaneProcess;
 
 void init_lane_process(LaneProcess* lane, int lane_id, int max_capacity);
+void init_lane_process_with_pool(LaneProcess* lane, int lane_id, int max_capacity,
+                                 QueueChunkPool* pool);
 void destroy_lane_process(LaneProcess* lane);
 void* lane_process_thread(void* arg);
 
 void add_vehicle_to_lane(LaneProcess* lane, int vehicle_id);
+bool add_vehicle_record_to_lane(LaneProcess* lane, const VehicleRecord* vehicle);
 int remove_vehicle_from_lane(LaneProcess* lane);
 int remove_vehicle_from_lane_unlocked(LaneProcess* lane);
+bool remove_vehicle_record_from_lane_unlocked(LaneProcess* lane, VehicleRecord* vehicle);
+bool peek_lane_head_vehicle(LaneProcess* lane, VehicleRecord* vehicle);
+
+VehicleMovement pick_vehicle_movement(int roll);
+VehicleClass pick_vehicle_class(int roll);
 int get_lane_queue_length(LaneProcess* lane);
+int get_lane_spillback_length(LaneProcess* lane);
 
 void update_lane_state(LaneProcess* lane, LaneState new_state);
 int is_lane_ready(LaneProcess* lane);
@@ -0,0 +1,49 @@
+/*
+ * Latency Histogram - Fixed-Size Log-Linear Histogram
+ *
+ * Records non-negative integer samples (typically nanoseconds) into
+ * log-linear buckets: values below 16 get exact buckets, larger values are
+ * split into 16 linear sub-buckets per power of two, so every bucket is
+ * within ~6% of the values it holds. Recording is a handful of relaxed
+ * atomic operations and never allocates, so any thread may record into a
+ * shared histogram without holding a lock.
+ *
+ * Percentile queries walk the buckets and report the bucket midpoint.
+ * histogram_percentile_since() answers the same query for only the samples
+ * recorded after an earlier snapshot (copied with histogram_merge into an
+ * empty histogram), which gives windowed percentiles from one cumulative
+ * histogram.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#define HISTOGRAM_SUB_BUCKET_BITS 4
+#define HISTOGRAM_SUB_BUCKETS (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_MAX_EXPONENT 47
+#define HISTOGRAM_BUCKET_COUNT \
+    ((HISTOGRAM_MAX_EXPONENT - HISTOGRAM_SUB_BUCKET_BITS + 2) * HISTOGRAM_SUB_BUCKETS)
+
+typedef struct {
+    long long counts[HISTOGRAM_BUCKET_COUNT];
+    long long total_count;
+    long long sum;
+    long long min_value;
+    long long max_value;
+} LatencyHistogram;
+
+void init_latency_histogram(LatencyHistogram* histogram);
+void reset_latency_histogram(LatencyHistogram* histogram);
+
+void histogram_record(LatencyHistogram* histogram, long long value);
+void histogram_merge(LatencyHistogram* destination, const LatencyHistogram* source);
+
+long long histogram_count(const LatencyHistogram* histogram);
+long long histogram_min(const LatencyHistogram* histogram);
+long long histogram_max(const LatencyHistogram* histogram);
+double histogram_mean(const LatencyHistogram* histogram);
+long long histogram_percentile(const LatencyHistogram* histogram, double percentile);
+long long histogram_percentile_since(const LatencyHistogram* histogram,
+                                     const LatencyHistogram* snapshot, double percentile);
+
+#endif
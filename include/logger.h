@@ -0,0 +1,63 @@
+/*
+ * Logger - Asynchronous Lock-Free Logging
+ *
+ * Producers write fixed-size binary records into a per-thread single-producer
+ * ring; a background thread drains the rings, formats the records and writes
+ * them to the log file. Producers never block, never format and never touch
+ * the terminal, so logging is safe from hot paths and while holding mutexes.
+ *
+ * Key Features:
+ * - Levels: ERROR, WARN, INFO, DEBUG (filtered before a record is written)
+ * - printf-style formats: the format must be a string literal; arguments are
+ *   captured by value (%s strings are copied into the record)
+ * - Rate limiting in the writer thread (errors are never suppressed)
+ * - Dropped (ring full) and suppressed (rate limit) records are counted
+ *
+ * Usage: LOG_INFO("Lane %d granted %d quadrants", lane_id, count);
+ */
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdbool.h>
+
+typedef enum {
+    LOG_LEVEL_ERROR = 0,
+    LOG_LEVEL_WARN = 1,
+    LOG_LEVEL_INFO = 2,
+    LOG_LEVEL_DEBUG = 3
+} LogLevel;
+
+#define LOG_MAX_ARGS 8
+#define LOG_INLINE_TEXT_SIZE 64
+#define LOG_RING_CAPACITY 256
+#define LOG_MAX_RINGS 32
+#define LOG_DEFAULT_RATE_LIMIT 200
+#define LOG_DEFAULT_FILE "trafficguru.log"
+
+typedef struct {
+    long long records_written;
+    long long records_dropped;
+    long long records_suppressed;
+    int rings_in_use;
+} LoggerStats;
+
+int init_logger(const char* filename, LogLevel min_level, int max_records_per_second);
+void destroy_logger();
+
+void set_log_level(LogLevel level);
+LogLevel get_log_level();
+bool is_log_level_enabled(LogLevel level);
+bool parse_log_level(const char* name, LogLevel* level);
+const char* get_log_level_name(LogLevel level);
+
+void log_message(LogLevel level, const char* format, ...)
+    __attribute__((format(printf, 2, 3)));
+void get_logger_stats(LoggerStats* stats);
+
+#define LOG_ERROR(...) log_message(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_WARN(...)  log_message(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_INFO(...)  log_message(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_DEBUG(...) log_message(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+#endif
@@ -0,0 +1,82 @@
+/*
+ * Metrics Endpoint - Prometheus Exposition over a Local Socket
+ *
+ * Optional HTTP endpoint that serves the simulator's metrics in Prometheus
+ * text format (version 0.0.4) on GET /metrics. It listens on a loopback TCP
+ * port, a Unix domain socket, or both; nothing is exposed off-host.
+ *
+ * The simulation thread publishes a plain-number snapshot (core metrics,
+ * per-lane queue and wait stats, intersection lock counters, scheduler
+ * decision latency, emergency preemption latency) at most once per
+ * METRICS_ENDPOINT_PUBLISH_MS. The snapshot is guarded by a sequence
+ * counter: the server thread copies it and retries if a publish overlapped,
+ * so a scrape never takes a simulation lock. Core gauges and queue lengths
+ * are taken from the simulation snapshot (sim_snapshot.h) the UI draws.
+ */
+
+#ifndef METRICS_ENDPOINT_H
+#define METRICS_ENDPOINT_H
+
+#include <stdbool.h>
+#include "performance_metrics.h"
+#include "scheduler.h"
+
+#define METRICS_ENDPOINT_PUBLISH_MS 1000
+#define METRICS_ENDPOINT_PATH_SIZE 108
+#define METRICS_ENDPOINT_QUANTILES 3     // 0.5, 0.95, 0.99
+
+typedef struct {
+    int tcp_port;                               // 0 = disabled, binds 127.0.0.1
+    char unix_path[METRICS_ENDPOINT_PATH_SIZE]; // Empty = disabled
+} MetricsEndpointConfig;
+
+// Summary of a latency histogram, in seconds
+typedef struct {
+    long long count;
+    double sum;
+    double quantiles[METRICS_ENDPOINT_QUANTILES];
+} MetricsEndpointSummary;
+
+typedef struct {
+    long long published_ns;         // Monotonic time of publication
+    float vehicles_per_minute;
+    float avg_wait_time;
+    float utilization;
+    float fairness_index;
+    float emergency_response_time;
+    int total_vehicles;
+    int context_switches;
+    int deadlocks_prevented;
+    int queue_overflows;
+    int spillback_vehicles;
+    float spillback_delay_seconds;
+    int simulation_seconds;
+    int num_lanes;
+    int lane_vehicles[MAX_LANES];
+    float lane_wait_seconds[MAX_LANES];     // Total wait of served vehicles
+    int lane_queue_length[MAX_LANES];
+    int lane_spillback[MAX_LANES];
+    MetricsEndpointSummary vehicle_wait;
+    long long lock_acquisitions;
+    long long lock_successes;
+    long long lock_failures;
+    long long lock_timeouts;
+    long long lock_preemptions;
+    MetricsEndpointSummary lock_acquire;
+    MetricsEndpointSummary scheduler_decision;
+    MetricsEndpointSummary emergency_preemption;
+    int emergency_preclears;
+    int emergency_preemptions;
+} MetricsEndpointSnapshot;
+
+void init_metrics_endpoint_config(MetricsEndpointConfig* config);
+bool is_metrics_endpoint_configured(const MetricsEndpointConfig* config);
+
+int start_metrics_endpoint(const MetricsEndpointConfig* config);
+void stop_metrics_endpoint();
+
+void publish_metrics_endpoint_snapshot(PerformanceMetrics* metrics, Scheduler* scheduler);
+bool read_metrics_endpoint_snapshot(MetricsEndpointSnapshot* snapshot);
+int format_prometheus_metrics(const MetricsEndpointSnapshot* snapshot, char* buffer, int size);
+
+#endif
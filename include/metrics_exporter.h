@@ -0,0 +1,86 @@
+/*
+ * Metrics Exporter - Periodic Streaming Export of Performance Metrics
+ *
+ * At a fixed interval the metrics sampler thread snapshots the metrics
+ * into a fixed-size record and pushes it into a single-producer/single-
+ * consumer ring. A background writer thread drains the ring and appends the records
+ * to the export file, so no file I/O runs on the simulation thread. If the
+ * ring is full the record is dropped and counted; the producer never blocks.
+ *
+ * Formats:
+ * - CSV: one row for the whole intersection (scope "all") followed by one
+ *   row per lane (scope "lane0", "lane1", ...) for every record
+ * - Binary: columnar blocks. The file starts with a header
+ *   ("TGMX", version, column count, then type and name of each column;
+ *   lane columns lane<i>_* repeat for each lane of the geometry);
+ *   each block is a row count followed by that many values of each column
+ *   in turn. Values are native-endian int32, int64 or float32.
+ *
+ * Both formats append, so a restarted run extends the same trajectory. An
+ * existing file must start with the header this run would write (same
+ * format, and for binary the same columns, hence lane count); otherwise
+ * the exporter refuses to start rather than mix incompatible rows.
+ */
+
+#ifndef METRICS_EXPORTER_H
+#define METRICS_EXPORTER_H
+
+#include <stdbool.h>
+#include "performance_metrics.h"
+
+#define EXPORT_RING_CAPACITY 256
+#define EXPORT_DEFAULT_INTERVAL_MS 1000
+#define EXPORT_BLOCK_ROWS 64
+#define EXPORT_PATH_SIZE 256
+#define EXPORT_BINARY_MAGIC "TGMX"
+#define EXPORT_BINARY_VERSION 1
+
+typedef enum {
+    EXPORT_FORMAT_CSV = 0,
+    EXPORT_FORMAT_BINARY = 1
+} ExportFormat;
+
+typedef struct {
+    char path[EXPORT_PATH_SIZE];
+    ExportFormat format;
+    int interval_ms;
+} MetricsExporterConfig;
+
+// One snapshot of the metrics, as pushed through the ring
+typedef struct {
+    long long timestamp_ms;         // Wall clock
+    long long elapsed_ms;           // Monotonic, since the exporter started
+    int total_vehicles;
+    float vehicles_per_minute;
+    float recent_vehicles_per_minute; // Last completed 1 s window
+    float avg_wait_time;
+    float recent_p95_wait;
+    float utilization;
+    float fairness_index;
+    int context_switches;
+    int deadlocks_prevented;
+    int queue_overflows;
+    float emergency_response_time;
+    int lane_vehicles[MAX_LANES];
+    float lane_avg_wait[MAX_LANES];
+    int lane_queue_length[MAX_LANES];
+} MetricsExportRecord;
+
+typedef struct {
+    long long records_exported;
+    long long records_dropped;
+    long long write_errors;
+} MetricsExporterStats;
+
+void init_metrics_exporter_config(MetricsExporterConfig* config);
+bool parse_export_format(const char* name, ExportFormat* format);
+
+int start_metrics_exporter(const MetricsExporterConfig* config);
+void stop_metrics_exporter();
+bool is_metrics_exporter_running();
+
+void metrics_exporter_tick(PerformanceMetrics* metrics);
+long long metrics_exporter_next_due_ns();
+void get_metrics_exporter_stats(MetricsExporterStats* stats);
+
+#endif
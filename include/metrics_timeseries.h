@@ -0,0 +1,100 @@
+/*
+ * Metrics Time Series - Rolling-Window Performance History
+ *
+ * Keeps fixed-size rings of per-window samples at 1 s, 10 s and 60 s
+ * resolution, so recent behaviour stays visible however long the run has
+ * been going. Each sample covers one window: throughput, mean queue length
+ * per lane, mean and p95 wait, utilization and context switches.
+ *
+ * Memory is bounded by TIMESERIES_TOTAL_SLOTS regardless of run length;
+ * the oldest sample in a ring is overwritten once it is full.
+ *
+ * There is a single writer (timeseries_update, called through
+ * update_time_based_metrics from the metrics sampler thread, which ticks
+ * every METRICS_SAMPLE_INTERVAL_MS independently of the crossings). A
+ * window closes on the first tick at or after its end, so a 1 s sample
+ * spans 1.0 s plus at most one tick. Every slot carries a sequence
+ * counter that is odd while the slot is being written, so readers (UI,
+ * exporters) copy samples without taking a lock and retry torn reads.
+ */
+
+#ifndef METRICS_TIMESERIES_H
+#define METRICS_TIMESERIES_H
+
+#include <stdbool.h>
+#include "latency_histogram.h"
+#include "intersection_geometry.h"
+
+#define TIMESERIES_1S_SLOTS 300     // 5 minutes
+#define TIMESERIES_10S_SLOTS 360    // 1 hour
+#define TIMESERIES_60S_SLOTS 1440   // 24 hours
+#define TIMESERIES_TOTAL_SLOTS (TIMESERIES_1S_SLOTS + TIMESERIES_10S_SLOTS + TIMESERIES_60S_SLOTS)
+
+typedef enum {
+    TIMESERIES_1S = 0,
+    TIMESERIES_10S = 1,
+    TIMESERIES_60S = 2,
+    TIMESERIES_RESOLUTIONS = 3
+} TimeSeriesResolution;
+
+typedef struct {
+    long long start_ns;         // Monotonic start of the window
+    int duration_ms;            // Actual window length (longer if the writer stalled)
+    float vehicles_per_minute;
+    float queue_length[MAX_LANES];      // Mean queue length per lane over the window
+    float mean_wait;            // Seconds, vehicles served in the window
+    float p95_wait;
+    float utilization;
+    int context_switches;
+} TimeSeriesSample;
+
+typedef struct {
+    unsigned int sequence;      // Odd while the writer is updating the sample
+    TimeSeriesSample sample;
+} TimeSeriesSlot;
+
+// Cumulative totals sampled by the writer; windows are built from deltas
+typedef struct {
+    long long vehicles_processed;
+    long long wait_time_ms;
+    long long context_switches;
+    int queue_length[MAX_LANES];
+    const LatencyHistogram* wait_time_histogram_ms;
+    float expected_arrivals_per_sec;
+} TimeSeriesInput;
+
+// Writer-only state for the window currently being accumulated
+typedef struct {
+    long long start_ns;
+    long long vehicles_processed;
+    long long wait_time_ms;
+    long long context_switches;
+    double queue_length_sum[MAX_LANES];
+    int queue_samples;
+    LatencyHistogram wait_snapshot_ms;
+} TimeSeriesWindow;
+
+typedef struct {
+    int resolution_seconds;
+    int capacity;
+    int offset;                 // First slot of this ring in MetricsTimeSeries.storage
+    long long published;        // Samples written so far
+    TimeSeriesWindow window;
+} TimeSeriesRing;
+
+typedef struct {
+    TimeSeriesRing rings[TIMESERIES_RESOLUTIONS];
+    TimeSeriesSlot storage[TIMESERIES_TOTAL_SLOTS];
+} MetricsTimeSeries;
+
+void init_metrics_timeseries(MetricsTimeSeries* series);
+void timeseries_update(MetricsTimeSeries* series, const TimeSeriesInput* input, long long now_ns);
+
+int timeseries_read(const MetricsTimeSeries* series, TimeSeriesResolution resolution,
+                    TimeSeriesSample* samples, int max_samples);
+bool timeseries_latest(const MetricsTimeSeries* series, TimeSeriesResolution resolution,
+                       TimeSeriesSample* sample);
+long long timeseries_published_count(const MetricsTimeSeries* series, TimeSeriesResolution resolution);
+int timeseries_resolution_seconds(TimeSeriesResolution resolution);
+
+#endif
@@ -0,0 +1,67 @@
+/*
+ * Mutex Benchmark - Contention Harness for Allocation Strategies
+ *
+ * Runs K lane threads against the intersection using each allocation
+ * strategy (FIFO, Banker's, Hybrid) and reports how the strategies scale
+ * with thread count. Runs headless, before the simulation or ncurses start.
+ *
+ * Thread i acts as lane i of the loaded geometry, so K is capped at its
+ * lane count: every thread is a distinct Banker's process with its own
+ * condition variable, and denials and deadlock preventions count contention
+ * between lanes only. Each thread repeatedly:
+ * waits an exponential inter-arrival time, calls
+ * acquire_intersection_with_bankers(), holds the intersection for the
+ * configured hold time and releases it.
+ *
+ * Reported per (strategy, lanes): acquisitions/s, acquire latency
+ * p50/p99/max, denials (failed attempts), Banker's deadlock preventions
+ * and the peak number of threads granted the intersection at once (above
+ * 1 only where lanes with disjoint quadrants crossed together).
+ */
+
+#ifndef MUTEX_BENCHMARK_H
+#define MUTEX_BENCHMARK_H
+
+#include <stdbool.h>
+
+#define BENCH_MAX_THREAD_COUNTS 8
+#define BENCH_MAX_THREADS 256
+#define BENCH_NUM_STRATEGIES 3
+#define BENCH_DEFAULT_SECONDS 2
+#define BENCH_DEFAULT_ARRIVAL_RATE 0
+#define BENCH_DEFAULT_HOLD_US 50
+
+typedef struct {
+    int thread_counts[BENCH_MAX_THREAD_COUNTS];
+    int num_thread_counts;
+    int duration_seconds;
+    int arrival_rate;       // Attempts per second per thread (0 = back-to-back)
+    int hold_time_us;       // Time the intersection is held once acquired
+} MutexBenchmarkConfig;
+
+typedef struct {
+    int strategy;
+    int threads;
+    long long attempts;
+    long long acquisitions;
+    long long denials;
+    int deadlock_preventions;
+    int peak_holders;       // Most threads inside the intersection at once
+    double elapsed_seconds;
+    double acquisitions_per_second;
+    double p50_latency_us;
+    double p99_latency_us;
+    double max_latency_us;
+} MutexBenchmarkResult;
+
+void init_mutex_benchmark_config(MutexBenchmarkConfig* config);
+bool parse_benchmark_thread_counts(const char* list, MutexBenchmarkConfig* config);
+
+bool run_mutex_benchmark_case(const MutexBenchmarkConfig* config, int strategy,
+                              int threads, MutexBenchmarkResult* result);
+int run_mutex_benchmark(const MutexBenchmarkConfig* config);
+
+void print_mutex_benchmark_header();
+void print_mutex_benchmark_result(const MutexBenchmarkResult* result);
+
+#endif
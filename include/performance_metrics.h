@@ -10,6 +10,24 @@
  * - Emergency Response: Time to respond to emergency vehicles
  *
  * Provides real-time statistics, comparative analysis, and validation functions.
+ *
+ * Hot-path counters (vehicles served, wait time, context switches) live in
+ * cache-line-padded shards updated with atomics, so the service path never
+ * takes a lock. update_time_based_metrics() folds the shards into the
+ * aggregate fields on read.
+ *
+ * Emergency preemption latency (detection to green) and stop-line delay
+ * (arrival to green, zero when the lane was pre-cleared in time) are kept
+ * as full histograms; emergency_response_time reports the mean stop-line
+ * delay.
+ *
+ * Per vehicle type (indexed by EmergencyType) three more histograms split
+ * each emergency into detection to green, green to clear and end-to-end
+ * (detection to clear), all from monotonic timestamps.
+ *
+ * The cumulative fields describe the whole run; timeseries holds rolling
+ * 1 s / 10 s / 60 s windows of the same quantities (see metrics_timeseries.h),
+ * advanced by update_time_based_metrics().
  */
 
 #ifndef PERFORMANCE_METRICS_H
@@ -17,6 +35,31 @@
 
 #include <time.h>
 #include <stdbool.h>
+#include "latency_histogram.h"
+#include "metrics_timeseries.h"
+
+#define METRICS_CACHE_LINE_SIZE 64
+#define METRICS_EMERGENCY_TYPES 4   // Indexed by EmergencyType, 0 is unclassified
+
+// Per-lane counters, written lock-free by the lane being served
+typedef struct {
+    long long vehicles_processed;
+    long long wait_time_ms;
+    long long spillback_vehicles;       // Served vehicles that first waited upstream
+    long long spillback_delay_ms;       // Their time upstream of the lane's storage
+} __attribute__((aligned(METRICS_CACHE_LINE_SIZE))) LaneCounterShard;
+
+// Scheduler-wide counters, written lock-free by the scheduling thread
+typedef struct {
+    long long context_switches;
+} __attribute__((aligned(METRICS_CACHE_LINE_SIZE))) SchedulerCounterShard;
+
+// Response-time distributions for one emergency vehicle type (nanoseconds)
+typedef struct {
+    LatencyHistogram detection_to_green_ns;
+    LatencyHistogram green_to_clear_ns;
+    LatencyHistogram end_to_end_ns;
+} EmergencyResponseHistograms;
 
 typedef struct {
     float vehicles_per_minute;
@@ -27,12 +70,25 @@ typedef struct {
     int context_switches;
     float emergency_response_time;
     int total_vehicles_processed;
-    int queue_overflow_count;
+    int queue_overflow_count;           // Arrivals dropped (queue memory cap reached)
+    int spillback_vehicles;
+    float spillback_delay;              // Total seconds spent upstream of storage
     time_t measurement_start_time;
     time_t last_update_time;
-    float lane_wait_times[4];
-    int lane_throughput[4];
+    int num_lanes;                      // Lanes in use out of MAX_LANES
+    float lane_wait_times[MAX_LANES];
+    int lane_throughput[MAX_LANES];
     int total_simulation_time;
+    LaneCounterShard lane_counters[MAX_LANES];
+    SchedulerCounterShard scheduler_counters;
+    LatencyHistogram preemption_latency_ns;
+    LatencyHistogram emergency_arrival_delay_ns;
+    int emergency_preclears;
+    int emergency_preemptions;
+    EmergencyResponseHistograms emergency_by_type[METRICS_EMERGENCY_TYPES];
+    LatencyHistogram wait_time_ms;
+    int lane_queue_lengths[MAX_LANES];
+    MetricsTimeSeries timeseries;
 } PerformanceMetrics;
 
 void init_performance_metrics(PerformanceMetrics* metrics);
@@ -40,14 +96,21 @@ void destroy_performance_metrics(PerformanceMetrics* metrics);
 void reset_performance_metrics(PerformanceMetrics* metrics);
 
 void calculate_throughput_metrics(PerformanceMetrics* metrics, time_t current_time);
-void calculate_wait_time_metrics(PerformanceMetrics* metrics, float lane_wait_times[4]);
+void calculate_wait_time_metrics(PerformanceMetrics* metrics, float lane_wait_times[MAX_LANES]);
 void calculate_utilization_metrics(PerformanceMetrics* metrics, time_t active_time, time_t total_time);
-void calculate_fairness_index_metrics(PerformanceMetrics* metrics, float wait_times[4]);
+void calculate_fairness_index_metrics(PerformanceMetrics* metrics, float wait_times[MAX_LANES]);
 
+void record_vehicle_served(PerformanceMetrics* metrics, int lane_id, float wait_time);
+void record_spillback_delay(PerformanceMetrics* metrics, int lane_id, long long delay_ns);
 void update_vehicle_count(PerformanceMetrics* metrics, int lane_id, int vehicle_count);
 void update_wait_time(PerformanceMetrics* metrics, int lane_id, float wait_time);
+void record_lane_queue_length(PerformanceMetrics* metrics, int lane_id, int queue_length);
 void update_context_switch_count(PerformanceMetrics* metrics);
 void update_emergency_response_time(PerformanceMetrics* metrics, float response_time);
+void record_preemption_latency(PerformanceMetrics* metrics, long long latency_ns);
+void record_emergency_arrival_delay(PerformanceMetrics* metrics, long long delay_ns, bool preclear);
+void record_emergency_response(PerformanceMetrics* metrics, int type, long long detected_ns,
+                               long long green_ns, long long cleared_ns);
 void update_deadlock_prevention_count(PerformanceMetrics* metrics);
 void update_queue_overflow_count(PerformanceMetrics* metrics);
 
@@ -69,9 +132,10 @@ void sanitize_metrics(PerformanceMetrics* metrics);
 
 float calculate_metrics_time_window(PerformanceMetrics* metrics, time_t start_time, time_t end_time);
 void update_time_based_metrics(PerformanceMetrics* metrics, time_t current_time);
+void aggregate_metric_shards(PerformanceMetrics* metrics);
 
 void print_performance_metrics(PerformanceMetrics* metrics);
 void print_detailed_metrics(PerformanceMetrics* metrics);
-PerformanceMetrics* copy_metrics(PerformanceMetrics* original);
+void copy_metrics(const PerformanceMetrics* original, PerformanceMetrics* copy);
 
 #endif
\ No newline at end of file
@@ -1,14 +1,38 @@
 /*
  * Queue - FIFO Data Structure for Vehicle Management
  *
- * Implements a circular queue for managing vehicle IDs at traffic lanes.
- * Provides FIFO insertion/removal with capacity limits and overflow tracking.
+ * Implements a segmented queue for managing vehicles at traffic lanes.
+ * Provides FIFO insertion/removal with storage limits, spillback and
+ * overflow tracking.
+ *
+ * Entries are vehicle records (id, arrival time, turning movement, class)
+ * stored struct-of-arrays: one array per field inside each chunk, so scans
+ * that only need ids or arrival times touch only those arrays.
+ * VehicleRecord is the by-value view used at the API boundary. The plain
+ * enqueue()/dequeue()/peek() calls store and return ids only (a through
+ * movement, arrival stamped now) for queues of lane ids and the like.
+ *
+ * Storage: a queue is a list of QUEUE_CHUNK_VEHICLES-slot chunks. Growing
+ * links one more chunk and a drained head chunk is handed back, so nothing
+ * is ever copied. A queue made with create_pooled_queue() takes its chunks
+ * from a QueueChunkPool shared by several queues and bounded by a memory
+ * cap; create_queue() allocates private chunks and never holds more than
+ * its capacity. A pool given a RunArena creates all its chunks there up to
+ * the cap, up front, and its queues' structs too: once set up, lane queues
+ * never touch the heap, and all of it goes when the arena is destroyed.
+ *
+ * Spillback: for a pooled queue, capacity is the lane's storage (vehicles
+ * that fit between the stop line and the upstream junction). Arrivals
+ * beyond it are still queued, in order, but wait upstream; each record's
+ * storage_ns is set when the vehicle moves up into storage, so
+ * storage_ns - arrival_ns is its spillback delay. Only when the pool cap
+ * is reached is an arrival refused (overflow_count).
  *
  * Key Features:
- * - Dynamic queue resizing
- * - Circular array implementation for efficient memory usage
- * - Queue overflow detection and counting
- * - Statistics tracking (enqueue/dequeue/overflow counts)
+ * - O(1) growth and shrink without copying
+ * - Shared, memory-capped chunk pool
+ * - Spillback and overflow detection and counting
+ * - Statistics tracking (enqueue/dequeue/spillback/overflow counts)
  *
  * Used By: Lane processes for queuing arriving vehicles awaiting intersection access
  */
@@ -19,19 +43,71 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <time.h>
+#include <pthread.h>
+#include "run_arena.h"
+
+typedef enum {
+    MOVEMENT_LEFT = 0,
+    MOVEMENT_STRAIGHT = 1,
+    MOVEMENT_RIGHT = 2,
+    MOVEMENT_U_TURN = 3
+} VehicleMovement;
+
+#define NUM_MOVEMENTS 4
+
+typedef enum {
+    VEHICLE_CAR = 0,
+    VEHICLE_HEAVY = 1               // Trucks and buses: slower to clear the box
+} VehicleClass;
+
+typedef struct {
+    int id;
+    long long arrival_ns;           // Monotonic time the vehicle joined the queue
+    VehicleMovement movement;
+    VehicleClass vehicle_class;
+    long long storage_ns;           // Moved up into lane storage, 0 while spilled back (set by the queue)
+} VehicleRecord;
+
+#define QUEUE_CHUNK_VEHICLES 32
+
+typedef struct QueueChunk {
+    struct QueueChunk* next;
+    int vehicles[QUEUE_CHUNK_VEHICLES];             // Vehicle ids
+    long long arrival_ns[QUEUE_CHUNK_VEHICLES];
+    long long storage_ns[QUEUE_CHUNK_VEHICLES];
+    unsigned char movements[QUEUE_CHUNK_VEHICLES];  // VehicleMovement
+    unsigned char classes[QUEUE_CHUNK_VEHICLES];    // VehicleClass
+} QueueChunk;
 
 typedef struct {
-    int* vehicles;
-    int front;
-    int rear;
+    ObjectPool chunks;              // QueueChunk objects; max_objects is the memory cap
+    RunArena* arena;                // Holds the chunks and the queues' own structs, NULL = heap
+} QueueChunkPool;
+
+typedef struct {
+    QueueChunk* head_chunk;
+    QueueChunk* tail_chunk;
+    QueueChunk* spare_chunk;        // Last drained chunk, kept for the next growth
+    int head_slot;                  // First occupied slot of head_chunk
+    int tail_slot;                  // Next free slot of tail_chunk
     int size;
-    int capacity;
+    int capacity;                   // Storage; a pooled queue spills back beyond it
+    QueueChunkPool* pool;           // NULL: private chunks, hard limit of capacity
     int enqueue_count;
     int dequeue_count;
-    int overflow_count;
+    int overflow_count;             // Arrivals refused
+    int spillback_count;            // Arrivals that found storage full
+    int peak_size;
 } Queue;
 
+QueueChunkPool* create_queue_chunk_pool(RunArena* arena, size_t max_bytes);
+void destroy_queue_chunk_pool(QueueChunkPool* pool);
+void set_queue_chunk_pool_limit(QueueChunkPool* pool, size_t max_bytes);
+size_t get_queue_chunk_pool_bytes_in_use(QueueChunkPool* pool);
+size_t get_queue_chunk_pool_peak_bytes(QueueChunkPool* pool);
+
 Queue* create_queue(int capacity);
+Queue* create_pooled_queue(int capacity, QueueChunkPool* pool);
 void destroy_queue(Queue* queue);
 void resize_queue(Queue* queue, int new_capacity);
 
@@ -39,6 +115,13 @@ bool enqueue(Queue* queue, int vehicle_id);
 int dequeue(Queue* queue);
 int peek(Queue* queue);
 
+bool enqueue_vehicle(Queue* queue, const VehicleRecord* vehicle);
+bool dequeue_vehicle(Queue* queue, VehicleRecord* vehicle);
+bool peek_vehicle(Queue* queue, VehicleRecord* vehicle);
+int copy_queued_vehicles(Queue* queue, VehicleRecord* vehicles, int max_vehicles);
+bool restore_queued_vehicle(Queue* queue, const VehicleRecord* vehicle);
+const char* get_movement_name(VehicleMovement movement);
+
 bool is_empty(Queue* queue);
 bool is_full(Queue* queue);
 int get_size(Queue* queue);
@@ -51,6 +134,8 @@ float get_queue_utilization(Queue* queue);
 int get_total_enqueues(Queue* queue);
 int get_total_dequeues(Queue* queue);
 int get_overflow_count(Queue* queue);
+int get_spillback_count(Queue* queue);
+int get_spillback_length(Queue* queue);
 float get_average_queue_length(Queue* queue, time_t start_time);
 
 #endif
\ No newline at end of file
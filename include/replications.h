@@ -0,0 +1,39 @@
+/*
+ * Replications - Parallel Monte Carlo Runs with Confidence Intervals
+ *
+ * Headless mode (--replications N) that runs N independently seeded
+ * replications of one scheduling algorithm in virtual time and reports,
+ * per metric, the mean, standard deviation and 95% Student-t confidence
+ * interval. Replication i uses the arrivals and crossing times of seed i
+ * of --compare, so the two modes agree on the same seeds.
+ *
+ * Replications run on a pool of one thread per online CPU; each thread
+ * owns a ComparisonWorker and claims the next replication index when it
+ * finishes one. With a target (--ci-target PCT) the run stops once every
+ * metric's 95% interval is within PCT percent of its mean, checked after
+ * each replication from REPLICATION_MIN_FOR_STOP on. Results are taken in
+ * index order, so the stopping point and the report depend only on the
+ * seeds, not on how the threads were scheduled.
+ */
+
+#ifndef REPLICATIONS_H
+#define REPLICATIONS_H
+
+#include <stdbool.h>
+#include "algorithm_comparison.h"
+
+#define REPLICATION_MAX 100000
+#define REPLICATION_MAX_THREADS 256
+#define REPLICATION_MIN_FOR_STOP 10
+
+typedef struct {
+    SchedulingAlgorithm algorithm;
+    int replications;               // Upper bound; fewer if the target is met
+    double ci_target;               // Relative half-width, e.g. 0.05; 0 = run all
+    AlgorithmComparisonConfig run;  // Duration, arrival rates, quantum and base seed
+} ReplicationConfig;
+
+void init_replication_config(ReplicationConfig* config);
+int run_replications(const ReplicationConfig* config);
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Road Network - Intersections Connected by Links
+ *
+ * Headless mode (--network FILE) that simulates many intersections at once
+ * in virtual time. Every intersection has the layout of the loaded
+ * geometry and keeps its own scheduler, which crosses one vehicle at a
+ * time (so, unlike the live intersection, no quadrants are arbitrated
+ * between vehicles); a vehicle that crosses one leaves by the approach its
+ * movement exits to and, when a link starts there, joins the far
+ * intersection's approach queue after the link's travel time. Without a
+ * link it leaves the network.
+ *
+ * A link stores a limited number of vehicles: those travelling along it
+ * and those queued at its far end. When it is full, a vehicle upstream
+ * that would turn into it is held at the stop line, its lane loses green
+ * and the queue grows behind it - spillback from one junction into the
+ * next. Vehicles enter at sources (Poisson arrivals at an approach) and
+ * choose their movement on each approach from its turning weights.
+ *
+ * Network file, one directive per line ('#' starts a comment):
+ *   intersection <name> [sjf|multilevel|priority]
+ *   link <from> <approach> <to> <approach> <travel s> <storage veh>
+ *   source <intersection> <approach> <veh/h>
+ *   turns <intersection> <approach|*> <L|S|R|U> <weight> [...]
+ * A link runs from the named exit approach of <from> into the named
+ * approach of <to>. An intersection is declared before the lines that
+ * name it, and has no policy of its own unless one is given (-g then
+ * applies). Turning weights default to 20/60/20 left/straight/right and
+ * no U-turns; a U-turn weight is honoured on approaches whose lanes carry
+ * one.
+ *
+ * The intersections are replayed with the --compare engine in windows as
+ * long as the shortest link's travel time: nothing that crosses in one
+ * window can reach another intersection before the next, so each window's
+ * arrivals are all known when it starts. Link occupancy is settled at the
+ * end of each window, so the order the intersections are replayed in does
+ * not change the result.
+ */
+
+#ifndef ROAD_NETWORK_H
+#define ROAD_NETWORK_H
+
+#include <stdbool.h>
+#include "algorithm_comparison.h"
+#include "intersection_geometry.h"
+
+#define NETWORK_MAX_INTERSECTIONS 64
+#define NETWORK_MAX_LINKS 256
+#define NETWORK_MAX_SOURCES 256
+#define NETWORK_NAME_LENGTH 16
+
+typedef struct {
+    char name[NETWORK_NAME_LENGTH];
+    int algorithm;                      // SchedulingAlgorithm, -1: the -g algorithm
+    float turn_weight[MAX_APPROACHES][NUM_MOVEMENTS];
+} NetworkIntersection;
+
+typedef struct {
+    int from;
+    int exit_approach;
+    int to;
+    int entry_approach;
+    int travel_seconds;
+    int storage;                        // Vehicles on the link and queued at its end
+} NetworkLink;
+
+typedef struct {
+    int intersection;
+    int approach;
+    float vehicles_per_hour;
+} NetworkSource;
+
+typedef struct {
+    char name[128];
+    int num_intersections;
+    NetworkIntersection intersections[NETWORK_MAX_INTERSECTIONS];
+    int num_links;
+    NetworkLink links[NETWORK_MAX_LINKS];
+    int num_sources;
+    NetworkSource sources[NETWORK_MAX_SOURCES];
+} RoadNetwork;
+
+typedef struct {
+    SchedulingAlgorithm algorithm;      // For intersections without a policy
+    AlgorithmComparisonConfig run;      // Duration, quantum and base seed
+} RoadNetworkConfig;
+
+bool load_road_network(RoadNetwork* network, const char* path, const IntersectionGeometry* geometry);
+void init_road_network_config(RoadNetworkConfig* config);
+int run_road_network(const RoadNetwork* network, const RoadNetworkConfig* config);
+
+#endif
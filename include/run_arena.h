@@ -0,0 +1,84 @@
+/*
+ * Run Arena - Simulation-Scoped Memory and Typed Object Pools
+ *
+ * A RunArena hands out memory from a few large blocks by bumping a cursor.
+ * Nothing allocated from it is freed on its own: reset_run_arena() rewinds
+ * every block for the next run and destroy_run_arena() releases them all
+ * at once, so a process running simulation after simulation reuses the
+ * same blocks instead of going back to malloc.
+ *
+ * An ObjectPool is a free list of fixed-size objects (queue chunks, and
+ * any other per-vehicle or per-event type) carved from an arena. It is
+ * sized at start-up and bounded by max_objects; taking and giving back an
+ * object is O(1) and never touches the heap once the objects exist.
+ *
+ * Every malloc made on behalf of an arena or pool is counted. A run marks
+ * the end of its start-up with mark_run_allocations_steady(); the count
+ * since then (get_run_allocation_stats) should stay at zero.
+ *
+ * Thread safety: arena allocation and pool take/give each take a private
+ * mutex; reset and destroy must not race with users.
+ */
+
+#ifndef RUN_ARENA_H
+#define RUN_ARENA_H
+
+#include <stddef.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#define RUN_ARENA_ALIGNMENT 64              // Cache line: pooled objects never false-share
+#define RUN_ARENA_DEFAULT_BLOCK (512 * 1024)
+
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;                            // Usable bytes after the header
+    size_t used;
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* blocks;                     // Most recently added first
+    ArenaBlock* current;                    // Block being carved
+    size_t block_size;
+    size_t bytes_reserved;                  // Sum of block sizes
+    size_t bytes_used;
+    size_t peak_bytes_used;
+    long long block_allocations;            // Blocks obtained from malloc
+    pthread_mutex_t lock;
+} RunArena;
+
+typedef struct {
+    RunArena* arena;                        // NULL: objects come from malloc
+    size_t object_size;
+    void* free_list;                        // Linked through each object's first word
+    int allocated;                          // Objects created so far
+    int in_use;
+    int peak_in_use;
+    int max_objects;                        // Cap on in_use
+    int exhausted_count;                    // Takes refused at the cap
+    pthread_mutex_t lock;
+} ObjectPool;
+
+typedef struct {
+    long long heap_allocations;             // Since the process started
+    long long heap_bytes;
+    long long steady_heap_allocations;      // Since mark_run_allocations_steady()
+} RunAllocationStats;
+
+RunArena* create_run_arena(size_t block_size);
+void destroy_run_arena(RunArena* arena);
+void reset_run_arena(RunArena* arena);
+void* arena_alloc(RunArena* arena, size_t size);
+
+bool init_object_pool(ObjectPool* pool, RunArena* arena, size_t object_size,
+                      int max_objects, int preallocate);
+void destroy_object_pool(ObjectPool* pool);
+void* object_pool_take(ObjectPool* pool);
+void object_pool_give(ObjectPool* pool, void* object);
+void set_object_pool_limit(ObjectPool* pool, int max_objects);
+bool reserve_object_pool(ObjectPool* pool, int objects);
+
+void mark_run_allocations_steady();
+void get_run_allocation_stats(RunAllocationStats* stats);
+
+#endif
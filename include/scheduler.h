@@ -8,6 +8,26 @@
  *
  * Manages green light allocation, context switching, and execution history tracking.
  * Thread-safe with mutex and condition variable synchronization.
+ *
+ * Emergency preemption: request_emergency_preemption() wakes any vehicle
+ * crossing or context switch sleeping on scheduler_cond. The next call to
+ * schedule_next_lane() runs an all-red clearance interval, then gives green
+ * to the emergency lane and holds it there, whatever algorithm is active,
+ * until clear_emergency_preemption(). Detection-to-green latency is recorded
+ * into the performance metrics.
+ *
+ * Pre-clearing: when an emergency is detected far enough out,
+ * request_emergency_preclear() plans the green instead. The emergency lane
+ * is switched to at an ordinary slice boundary once
+ *   now >= arrival - queue_length * PRECLEAR_SECONDS_PER_VEHICLE - margin
+ * so the vehicles in front of it are drained before it arrives. If the lane
+ * is still not green at arrival the request escalates to a hard preemption.
+ *
+ * Execution records go to a ring of the last history_size slices and, always
+ * (the ring is skipped when scheduler_lock is busy), to the Gantt history.
+ *
+ * decision_latency_ns records how long the active algorithm takes to pick
+ * a lane (emergency paths and the context switch are not included).
  */
 
 #ifndef SCHEDULER_H
@@ -16,6 +36,13 @@
 #include <time.h>
 #include <pthread.h>
 #include "lane_process.h"
+#include "latency_histogram.h"
+#include "gantt_history.h"
+#include "scheduling_policy.h"
+
+#define ALL_RED_CLEARANCE_MS 1000
+#define PRECLEAR_SECONDS_PER_VEHICLE 3
+#define PRECLEAR_SWITCH_MARGIN_MS 6000      // Longest crossing + context switch
 
 typedef enum {
     SJF = 0,
@@ -40,11 +67,23 @@ typedef struct {
     ExecutionRecord* execution_history;
     int history_size;
     int history_index;
+    GanttHistory* gantt;                // Every execution record, downsampled for the Gantt view
     int total_context_switches;
     time_t last_schedule_time;
     bool scheduler_running;
     pthread_mutex_t scheduler_lock;
-    pthread_cond_t scheduler_cond;
+    pthread_cond_t scheduler_cond;      // Monotonic clock; interrupts timed waits
+    bool preempt_pending;               // Emergency waiting for all-red + green
+    bool preclear_pending;              // Emergency green planned ahead of arrival
+    int preempt_lane;
+    long long preempt_detected_ns;
+    long long preempt_arrival_ns;       // Expected arrival at the stop line
+    int emergency_green_lane;           // Lane held green for an emergency, -1 if none
+    long long emergency_green_ns;       // When that green started
+    int all_red_clearance_ms;
+    int total_preemptions;
+    int total_preclears;
+    LatencyHistogram decision_latency_ns;
 } Scheduler;
 
 void init_scheduler(Scheduler* scheduler, SchedulingAlgorithm algorithm);
@@ -52,14 +91,24 @@ void destroy_scheduler(Scheduler* scheduler);
 void start_scheduler(Scheduler* scheduler);
 void stop_scheduler(Scheduler* scheduler);
 
-int schedule_next_lane_sjf(Scheduler* scheduler, LaneProcess lanes[4]);
-int schedule_next_lane_multilevel(Scheduler* scheduler, LaneProcess lanes[4]);
-int schedule_next_lane_priority_rr(Scheduler* scheduler, LaneProcess lanes[4]);
+void fill_lane_policy_views(LaneProcess* lanes, int num_lanes, LanePolicyView* views);
+int schedule_next_lane_sjf(Scheduler* scheduler, LaneProcess* lanes, int num_lanes);
+int schedule_next_lane_multilevel(Scheduler* scheduler, LaneProcess* lanes, int num_lanes);
+int schedule_next_lane_priority_rr(Scheduler* scheduler, LaneProcess* lanes, int num_lanes);
 
-int schedule_next_lane(Scheduler* scheduler, LaneProcess lanes[4]);
+int schedule_next_lane(Scheduler* scheduler, LaneProcess* lanes, int num_lanes);
 void execute_lane_time_slice(Scheduler* scheduler, LaneProcess* lane, int time_quantum);
 void context_switch(Scheduler* scheduler, LaneProcess* from_lane, LaneProcess* to_lane);
 
+void request_emergency_preemption(Scheduler* scheduler, int lane_id,
+                                  long long detected_ns, long long arrival_ns);
+bool request_emergency_preclear(Scheduler* scheduler, int lane_id,
+                                long long detected_ns, long long arrival_ns);
+void clear_emergency_preemption(Scheduler* scheduler);
+bool is_emergency_green_active(Scheduler* scheduler);
+bool is_emergency_green_for_lane(Scheduler* scheduler, int lane_id, long long* green_since_ns);
+bool scheduler_wait_unless_preempted(Scheduler* scheduler, long long duration_ns);
+
 void set_scheduling_algorithm(Scheduler* scheduler, SchedulingAlgorithm algorithm);
 SchedulingAlgorithm get_scheduling_algorithm(Scheduler* scheduler);
 const char* get_algorithm_name(SchedulingAlgorithm algorithm);
@@ -69,9 +118,9 @@ void record_execution(Scheduler* scheduler, int lane_id, time_t start_time,
 void print_execution_history(Scheduler* scheduler);
 ExecutionRecord* get_execution_history(Scheduler* scheduler, int* count);
 
-float calculate_average_wait_time(Scheduler* scheduler, LaneProcess lanes[4]);
+float calculate_average_wait_time(Scheduler* scheduler, LaneProcess* lanes, int num_lanes);
 float calculate_throughput(Scheduler* scheduler, time_t time_period);
-float calculate_fairness_index(Scheduler* scheduler, LaneProcess lanes[4]);
+float calculate_fairness_index(Scheduler* scheduler, LaneProcess* lanes, int num_lanes);
 int calculate_context_switch_overhead(Scheduler* scheduler);
 
 void add_lane_to_ready_queue(Scheduler* scheduler, LaneProcess* lane);
@@ -0,0 +1,88 @@
+/*
+ * Scheduling Policy - Lane Selection Rules Shared by Live and Replay
+ *
+ * The selection rules of SJF, multilevel feedback and priority round robin
+ * as pure functions over an array of per-lane views. The live schedulers
+ * (sjf_scheduler.c, multilevel_scheduler.c, priority_rr_scheduler.c) fill
+ * the views from the lanes under their locks; the virtual-time replays
+ * (--compare, --replications, --network) fill them from their own queues.
+ * Both paths make one decision per vehicle, so the rules, thresholds and
+ * crossing times below are the only copy.
+ *
+ * Candidates: every ready lane. The lane holding green is a candidate only
+ * when no other lane is ready, so it keeps green for one more vehicle
+ * rather than the intersection idling with vehicles queued.
+ *
+ * - SJF: fewest queued vehicles, ties to the earlier last arrival
+ * - Multilevel: three levels (start at medium). A lane waiting longer than
+ *   MLFQ_PROMOTION_SECONDS moves up one level, one that has sat in its
+ *   level longer than MLFQ_AGING_SECONDS jumps to the top, and one that
+ *   holds green for more than MLFQ_DEMOTION_RUNS decisions in a row moves
+ *   down. The top non-empty level goes first, longest wait within it.
+ * - Priority round robin: emergency lanes, then NORMAL lanes (more than
+ *   RR_NORMAL_QUEUE_LENGTH queued, or unserved for RR_STARVATION_SECONDS),
+ *   then LOW lanes, round robin within each class.
+ *
+ * Time in the views and in MultilevelLaneState is in whole seconds of the
+ * caller's clock (wall clock live, virtual time in a replay).
+ *
+ * Compilation: Include scheduling_policy.h
+ */
+
+#ifndef SCHEDULING_POLICY_H
+#define SCHEDULING_POLICY_H
+
+#include <stdbool.h>
+#include "queue.h"
+#include "intersection_geometry.h"
+
+// Crossing time: uniform in [min, min + spread), heavy vehicles one second more
+#define VEHICLE_CROSS_MIN_MS 2000
+#define VEHICLE_CROSS_SPREAD_MS 2000
+#define HEAVY_VEHICLE_EXTRA_MS 1000
+
+#define MLFQ_LEVELS 3
+#define MLFQ_START_LEVEL 1
+#define MLFQ_PROMOTION_SECONDS 10
+#define MLFQ_DEMOTION_RUNS 5
+#define MLFQ_AGING_SECONDS 15
+
+#define RR_TIME_QUANTUM 3
+#define RR_NORMAL_QUEUE_LENGTH 3
+#define RR_STARVATION_SECONDS 30
+
+typedef enum {
+    RR_CLASS_EMERGENCY = 1,
+    RR_CLASS_NORMAL = 2,
+    RR_CLASS_LOW = 3
+} RoundRobinClass;
+
+// One lane as a scheduling decision sees it
+typedef struct {
+    bool ready;                 // Has a vehicle free to go and does not hold green
+    bool running;               // Holds green with a vehicle free to go
+    bool emergency;             // Emergency priority set on the lane
+    int queue_length;
+    long long last_arrival_ns;  // SJF tie-break
+    long long waiting_seconds;  // Since it became ready or lost green; 0 while green
+    long long idle_seconds;     // Since its last vehicle was served
+} LanePolicyView;
+
+typedef struct {
+    int level;                  // 0 = highest
+    int consecutive_runs;       // Decisions in a row that found it holding green
+    long long level_since;      // Last promotion, seconds
+} MultilevelLaneState;
+
+long long vehicle_crossing_ns(VehicleClass vehicle_class, int spread_ms);
+
+void init_multilevel_lane_states(MultilevelLaneState* levels, int num_lanes, long long now);
+int multilevel_time_quantum(int level);
+RoundRobinClass round_robin_class(const LanePolicyView* lane);
+
+int select_lane_sjf(const LanePolicyView* lanes, int num_lanes);
+int select_lane_multilevel(const LanePolicyView* lanes, int num_lanes, long long now,
+                           MultilevelLaneState* levels, int* quantum);
+int select_lane_priority_rr(const LanePolicyView* lanes, int num_lanes, int* rr_index);
+
+#endif
@@ -0,0 +1,19 @@
+/*
+ * Simulation Clock - Time Sources for Measurement
+ *
+ * Provides monotonic nanosecond timestamps for latency measurement.
+ * time(NULL) is kept for coarse wall-clock bookkeeping; anything that
+ * computes a duration or a percentile should use these instead.
+ */
+
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#define NS_PER_US 1000LL
+#define NS_PER_MS 1000000LL
+#define NS_PER_SEC 1000000000LL
+
+long long monotonic_now_ns();
+void sleep_ns(long long duration_ns);
+
+#endif
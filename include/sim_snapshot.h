@@ -0,0 +1,60 @@
+/*
+ * Simulation Snapshot - Seqlock-Published View of the Simulation
+ *
+ * A compact, versioned copy of what the UI and the metrics endpoint show:
+ * per-lane queue/wait/state, the active algorithm and green lane, the
+ * emergency flag and the aggregate metrics. Writers build a SimSnapshot
+ * under the simulation's own locks and publish it here; readers copy it
+ * with read_sim_snapshot() and retry if a publish overlapped, so they never
+ * take a simulation lock and never see a torn copy.
+ *
+ * Writers (the simulation thread each tick and around each crossing, the
+ * vehicle generator after each arrival) are serialized by a private mutex
+ * that readers never touch, and each captures while holding it
+ * (capture_and_publish_sim_snapshot), so a slow capture cannot overwrite a
+ * newer one. Every publish bumps version, so a reader can skip work when
+ * nothing changed.
+ */
+
+#ifndef SIM_SNAPSHOT_H
+#define SIM_SNAPSHOT_H
+
+#include <stdbool.h>
+#include "lane_process.h"
+#include "scheduler.h"
+
+typedef struct {
+    unsigned long long version;     // Publish count, 0 = nothing published
+    long long published_ns;         // Monotonic time of publication
+    SchedulingAlgorithm algorithm;
+    int current_lane;               // Lane holding green, -1 if none
+    bool emergency_mode;
+    int total_vehicles_generated;
+    int num_lanes;                  // Entries in use in the lane arrays
+    int lane_queue_length[MAX_LANES];
+    int lane_spillback[MAX_LANES];  // Of lane_queue_length, vehicles held upstream
+    int lane_waiting_time[MAX_LANES];
+    LaneState lane_state[MAX_LANES];
+    float vehicles_per_minute;
+    float avg_wait_time;
+    float utilization;
+    float fairness_index;
+    float emergency_response_time;
+    int total_vehicles_processed;
+    int context_switches;
+    int deadlocks_prevented;
+    int queue_overflow_count;
+    int spillback_vehicles;
+    float spillback_delay;          // Total seconds served vehicles spent upstream
+    int simulation_seconds;
+} SimSnapshot;
+
+// Fills a zeroed snapshot from the simulation
+typedef void (*SimSnapshotCapture)(SimSnapshot* snapshot);
+
+void publish_sim_snapshot(const SimSnapshot* snapshot);
+void capture_and_publish_sim_snapshot(SimSnapshotCapture capture);
+bool read_sim_snapshot(SimSnapshot* snapshot);
+unsigned long long get_sim_snapshot_version();
+
+#endif
@@ -10,6 +10,13 @@
  * - release_intersection: Release intersection access and signal waiting lanes
  * - Priority inversion and deadlock handling
  * - Real-time lock holder and acquisition time tracking
+ *
+ * Admission is by quadrant: a lane enters when the quadrants it requested
+ * (LaneProcess.requested_quadrants, a bitmask; 0 means the whole box) do
+ * not overlap those held by other lanes, so non-conflicting movements such
+ * as a right turn and the cross street's through traffic hold the
+ * intersection together. current_lane is the most recently admitted lane
+ * still inside, -1 when the box is empty.
  */
 
 #ifndef SYNCHRONIZATION_H
@@ -21,7 +28,9 @@
 
 typedef struct {
     pthread_mutex_t intersection_lock;
-    pthread_cond_t condition_vars[4];
+    pthread_cond_t condition_vars[MAX_LANES];
+    int lane_holders[MAX_LANES];    // Threads of each lane inside the box
+    int lane_quadrants[MAX_LANES];  // Quadrants each lane holds
     int current_lane;
     pthread_t lock_holder;
     time_t lock_acquisition_time;
@@ -35,6 +44,7 @@ void destroy_intersection_mutex(IntersectionMutex* intersection);
 bool acquire_intersection(LaneProcess* lane);
 bool try_acquire_intersection(LaneProcess* lane);
 void release_intersection(LaneProcess* lane);
+int evict_intersection_holders(int keep_lane);
 bool is_intersection_available(LaneProcess* lane);
 
 void wait_for_lane_signal(LaneProcess* lane);
@@ -45,9 +55,9 @@ void handle_priority_inversion(LaneProcess* high_priority_lane, LaneProcess* low
 void boost_lane_priority(LaneProcess* lane, int new_priority);
 void restore_lane_priority(LaneProcess* lane, int original_priority);
 
-bool detect_deadlock(LaneProcess lanes[4]);
-void resolve_deadlock(LaneProcess lanes[4]);
-bool is_circular_wait_detected(LaneProcess lanes[4]);
+bool detect_deadlock(LaneProcess* lanes, int num_lanes);
+void resolve_deadlock(LaneProcess* lanes, int num_lanes);
+bool is_circular_wait_detected(LaneProcess* lanes, int num_lanes);
 
 int get_current_lane();
 pthread_t get_lock_holder();
@@ -25,6 +25,19 @@
 #include "lane_process.h"
 #include "synchronization.h"
 #include "bankers_algorithm.h"
+#include "latency_histogram.h"
+
+// Acquisition statistics across all strategies (updated atomically)
+typedef struct {
+    long long total_acquisitions;
+    long long successful_acquisitions;
+    long long failed_acquisitions;
+    long long timeouts;
+    long long preemptive_acquisitions;
+    long long total_wait_ns;
+    LatencyHistogram acquire_latency_ns;
+    time_t monitoring_start_time;
+} MutexPerformanceStats;
 
 void init_traffic_mutex_system();
 void reset_traffic_mutex_system();
@@ -32,8 +45,8 @@ void reset_traffic_mutex_system();
 bool acquire_intersection_with_bankers(LaneProcess* lane);
 void release_intersection_with_bankers(LaneProcess* lane);
 
-bool detect_and_resolve_advanced_deadlock(LaneProcess lanes[4]);
-void resolve_advanced_deadlock(LaneProcess lanes[4]);
+bool detect_and_resolve_advanced_deadlock(LaneProcess* lanes, int num_lanes);
+void resolve_advanced_deadlock(LaneProcess* lanes, int num_lanes);
 
 bool acquire_intersection_with_timeout(LaneProcess* lane, int timeout_seconds);
 
@@ -41,13 +54,17 @@ bool acquire_intersection_with_preemption(LaneProcess* lane);
 
 void init_mutex_performance_monitoring();
 void record_mutex_acquisition(bool success, bool timeout, bool preemptive, float wait_time);
+void get_mutex_performance_stats(MutexPerformanceStats* stats);
+const LatencyHistogram* get_mutex_acquire_latency_histogram();
+float get_mutex_average_wait_time(const MutexPerformanceStats* stats);
 void print_mutex_performance_stats();
 
 void set_allocation_strategy(int strategy);
 int get_allocation_strategy();
+const char* get_allocation_strategy_name(int strategy);
 void set_enhanced_mode(bool enabled);
 bool is_enhanced_mode_enabled();
 
-bool acquire_intersection_hybrid(LaneProcess* lane, int needed_quadrants[NUM_QUADRANTS]);
+bool acquire_intersection_hybrid(LaneProcess* lane, int needed_quadrants[MAX_QUADRANTS]);
 
 #endif
\ No newline at end of file
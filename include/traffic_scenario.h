@@ -0,0 +1,102 @@
+/*
+ * Traffic Scenario - Time-of-Day Demand, Turning Ratios and Signal Policy
+ *
+ * A scenario file describes a day of traffic instead of a flat arrival
+ * rate: a demand curve per approach (vehicles per hour at given times of
+ * day), turning ratios per approach, an emergency vehicle rate curve and
+ * the scheduling policy in force over the day. One directive per line,
+ * '#' starts a comment:
+ *
+ *   clock <HH:MM> [<speed>]      Time of day at simulation start, and
+ *                                scenario seconds per simulated second
+ *   interpolate linear|step      Between curve points (default linear)
+ *   geometry <preset|file>       Layout, unless -G is given
+ *   demand <approach|*> <HH:MM> <veh/h> [<HH:MM> <veh/h> ...]
+ *   turns <approach|*> <L|S|R|U> <weight> [...]
+ *   emergency <HH:MM> <veh/h> [...]
+ *   policy <HH:MM> <sjf|multilevel|priority> [...]
+ *
+ * Curves repeat every day: after the last point they run back to the
+ * first. "*" sets every approach without a line of its own. Turning
+ * weights are relative; a movement no lane of the approach carries is
+ * dropped and the rest rescaled.
+ *
+ * The file is parsed once; resolve_traffic_scenario() then bakes it
+ * against the geometry into per-minute tables (total rate, cumulative
+ * approach shares, emergency share, policy) and per-approach movement and
+ * lane tables, so sample_scenario_arrival() does a fixed amount of work
+ * per arrival. Within a minute the rate is constant, so arrivals are an
+ * exact piecewise-Poisson process.
+ */
+
+#ifndef TRAFFIC_SCENARIO_H
+#define TRAFFIC_SCENARIO_H
+
+#include <stdbool.h>
+#include "intersection_geometry.h"
+#include "scheduler.h"
+
+#define SCENARIO_MINUTES 1440
+#define SCENARIO_MAX_POINTS 48
+#define SCENARIO_SHARE_SCALE 65536          // Approach shares are fractions of this
+
+typedef struct {
+    int num_points;
+    short minute[SCENARIO_MAX_POINTS];      // Ascending minute of day
+    float value[SCENARIO_MAX_POINTS];
+} ScenarioCurve;
+
+typedef struct {
+    char approach[GEOMETRY_NAME_LENGTH];    // "*" for every other approach
+    ScenarioCurve demand;
+} ScenarioDemand;
+
+typedef struct {
+    char approach[GEOMETRY_NAME_LENGTH];
+    float weight[NUM_MOVEMENTS];
+} ScenarioTurns;
+
+typedef struct {
+    // As written in the file
+    char name[64];
+    char geometry[128];                     // Empty: the default or -G
+    int clock_start_seconds;
+    float clock_speed;
+    bool step_interpolation;
+    int num_demands;
+    ScenarioDemand demands[MAX_APPROACHES + 1];
+    int num_turns;
+    ScenarioTurns turns[MAX_APPROACHES + 1];
+    ScenarioCurve emergency;
+    ScenarioCurve policy;                   // Values are SchedulingAlgorithm
+
+    // Baked against the geometry by resolve_traffic_scenario()
+    int num_approaches;
+    float total_rate[SCENARIO_MINUTES];     // Vehicles per hour over all approaches
+    float emergency_share[SCENARIO_MINUTES];    // Fraction of arrivals that are emergencies
+    signed char policy_by_minute[SCENARIO_MINUTES];  // -1: no policy
+    unsigned short approach_cumulative[SCENARIO_MINUTES][MAX_APPROACHES];
+    unsigned char turn_cumulative[MAX_APPROACHES][NUM_MOVEMENTS];   // Percent, ends at 100
+    unsigned char movement_lanes[MAX_APPROACHES][NUM_MOVEMENTS][MAX_LANES];
+    unsigned char movement_lane_count[MAX_APPROACHES][NUM_MOVEMENTS];
+} TrafficScenario;
+
+typedef struct {
+    long long gap_ns;           // Simulated time from 'elapsed_ns' to this arrival
+    int lane_id;                // -1: no arrival, just advance by gap_ns
+    VehicleMovement movement;
+    bool emergency;             // The arrival also brings an emergency vehicle
+    int policy;                 // Policy in force at the arrival, -1 if none
+} ScenarioArrival;
+
+bool load_traffic_scenario(TrafficScenario* scenario, const char* path);
+bool resolve_traffic_scenario(TrafficScenario* scenario, const IntersectionGeometry* geometry);
+void set_traffic_scenario(const TrafficScenario* scenario);
+const TrafficScenario* get_traffic_scenario();
+
+void sample_scenario_arrival(const TrafficScenario* scenario, long long elapsed_ns,
+                             unsigned int* seed, ScenarioArrival* arrival);
+int scenario_time_of_day(const TrafficScenario* scenario, long long elapsed_ns);
+void print_traffic_scenario(const TrafficScenario* scenario);
+
+#endif
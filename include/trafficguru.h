@@ -7,13 +7,15 @@
  * performance metrics collection.
  *
  * Key Components:
- * - Lane processes: North, South, East, West traffic lanes
+ * - Lane processes: one per lane of the intersection geometry (four-way by default)
  * - Scheduler: Multiple scheduling algorithms (SJF, Multilevel Feedback, Priority RR)
  * - Synchronization: Intersection mutex and condition variables
  * - Banker's Algorithm: Deadlock prevention for resource allocation
  * - Emergency System: Preemptive handling of emergency vehicles
  * - Performance Metrics: Real-time traffic statistics and analysis
  * - Visualization: Terminal UI with ncurses display
+ * - Logger: Asynchronous file logging off the simulation hot paths
+ * - Mutex Benchmark: Headless contention harness for allocation strategies
  *
  * Author: TrafficGuru Development Team
  * Version: 1.0
@@ -40,17 +42,34 @@
 #include "emergency_system.h"
 #include "visualization.h"
 #include "traffic_mutex.h"
-
-#define NUM_LANES 4
-#define MAX_QUEUE_CAPACITY 20
+#include "logger.h"
+#include "mutex_benchmark.h"
+#include "metrics_exporter.h"
+#include "metrics_endpoint.h"
+#include "vehicle_trace.h"
+#include "algorithm_comparison.h"
+#include "sim_snapshot.h"
+#include "run_arena.h"
+#include "intersection_geometry.h"
+#include "traffic_scenario.h"
+#include "detector_replay.h"
+#include "arrival_process.h"
+#include "checkpoint.h"
+#include "replications.h"
+#include "road_network.h"
+
+#define MAX_QUEUE_CAPACITY 20        // Lane storage; later arrivals spill back upstream
+#define QUEUE_MEMORY_DEFAULT_KB 256  // Cap on the lane queues' shared chunk pool
 #define DEFAULT_TIME_QUANTUM 3
 #define CONTEXT_SWITCH_TIME 500
 #define VEHICLE_CROSS_TIME 3
 #define BATCH_EXIT_SIZE 3
 #define EMERGENCY_PROBABILITY 100
 #define SIMULATION_UPDATE_INTERVAL 300000
+#define METRICS_SAMPLE_INTERVAL_MS 100
 #define SIMULATION_DURATION 200
 
+// Lane ids of the default four-way geometry
 #define LANE_NORTH 0
 #define LANE_SOUTH 1
 #define LANE_EAST 2
@@ -61,7 +80,10 @@
 
 
 typedef struct {
-    LaneProcess lanes[NUM_LANES];
+    LaneProcess* lanes;                 // num_lanes lanes, contiguous, from the arena
+    int num_lanes;
+    RunArena* arena;                    // Run-scoped memory, released at teardown
+    QueueChunkPool* lane_queue_pool;    // Chunks for all lane queues, memory-capped
     Scheduler scheduler;
     IntersectionMutex intersection;
     BankersState bankers_state;
@@ -78,13 +100,17 @@ typedef struct {
     pthread_mutex_t global_state_lock;
     int min_arrival_rate;
     int max_arrival_rate;
+    long long scenario_elapsed_ns;      // Scenario clock, advanced by the generator
+    long long replay_elapsed_ns;        // Detector file time of the last replayed arrival
+    int restored_elapsed_seconds;       // Run time carried over from a checkpoint
     pthread_t vehicle_generator_thread;
+    pthread_t metrics_sampler_thread;
 } TrafficGuruSystem;
 
 extern TrafficGuruSystem* g_traffic_system;
 extern volatile bool keep_running;
 
-void init_traffic_guru_system();
+int init_traffic_guru_system();
 void destroy_traffic_guru_system();
 int start_traffic_simulation();
 void stop_traffic_simulation();
@@ -92,14 +118,12 @@ void pause_traffic_simulation();
 void resume_traffic_simulation();
 
 void* simulation_main_loop(void* arg);
-
-#endif
 void update_simulation_state();
+void* metrics_sampler_loop(void* arg);
+void sample_simulation_metrics();
 void process_traffic_events();
 
-// --- DELETED ---
-// Removed update_visualization_snapshot prototype
-// --- END DELETED ---
+void capture_simulation_snapshot();
 
 // Signal handlers
 void handle_signal_interrupt(int sig);
@@ -116,6 +140,7 @@ bool validate_system_state();
 void set_simulation_duration(int seconds);
 void set_vehicle_arrival_rate(int min_seconds, int max_seconds);
 void set_time_quantum(int seconds);
+void set_queue_memory_limit(int kilobytes);
 void set_debug_mode(bool enabled);
 
 // Logging functions
@@ -130,10 +155,37 @@ typedef struct {
     int min_arrival_rate;
     int max_arrival_rate;
     int time_quantum;
+    int queue_memory_kb;
+    const char* geometry;               // Preset name or geometry file, NULL: scenario's or default
+    const char* scenario;               // Scenario file, NULL: flat -a/-A arrivals
+    const char* replay_file;            // Detector counts to replay, NULL: generated arrivals
+    double replay_speed;
+    bool arrival_process;               // --arrivals given; otherwise uniform -a/-A gaps
+    bool lane_weights;
+    ArrivalProcessConfig arrival_config;
     SchedulingAlgorithm algorithm;
     bool debug_mode;
     bool no_color;
     bool help_requested;
+    const char* log_file;
+    LogLevel log_level;
+    int log_rate_limit;
+    bool bench_mutex;
+    MutexBenchmarkConfig bench_config;
+    MetricsExporterConfig export_config;
+    MetricsEndpointConfig endpoint_config;
+    const char* trace_file;
+    bool compare_algorithms;
+    AlgorithmComparisonConfig compare_config;
+    int replications;                   // --replications: headless Monte Carlo runs, 0 = off
+    double ci_target;                   // Stop once every 95% CI is within this fraction of its mean
+    const char* network_file;           // --network: headless multi-intersection run, NULL = off
+    const char* checkpoint_file;        // Saved at the end, on 'c' and every checkpoint_interval
+    int checkpoint_interval;
+    const char* restore_file;           // Checkpoint to continue from
+    bool duration_given;                // -d, -g and -q override a restored checkpoint
+    bool algorithm_given;
+    bool quantum_given;
 } CommandLineArgs;
 
 CommandLineArgs parse_command_line_args(int argc, char* argv[]);
@@ -0,0 +1,70 @@
+/*
+ * Vehicle Trace - Binary Per-Vehicle Event Trace
+ *
+ * Optional trace of every vehicle's lifecycle (arrival, departure), signal
+ * phases (green start/end per lane) and emergency events, written as
+ * fixed-width records to an append-only file for offline analysis with
+ * trafficguru-trace (tools/trafficguru_trace.c).
+ *
+ * Each thread fills its own buffer without locking; a full buffer is
+ * written with a single write() to a file opened with O_APPEND, so buffers
+ * from different threads never interleave within a record. Records are
+ * therefore grouped by thread, not globally time-ordered; readers sort by
+ * timestamp. When tracing is off, trace_vehicle_event() is one atomic load.
+ *
+ * File layout: TraceFileHeader, then TraceRecord[] to end of file.
+ * All fields are native-endian. The header names the intersection geometry
+ * and its lane count, since lane ids mean nothing without them; version 1
+ * files, which lacked both, are no longer read.
+ */
+
+#ifndef VEHICLE_TRACE_H
+#define VEHICLE_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TRACE_MAGIC "TGTR"
+#define TRACE_VERSION 2
+#define TRACE_GEOMETRY_LENGTH 64
+#define TRACE_BUFFER_RECORDS 512
+#define TRACE_MAX_THREADS 64
+
+typedef enum {
+    TRACE_ARRIVAL = 1,              // vehicle joined lane queue; aux = movement | class << 8
+    TRACE_OVERFLOW = 2,             // vehicle dropped, queue memory cap reached; aux as for arrival
+    TRACE_DEPARTURE = 3,            // vehicle left the queue to cross; aux = movement, value = wait (ms)
+    TRACE_GREEN = 4,                // lane got green; aux = 1 for emergency preemption
+    TRACE_GREEN_END = 5,            // lane lost green
+    TRACE_EMERGENCY_DETECTED = 6,   // aux = EmergencyType, value = approach time (ms)
+    TRACE_EMERGENCY_GREEN = 7,      // aux = 1 if pre-cleared
+    TRACE_EMERGENCY_CLEARED = 8     // aux = EmergencyType, value = detection to clear (ms)
+} TraceEventType;
+
+typedef struct {
+    char magic[4];
+    uint32_t version;
+    uint32_t record_size;
+    uint32_t num_lanes;             // Lanes of the geometry the run used
+    int64_t start_wall_ns;          // CLOCK_REALTIME at trace start
+    int64_t start_monotonic_ns;     // Record timestamps are relative to this
+    char geometry[TRACE_GEOMETRY_LENGTH];   // Its preset name or file path, NUL-terminated
+} TraceFileHeader;
+
+typedef struct {
+    int64_t timestamp_ns;           // Monotonic, relative to start_monotonic_ns
+    int32_t vehicle_id;             // -1 for lane-level events
+    uint8_t type;                   // TraceEventType
+    uint8_t lane_id;
+    uint16_t aux;
+    int32_t value;
+    int32_t reserved;
+} TraceRecord;
+
+int start_vehicle_trace(const char* path);
+void stop_vehicle_trace();
+bool is_vehicle_trace_enabled();
+
+void trace_vehicle_event(TraceEventType type, int vehicle_id, int lane_id, int aux, int value);
+
+#endif
@@ -10,7 +10,8 @@
  * - User input handling (pause, algorithm selection, emergency trigger)
  * - Signal history tracking
  * - Non-blocking input to prevent UI freezing
- * - Deadlock-free mutex usage with trylock instead of lock
+ * - Lock-free reads of the published simulation snapshot
+ * - Frame-diff rendering: only changed cells are redrawn, at an adaptive rate
  *
  * Controls: q=quit, Space=pause, 1-3=algorithm, e=emergency, h=help
  */
@@ -65,7 +66,7 @@ void add_signal_event(SignalHistory* history, int lane_id, int state, time_t tim
 
 void update_signal_display(Visualization* viz, int lane_id, int new_state, time_t timestamp);
 void display_real_time_status_text();
-void display_detailed_intersection_status(Visualization* viz, LaneProcess lanes[4]);
+void display_detailed_intersection_status(Visualization* viz, LaneProcess* lanes, int num_lanes);
 void display_enhanced_metrics_dashboard(Visualization* viz, PerformanceMetrics* metrics, SchedulingAlgorithm current_algo);
 
 #endif
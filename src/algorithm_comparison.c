@@ -0,0 +1,945 @@
+/*
+ * Algorithm Comparison Implementation - Virtual-Time Replays
+ *
+ * Each replication builds one ComparisonTrace (arrival time, lane,
+ * movement, class and crossing time per vehicle) and starts one replay thread per algorithm.
+ * A replay owns its queues, policy state and PerformanceMetrics; the only
+ * thing the threads share is the read-only trace. Each algorithm slot keeps
+ * one RunArena across replications and rewinds it before each, so lane
+ * rings stop costing heap allocations once the first replication has
+ * sized them. A ReplayIntersection is a worker whose trace the caller
+ * extends between advances; the replay loop only consults its hooks.
+ *
+ * Compilation: Include algorithm_comparison.h, scheduling_policy.h,
+ *              vehicle_trace.h, sim_clock.h, run_arena.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/algorithm_comparison.h"
+#include "../include/trafficguru.h"
+#include "../include/vehicle_trace.h"
+#include "../include/sim_clock.h"
+#include "../include/run_arena.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+#include <pthread.h>
+
+#define COMPARE_DETAIL_SEED_MIX 0x5bd1e995u
+
+typedef struct {
+    ReplayVehicle* arrivals;
+    int count;
+    int capacity;
+    unsigned int detail_seed;           // Movements and classes the source does not give
+} ComparisonTrace;
+
+typedef struct {
+    int* vehicles;                      // Ring of trace indices, grown on demand
+    int ring_size;
+    int head;
+    int length;
+    long long last_arrival_ns;
+    long long waiting_since_ns;         // Became non-empty or lost green
+    long long last_service_ns;
+} ReplayLane;
+
+typedef struct {
+    const ComparisonTrace* trace;
+    const AlgorithmComparisonConfig* config;
+    SchedulingAlgorithm algorithm;
+    int num_lanes;
+    ReplayLane lanes[MAX_LANES];
+    RunArena* arena;                    // Lane rings; rewound per replication
+    int next_arrival;
+    int current_lane;                   // Last lane given green
+    bool green_active;                  // current_lane has not emptied since
+    long long now_ns;
+    long long end_ns;
+    long long admit_before_ns;          // Later arrivals wait for the next advance
+    long long busy_ns;
+    MultilevelLaneState mlfq[MAX_LANES];
+    int rr_index;
+    PerformanceMetrics* metrics;
+    const ReplayHooks* hooks;           // NULL outside a network
+    ComparisonRunResult result;
+} ReplayState;
+
+static const char* metric_names[COMPARE_NUM_METRICS] = {
+    "Throughput (veh/min)", "Avg wait (s)", "p95 wait (s)", "Fairness index",
+    "Utilization", "Switches/min", "Spillback (veh)"
+};
+static const bool metric_lower_is_better[COMPARE_NUM_METRICS] = {
+    false, true, true, false, false, true, true
+};
+
+void init_algorithm_comparison_config(AlgorithmComparisonConfig* config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+    config->algorithms[0] = SJF;
+    config->algorithms[1] = MULTILEVEL_FEEDBACK;
+    config->algorithms[2] = PRIORITY_ROUND_ROBIN;
+    config->num_algorithms = COMPARE_MAX_ALGORITHMS;
+    config->seeds = COMPARE_DEFAULT_SEEDS;
+    config->base_seed = 1;
+    config->duration_seconds = SIMULATION_DURATION;
+    config->min_arrival_rate = VEHICLE_ARRIVAL_RATE_MIN;
+    config->max_arrival_rate = VEHICLE_ARRIVAL_RATE_MAX;
+    config->time_quantum = DEFAULT_TIME_QUANTUM;
+    config->trace_file = NULL;
+}
+
+// Parse a comma-separated list of algorithms, e.g. "sjf,multilevel"
+bool parse_comparison_algorithms(const char* list, AlgorithmComparisonConfig* config) {
+    if (!list || !config) {
+        return false;
+    }
+
+    static const struct {
+        const char* name;
+        SchedulingAlgorithm algorithm;
+    } names[] = {
+        {"sjf", SJF}, {"multilevel", MULTILEVEL_FEEDBACK}, {"priority", PRIORITY_ROUND_ROBIN}
+    };
+
+    int count = 0;
+    const char* cursor = list;
+
+    while (*cursor) {
+        size_t length = strcspn(cursor, ",");
+        int match = -1;
+        for (int i = 0; i < 3; i++) {
+            if (strlen(names[i].name) == length && strncmp(cursor, names[i].name, length) == 0) {
+                match = i;
+            }
+        }
+        if (match < 0 || count == COMPARE_MAX_ALGORITHMS) {
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            if (config->algorithms[i] == names[match].algorithm) {
+                return false;
+            }
+        }
+
+        config->algorithms[count++] = names[match].algorithm;
+        cursor += length;
+        if (*cursor == ',') {
+            cursor++;
+        }
+    }
+
+    if (count < 2) {
+        return false;
+    }
+
+    config->num_algorithms = count;
+    return true;
+}
+
+// Queue one arrival; a negative movement or class is drawn as the live
+// generator would, from the trace's detail stream
+static bool append_arrival(ComparisonTrace* trace, long long arrival_ns, int lane_id,
+                           int movement, int vehicle_class) {
+    if (trace->count == trace->capacity) {
+        int capacity = trace->capacity ? trace->capacity * 2 : 1024;
+        ReplayVehicle* grown = realloc(trace->arrivals, (size_t)capacity * sizeof(ReplayVehicle));
+        if (!grown) {
+            return false;
+        }
+        trace->arrivals = grown;
+        trace->capacity = capacity;
+    }
+
+    if (movement < 0) {
+        movement = fit_movement_to_lane(lane_id,
+                                        pick_vehicle_movement(rand_r(&trace->detail_seed) % 100));
+    }
+    if (vehicle_class < 0) {
+        vehicle_class = pick_vehicle_class(rand_r(&trace->detail_seed) % 100);
+    }
+
+    trace->arrivals[trace->count].arrival_ns = arrival_ns;
+    trace->arrivals[trace->count].crossing_ns = 0;
+    trace->arrivals[trace->count].lane_id = lane_id;
+    trace->arrivals[trace->count].movement = (VehicleMovement)movement;
+    trace->arrivals[trace->count].vehicle_class = (VehicleClass)vehicle_class;
+    trace->arrivals[trace->count].tag = -1;
+    trace->arrivals[trace->count].origin_ns = arrival_ns;
+    trace->count++;
+    return true;
+}
+
+// Same arrivals as vehicle_generator_loop(): the scenario's or the arrival
+// process's when one is set, else gaps of whole seconds in [min, max] plus
+// 0-999 ms
+static bool generate_arrival_trace(ComparisonTrace* trace, const AlgorithmComparisonConfig* config,
+                                   unsigned int seed) {
+    long long end_ns = (long long)config->duration_seconds * NS_PER_SEC;
+    int spread = config->max_arrival_rate - config->min_arrival_rate + 1;
+    long long arrival_ns = 0;
+
+    trace->count = 0;
+    trace->detail_seed = seed ^ COMPARE_DETAIL_SEED_MIX;
+    const TrafficScenario* scenario = get_traffic_scenario();
+    if (scenario) {
+        // Scenario demand from its clock start; the policy schedule is not replayed
+        while (arrival_ns < end_ns) {
+            ScenarioArrival arrival;
+            sample_scenario_arrival(scenario, arrival_ns, &seed, &arrival);
+            arrival_ns += arrival.gap_ns;
+            if (arrival.lane_id >= 0 && arrival_ns < end_ns &&
+                !append_arrival(trace, arrival_ns, arrival.lane_id, arrival.movement, -1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    const ArrivalProcessConfig* process_config = get_arrival_process_config();
+    if (process_config) {
+        ArrivalProcess process;
+        init_arrival_process(&process, process_config, get_num_lanes(), seed);
+        int lane_id;
+        while ((arrival_ns = next_process_arrival(&process, &lane_id)) < end_ns) {
+            if (!append_arrival(trace, arrival_ns, lane_id, -1, -1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    while (arrival_ns < end_ns) {
+        if (!append_arrival(trace, arrival_ns, rand_r(&seed) % get_num_lanes(), -1, -1)) {
+            return false;
+        }
+        int gap_seconds = rand_r(&seed) % spread + config->min_arrival_rate;
+        arrival_ns += gap_seconds * NS_PER_SEC + (rand_r(&seed) % 1000) * NS_PER_MS;
+    }
+    return true;
+}
+
+static int compare_arrival_time(const void* a, const void* b) {
+    const ReplayVehicle* left = (const ReplayVehicle*)a;
+    const ReplayVehicle* right = (const ReplayVehicle*)b;
+    return (left->arrival_ns > right->arrival_ns) - (left->arrival_ns < right->arrival_ns);
+}
+
+// Take every arrival attempt (queued or overflowed) from a vehicle trace,
+// with the movement and class it was recorded with
+static bool load_arrival_trace(ComparisonTrace* trace, const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        printf("Cannot open trace file %s\n", path);
+        return false;
+    }
+
+    TraceFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 ||
+        memcmp(header.magic, TRACE_MAGIC, 4) != 0 || header.version != TRACE_VERSION ||
+        header.record_size != sizeof(TraceRecord)) {
+        printf("%s is not a vehicle trace\n", path);
+        fclose(file);
+        return false;
+    }
+    if ((int)header.num_lanes != get_num_lanes()) {
+        printf("%s was recorded on %.*s (%u lanes); run with that geometry (-G)\n",
+               path, TRACE_GEOMETRY_LENGTH, header.geometry, header.num_lanes);
+        fclose(file);
+        return false;
+    }
+
+    TraceRecord records[TRACE_BUFFER_RECORDS];
+    size_t read;
+    trace->count = 0;
+    while ((read = fread(records, sizeof(TraceRecord), TRACE_BUFFER_RECORDS, file)) > 0) {
+        for (size_t i = 0; i < read; i++) {
+            int movement = records[i].aux & 0xff;
+            int vehicle_class = records[i].aux >> 8;
+            if ((records[i].type == TRACE_ARRIVAL || records[i].type == TRACE_OVERFLOW) &&
+                records[i].lane_id < get_num_lanes() &&
+                !append_arrival(trace, records[i].timestamp_ns, records[i].lane_id,
+                                movement < NUM_MOVEMENTS ? movement : -1,
+                                vehicle_class <= VEHICLE_HEAVY ? vehicle_class : -1)) {
+                fclose(file);
+                return false;
+            }
+        }
+    }
+    fclose(file);
+
+    // The writer appends per-thread buffers, so records are not in time order
+    qsort(trace->arrivals, (size_t)trace->count, sizeof(ReplayVehicle), compare_arrival_time);
+    return trace->count > 0;
+}
+
+// Take the detector replay's arrivals that fall before 'end_ns'. Detector
+// data has no movements or classes, so they are drawn once from 'seed'
+static bool load_detector_arrivals(ComparisonTrace* trace, DetectorReplay* replay, long long end_ns,
+                                   unsigned int seed) {
+    DetectorArrival arrival;
+    trace->count = 0;
+    trace->detail_seed = seed ^ COMPARE_DETAIL_SEED_MIX;
+    while (next_detector_arrival(replay, &arrival) && arrival.time_ns < end_ns) {
+        if (!append_arrival(trace, arrival.time_ns, arrival.lane_id, -1, -1)) {
+            return false;
+        }
+    }
+    return trace->count > 0;
+}
+
+// Crossing times come from their own stream so a loaded trace can vary them
+static void assign_crossing_times(ComparisonTrace* trace, unsigned int seed) {
+    for (int i = 0; i < trace->count; i++) {
+        trace->arrivals[i].crossing_ns = vehicle_crossing_ns(trace->arrivals[i].vehicle_class,
+                                                             rand_r(&seed) % VEHICLE_CROSS_SPREAD_MS);
+    }
+}
+
+// Make room for one more vehicle, doubling the ring in the replay's arena
+// (the old ring is left there until the next rewind); false if out of memory
+static bool reserve_lane_slot(RunArena* arena, ReplayLane* lane) {
+    if (lane->length < lane->ring_size) {
+        return true;
+    }
+
+    int size = lane->ring_size ? lane->ring_size * 2 : MAX_QUEUE_CAPACITY * 2;
+    int* vehicles = arena_alloc(arena, (size_t)size * sizeof(int));
+    if (!vehicles) {
+        return false;
+    }
+    for (int i = 0; i < lane->length; i++) {
+        vehicles[i] = lane->vehicles[(lane->head + i) % lane->ring_size];
+    }
+    lane->vehicles = vehicles;
+    lane->ring_size = size;
+    lane->head = 0;
+    return true;
+}
+
+// Queue every arrival up to `until_ns`. Like the live lanes, arrivals past
+// MAX_QUEUE_CAPACITY spill back upstream instead of being dropped
+static void admit_arrivals(ReplayState* state, long long until_ns) {
+    const ComparisonTrace* trace = state->trace;
+
+    while (state->next_arrival < trace->count &&
+           trace->arrivals[state->next_arrival].arrival_ns <= until_ns &&
+           trace->arrivals[state->next_arrival].arrival_ns < state->end_ns &&
+           trace->arrivals[state->next_arrival].arrival_ns < state->admit_before_ns) {
+        const ReplayVehicle* arrival = &trace->arrivals[state->next_arrival];
+        ReplayLane* lane = &state->lanes[arrival->lane_id];
+
+        if (reserve_lane_slot(state->arena, lane)) {
+            lane->vehicles[(lane->head + lane->length) % lane->ring_size] = state->next_arrival;
+            lane->length++;
+            lane->last_arrival_ns = arrival->arrival_ns;
+            if (lane->length == 1) {
+                lane->waiting_since_ns = arrival->arrival_ns;
+            }
+        } else {
+            update_queue_overflow_count(state->metrics);
+        }
+        state->next_arrival++;
+    }
+}
+
+// A lane can be given green when its head vehicle is free to leave
+static bool lane_ready(const ReplayState* state, int lane_id) {
+    const ReplayLane* lane = &state->lanes[lane_id];
+    if (lane->length == 0) {
+        return false;
+    }
+    return !state->hooks || state->hooks->can_depart(state->hooks->context,
+                                                     &state->trace->arrivals[lane->vehicles[lane->head]]);
+}
+
+// Like a live RUNNING lane: given green and not emptied since
+static bool holds_green(const ReplayState* state, int lane_id) {
+    return lane_id == state->current_lane && state->green_active;
+}
+
+static long long lane_waiting_seconds(const ReplayState* state, int lane_id) {
+    const ReplayLane* lane = &state->lanes[lane_id];
+    if (lane->length == 0 || holds_green(state, lane_id)) {
+        return 0;
+    }
+    return (state->now_ns - lane->waiting_since_ns) / NS_PER_SEC;
+}
+
+// The replay's lanes as fill_lane_policy_views() shows the live ones
+static void fill_replay_views(const ReplayState* state, LanePolicyView views[MAX_LANES]) {
+    for (int i = 0; i < state->num_lanes; i++) {
+        const ReplayLane* lane = &state->lanes[i];
+        bool free_to_go = lane_ready(state, i);
+
+        memset(&views[i], 0, sizeof(LanePolicyView));
+        views[i].ready = free_to_go && !holds_green(state, i);
+        views[i].running = free_to_go && holds_green(state, i);
+        views[i].queue_length = lane->length;
+        views[i].last_arrival_ns = lane->last_arrival_ns;
+        views[i].waiting_seconds = lane_waiting_seconds(state, i);
+        views[i].idle_seconds = (state->now_ns - lane->last_service_ns) / NS_PER_SEC;
+    }
+}
+
+static int pick_lane(ReplayState* state, const LanePolicyView views[MAX_LANES]) {
+    switch (state->algorithm) {
+        case MULTILEVEL_FEEDBACK:
+            return select_lane_multilevel(views, state->num_lanes, state->now_ns / NS_PER_SEC,
+                                          state->mlfq, NULL);
+        case PRIORITY_ROUND_ROBIN:
+            return select_lane_priority_rr(views, state->num_lanes, &state->rr_index);
+        case SJF:
+        default:
+            return select_lane_sjf(views, state->num_lanes);
+    }
+}
+
+// Serve the lane's head vehicle, unless the hooks hold it
+static void serve_vehicle(ReplayState* state, int lane_id) {
+    ReplayLane* lane = &state->lanes[lane_id];
+    const ReplayHooks* hooks = state->hooks;
+
+    const ReplayVehicle* vehicle = &state->trace->arrivals[lane->vehicles[lane->head]];
+    if (hooks && !hooks->can_depart(hooks->context, vehicle)) {
+        return;
+    }
+    lane->head = (lane->head + 1) % lane->ring_size;
+    lane->length--;
+    lane->last_service_ns = state->now_ns;
+
+    // The first spilled-back vehicle moves up into the freed storage
+    if (lane->length >= MAX_QUEUE_CAPACITY) {
+        int entering = lane->vehicles[(lane->head + MAX_QUEUE_CAPACITY - 1) % lane->ring_size];
+        record_spillback_delay(state->metrics, lane_id,
+                               state->now_ns - state->trace->arrivals[entering].arrival_ns);
+    }
+
+    record_vehicle_served(state->metrics, lane_id,
+                          (float)((double)(state->now_ns - vehicle->arrival_ns) / NS_PER_SEC));
+    if (hooks) {
+        hooks->depart(hooks->context, vehicle, state->now_ns);
+    }
+    state->now_ns += vehicle->crossing_ns;
+    state->busy_ns += vehicle->crossing_ns;
+    if (hooks) {
+        hooks->cleared(hooks->context, vehicle, state->now_ns);
+    }
+
+    // An emptied lane waits for its next arrival like any other
+    if (lane->length == 0) {
+        state->green_active = false;
+    }
+}
+
+static void begin_replay(ReplayState* state) {
+    state->current_lane = -1;
+    state->end_ns = (long long)state->config->duration_seconds * NS_PER_SEC;
+    state->admit_before_ns = LLONG_MAX;
+    init_multilevel_lane_states(state->mlfq, state->num_lanes, 0);
+}
+
+// Run decisions until virtual time reaches 'until_ns' or the end of the
+// run. As in the live loop, each decision serves at most one vehicle
+static void advance_replay(ReplayState* state, long long until_ns) {
+    if (until_ns > state->end_ns) {
+        until_ns = state->end_ns;
+    }
+
+    while (state->now_ns < until_ns) {
+        admit_arrivals(state, state->now_ns);
+
+        LanePolicyView views[MAX_LANES];
+        fill_replay_views(state, views);
+        int lane_id = pick_lane(state, views);
+        if (lane_id < 0) {
+            // Idle until the next arrival this call may admit
+            long long next_ns = until_ns;
+            if (state->next_arrival < state->trace->count &&
+                state->trace->arrivals[state->next_arrival].arrival_ns < next_ns) {
+                next_ns = state->trace->arrivals[state->next_arrival].arrival_ns;
+            }
+            state->now_ns = next_ns > state->now_ns ? next_ns : state->now_ns;
+            continue;
+        }
+
+        if (lane_id != state->current_lane) {
+            if (state->current_lane >= 0) {
+                state->lanes[state->current_lane].waiting_since_ns = state->now_ns;
+            }
+            state->now_ns += CONTEXT_SWITCH_TIME * NS_PER_MS;
+            state->current_lane = lane_id;
+            update_context_switch_count(state->metrics);
+            admit_arrivals(state, state->now_ns);
+        }
+        state->green_active = true;
+
+        serve_vehicle(state, lane_id);
+    }
+}
+
+static void finish_replay(ReplayState* state) {
+    // Fold the run into the metrics as if it had lasted duration_seconds
+    PerformanceMetrics* metrics = state->metrics;
+    metrics->measurement_start_time = 0;
+    update_time_based_metrics(metrics, (time_t)state->config->duration_seconds);
+
+    double minutes = state->config->duration_seconds / 60.0;
+    ComparisonRunResult* result = &state->result;
+    result->algorithm = state->algorithm;
+    result->vehicles_per_minute = metrics->vehicles_per_minute;
+    result->avg_wait_time = metrics->avg_wait_time;
+    result->p95_wait_time = histogram_percentile(&metrics->wait_time_ms, 95.0) / 1000.0;
+    result->fairness_index = metrics->fairness_index;
+    result->utilization = (double)state->busy_ns / state->end_ns;
+    result->context_switches_per_minute = metrics->context_switches / minutes;
+    result->spillback_vehicles = metrics->spillback_vehicles;
+    result->vehicles_arrived = state->next_arrival;
+    result->vehicles_left_queued = 0;
+    for (int i = 0; i < state->num_lanes; i++) {
+        result->vehicles_left_queued += state->lanes[i].length;
+    }
+}
+
+static void run_replay(ReplayState* state) {
+    begin_replay(state);
+    advance_replay(state, state->end_ns);
+    finish_replay(state);
+}
+
+static void* replay_thread(void* arg) {
+    run_replay((ReplayState*)arg);
+    return NULL;
+}
+
+// One thread's trace, arena and metrics, reused across its replications
+struct ComparisonWorker {
+    ComparisonTrace trace;
+    RunArena* arena;
+    PerformanceMetrics* metrics;
+    ReplayState state;
+};
+
+ComparisonWorker* create_comparison_worker() {
+    ComparisonWorker* worker = calloc(1, sizeof(ComparisonWorker));
+    if (!worker) {
+        return NULL;
+    }
+    worker->arena = create_run_arena(0);
+    if (posix_memalign((void**)&worker->metrics, METRICS_CACHE_LINE_SIZE,
+                       sizeof(PerformanceMetrics)) != 0) {
+        worker->metrics = NULL;
+    }
+    if (!worker->arena || !worker->metrics) {
+        destroy_comparison_worker(worker);
+        return NULL;
+    }
+    return worker;
+}
+
+void destroy_comparison_worker(ComparisonWorker* worker) {
+    if (!worker) {
+        return;
+    }
+    destroy_run_arena(worker->arena);
+    free(worker->metrics);
+    free(worker->trace.arrivals);
+    free(worker);
+}
+
+// Generate the arrivals for 'seed' (as replication 'seed' of --compare
+// would) and replay them against 'algorithm' on the calling thread
+bool run_comparison_replication(ComparisonWorker* worker, const AlgorithmComparisonConfig* config,
+                                SchedulingAlgorithm algorithm, unsigned int seed,
+                                ComparisonRunResult* result) {
+    if (!generate_arrival_trace(&worker->trace, config, seed)) {
+        return false;
+    }
+    assign_crossing_times(&worker->trace, seed ^ 0x9e3779b9u);
+
+    ReplayState* state = &worker->state;
+    memset(state, 0, sizeof(ReplayState));
+    reset_run_arena(worker->arena);
+    state->arena = worker->arena;
+    state->num_lanes = get_num_lanes();
+    state->trace = &worker->trace;
+    state->config = config;
+    state->algorithm = algorithm;
+    state->metrics = worker->metrics;
+    init_performance_metrics(worker->metrics);
+
+    run_replay(state);
+    *result = state->result;
+    destroy_performance_metrics(worker->metrics);
+    return true;
+}
+
+// A worker whose arrivals come from the caller, one window at a time
+struct ReplayIntersection {
+    ComparisonWorker* worker;
+    ReplayHooks hooks;
+    unsigned int crossing_seed;
+};
+
+ReplayIntersection* create_replay_intersection(const AlgorithmComparisonConfig* config,
+                                               SchedulingAlgorithm algorithm,
+                                               unsigned int crossing_seed, const ReplayHooks* hooks) {
+    if (!config || !hooks) {
+        return NULL;
+    }
+
+    ReplayIntersection* intersection = calloc(1, sizeof(ReplayIntersection));
+    if (!intersection) {
+        return NULL;
+    }
+    intersection->worker = create_comparison_worker();
+    if (!intersection->worker) {
+        free(intersection);
+        return NULL;
+    }
+    intersection->hooks = *hooks;
+    intersection->crossing_seed = crossing_seed;
+
+    ReplayState* state = &intersection->worker->state;
+    state->arena = intersection->worker->arena;
+    state->num_lanes = get_num_lanes();
+    state->trace = &intersection->worker->trace;
+    state->config = config;
+    state->algorithm = algorithm;
+    state->metrics = intersection->worker->metrics;
+    state->hooks = &intersection->hooks;
+    init_performance_metrics(state->metrics);
+    begin_replay(state);
+    return intersection;
+}
+
+void destroy_replay_intersection(ReplayIntersection* intersection) {
+    if (!intersection) {
+        return;
+    }
+    destroy_performance_metrics(intersection->worker->metrics);
+    destroy_comparison_worker(intersection->worker);
+    free(intersection);
+}
+
+// Queue one arrival; arrivals must come in time order. The crossing time is
+// drawn here, from the intersection's own stream
+bool add_replay_arrival(ReplayIntersection* intersection, const ReplayVehicle* vehicle) {
+    ComparisonTrace* trace = &intersection->worker->trace;
+    if (vehicle->lane_id < 0 || vehicle->lane_id >= get_num_lanes() ||
+        (trace->count > 0 && vehicle->arrival_ns < trace->arrivals[trace->count - 1].arrival_ns) ||
+        !append_arrival(trace, vehicle->arrival_ns, vehicle->lane_id, vehicle->movement,
+                        vehicle->vehicle_class)) {
+        return false;
+    }
+
+    ReplayVehicle* added = &trace->arrivals[trace->count - 1];
+    *added = *vehicle;
+    added->crossing_ns = vehicle_crossing_ns(vehicle->vehicle_class,
+                                             rand_r(&intersection->crossing_seed) % VEHICLE_CROSS_SPREAD_MS);
+    return true;
+}
+
+// Replay up to 'until_ns'. Only arrivals before 'until_ns' are admitted, so
+// the caller may still add any arrival from 'until_ns' on
+void advance_replay_intersection(ReplayIntersection* intersection, long long until_ns) {
+    ReplayState* state = &intersection->worker->state;
+    state->admit_before_ns = until_ns;
+    advance_replay(state, until_ns);
+}
+
+void finish_replay_intersection(ReplayIntersection* intersection, ComparisonRunResult* result) {
+    ReplayState* state = &intersection->worker->state;
+    finish_replay(state);
+    *result = state->result;
+}
+
+const char* get_comparison_metric_name(int metric) {
+    return metric >= 0 && metric < COMPARE_NUM_METRICS ? metric_names[metric] : "";
+}
+
+double get_comparison_metric(const ComparisonRunResult* result, int metric) {
+    switch (metric) {
+        case 0: return result->vehicles_per_minute;
+        case 1: return result->avg_wait_time;
+        case 2: return result->p95_wait_time;
+        case 3: return result->fairness_index;
+        case 4: return result->utilization;
+        case 5: return result->context_switches_per_minute;
+        default: return result->spillback_vehicles;
+    }
+}
+
+// Two-sided 95% Student-t quantile for `df` degrees of freedom. Past 40
+// it is interpolated linearly in 1/df between tabulated points and
+// rounded up to the table's three decimals, so a confidence interval is
+// never narrower than the exact quantile gives
+double t_quantile_95(int df) {
+    static const double table[] = {
+        0.0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+        2.040, 2.037, 2.035, 2.032, 2.030, 2.028, 2.026, 2.024, 2.023, 2.021
+    };
+    // df, quantile; the last point is df = infinity (1/df = 0)
+    static const double tail[][2] = {
+        {40, 2.021}, {60, 2.000}, {120, 1.980}, {0, 1.960}
+    };
+
+    if (df <= 0) {
+        return 0.0;
+    }
+    if (df <= 40) {
+        return table[df];
+    }
+
+    double x = 1.0 / df;
+    for (int i = 1; i < (int)(sizeof(tail) / sizeof(tail[0])); i++) {
+        double lower = tail[i][0] > 0 ? 1.0 / tail[i][0] : 0.0;
+        if (x >= lower) {
+            double upper = 1.0 / tail[i - 1][0];
+            double t = tail[i][1] + (tail[i - 1][1] - tail[i][1]) * (x - lower) / (upper - lower);
+            return ceil(t * 1000.0 - 1e-9) / 1000.0;
+        }
+    }
+    return 1.960;
+}
+
+// Sample mean and 95% confidence half-width
+static void mean_confidence(const double* values, int count, double* mean, double* half_width) {
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += values[i];
+    }
+    *mean = count > 0 ? sum / count : 0.0;
+
+    double squares = 0.0;
+    for (int i = 0; i < count; i++) {
+        squares += (values[i] - *mean) * (values[i] - *mean);
+    }
+    *half_width = count > 1 ? t_quantile_95(count - 1) * sqrt(squares / (count - 1) / count) : 0.0;
+}
+
+static void print_comparison_report(const AlgorithmComparisonConfig* config,
+                                    ComparisonRunResult* results[COMPARE_MAX_ALGORITHMS]) {
+    int seeds = config->seeds;
+    double* values = malloc((size_t)seeds * sizeof(double));
+    if (!values) {
+        return;
+    }
+
+    printf("\n%-22s", "Mean, 95% CI");
+    for (int a = 0; a < config->num_algorithms; a++) {
+        printf(" %28s", get_algorithm_name(config->algorithms[a]));
+    }
+    printf("\n");
+
+    for (int m = 0; m < COMPARE_NUM_METRICS; m++) {
+        printf("%-22s", metric_names[m]);
+        for (int a = 0; a < config->num_algorithms; a++) {
+            double mean, half_width;
+            for (int s = 0; s < seeds; s++) {
+                values[s] = get_comparison_metric(&results[a][s], m);
+            }
+            mean_confidence(values, seeds, &mean, &half_width);
+            printf("   %13.3f ± %-10.3f", mean, half_width);
+        }
+        printf("\n");
+    }
+
+    // Paired differences: both algorithms saw the same arrivals in each seed
+    for (int a = 1; a < config->num_algorithms; a++) {
+        printf("\n%s - %s (paired, 95%% CI):\n", get_algorithm_name(config->algorithms[a]),
+               get_algorithm_name(config->algorithms[0]));
+        for (int m = 0; m < COMPARE_NUM_METRICS; m++) {
+            double mean, half_width;
+            for (int s = 0; s < seeds; s++) {
+                values[s] = get_comparison_metric(&results[a][s], m) -
+                            get_comparison_metric(&results[0][s], m);
+            }
+            mean_confidence(values, seeds, &mean, &half_width);
+
+            const char* verdict = "no significant difference";
+            if (mean - half_width > 0 || mean + half_width < 0) {
+                bool higher = mean > 0;
+                verdict = higher != metric_lower_is_better[m] ? "better" : "worse";
+            }
+            printf("  %-22s %+10.3f  [%+10.3f, %+10.3f]  %s\n", metric_names[m], mean,
+                   mean - half_width, mean + half_width, verdict);
+        }
+    }
+
+    free(values);
+}
+
+// Replay every configured algorithm on `seeds` shared arrival traces and report
+int run_algorithm_comparison(const AlgorithmComparisonConfig* requested) {
+    if (!requested || requested->num_algorithms < 2 || requested->seeds <= 0 ||
+        requested->seeds > COMPARE_MAX_SEEDS) {
+        return -1;
+    }
+
+    AlgorithmComparisonConfig run_config = *requested;
+    const AlgorithmComparisonConfig* config = &run_config;
+
+    ComparisonTrace trace = {0};
+    DetectorReplay* replay = get_detector_replay();
+    if (config->trace_file || replay) {
+        bool loaded = replay ? load_detector_arrivals(&trace, replay,
+                                                      (long long)config->duration_seconds * NS_PER_SEC,
+                                                      config->base_seed)
+                             : load_arrival_trace(&trace, config->trace_file);
+        if (!loaded) {
+            if (replay) {
+                printf("%s: no detector arrivals in the first %d s\n", replay->path,
+                       config->duration_seconds);
+            }
+            free(trace.arrivals);
+            return -1;
+        }
+        // Rates are per minute of replay, so don't run past the recorded arrivals
+        int span_seconds = (int)(trace.arrivals[trace.count - 1].arrival_ns / NS_PER_SEC) + 1;
+        if (span_seconds < run_config.duration_seconds) {
+            run_config.duration_seconds = span_seconds;
+        }
+    }
+
+    ComparisonRunResult* results[COMPARE_MAX_ALGORITHMS] = {0};
+    PerformanceMetrics* first_metrics[COMPARE_MAX_ALGORITHMS] = {0};
+    RunArena* arenas[COMPARE_MAX_ALGORITHMS] = {0};
+    ReplayState* states = calloc(config->num_algorithms, sizeof(ReplayState));
+    int failures = 0;
+
+    for (int a = 0; a < config->num_algorithms; a++) {
+        results[a] = calloc(config->seeds, sizeof(ComparisonRunResult));
+        // Cache-line aligned: the metric shards are declared aligned
+        if (posix_memalign((void**)&first_metrics[a], METRICS_CACHE_LINE_SIZE,
+                           sizeof(PerformanceMetrics)) != 0) {
+            first_metrics[a] = NULL;
+        }
+        arenas[a] = create_run_arena(0);
+        if (!results[a] || !first_metrics[a] || !arenas[a]) {
+            failures++;
+        }
+    }
+    if (!states || failures) {
+        printf("Out of memory for the comparison\n");
+        for (int a = 0; a < config->num_algorithms; a++) {
+            free(results[a]);
+            free(first_metrics[a]);
+            destroy_run_arena(arenas[a]);
+        }
+        free(states);
+        free(trace.arrivals);
+        return -1;
+    }
+
+    printf("=== ALGORITHM COMPARISON ===\n");
+    if (replay) {
+        printf("Arrivals: %d from detector file %s (%lld records, %lld skipped), "
+               "crossing times redrawn per seed\n",
+               trace.count, replay->path, replay->records, replay->skipped);
+    } else if (config->trace_file) {
+        printf("Arrivals: %d from %s, crossing times redrawn per seed\n",
+               trace.count, config->trace_file);
+    } else if (get_arrival_process_config()) {
+        char description[128];
+        format_arrival_process(get_arrival_process_config(), description, sizeof(description));
+        printf("Arrivals: %s, shared by all algorithms per seed\n", description);
+    } else if (get_traffic_scenario()) {
+        printf("Arrivals: generated from scenario %s, shared by all algorithms per seed\n",
+               get_traffic_scenario()->name);
+    } else {
+        printf("Arrivals: generated, %d-%d s apart, shared by all algorithms per seed\n",
+               config->min_arrival_rate, config->max_arrival_rate);
+    }
+    printf("Replications: %d x %d s virtual time, baseline: %s\n", config->seeds,
+           config->duration_seconds, get_algorithm_name(config->algorithms[0]));
+
+    long long start_ns = monotonic_now_ns();
+    long long steady_allocations = 0;
+    PerformanceMetrics* metrics = NULL;
+    if (posix_memalign((void**)&metrics, METRICS_CACHE_LINE_SIZE,
+                       config->num_algorithms * sizeof(PerformanceMetrics)) != 0) {
+        metrics = NULL;
+        failures++;
+    }
+
+    for (int s = 0; s < config->seeds && !failures; s++) {
+        unsigned int seed = config->base_seed + (unsigned int)s * 7919u;
+        if (!config->trace_file && !replay && !generate_arrival_trace(&trace, config, seed)) {
+            failures++;
+            break;
+        }
+        assign_crossing_times(&trace, seed ^ 0x9e3779b9u);
+
+        pthread_t threads[COMPARE_MAX_ALGORITHMS];
+        bool started[COMPARE_MAX_ALGORITHMS];
+        for (int a = 0; a < config->num_algorithms; a++) {
+            memset(&states[a], 0, sizeof(ReplayState));
+            reset_run_arena(arenas[a]);
+            states[a].arena = arenas[a];
+            states[a].num_lanes = get_num_lanes();
+            states[a].trace = &trace;
+            states[a].config = config;
+            states[a].algorithm = config->algorithms[a];
+            states[a].metrics = &metrics[a];
+            init_performance_metrics(&metrics[a]);
+
+            started[a] = pthread_create(&threads[a], NULL, replay_thread, &states[a]) == 0;
+            if (!started[a]) {
+                run_replay(&states[a]);     // No thread available: replay inline
+            }
+        }
+
+        for (int a = 0; a < config->num_algorithms; a++) {
+            if (started[a]) {
+                pthread_join(threads[a], NULL);
+            }
+            results[a][s] = states[a].result;
+            if (s == 0) {
+                memcpy(first_metrics[a], &metrics[a], sizeof(PerformanceMetrics));
+            }
+            destroy_performance_metrics(&metrics[a]);
+        }
+
+        // The first replication sizes the arenas; the rest should reuse them
+        if (s == 0) {
+            mark_run_allocations_steady();
+        } else {
+            RunAllocationStats allocations;
+            get_run_allocation_stats(&allocations);
+            steady_allocations = allocations.steady_heap_allocations;
+        }
+    }
+
+    if (!failures) {
+        printf("Completed in %.2f s (arena allocations after the first replication: %lld)\n",
+               (double)(monotonic_now_ns() - start_ns) / NS_PER_SEC, steady_allocations);
+        if (config->seeds > 1) {
+            print_comparison_report(config, results);
+        } else {
+            for (int a = 1; a < config->num_algorithms; a++) {
+                compare_algorithm_performance(first_metrics[0], first_metrics[a],
+                                              get_algorithm_name(config->algorithms[0]),
+                                              get_algorithm_name(config->algorithms[a]));
+            }
+        }
+        printf("============================\n");
+    }
+
+    for (int a = 0; a < config->num_algorithms; a++) {
+        free(results[a]);
+        free(first_metrics[a]);
+        destroy_run_arena(arenas[a]);
+    }
+    free(metrics);
+    free(states);
+    free(trace.arrivals);
+    return failures == 0 ? 0 : -1;
+}
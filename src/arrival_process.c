@@ -0,0 +1,315 @@
+/*
+ * Arrival Process Implementation - Per-Lane Streams Refilled in Batches
+ *
+ * A refill draws the whole batch of unit exponentials first (no
+ * dependencies between iterations), then walks them once to place the
+ * arrival times: scaled by the lane's mean gap for Poisson, spent against
+ * the current rate across state changes for MMPP (exact, as the
+ * exponential is memoryless), or used to size platoons.
+ *
+ * Compilation: Include arrival_process.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/arrival_process.h"
+#include "../include/sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <limits.h>
+
+#define SECONDS_PER_HOUR 3600.0
+
+static ArrivalProcessConfig g_config;
+static bool config_active = false;
+
+// xorshift64*: a few cycles a draw and independent per lane
+static inline unsigned long long next_random(unsigned long long* state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+// Uniform on (0, 1], so the logarithm is finite
+static inline double next_uniform(unsigned long long* state) {
+    return ((next_random(state) >> 11) + 1) * 0x1.0p-53;
+}
+
+// Uniforms first, then the logarithms in a loop that carries no state
+// between iterations
+static void fill_unit_exponentials(unsigned long long* state, double* units, int count) {
+    for (int i = 0; i < count; i++) {
+        units[i] = next_uniform(state);
+    }
+    for (int i = 0; i < count; i++) {
+        units[i] = -log(units[i]);
+    }
+}
+
+// Comma-separated numbers after "name:"; returns how many were read
+static int parse_numbers(const char* text, double* values, int max_values) {
+    int count = 0;
+    while (count < max_values) {
+        char* end;
+        values[count] = strtod(text, &end);
+        if (end == text) {
+            return -1;
+        }
+        count++;
+        if (*end == '\0') {
+            return count;
+        }
+        if (*end != ',') {
+            return -1;
+        }
+        text = end + 1;
+    }
+    return -1;
+}
+
+bool parse_arrival_process(const char* spec, ArrivalProcessConfig* config) {
+    const char* colon = strchr(spec, ':');
+    if (!colon) {
+        return false;
+    }
+    size_t name_length = (size_t)(colon - spec);
+    double values[4];
+    int count = parse_numbers(colon + 1, values, 4);
+
+    memset(config->lane_shares, 0, sizeof(config->lane_shares));
+    config->headway_seconds = ARRIVAL_DEFAULT_HEADWAY;
+    if (name_length == 7 && strncmp(spec, "poisson", 7) == 0 && count == 1) {
+        config->type = ARRIVAL_POISSON;
+        config->rate = values[0];
+        return config->rate > 0;
+    }
+    if (name_length == 4 && strncmp(spec, "mmpp", 4) == 0 && count == 4) {
+        config->type = ARRIVAL_MMPP;
+        config->rate = values[0];
+        config->burst_rate = values[1];
+        config->calm_seconds = values[2];
+        config->burst_seconds = values[3];
+        return config->rate >= 0 && config->burst_rate > 0 &&
+               config->calm_seconds > 0 && config->burst_seconds > 0;
+    }
+    if (name_length == 7 && strncmp(spec, "platoon", 7) == 0 && (count == 2 || count == 3)) {
+        config->type = ARRIVAL_PLATOON;
+        config->rate = values[0];
+        config->cycle_seconds = values[1];
+        if (count == 3) {
+            config->headway_seconds = values[2];
+        }
+        return config->rate > 0 && config->cycle_seconds > 0 && config->headway_seconds > 0;
+    }
+    return false;
+}
+
+bool parse_lane_weights(const char* list, ArrivalProcessConfig* config) {
+    int count = parse_numbers(list, config->lane_weights, MAX_LANES);
+    if (count <= 0) {
+        return false;
+    }
+    for (int i = 0; i < count; i++) {
+        if (config->lane_weights[i] < 0) {
+            return false;
+        }
+    }
+    config->num_weights = count;
+    return true;
+}
+
+// Share the junction rate between the geometry's lanes
+bool resolve_arrival_process(ArrivalProcessConfig* config, int num_lanes) {
+    if (config->num_weights && config->num_weights != num_lanes) {
+        printf("--lane-weights lists %d weights, the geometry has %d lanes\n",
+               config->num_weights, num_lanes);
+        return false;
+    }
+
+    double total = 0;
+    for (int l = 0; l < num_lanes; l++) {
+        total += config->num_weights ? config->lane_weights[l] : 1.0;
+    }
+    if (total <= 0) {
+        printf("--lane-weights closes every lane\n");
+        return false;
+    }
+    for (int l = 0; l < num_lanes; l++) {
+        config->lane_shares[l] = (config->num_weights ? config->lane_weights[l] : 1.0) / total;
+    }
+    return true;
+}
+
+void format_arrival_process(const ArrivalProcessConfig* config, char* buffer, size_t size) {
+    switch (config->type) {
+        case ARRIVAL_MMPP:
+            snprintf(buffer, size, "MMPP %.0f/%.0f veh/h, %.0f s calm, %.0f s bursts",
+                     config->rate, config->burst_rate, config->calm_seconds, config->burst_seconds);
+            break;
+        case ARRIVAL_PLATOON:
+            snprintf(buffer, size, "platoons %.0f veh/h, %.0f s cycle, %.1f s headway",
+                     config->rate, config->cycle_seconds, config->headway_seconds);
+            break;
+        default:
+            snprintf(buffer, size, "Poisson %.0f veh/h", config->rate);
+            break;
+    }
+}
+
+void set_arrival_process_config(const ArrivalProcessConfig* config) {
+    if (config) {
+        g_config = *config;
+    }
+    config_active = config != NULL;
+}
+
+// NULL when the generator uses its uniform gaps
+const ArrivalProcessConfig* get_arrival_process_config() {
+    return config_active ? &g_config : NULL;
+}
+
+// Knuth's method on exponentials: how many unit-rate arrivals fit in 'mean'
+static int draw_poisson_count(unsigned long long* state, double mean) {
+    int count = 0;
+    double elapsed = -log(next_uniform(state));
+    while (elapsed < mean) {
+        count++;
+        elapsed -= log(next_uniform(state));
+    }
+    return count;
+}
+
+static void refill_poisson(ArrivalStream* stream) {
+    double units[ARRIVAL_BATCH];
+    fill_unit_exponentials(&stream->rng, units, ARRIVAL_BATCH);
+    long long clock_ns = stream->clock_ns;
+    for (int i = 0; i < ARRIVAL_BATCH; i++) {
+        clock_ns += (long long)(units[i] * stream->calm_gap_ns);
+        stream->times[i] = clock_ns;
+    }
+    stream->clock_ns = clock_ns;
+}
+
+// Spend each unit exponential against the current rate; at a state change
+// the unspent part carries over at the new rate
+static void refill_mmpp(ArrivalStream* stream, const ArrivalProcessConfig* config) {
+    double units[ARRIVAL_BATCH];
+    fill_unit_exponentials(&stream->rng, units, ARRIVAL_BATCH);
+    double clock_ns = (double)stream->clock_ns;
+    for (int i = 0; i < ARRIVAL_BATCH; i++) {
+        double work = units[i];
+        for (;;) {
+            double gap_ns = stream->in_burst ? stream->burst_gap_ns : stream->calm_gap_ns;
+            if (gap_ns > 0 && clock_ns + work * gap_ns <= (double)stream->switch_ns) {
+                clock_ns += work * gap_ns;
+                break;
+            }
+            if (gap_ns > 0) {
+                work -= ((double)stream->switch_ns - clock_ns) / gap_ns;
+            }
+            clock_ns = (double)stream->switch_ns;
+            stream->in_burst = !stream->in_burst;
+            double mean_seconds = stream->in_burst ? config->burst_seconds : config->calm_seconds;
+            stream->switch_ns += (long long)(-log(next_uniform(&stream->rng)) * mean_seconds * NS_PER_SEC);
+        }
+        stream->times[i] = (long long)clock_ns;
+    }
+    stream->clock_ns = (long long)clock_ns;
+}
+
+// One platoon per upstream cycle; a platoon longer than the cycle pushes
+// the next one back
+static void refill_platoon(ArrivalStream* stream, const ArrivalProcessConfig* config) {
+    long long cycle_ns = (long long)(config->cycle_seconds * NS_PER_SEC);
+    long long headway_ns = (long long)(config->headway_seconds * NS_PER_SEC);
+    double mean_platoon = config->cycle_seconds * NS_PER_SEC / stream->calm_gap_ns;
+
+    for (int i = 0; i < ARRIVAL_BATCH; i++) {
+        while (stream->platoon_left == 0) {
+            stream->cycle_start_ns += cycle_ns;
+            stream->platoon_left = draw_poisson_count(&stream->rng, mean_platoon);
+            long long release_ns = stream->cycle_start_ns + stream->offset_ns;
+            if (stream->platoon_left > 0 && release_ns > stream->clock_ns) {
+                stream->clock_ns = release_ns - headway_ns;
+            }
+        }
+        stream->clock_ns += headway_ns;
+        stream->times[i] = stream->clock_ns;
+        stream->platoon_left--;
+    }
+}
+
+static void refill_stream(ArrivalStream* stream, const ArrivalProcessConfig* config) {
+    switch (config->type) {
+        case ARRIVAL_MMPP:
+            refill_mmpp(stream, config);
+            break;
+        case ARRIVAL_PLATOON:
+            refill_platoon(stream, config);
+            break;
+        default:
+            refill_poisson(stream);
+            break;
+    }
+    stream->next = 0;
+}
+
+// 'config' must have been resolved for 'num_lanes' and outlive the process
+void init_arrival_process(ArrivalProcess* process, const ArrivalProcessConfig* config,
+                          int num_lanes, unsigned long long seed) {
+    memset(process, 0, sizeof(ArrivalProcess));
+    process->config = config;
+    process->num_lanes = num_lanes;
+
+    for (int l = 0; l < num_lanes; l++) {
+        ArrivalStream* stream = &process->streams[l];
+        double share = config->lane_shares[l];
+        if (share <= 0) {
+            stream->times[0] = LLONG_MAX;   // Closed lane, never the earliest
+            continue;
+        }
+
+        // splitmix-style spreading so neighbouring seeds give unrelated lanes
+        stream->rng = (seed + (unsigned long long)(l + 1) * 0x9E3779B97F4A7C15ULL) | 1;
+        next_random(&stream->rng);
+
+        double ns_per_hour = SECONDS_PER_HOUR * NS_PER_SEC;
+        stream->calm_gap_ns = config->rate > 0 ? ns_per_hour / (config->rate * share) : 0;
+        stream->burst_gap_ns = ns_per_hour / (config->burst_rate > 0 ? config->burst_rate * share : 1);
+        if (config->type == ARRIVAL_MMPP) {
+            // Start in each state in proportion to the time spent there
+            double calm_fraction = config->calm_seconds / (config->calm_seconds + config->burst_seconds);
+            stream->in_burst = next_uniform(&stream->rng) > calm_fraction;
+            double mean_seconds = stream->in_burst ? config->burst_seconds : config->calm_seconds;
+            stream->switch_ns = (long long)(-log(next_uniform(&stream->rng)) * mean_seconds * NS_PER_SEC);
+        } else if (config->type == ARRIVAL_PLATOON) {
+            long long cycle_ns = (long long)(config->cycle_seconds * NS_PER_SEC);
+            stream->offset_ns = (long long)(next_uniform(&stream->rng) * cycle_ns);
+            stream->cycle_start_ns = -cycle_ns;
+        }
+        refill_stream(stream, config);
+    }
+}
+
+// Next arrival over all lanes, in ns from the start of the process
+long long next_process_arrival(ArrivalProcess* process, int* lane_id) {
+    // A select rather than a branch, as the winning lane is unpredictable
+    int best = 0;
+    long long best_ns = LLONG_MAX;
+    for (int l = 0; l < process->num_lanes; l++) {
+        const ArrivalStream* stream = &process->streams[l];
+        long long head_ns = stream->times[stream->next];
+        bool earlier = head_ns < best_ns;
+        best = earlier ? l : best;
+        best_ns = earlier ? head_ns : best_ns;
+    }
+
+    ArrivalStream* stream = &process->streams[best];
+    if (++stream->next == ARRIVAL_BATCH) {
+        refill_stream(stream, process->config);
+    }
+    *lane_id = best;
+    return best_ns;
+}
@@ -10,10 +10,11 @@
  * - Run safety algorithm to check if all lanes can finish
  * - Rollback if unsafe, confirm if safe
  *
- * Compilation: Include bankers_algorithm.h, lane_process.h
+ * Compilation: Include bankers_algorithm.h, lane_process.h, intersection_geometry.h
  */
 
 #include "../include/bankers_algorithm.h"
+#include "../include/logger.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,7 +24,12 @@ static BankersState g_bankers_state = {0};
 static bool bankers_initialized = false;
 
 static bool is_safe_state_unlocked(BankersState* state);
-static bool safety_algorithm_unlocked(BankersState* state, bool finish[NUM_LANES]);
+static bool safety_algorithm_unlocked(BankersState* state, bool finish[MAX_LANES]);
+static void add_movement_quadrants(int lane_id, VehicleMovement movement,
+                                   int quadrants[MAX_QUADRANTS]);
+static bool request_within_claim_unlocked(BankersState* state, int lane_id,
+                                          int request[MAX_QUADRANTS]);
+static void restore_standing_claim_unlocked(BankersState* state, int lane_id);
 
 
 // Initialize Banker's algorithm state
@@ -32,16 +38,25 @@ void init_bankers_state(BankersState* state) {
         return;
     }
 
+    const IntersectionGeometry* geometry = get_intersection_geometry();
+    memset(state->available, 0, sizeof(state->available));
+    memset(state->maximum, 0, sizeof(state->maximum));
+    state->num_lanes = geometry->num_lanes;
+    state->num_quadrants = geometry->num_quadrants;
+
     // Initialize all intersection quadrants as available
-    for (int i = 0; i < NUM_QUADRANTS; i++) {
+    for (int i = 0; i < state->num_quadrants; i++) {
         state->available[i] = 1; // Each quadrant available once
     }
 
-    // Initialize maximum claims for each lane
-    for (int lane = 0; lane < NUM_LANES; lane++) {
-        for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
-            // Each lane may need up to 2 quadrants (for turning)
-            state->maximum[lane][quad] = (quad % 2 == lane % 2) ? 1 : 0;
+    // Initialize maximum claims for each lane: the standing claim of
+    // calculate_maximum_quadrants (a U-turn is claimed per request)
+    for (int lane = 0; lane < state->num_lanes; lane++) {
+        int claim[MAX_QUADRANTS];
+        calculate_maximum_quadrants(lane, claim);
+
+        for (int quad = 0; quad < state->num_quadrants; quad++) {
+            state->maximum[lane][quad] = claim[quad];
             state->allocation[lane][quad] = 0;
             state->need[lane][quad] = state->maximum[lane][quad];
         }
@@ -79,33 +94,32 @@ BankersState* get_global_bankers_state() {
 }
 
 // Core Banker's algorithm: request resources
-bool request_resources(BankersState* state, int lane_id, int request[NUM_QUADRANTS]) {
-    if (!state || lane_id < 0 || lane_id >= NUM_LANES || !request) {
+bool request_resources(BankersState* state, int lane_id, int request[MAX_QUADRANTS]) {
+    if (!state || lane_id < 0 || lane_id >= state->num_lanes || !request) {
         return false;
     }
 
     pthread_mutex_lock(&state->resource_lock);
 
     // Step 1: Check if request <= need for the lane
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
-        if (request[quad] > state->need[lane_id][quad]) {
-            printf("Lane %d request exceeds maximum claim for quadrant %d\n", lane_id, quad);
-            pthread_mutex_unlock(&state->resource_lock);
-            return false;
-        }
+    if (!request_within_claim_unlocked(state, lane_id, request)) {
+        LOG_DEBUG("Lane %d request exceeds its maximum claim", lane_id);
+        pthread_mutex_unlock(&state->resource_lock);
+        return false;
     }
 
     // Step 2: Check if request <= available resources
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         if (request[quad] > state->available[quad]) {
-            printf("Insufficient resources for quadrant %d\n", quad);
+            LOG_DEBUG("Insufficient resources for quadrant %d", quad);
+            restore_standing_claim_unlocked(state, lane_id);
             pthread_mutex_unlock(&state->resource_lock);
             return false;
         }
     }
 
     // Step 3: Pretend to allocate resources
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         state->available[quad] -= request[quad];
         state->allocation[lane_id][quad] += request[quad];
         state->need[lane_id][quad] -= request[quad];
@@ -116,25 +130,82 @@ bool request_resources(BankersState* state, int lane_id, int request[NUM_QUADRAN
     if (is_safe_state_unlocked(state)) {
     // --- END DEADLOCK FIX ---
         // Allocation is safe, proceed
-        printf("Safe allocation for lane %d\n", lane_id);
+        LOG_DEBUG("Safe allocation for lane %d", lane_id);
         pthread_mutex_unlock(&state->resource_lock);
         return true;
     } else {
         // Allocation would lead to unsafe state, rollback
-        printf("Unsafe allocation detected for lane %d, rolling back\n", lane_id);
+        LOG_INFO("Unsafe allocation detected for lane %d, rolling back", lane_id);
         state->deadlock_preventions++;
 
-        for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+        for (int quad = 0; quad < state->num_quadrants; quad++) {
             state->available[quad] += request[quad];
             state->allocation[lane_id][quad] -= request[quad];
             state->need[lane_id][quad] += request[quad];
         }
+        restore_standing_claim_unlocked(state, lane_id);
 
         pthread_mutex_unlock(&state->resource_lock);
         return false;
     }
 }
 
+// Request <= need, or a lane holding nothing asks for a movement it
+// carries beyond its standing claim (a U-turn): the claim is raised to
+// the request until the lane releases it
+static bool request_within_claim_unlocked(BankersState* state, int lane_id,
+                                          int request[MAX_QUADRANTS]) {
+    bool within_need = true;
+    bool holds_nothing = true;
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
+        within_need = within_need && request[quad] <= state->need[lane_id][quad];
+        holds_nothing = holds_nothing && state->allocation[lane_id][quad] == 0;
+    }
+    if (within_need) {
+        return true;
+    }
+    if (!holds_nothing) {
+        return false;
+    }
+
+    int carried[MAX_QUADRANTS] = {0};
+    const GeometryLane* lane = &get_intersection_geometry()->lanes[lane_id];
+    for (int movement = 0; movement < NUM_MOVEMENTS; movement++) {
+        if (lane->movements & (1 << movement)) {
+            add_movement_quadrants(lane_id, (VehicleMovement)movement, carried);
+        }
+    }
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
+        if (request[quad] > carried[quad]) {
+            return false;
+        }
+    }
+
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
+        if (request[quad] > state->maximum[lane_id][quad]) {
+            state->maximum[lane_id][quad] = request[quad];
+        }
+        state->need[lane_id][quad] = state->maximum[lane_id][quad];
+    }
+    return true;
+}
+
+// Back to the standing claim once a lane holds nothing
+static void restore_standing_claim_unlocked(BankersState* state, int lane_id) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
+        if (state->allocation[lane_id][quad] != 0) {
+            return;
+        }
+    }
+
+    int claim[MAX_QUADRANTS];
+    calculate_maximum_quadrants(lane_id, claim);
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
+        state->maximum[lane_id][quad] = claim[quad];
+        state->need[lane_id][quad] = claim[quad];
+    }
+}
+
 // --- DEADLOCK FIX: Renamed to is_safe_state_unlocked and made static ---
 // Safety algorithm implementation (INTERNAL, NO LOCK)
 static bool is_safe_state_unlocked(BankersState* state) {
@@ -143,28 +214,28 @@ static bool is_safe_state_unlocked(BankersState* state) {
         return false;
     }
 
-    bool finish[NUM_LANES] = {false};
-    int work[NUM_QUADRANTS];
+    bool finish[MAX_LANES] = {false};
+    int work[MAX_QUADRANTS];
 
     // Initialize work = available
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         work[quad] = state->available[quad];
     }
 
     // Find a lane whose need <= work
     bool found_lane;
     int iterations = 0;
-    const int max_iterations = NUM_LANES * 2; // Prevent infinite loops
+    const int max_iterations = state->num_lanes * 2; // Prevent infinite loops
 
     do {
         found_lane = false;
 
-        for (int lane = 0; lane < NUM_LANES; lane++) {
+        for (int lane = 0; lane < state->num_lanes; lane++) {
             if (!finish[lane]) {
                 bool can_finish = true;
 
                 // Check if need[lane] <= work
-                for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+                for (int quad = 0; quad < state->num_quadrants; quad++) {
                     if (state->need[lane][quad] > work[quad]) {
                         can_finish = false;
                         break;
@@ -173,7 +244,7 @@ static bool is_safe_state_unlocked(BankersState* state) {
 
                 if (can_finish) {
                     // Lane can finish, add its allocated resources to work
-                    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+                    for (int quad = 0; quad < state->num_quadrants; quad++) {
                         work[quad] += state->allocation[lane][quad];
                     }
 
@@ -189,7 +260,7 @@ static bool is_safe_state_unlocked(BankersState* state) {
 
     // Check if all lanes can finish
     bool all_finished = true;
-    for (int lane = 0; lane < NUM_LANES; lane++) {
+    for (int lane = 0; lane < state->num_lanes; lane++) {
         if (!finish[lane]) {
             all_finished = false;
             break;
@@ -217,34 +288,34 @@ bool is_safe_state(BankersState* state) {
 
 // --- DEADLOCK FIX: Renamed to safety_algorithm_unlocked and made static ---
 // Detailed safety algorithm (INTERNAL, NO LOCK)
-static bool safety_algorithm_unlocked(BankersState* state, bool finish[NUM_LANES]) {
+static bool safety_algorithm_unlocked(BankersState* state, bool finish[MAX_LANES]) {
 // --- END DEADLOCK FIX ---
     if (!state || !finish) {
         return false;
     }
 
-    int work[NUM_QUADRANTS];
+    int work[MAX_QUADRANTS];
 
     // Initialize work array
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         work[quad] = state->available[quad];
     }
 
     // Initialize finish array
-    for (int lane = 0; lane < NUM_LANES; lane++) {
+    for (int lane = 0; lane < state->num_lanes; lane++) {
         finish[lane] = false;
     }
 
     // Find safe sequence
-    for (int count = 0; count < NUM_LANES; count++) {
+    for (int count = 0; count < state->num_lanes; count++) {
         int found_lane = -1;
 
         // Find lane that can finish
-        for (int lane = 0; lane < NUM_LANES; lane++) {
+        for (int lane = 0; lane < state->num_lanes; lane++) {
             if (!finish[lane]) {
                 bool can_finish = true;
 
-                for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+                for (int quad = 0; quad < state->num_quadrants; quad++) {
                     if (state->need[lane][quad] > work[quad]) {
                         can_finish = false;
                         break;
@@ -264,7 +335,7 @@ static bool safety_algorithm_unlocked(BankersState* state, bool finish[NUM_LANES
 
         // Mark lane as finished and free its resources
         finish[found_lane] = true;
-        for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+        for (int quad = 0; quad < state->num_quadrants; quad++) {
             work[quad] += state->allocation[found_lane][quad];
         }
     }
@@ -273,7 +344,7 @@ static bool safety_algorithm_unlocked(BankersState* state, bool finish[NUM_LANES
 }
 
 // --- DEADLOCK FIX: NEW public, thread-safe version ---
-bool safety_algorithm(BankersState* state, bool finish[NUM_LANES]) {
+bool safety_algorithm(BankersState* state, bool finish[MAX_LANES]) {
     if (!state || !finish) {
         return false;
     }
@@ -287,14 +358,14 @@ bool safety_algorithm(BankersState* state, bool finish[NUM_LANES]) {
 
 
 // Allocate resources to a lane
-void allocate_resources(BankersState* state, int lane_id, int allocation[NUM_QUADRANTS]) {
-    if (!state || lane_id < 0 || lane_id >= NUM_LANES || !allocation) {
+void allocate_resources(BankersState* state, int lane_id, int allocation[MAX_QUADRANTS]) {
+    if (!state || lane_id < 0 || lane_id >= state->num_lanes || !allocation) {
         return;
     }
 
     pthread_mutex_lock(&state->resource_lock);
 
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         if (allocation[quad] <= state->available[quad] &&
             allocation[quad] <= state->need[lane_id][quad]) {
 
@@ -309,30 +380,31 @@ void allocate_resources(BankersState* state, int lane_id, int allocation[NUM_QUA
 
 // Deallocate resources from a lane
 void deallocate_resources(BankersState* state, int lane_id) {
-    if (!state || lane_id < 0 || lane_id >= NUM_LANES) {
+    if (!state || lane_id < 0 || lane_id >= state->num_lanes) {
         return;
     }
 
     pthread_mutex_lock(&state->resource_lock);
 
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         state->available[quad] += state->allocation[lane_id][quad];
         state->need[lane_id][quad] += state->allocation[lane_id][quad];
         state->allocation[lane_id][quad] = 0;
     }
+    restore_standing_claim_unlocked(state, lane_id);
 
     pthread_mutex_unlock(&state->resource_lock);
 }
 
 // Update available resources
-void update_available_resources(BankersState* state, int available[NUM_QUADRANTS]) {
+void update_available_resources(BankersState* state, int available[MAX_QUADRANTS]) {
     if (!state || !available) {
         return;
     }
 
     pthread_mutex_lock(&state->resource_lock);
 
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         state->available[quad] = available[quad];
     }
 
@@ -340,38 +412,75 @@ void update_available_resources(BankersState* state, int available[NUM_QUADRANTS
 }
 
 // Calculate quadrants needed for different movements
-void calculate_needed_quadrants(LaneProcess* lane, int need[NUM_QUADRANTS]) {
+void calculate_needed_quadrants(LaneProcess* lane, int need[MAX_QUADRANTS]) {
     if (!lane || !need) {
         return;
     }
 
     // Initialize need array
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < MAX_QUADRANTS; quad++) {
         need[quad] = 0;
     }
 
-    // Calculate quadrants based on lane and typical movement patterns
-    // This is simplified - in practice, would depend on vehicle destination
-    calculate_straight_movement_quadrants(lane->lane_id, need);
+    // The head vehicle's movement decides the path; an empty lane asks
+    // for the through movement
+    VehicleRecord head;
+    VehicleMovement movement = MOVEMENT_STRAIGHT;
+    if (peek_lane_head_vehicle(lane, &head)) {
+        movement = head.movement;
+    }
+
+    calculate_movement_quadrants(lane->lane_id, movement, need);
+}
+
+// Quadrants one movement from 'lane_id' passes through (added to 'quadrants')
+void calculate_movement_quadrants(int lane_id, VehicleMovement movement, int quadrants[MAX_QUADRANTS]) {
+    switch (movement) {
+        case MOVEMENT_LEFT:
+            calculate_left_turn_quadrants(lane_id, quadrants);
+            break;
+        case MOVEMENT_RIGHT:
+            calculate_right_turn_quadrants(lane_id, quadrants);
+            break;
+        case MOVEMENT_U_TURN:
+            calculate_u_turn_quadrants(lane_id, quadrants);
+            break;
+        case MOVEMENT_STRAIGHT:
+        default:
+            calculate_straight_movement_quadrants(lane_id, quadrants);
+            break;
+    }
 }
 
 // Calculate maximum quadrants a lane might need
-void calculate_maximum_quadrants(int lane_id, int maximum[NUM_QUADRANTS]) {
-    if (lane_id < 0 || lane_id >= NUM_LANES || !maximum) {
+void calculate_maximum_quadrants(int lane_id, int maximum[MAX_QUADRANTS]) {
+    if (lane_id < 0 || lane_id >= get_num_lanes() || !maximum) {
         return;
     }
 
     // Initialize maximum array
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < MAX_QUADRANTS; quad++) {
         maximum[quad] = 0;
     }
 
-    // Calculate maximum based on worst-case scenario (left turn needs most quadrants)
-    calculate_left_turn_quadrants(lane_id, maximum);
+    // Union of the quadrants of every movement the lane carries but the
+    // U-turn, which sweeps the whole intersection: claiming it standing
+    // would make every lane claim everything and serialise all crossings.
+    // A lane whose only movement is the U-turn claims it.
+    const GeometryLane* lane = &get_intersection_geometry()->lanes[lane_id];
+    int movements = lane->movements;
+    if (movements != (1 << MOVEMENT_U_TURN)) {
+        movements &= ~(1 << MOVEMENT_U_TURN);
+    }
+    for (int movement = 0; movement < NUM_MOVEMENTS; movement++) {
+        if (movements & (1 << movement)) {
+            add_movement_quadrants(lane_id, (VehicleMovement)movement, maximum);
+        }
+    }
 }
 
 // Check if quadrants are available
-bool are_quadrants_available(BankersState* state, int request[NUM_QUADRANTS]) {
+bool are_quadrants_available(BankersState* state, int request[MAX_QUADRANTS]) {
     if (!state || !request) {
         return false;
     }
@@ -379,7 +488,7 @@ bool are_quadrants_available(BankersState* state, int request[NUM_QUADRANTS]) {
     pthread_mutex_lock(&state->resource_lock);
 
     bool available = true;
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         if (request[quad] > state->available[quad]) {
             available = false;
             break;
@@ -392,14 +501,14 @@ bool are_quadrants_available(BankersState* state, int request[NUM_QUADRANTS]) {
 
 // Check if a specific lane can finish
 bool can_lane_finish(BankersState* state, int lane_id) {
-    if (!state || lane_id < 0 || lane_id >= NUM_LANES) {
+    if (!state || lane_id < 0 || lane_id >= state->num_lanes) {
         return false;
     }
 
     pthread_mutex_lock(&state->resource_lock);
 
     bool can_finish = true;
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         if (state->need[lane_id][quad] > state->available[quad]) {
             can_finish = false;
             break;
@@ -411,32 +520,27 @@ bool can_lane_finish(BankersState* state, int lane_id) {
 }
 
 // Check resource request validity
-bool check_resource_request(BankersState* state, int lane_id, int request[NUM_QUADRANTS]) {
-    if (!state || lane_id < 0 || lane_id >= NUM_LANES || !request) {
+bool check_resource_request(BankersState* state, int lane_id, int request[MAX_QUADRANTS]) {
+    if (!state || lane_id < 0 || lane_id >= state->num_lanes || !request) {
         return false;
     }
 
     pthread_mutex_lock(&state->resource_lock);
 
-    bool valid = true;
-
-    // Check if request exceeds need
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
-        if (request[quad] > state->need[lane_id][quad]) {
-            valid = false;
-            break;
-        }
-    }
+    // Check if request exceeds need (raising the claim for a U-turn is
+    // undone below, since nothing is allocated here)
+    bool valid = request_within_claim_unlocked(state, lane_id, request);
 
     // Check if request exceeds available resources
     if (valid) {
-        for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+        for (int quad = 0; quad < state->num_quadrants; quad++) {
             if (request[quad] > state->available[quad]) {
                 valid = false;
                 break;
             }
         }
     }
+    restore_standing_claim_unlocked(state, lane_id);
 
     pthread_mutex_unlock(&state->resource_lock);
     return valid;
@@ -448,83 +552,45 @@ bool is_deadlock_possible(BankersState* state) {
     return !is_safe_state(state);
 }
 
-// Movement-specific quadrant calculations
-void calculate_straight_movement_quadrants(int lane_id, int quadrants[NUM_QUADRANTS]) {
-    if (!quadrants || lane_id < 0 || lane_id >= NUM_LANES) {
-        return;
-    }
-
-    switch (lane_id) {
-        case LANE_NORTH: // North going straight needs SE quadrant
-            quadrants[QUADRANT_SE] = 1;
-            break;
-        case LANE_SOUTH: // South going straight needs NW quadrant
-            quadrants[QUADRANT_NW] = 1;
-            break;
-        case LANE_EAST: // East going straight needs NW quadrant
-            quadrants[QUADRANT_NW] = 1;
-            break;
-        case LANE_WEST: // West going straight needs SE quadrant
-            quadrants[QUADRANT_SE] = 1;
-            break;
+// Set the quadrants one movement sweeps in 'quadrants' (movements the lane
+// does not carry add nothing)
+static void add_movement_quadrants(int lane_id, VehicleMovement movement,
+                                   int quadrants[MAX_QUADRANTS]) {
+    int mask = get_movement_quadrant_mask(lane_id, movement);
+    for (int quad = 0; quad < MAX_QUADRANTS; quad++) {
+        if (mask & (1 << quad)) {
+            quadrants[quad] = 1;
+        }
     }
 }
 
-void calculate_left_turn_quadrants(int lane_id, int quadrants[NUM_QUADRANTS]) {
-    if (!quadrants || lane_id < 0 || lane_id >= NUM_LANES) {
+// Movement-specific quadrant calculations
+void calculate_straight_movement_quadrants(int lane_id, int quadrants[MAX_QUADRANTS]) {
+    if (!quadrants) {
         return;
     }
-
-    switch (lane_id) {
-        case LANE_NORTH: // North turning left needs SW and SE quadrants
-            quadrants[QUADRANT_SW] = 1;
-            quadrants[QUADRANT_SE] = 1;
-            break;
-        case LANE_SOUTH: // South turning left needs NE and NW quadrants
-            quadrants[QUADRANT_NE] = 1;
-            quadrants[QUADRANT_NW] = 1;
-            break;
-        case LANE_EAST: // East turning left needs NE and SE quadrants
-            quadrants[QUADRANT_NE] = 1;
-            quadrants[QUADRANT_SE] = 1;
-            break;
-        case LANE_WEST: // West turning left needs NW and SW quadrants
-            quadrants[QUADRANT_NW] = 1;
-            quadrants[QUADRANT_SW] = 1;
-            break;
-    }
+    add_movement_quadrants(lane_id, MOVEMENT_STRAIGHT, quadrants);
 }
 
-void calculate_right_turn_quadrants(int lane_id, int quadrants[NUM_QUADRANTS]) {
-    if (!quadrants || lane_id < 0 || lane_id >= NUM_LANES) {
+void calculate_left_turn_quadrants(int lane_id, int quadrants[MAX_QUADRANTS]) {
+    if (!quadrants) {
         return;
     }
-
-    switch (lane_id) {
-        case LANE_NORTH: // North turning right needs NE quadrant
-            quadrants[QUADRANT_NE] = 1;
-            break;
-        case LANE_SOUTH: // South turning right needs SW quadrant
-            quadrants[QUADRANT_SW] = 1;
-            break;
-        case LANE_EAST: // East turning right needs SE quadrant
-            quadrants[QUADRANT_SE] = 1;
-            break;
-        case LANE_WEST: // West turning right needs NW quadrant
-            quadrants[QUADRANT_NW] = 1;
-            break;
-    }
+    add_movement_quadrants(lane_id, MOVEMENT_LEFT, quadrants);
 }
 
-void calculate_u_turn_quadrants(int lane_id, int quadrants[NUM_QUADRANTS]) {
-    if (!quadrants || lane_id < 0 || lane_id >= NUM_LANES) {
+void calculate_right_turn_quadrants(int lane_id, int quadrants[MAX_QUADRANTS]) {
+    if (!quadrants) {
         return;
     }
+    add_movement_quadrants(lane_id, MOVEMENT_RIGHT, quadrants);
+}
 
-    // U-turn needs all quadrants (worst case)
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
-        quadrants[quad] = 1;
+void calculate_u_turn_quadrants(int lane_id, int quadrants[MAX_QUADRANTS]) {
+    if (!quadrants) {
+        return;
     }
+    add_movement_quadrants(lane_id, MOVEMENT_U_TURN, quadrants);
 }
 
 // Utility functions
@@ -541,24 +607,24 @@ void print_bankers_state(BankersState* state) {
     printf("Deadlocks Prevented: %d\n", state->deadlock_preventions);
 
     printf("\nAvailable Resources: ");
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         printf("%d ", state->available[quad]);
     }
     printf("\n");
 
     printf("\nAllocation Matrix:\n");
-    for (int lane = 0; lane < NUM_LANES; lane++) {
+    for (int lane = 0; lane < state->num_lanes; lane++) {
         printf("Lane %d: ", lane);
-        for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+        for (int quad = 0; quad < state->num_quadrants; quad++) {
             printf("%d ", state->allocation[lane][quad]);
         }
         printf("\n");
     }
 
     printf("\nNeed Matrix:\n");
-    for (int lane = 0; lane < NUM_LANES; lane++) {
+    for (int lane = 0; lane < state->num_lanes; lane++) {
         printf("Lane %d: ", lane);
-        for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+        for (int quad = 0; quad < state->num_quadrants; quad++) {
             printf("%d ", state->need[lane][quad]);
         }
         printf("\n");
@@ -570,20 +636,20 @@ void print_bankers_state(BankersState* state) {
 }
 
 void print_lane_allocation(BankersState* state, int lane_id) {
-    if (!state || lane_id < 0 || lane_id >= NUM_LANES) {
+    if (!state || lane_id < 0 || lane_id >= state->num_lanes) {
         return;
     }
 
     pthread_mutex_lock(&state->resource_lock);
 
     printf("Lane %d Allocation: ", lane_id);
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         printf("%d ", state->allocation[lane_id][quad]);
     }
     printf("\n");
 
     printf("Lane %d Need: ", lane_id);
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         printf("%d ", state->need[lane_id][quad]);
     }
     printf("\n");
@@ -599,7 +665,7 @@ void print_available_quadrants(BankersState* state) {
     pthread_mutex_lock(&state->resource_lock);
 
     printf("Available Quadrants: ");
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         printf("%d ", state->available[quad]);
     }
     printf("\n");
@@ -614,7 +680,7 @@ int get_total_available_quadrants(BankersState* state) {
 
     pthread_mutex_lock(&state->resource_lock);
     int total = 0;
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < state->num_quadrants; quad++) {
         total += state->available[quad];
     }
     pthread_mutex_unlock(&state->resource_lock);
@@ -629,8 +695,8 @@ int get_total_allocated_quadrants(BankersState* state) {
 
     pthread_mutex_lock(&state->resource_lock);
     int total = 0;
-    for (int lane = 0; lane < NUM_LANES; lane++) {
-        for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int lane = 0; lane < state->num_lanes; lane++) {
+        for (int quad = 0; quad < state->num_quadrants; quad++) {
             total += state->allocation[lane][quad];
         }
     }
@@ -657,7 +723,7 @@ float get_resource_utilization(BankersState* state) {
     }
 
     int total_allocated = get_total_allocated_quadrants(state);
-    int total_resources = NUM_QUADRANTS; // Total available quadrants
+    int total_resources = state->num_quadrants; // Total available quadrants
 
     return total_resources > 0 ? (float)total_allocated / total_resources : 0.0f;
 }
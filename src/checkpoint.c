@@ -0,0 +1,579 @@
+/*
+ * Checkpoint Implementation - Sectioned State File, Written Atomically
+ *
+ * save_checkpoint() copies each component under its own lock, one at a
+ * time, and writes the file to PATH.tmp before renaming it over PATH, so
+ * a crash mid-write leaves the previous checkpoint intact. The simulation
+ * thread calls checkpoint_tick() between time slices to take requested
+ * ('c' key) and periodic checkpoints.
+ *
+ * load_checkpoint() reads the whole file and checks every section before
+ * the system (and ncurses) starts, so a bad file is reported on the
+ * terminal; restore_checkpoint() then applies it to the initialised system
+ * before the simulation threads start.
+ *
+ * Compilation: Include checkpoint.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/checkpoint.h"
+#include "../include/trafficguru.h"
+#include "../include/sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+static char checkpoint_path[256];
+static int checkpoint_interval = 0;     // Seconds between periodic checkpoints, 0 = none
+static time_t next_checkpoint_time = 0;
+static volatile bool checkpoint_requested = false;
+static char* loaded_data = NULL;        // Validated by load_checkpoint(), applied by restore_checkpoint()
+static size_t loaded_size = 0;
+
+// --- Writing ---
+
+static bool write_section(FILE* file, CheckpointSectionType type, const void* data, size_t size) {
+    CheckpointSection section = { (uint32_t)type, (uint32_t)size };
+    return fwrite(&section, sizeof(section), 1, file) == 1 &&
+           (size == 0 || fwrite(data, size, 1, file) == 1);
+}
+
+// One section per lane: its state, then its queued vehicles head first
+static bool write_lane(FILE* file, LaneProcess* lane) {
+    CheckpointLane saved;
+    memset(&saved, 0, sizeof(saved));
+
+    pthread_mutex_lock(&lane->queue_lock);
+    int queued = get_size(lane->queue);
+    VehicleRecord* vehicles = malloc((size_t)(queued > 0 ? queued : 1) * sizeof(VehicleRecord));
+    if (!vehicles) {
+        pthread_mutex_unlock(&lane->queue_lock);
+        return false;
+    }
+    saved.queued = copy_queued_vehicles(lane->queue, vehicles, queued);
+    saved.max_queue_length = lane->max_queue_length;
+    saved.state = lane->state;
+    saved.priority = lane->priority;
+    saved.waiting_time = lane->waiting_time;
+    saved.last_arrival_time = lane->last_arrival_time;
+    saved.last_service_time = lane->last_service_time;
+    saved.total_vehicles_served = lane->total_vehicles_served;
+    saved.total_waiting_time = lane->total_waiting_time;
+    saved.requested_quadrants = lane->requested_quadrants;
+    saved.allocated_quadrants = lane->allocated_quadrants;
+    saved.enqueue_count = lane->queue->enqueue_count;
+    saved.dequeue_count = lane->queue->dequeue_count;
+    saved.overflow_count = lane->queue->overflow_count;
+    saved.spillback_count = lane->queue->spillback_count;
+    saved.peak_size = lane->queue->peak_size;
+    pthread_mutex_unlock(&lane->queue_lock);
+
+    size_t vehicle_bytes = (size_t)saved.queued * sizeof(VehicleRecord);
+    CheckpointSection section = { CHECKPOINT_LANES, (uint32_t)(sizeof(saved) + vehicle_bytes) };
+    bool ok = fwrite(&section, sizeof(section), 1, file) == 1 &&
+              fwrite(&saved, sizeof(saved), 1, file) == 1 &&
+              (vehicle_bytes == 0 || fwrite(vehicles, vehicle_bytes, 1, file) == 1);
+    free(vehicles);
+    return ok;
+}
+
+static void save_scheduler(Scheduler* scheduler, CheckpointScheduler* saved) {
+    memset(saved, 0, sizeof(CheckpointScheduler));
+    pthread_mutex_lock(&scheduler->scheduler_lock);
+    saved->algorithm = scheduler->algorithm;
+    saved->time_quantum = scheduler->time_quantum;
+    saved->current_lane = scheduler->current_lane;
+    saved->total_context_switches = scheduler->total_context_switches;
+    saved->last_schedule_time = scheduler->last_schedule_time;
+    saved->preempt_pending = scheduler->preempt_pending;
+    saved->preclear_pending = scheduler->preclear_pending;
+    saved->preempt_lane = scheduler->preempt_lane;
+    saved->preempt_detected_ns = scheduler->preempt_detected_ns;
+    saved->preempt_arrival_ns = scheduler->preempt_arrival_ns;
+    saved->emergency_green_lane = scheduler->emergency_green_lane;
+    saved->emergency_green_ns = scheduler->emergency_green_ns;
+    saved->total_preemptions = scheduler->total_preemptions;
+    saved->total_preclears = scheduler->total_preclears;
+    saved->decision_latency_ns = scheduler->decision_latency_ns;
+    pthread_mutex_unlock(&scheduler->scheduler_lock);
+}
+
+static void save_bankers(BankersState* state, CheckpointBankers* saved) {
+    memset(saved, 0, sizeof(CheckpointBankers));
+    pthread_mutex_lock(&state->resource_lock);
+    for (int q = 0; q < MAX_QUADRANTS; q++) {
+        saved->available[q] = state->available[q];
+    }
+    for (int l = 0; l < MAX_LANES; l++) {
+        for (int q = 0; q < MAX_QUADRANTS; q++) {
+            saved->maximum[l][q] = state->maximum[l][q];
+            saved->allocation[l][q] = state->allocation[l][q];
+            saved->need[l][q] = state->need[l][q];
+        }
+    }
+    saved->safe_state = state->safe_state;
+    saved->deadlock_preventions = state->deadlock_preventions;
+    pthread_mutex_unlock(&state->resource_lock);
+}
+
+static void save_emergency(EmergencySystem* system, CheckpointEmergency* saved) {
+    memset(saved, 0, sizeof(CheckpointEmergency));
+    pthread_mutex_lock(&system->lock);
+    saved->current_emergency = system->current_emergency;
+    memcpy(saved->pending, system->pending, sizeof(saved->pending));
+    saved->pending_count = system->pending_count;
+    saved->next_sequence = system->next_sequence;
+    saved->emergencies_queued = system->emergencies_queued;
+    saved->emergencies_dropped = system->emergencies_dropped;
+    saved->max_queue_delay = system->max_queue_delay;
+    saved->queue_delay_ns = system->queue_delay_ns;
+    saved->emergency_mode = system->emergency_mode;
+    saved->emergency_start_time = system->emergency_start_time;
+    saved->total_emergencies_handled = system->total_emergencies_handled;
+    saved->total_emergency_response_time = system->total_emergency_response_time;
+    saved->average_response_time = system->average_response_time;
+    pthread_mutex_unlock(&system->lock);
+}
+
+// Write the simulation's state to 'path', with 'end_time' as the planned end of the run
+static bool write_checkpoint(const char* path, time_t end_time) {
+    TrafficGuruSystem* sys = g_traffic_system;
+    if (!sys || !path || !path[0]) {
+        return false;
+    }
+
+    char temp_path[sizeof(checkpoint_path) + 8];
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp", path);
+    FILE* file = fopen(temp_path, "wb");
+    if (!file) {
+        LOG_WARN("Checkpoint: cannot write %s", temp_path);
+        return false;
+    }
+
+    // Continue from a known seed so a restored run draws the same stream
+    unsigned int seed = (unsigned int)rand();
+    srand(seed);
+
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, 4);
+    header.version = CHECKPOINT_VERSION;
+    header.header_size = sizeof(header);
+    header.num_lanes = sys->num_lanes;
+    snprintf(header.geometry, sizeof(header.geometry), "%s", get_intersection_geometry()->name);
+    time_t now = time(NULL);
+    header.wall_time = now;
+    header.monotonic_ns = monotonic_now_ns();
+    header.elapsed_seconds = (int32_t)(now - sys->simulation_start_time);
+    header.remaining_seconds = (int32_t)(end_time > now ? end_time - now : 0);
+    header.random_seed = seed;
+    header.scenario_elapsed_ns = __atomic_load_n(&sys->scenario_elapsed_ns, __ATOMIC_RELAXED);
+    header.replay_elapsed_ns = __atomic_load_n(&sys->replay_elapsed_ns, __ATOMIC_RELAXED);
+
+    // Lanes first: a vehicle admitted meanwhile is then at least counted
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    for (int i = 0; ok && i < sys->num_lanes; i++) {
+        ok = write_lane(file, &sys->lanes[i]);
+    }
+
+    CheckpointScheduler scheduler;
+    save_scheduler(&sys->scheduler, &scheduler);
+    ok = ok && write_section(file, CHECKPOINT_SCHEDULER, &scheduler, sizeof(scheduler));
+
+    static CheckpointMultilevel multilevel;
+    save_multilevel_checkpoint(&multilevel);
+    ok = ok && write_section(file, CHECKPOINT_MULTILEVEL, &multilevel, sizeof(multilevel));
+
+    static CheckpointRoundRobin round_robin;
+    save_round_robin_checkpoint(&round_robin);
+    ok = ok && write_section(file, CHECKPOINT_ROUND_ROBIN, &round_robin, sizeof(round_robin));
+
+    static CheckpointBankers bankers;
+    save_bankers(get_global_bankers_state(), &bankers);
+    ok = ok && write_section(file, CHECKPOINT_BANKERS, &bankers, sizeof(bankers));
+
+    static CheckpointEmergency emergency;
+    save_emergency(&sys->emergency_system, &emergency);
+    ok = ok && write_section(file, CHECKPOINT_EMERGENCY, &emergency, sizeof(emergency));
+
+    pthread_mutex_lock(&sys->global_state_lock);
+    int32_t generated = sys->total_vehicles_generated;
+    ok = ok && write_section(file, CHECKPOINT_METRICS, &sys->metrics,
+                             offsetof(PerformanceMetrics, timeseries));
+    pthread_mutex_unlock(&sys->global_state_lock);
+    ok = ok && write_section(file, CHECKPOINT_END, NULL, 0);
+
+    // The vehicle count is only final now; patch it into the header
+    ok = ok && fseek(file, offsetof(CheckpointHeader, total_vehicles_generated), SEEK_SET) == 0 &&
+         fwrite(&generated, sizeof(generated), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+
+    if (!ok || rename(temp_path, path) != 0) {
+        remove(temp_path);
+        LOG_WARN("Checkpoint: writing %s failed", path);
+        return false;
+    }
+    LOG_INFO("Checkpoint saved to %s at %d s (%d vehicles generated)",
+             path, header.elapsed_seconds, generated);
+    return true;
+}
+
+bool save_checkpoint(const char* path) {
+    return g_traffic_system && write_checkpoint(path, g_traffic_system->simulation_end_time);
+}
+
+// --- Reading ---
+
+typedef struct {
+    const char* data;
+    size_t size;
+    size_t offset;
+} CheckpointReader;
+
+// Next section, or NULL if the file ends inside one
+static const void* next_section(CheckpointReader* reader, CheckpointSection* section) {
+    if (reader->size - reader->offset < sizeof(CheckpointSection)) {
+        return NULL;
+    }
+    memcpy(section, reader->data + reader->offset, sizeof(CheckpointSection));
+    reader->offset += sizeof(CheckpointSection);
+    if (reader->size - reader->offset < section->size) {
+        return NULL;
+    }
+    const void* body = reader->data + reader->offset;
+    reader->offset += section->size;
+    return body;
+}
+
+static char* read_whole_file(const char* path, size_t* size) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        return NULL;
+    }
+    char* data = NULL;
+    long length = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        length = ftell(file);
+    }
+    if (length > 0 && fseek(file, 0, SEEK_SET) == 0) {
+        data = malloc((size_t)length);
+        if (data && fread(data, (size_t)length, 1, file) != 1) {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(file);
+    *size = length > 0 ? (size_t)length : 0;
+    return data;
+}
+
+// Check the header and that every section is complete and sized for this
+// build before anything is restored
+static bool validate_checkpoint(const char* path, const char* data, size_t size, const CheckpointHeader** header) {
+    if (size < sizeof(CheckpointHeader) || memcmp(data, CHECKPOINT_MAGIC, 4) != 0) {
+        printf("%s is not a TrafficGuru checkpoint\n", path);
+        return false;
+    }
+    *header = (const CheckpointHeader*)data;
+    if ((*header)->version != CHECKPOINT_VERSION || (*header)->header_size != sizeof(CheckpointHeader)) {
+        printf("%s: checkpoint version %u is not supported (expected %d)\n",
+               path, (*header)->version, CHECKPOINT_VERSION);
+        return false;
+    }
+    if ((*header)->num_lanes != get_num_lanes() ||
+        strncmp((*header)->geometry, get_intersection_geometry()->name, sizeof((*header)->geometry)) != 0) {
+        printf("%s was saved for geometry %.64s (%d lanes); run with -G %.64s\n",
+               path, (*header)->geometry, (*header)->num_lanes, (*header)->geometry);
+        return false;
+    }
+
+    static const size_t fixed_sizes[] = {
+        [CHECKPOINT_SCHEDULER] = sizeof(CheckpointScheduler),
+        [CHECKPOINT_MULTILEVEL] = sizeof(CheckpointMultilevel),
+        [CHECKPOINT_ROUND_ROBIN] = sizeof(CheckpointRoundRobin),
+        [CHECKPOINT_BANKERS] = sizeof(CheckpointBankers),
+        [CHECKPOINT_EMERGENCY] = sizeof(CheckpointEmergency),
+        [CHECKPOINT_METRICS] = offsetof(PerformanceMetrics, timeseries),
+        [CHECKPOINT_END] = 0
+    };
+    CheckpointReader reader = { data, size, sizeof(CheckpointHeader) };
+    CheckpointSection section;
+    const void* body;
+    int lanes = 0;
+    bool ended = false;
+    while (!ended && (body = next_section(&reader, &section)) != NULL) {
+        bool valid;
+        if (section.type == CHECKPOINT_LANES) {
+            const CheckpointLane* lane = body;
+            valid = section.size >= sizeof(CheckpointLane) && lane->queued >= 0 &&
+                    section.size == sizeof(CheckpointLane) + (size_t)lane->queued * sizeof(VehicleRecord);
+            lanes++;
+        } else {
+            valid = section.type > CHECKPOINT_LANES && section.type <= CHECKPOINT_END &&
+                    section.size == fixed_sizes[section.type];
+        }
+        if (!valid) {
+            printf("%s: section %u does not match this build\n", path, section.type);
+            return false;
+        }
+        ended = section.type == CHECKPOINT_END;
+    }
+    if (!ended || lanes != (*header)->num_lanes) {
+        printf("%s is truncated\n", path);
+        return false;
+    }
+    return true;
+}
+
+static void restore_lane(LaneProcess* lane, const CheckpointLane* saved, long long monotonic_shift,
+                         time_t wall_shift) {
+    const VehicleRecord* vehicles = (const VehicleRecord*)(saved + 1);
+
+    pthread_mutex_lock(&lane->queue_lock);
+    clear_queue(lane->queue);
+    for (int v = 0; v < saved->queued; v++) {
+        VehicleRecord vehicle;
+        memcpy(&vehicle, &vehicles[v], sizeof(vehicle));
+        vehicle.arrival_ns += monotonic_shift;
+        if (vehicle.storage_ns != 0) {
+            vehicle.storage_ns += monotonic_shift;
+        }
+        if (!restore_queued_vehicle(lane->queue, &vehicle)) {
+            LOG_WARN("Checkpoint: %s lane dropped %d vehicles over the queue memory cap",
+                     get_lane_name(lane->lane_id), saved->queued - v);
+            break;
+        }
+    }
+    lane->queue->enqueue_count = saved->enqueue_count;
+    lane->queue->dequeue_count = saved->dequeue_count;
+    lane->queue->overflow_count = saved->overflow_count;
+    lane->queue->spillback_count = saved->spillback_count;
+    lane->queue->peak_size = saved->peak_size;
+    lane->queue_length = get_size(lane->queue);
+    lane->max_queue_length = saved->max_queue_length;
+    // A lane saved mid-slice has to be scheduled again
+    lane->state = saved->state == RUNNING ? READY : (LaneState)saved->state;
+    lane->priority = saved->priority;
+    lane->waiting_time = saved->waiting_time;
+    lane->ready_since_ns = monotonic_now_ns() - (long long)saved->waiting_time * NS_PER_SEC;
+    lane->last_arrival_time = (time_t)saved->last_arrival_time + wall_shift;
+    lane->last_service_time = (time_t)saved->last_service_time + wall_shift;
+    lane->total_vehicles_served = saved->total_vehicles_served;
+    lane->total_waiting_time = saved->total_waiting_time;
+    lane->requested_quadrants = saved->requested_quadrants;
+    lane->allocated_quadrants = saved->allocated_quadrants;
+    pthread_mutex_unlock(&lane->queue_lock);
+}
+
+// Monotonic times of 0 mean "not set" and stay 0
+static long long shift_ns(long long value_ns, long long shift) {
+    return value_ns != 0 ? value_ns + shift : 0;
+}
+
+static void restore_scheduler(Scheduler* scheduler, const CheckpointScheduler* saved,
+                              long long monotonic_shift, time_t wall_shift) {
+    pthread_mutex_lock(&scheduler->scheduler_lock);
+    scheduler->algorithm = (SchedulingAlgorithm)saved->algorithm;
+    scheduler->time_quantum = saved->time_quantum;
+    // The green lane came back READY, so nobody holds green until the next
+    // decision switches to a lane (and traces its green) again
+    scheduler->current_lane = -1;
+    scheduler->total_context_switches = saved->total_context_switches;
+    scheduler->last_schedule_time = (time_t)saved->last_schedule_time + wall_shift;
+    scheduler->preempt_pending = saved->preempt_pending;
+    scheduler->preclear_pending = saved->preclear_pending;
+    scheduler->preempt_lane = saved->preempt_lane;
+    scheduler->preempt_detected_ns = shift_ns(saved->preempt_detected_ns, monotonic_shift);
+    scheduler->preempt_arrival_ns = shift_ns(saved->preempt_arrival_ns, monotonic_shift);
+    scheduler->emergency_green_lane = saved->emergency_green_lane;
+    scheduler->emergency_green_ns = shift_ns(saved->emergency_green_ns, monotonic_shift);
+    scheduler->total_preemptions = saved->total_preemptions;
+    scheduler->total_preclears = saved->total_preclears;
+    scheduler->decision_latency_ns = saved->decision_latency_ns;
+    pthread_mutex_unlock(&scheduler->scheduler_lock);
+}
+
+static void restore_bankers(BankersState* state, const CheckpointBankers* saved) {
+    pthread_mutex_lock(&state->resource_lock);
+    for (int q = 0; q < MAX_QUADRANTS; q++) {
+        state->available[q] = saved->available[q];
+    }
+    for (int l = 0; l < MAX_LANES; l++) {
+        for (int q = 0; q < MAX_QUADRANTS; q++) {
+            state->maximum[l][q] = saved->maximum[l][q];
+            state->allocation[l][q] = saved->allocation[l][q];
+            state->need[l][q] = saved->need[l][q];
+        }
+    }
+    state->safe_state = saved->safe_state;
+    state->deadlock_preventions = saved->deadlock_preventions;
+    pthread_mutex_unlock(&state->resource_lock);
+}
+
+static void shift_emergency_vehicle(EmergencyVehicle* vehicle, long long monotonic_shift, time_t wall_shift) {
+    if (vehicle->timestamp != 0) {
+        vehicle->timestamp += wall_shift;
+    }
+    vehicle->detected_ns = shift_ns(vehicle->detected_ns, monotonic_shift);
+    vehicle->arrival_ns = shift_ns(vehicle->arrival_ns, monotonic_shift);
+    vehicle->green_ns = shift_ns(vehicle->green_ns, monotonic_shift);
+    vehicle->crossing_start_ns = shift_ns(vehicle->crossing_start_ns, monotonic_shift);
+}
+
+static void restore_emergency(EmergencySystem* system, const CheckpointEmergency* saved,
+                              long long monotonic_shift, time_t wall_shift) {
+    pthread_mutex_lock(&system->lock);
+    system->current_emergency = saved->current_emergency;
+    shift_emergency_vehicle(&system->current_emergency, monotonic_shift, wall_shift);
+    system->pending_count = saved->pending_count;
+    for (int i = 0; i < saved->pending_count && i < EMERGENCY_QUEUE_CAPACITY; i++) {
+        system->pending[i] = saved->pending[i];
+        shift_emergency_vehicle(&system->pending[i].vehicle, monotonic_shift, wall_shift);
+        system->pending[i].key += (double)monotonic_shift / NS_PER_SEC;
+    }
+    system->next_sequence = saved->next_sequence;
+    system->emergencies_queued = saved->emergencies_queued;
+    system->emergencies_dropped = saved->emergencies_dropped;
+    system->max_queue_delay = saved->max_queue_delay;
+    system->queue_delay_ns = saved->queue_delay_ns;
+    system->emergency_mode = saved->emergency_mode;
+    system->emergency_start_time = saved->emergency_start_time != 0
+                                   ? (time_t)saved->emergency_start_time + wall_shift : 0;
+    system->total_emergencies_handled = saved->total_emergencies_handled;
+    system->total_emergency_response_time = saved->total_emergency_response_time;
+    system->average_response_time = saved->average_response_time;
+    pthread_mutex_unlock(&system->lock);
+}
+
+// Read and check 'path' against the current geometry; call before the
+// system is initialised
+bool load_checkpoint(const char* path) {
+    size_t size = 0;
+    char* data = read_whole_file(path, &size);
+    if (!data) {
+        printf("Cannot read checkpoint %s\n", path);
+        return false;
+    }
+    const CheckpointHeader* header = NULL;
+    if (!validate_checkpoint(path, data, size, &header)) {
+        free(data);
+        return false;
+    }
+    free(loaded_data);
+    loaded_data = data;
+    loaded_size = size;
+    return true;
+}
+
+// Apply the loaded checkpoint to the initialised, not yet started system.
+// '*remaining_seconds' is the run time that was left when it was saved.
+bool restore_checkpoint(int* remaining_seconds) {
+    TrafficGuruSystem* sys = g_traffic_system;
+    if (!sys || sys->simulation_running || !loaded_data) {
+        return false;
+    }
+    const char* data = loaded_data;
+    size_t size = loaded_size;
+    const CheckpointHeader* header = (const CheckpointHeader*)data;
+
+    time_t wall_shift = time(NULL) - (time_t)header->wall_time;
+    long long monotonic_shift = monotonic_now_ns() - header->monotonic_ns;
+
+    CheckpointReader reader = { data, size, sizeof(CheckpointHeader) };
+    CheckpointSection section;
+    const void* body;
+    int lane = 0;
+    while ((body = next_section(&reader, &section)) != NULL && section.type != CHECKPOINT_END) {
+        switch (section.type) {
+            case CHECKPOINT_LANES:
+                restore_lane(&sys->lanes[lane++], body, monotonic_shift, wall_shift);
+                break;
+            case CHECKPOINT_SCHEDULER:
+                restore_scheduler(&sys->scheduler, body, monotonic_shift, wall_shift);
+                break;
+            case CHECKPOINT_MULTILEVEL:
+                restore_multilevel_checkpoint(body, wall_shift);
+                break;
+            case CHECKPOINT_ROUND_ROBIN:
+                restore_round_robin_checkpoint(body, wall_shift);
+                break;
+            case CHECKPOINT_BANKERS:
+                restore_bankers(get_global_bankers_state(), body);
+                break;
+            case CHECKPOINT_EMERGENCY:
+                restore_emergency(&sys->emergency_system, body, monotonic_shift, wall_shift);
+                break;
+            case CHECKPOINT_METRICS:
+                pthread_mutex_lock(&sys->global_state_lock);
+                memcpy(&sys->metrics, body, section.size);
+                sys->metrics.measurement_start_time += wall_shift;
+                sys->metrics.last_update_time += wall_shift;
+                pthread_mutex_unlock(&sys->global_state_lock);
+                break;
+            default:
+                break;
+        }
+    }
+
+    pthread_mutex_lock(&sys->global_state_lock);
+    sys->total_vehicles_generated = header->total_vehicles_generated;
+    sys->scenario_elapsed_ns = header->scenario_elapsed_ns;
+    sys->replay_elapsed_ns = header->replay_elapsed_ns;
+    sys->restored_elapsed_seconds = header->elapsed_seconds;
+    pthread_mutex_unlock(&sys->global_state_lock);
+    srand(header->random_seed);
+
+    LOG_INFO("Restored checkpoint: %d s in, %d s left, %d vehicles generated",
+             header->elapsed_seconds, header->remaining_seconds, header->total_vehicles_generated);
+    if (remaining_seconds) {
+        *remaining_seconds = header->remaining_seconds;
+    }
+    free(loaded_data);
+    loaded_data = NULL;
+    return true;
+}
+
+// --- Scheduling ---
+
+// 'path' is written at the end of the run, on request, and every
+// 'interval_seconds' if that is positive
+void set_checkpoint_schedule(const char* path, int interval_seconds) {
+    snprintf(checkpoint_path, sizeof(checkpoint_path), "%s", path ? path : "");
+    checkpoint_interval = interval_seconds > 0 ? interval_seconds : 0;
+    next_checkpoint_time = checkpoint_interval ? time(NULL) + checkpoint_interval : 0;
+}
+
+// Ask the simulation thread for a checkpoint at its next tick
+void request_checkpoint() {
+    if (checkpoint_path[0]) {
+        checkpoint_requested = true;
+    }
+}
+
+// Called by the simulation thread between time slices, and once more when
+// the run ends
+void checkpoint_tick() {
+    if (!checkpoint_path[0]) {
+        return;
+    }
+
+    time_t now = time(NULL);
+    bool due = checkpoint_interval && now >= next_checkpoint_time;
+    if (!checkpoint_requested && !due) {
+        return;
+    }
+    checkpoint_requested = false;
+    if (due) {
+        next_checkpoint_time = now + checkpoint_interval;
+    }
+    save_checkpoint(checkpoint_path);
+}
+
+// Final checkpoint after the threads have stopped; 'planned_end_time' is
+// when the run was due to end, so a run quit early keeps its remaining time
+void save_final_checkpoint(time_t planned_end_time) {
+    if (checkpoint_path[0] && g_traffic_system) {
+        write_checkpoint(checkpoint_path, planned_end_time);
+    }
+}
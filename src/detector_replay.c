@@ -0,0 +1,374 @@
+/*
+ * Detector Replay Implementation - Mapped, Streamed Count Files
+ *
+ * Records are read one at a time from the mapping. Each lane keeps one
+ * spread (vehicles left from its latest count and their spacing); the next
+ * arrival is the earliest spread vehicle, unless the next record comes
+ * first, in which case that record is folded into its lanes' spreads.
+ *
+ * Compilation: Include detector_replay.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/detector_replay.h"
+#include "../include/sim_clock.h"
+#include "../include/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define SECONDS_PER_DAY 86400
+
+static DetectorReplay* g_replay = NULL;
+static double g_replay_speed = 1.0;
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+static long long days_from_civil(int year, int month, int day) {
+    year -= month <= 2;
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    int year_of_era = (int)(year - era * 400);
+    int day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + day_of_era - 719468;
+}
+
+// "HH:MM[:SS[.fff]]" -> seconds of the day
+static bool parse_clock(const char* text, double* seconds) {
+    int hours, minutes, consumed = 0;
+    if (sscanf(text, "%d:%d%n", &hours, &minutes, &consumed) != 2 ||
+        hours < 0 || hours > 23 || minutes < 0 || minutes > 59) {
+        return false;
+    }
+    double second = 0;
+    text += consumed;
+    if (*text == ':') {
+        char* end;
+        second = strtod(text + 1, &end);
+        if (end == text + 1 || second < 0 || second >= 61) {
+            return false;
+        }
+        text = end;
+    }
+    *seconds = hours * 3600.0 + minutes * 60.0 + second;
+    return *text == '\0';
+}
+
+// Seconds, a time of day or a date and time -> nanoseconds on its own origin
+static bool parse_detector_time(const char* text, long long* time_ns) {
+    int year, month, day, consumed = 0;
+    double seconds;
+    if (sscanf(text, "%4d-%2d-%2d%n", &year, &month, &day, &consumed) == 3 &&
+        (text[consumed] == ' ' || text[consumed] == 'T')) {
+        if (month < 1 || month > 12 || day < 1 || day > 31 ||
+            !parse_clock(text + consumed + 1, &seconds)) {
+            return false;
+        }
+        *time_ns = days_from_civil(year, month, day) * SECONDS_PER_DAY * NS_PER_SEC +
+                   (long long)(seconds * NS_PER_SEC);
+        return true;
+    }
+
+    if (strchr(text, ':')) {
+        if (!parse_clock(text, &seconds)) {
+            return false;
+        }
+    } else {
+        char* end;
+        seconds = strtod(text, &end);
+        if (end == text || *end != '\0' || seconds < 0) {
+            return false;
+        }
+    }
+    *time_ns = (long long)(seconds * NS_PER_SEC);
+    return true;
+}
+
+static char* trim(char* text) {
+    while (isspace((unsigned char)*text)) {
+        text++;
+    }
+    char* end = text + strlen(text);
+    while (end > text && isspace((unsigned char)end[-1])) {
+        *--end = '\0';
+    }
+    return text;
+}
+
+// Lane id, lane name or approach name; an approach with one lane is that lane
+static bool resolve_detector_lane(const char* text, int* lane_id, int* approach) {
+    const IntersectionGeometry* geometry = get_intersection_geometry();
+    char* end;
+    long id = strtol(text, &end, 10);
+    if (end != text && *end == '\0') {
+        *lane_id = (int)id;
+        *approach = -1;
+        return id >= 0 && id < geometry->num_lanes;
+    }
+
+    for (int l = 0; l < geometry->num_lanes; l++) {
+        if (strcasecmp(geometry->lanes[l].name, text) == 0) {
+            *lane_id = l;
+            *approach = -1;
+            return true;
+        }
+    }
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        if (strcasecmp(geometry->approaches[a].name, text) == 0) {
+            *lane_id = -1;
+            *approach = a;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Copy the next line out of the mapping; false at end of file
+static bool read_line(DetectorReplay* replay, char* line) {
+    if (replay->offset >= replay->size) {
+        return false;
+    }
+    const char* start = replay->data + replay->offset;
+    size_t left = replay->size - replay->offset;
+    const char* newline = memchr(start, '\n', left);
+    size_t length = newline ? (size_t)(newline - start) : left;
+    replay->offset += newline ? length + 1 : length;
+    replay->line_number++;
+
+    // An overlong line is cut short and then fails to parse
+    if (length >= DETECTOR_LINE_MAX) {
+        length = DETECTOR_LINE_MAX - 1;
+    }
+    memcpy(line, start, length);
+    line[length] = '\0';
+    return true;
+}
+
+// <time>,<lane>[,<count>[,<interval>]]; false at end of file
+static bool read_csv_record(DetectorReplay* replay, DetectorCount* record) {
+    char buffer[DETECTOR_LINE_MAX];
+    while (read_line(replay, buffer)) {
+        char* comment = strchr(buffer, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        char* line = trim(buffer);
+        if (*line == '\0') {
+            continue;
+        }
+
+        char* save = NULL;
+        char* time_text = strtok_r(line, ",", &save);
+        char* lane_text = strtok_r(NULL, ",", &save);
+        char* count_text = strtok_r(NULL, ",", &save);
+        char* interval_text = strtok_r(NULL, ",", &save);
+
+        bool valid = time_text && lane_text &&
+                     parse_detector_time(trim(time_text), &record->time_ns);
+        if (!valid && replay->records == 0 && replay->skipped == 0) {
+            continue;   // Column header
+        }
+
+        record->count = 1;
+        record->interval_ns = 0;
+        if (valid && count_text) {
+            char* end;
+            long count = strtol(trim(count_text), &end, 10);
+            valid = *end == '\0' && count >= 0 && count <= UINT16_MAX;
+            double interval = DETECTOR_DEFAULT_INTERVAL;
+            if (interval_text) {
+                interval = strtod(trim(interval_text), &end);
+                valid = valid && *end == '\0' && interval >= 0;
+            }
+            record->count = (int)count;
+            record->interval_ns = (long long)(interval * NS_PER_SEC);
+        }
+        if (valid) {
+            valid = resolve_detector_lane(trim(lane_text), &record->lane_id, &record->approach);
+        }
+        if (!valid) {
+            replay->skipped++;
+            LOG_WARN("%s:%d: skipped, expected <time>,<lane>[,<count>[,<interval>]]",
+                     replay->path, replay->line_number);
+            continue;
+        }
+        return true;
+    }
+    return false;
+}
+
+// Next fixed-width record; a partial one at the end is ignored
+static bool read_binary_record(DetectorReplay* replay, DetectorCount* record) {
+    while (replay->offset + sizeof(DetectorRecord) <= replay->size) {
+        DetectorRecord raw;
+        memcpy(&raw, replay->data + replay->offset, sizeof(raw));
+        replay->offset += sizeof(raw);
+
+        if (raw.lane_id >= get_num_lanes()) {
+            replay->skipped++;
+            continue;
+        }
+        record->time_ns = raw.timestamp_ns;
+        record->lane_id = raw.lane_id;
+        record->approach = -1;
+        record->count = raw.count;
+        record->interval_ns = (long long)raw.interval_ms * NS_PER_MS;
+        return true;
+    }
+    return false;
+}
+
+// Read a record and put its time on the replay's origin
+static bool read_detector_record(DetectorReplay* replay, DetectorCount* record) {
+    if (!(replay->binary ? read_binary_record(replay, record) : read_csv_record(replay, record))) {
+        return false;
+    }
+    if (!replay->have_origin) {
+        replay->origin_ns = record->time_ns;
+        replay->have_origin = true;
+    }
+    record->time_ns -= replay->origin_ns;
+    if (record->time_ns < replay->record_ns) {
+        replay->out_of_order++;
+        record->time_ns = replay->record_ns;
+    }
+    replay->record_ns = record->time_ns;
+    replay->records++;
+    return true;
+}
+
+// Vehicles still to come from the lane's last count join the new one
+static void add_to_spread(DetectorSpread* spread, long long time_ns, int count, long long interval_ns) {
+    if (count <= 0) {
+        return;
+    }
+    spread->remaining += count;
+    spread->step_ns = interval_ns / spread->remaining;
+    spread->next_ns = time_ns + spread->step_ns / 2;
+}
+
+// An approach's count is shared over its lanes, the remainder taken in turn
+static void spread_record(DetectorReplay* replay, const DetectorCount* record) {
+    if (record->lane_id >= 0) {
+        add_to_spread(&replay->spreads[record->lane_id], record->time_ns, record->count,
+                      record->interval_ns);
+        return;
+    }
+
+    const GeometryApproach* approach = &get_intersection_geometry()->approaches[record->approach];
+    int* turn = &replay->approach_turn[record->approach];
+    for (int i = 0; i < approach->num_lanes; i++) {
+        int share = record->count / approach->num_lanes +
+                    ((i - *turn + approach->num_lanes) % approach->num_lanes <
+                     record->count % approach->num_lanes);
+        add_to_spread(&replay->spreads[approach->first_lane + i], record->time_ns, share,
+                      record->interval_ns);
+    }
+    *turn = (*turn + record->count) % approach->num_lanes;
+}
+
+bool open_detector_replay(DetectorReplay* replay, const char* path) {
+    memset(replay, 0, sizeof(DetectorReplay));
+    snprintf(replay->path, sizeof(replay->path), "%s", path);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Cannot open detector file %s\n", path);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        printf("%s: empty detector file\n", path);
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("%s: cannot map the detector file\n", path);
+        return false;
+    }
+    posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+    replay->data = map;
+    replay->size = (size_t)st.st_size;
+
+    const DetectorFileHeader* header = (const DetectorFileHeader*)map;
+    if (replay->size >= sizeof(DetectorFileHeader) &&
+        memcmp(header->magic, DETECTOR_MAGIC, 4) == 0) {
+        if (header->version != DETECTOR_VERSION || header->record_size != sizeof(DetectorRecord)) {
+            printf("%s: unsupported detector file version or record size\n", path);
+            close_detector_replay(replay);
+            return false;
+        }
+        replay->binary = true;
+        replay->offset = sizeof(DetectorFileHeader);
+    }
+
+    // Read ahead to the first record so an unusable file fails here
+    replay->have_next = read_detector_record(replay, &replay->next);
+    if (!replay->have_next) {
+        printf("%s: no detector records for geometry %s\n", path, get_intersection_geometry()->name);
+        close_detector_replay(replay);
+        return false;
+    }
+    return true;
+}
+
+void close_detector_replay(DetectorReplay* replay) {
+    if (replay && replay->data) {
+        munmap((void*)replay->data, replay->size);
+        replay->data = NULL;
+        replay->size = 0;
+    }
+}
+
+// Next vehicle in time order; false once the file and every spread are used up
+bool next_detector_arrival(DetectorReplay* replay, DetectorArrival* arrival) {
+    for (;;) {
+        int lane = -1;
+        for (int l = 0; l < MAX_LANES; l++) {
+            if (replay->spreads[l].remaining > 0 &&
+                (lane < 0 || replay->spreads[l].next_ns < replay->spreads[lane].next_ns)) {
+                lane = l;
+            }
+        }
+
+        if (!replay->have_next && replay->data) {
+            replay->have_next = read_detector_record(replay, &replay->next);
+        }
+        if (lane >= 0 && (!replay->have_next || replay->spreads[lane].next_ns <= replay->next.time_ns)) {
+            DetectorSpread* spread = &replay->spreads[lane];
+            arrival->time_ns = spread->next_ns;
+            arrival->lane_id = lane;
+            spread->remaining--;
+            spread->next_ns += spread->step_ns;
+            replay->vehicles++;
+            return true;
+        }
+        if (!replay->have_next) {
+            return false;
+        }
+        spread_record(replay, &replay->next);
+        replay->have_next = false;
+    }
+}
+
+void set_detector_replay(DetectorReplay* replay, double speed) {
+    g_replay = replay;
+    g_replay_speed = speed > 0 ? speed : 1.0;
+}
+
+// NULL when arrivals are generated
+DetectorReplay* get_detector_replay() {
+    return g_replay;
+}
+
+double get_detector_replay_speed() {
+    return g_replay_speed;
+}
@@ -3,13 +3,19 @@
  *
  * Handles detection, preemption, and clearance of emergency vehicles at intersections.
  * Supports multiple emergency types with priority-based signal override.
+ * Emergencies that arrive while another is being served wait in a bounded
+ * priority heap and are dispatched in key order as each one clears.
  *
  * Compilation: Include emergency_system.h, synchronization.h, traffic_mutex.h
  */
 
+#define _XOPEN_SOURCE 600
 #include "../include/emergency_system.h"
 #include "../include/synchronization.h"
 #include "../include/traffic_mutex.h"
+#include "../include/logger.h"
+#include "../include/sim_clock.h"
+#include "../include/vehicle_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -25,6 +31,8 @@ static bool emergency_system_initialized = false;
 #define DEFAULT_CROSSING_DURATION_MAX 6.0f
 #define DEFAULT_EMERGENCY_PROBABILITY 200
 
+static void dispatch_next_emergency(EmergencySystem* system);
+
 // Get global emergency system instance
 EmergencySystem* get_global_emergency_system() {
     if (!emergency_system_initialized) {
@@ -39,8 +47,17 @@ void init_emergency_system(EmergencySystem* system) {
         return;
     }
 
+    pthread_mutex_init(&system->lock, NULL);
     memset(&system->current_emergency, 0, sizeof(EmergencyVehicle));
     system->current_emergency.active = false;
+    system->pending_count = 0;
+    system->next_sequence = 0;
+    system->emergencies_queued = 0;
+    system->emergencies_dropped = 0;
+    system->max_queue_delay = 0.0f;
+    init_latency_histogram(&system->queue_delay_ns);
+    system->scheduler = NULL;
+    system->metrics = NULL;
     system->emergency_mode = false;
     system->emergency_start_time = 0;
     system->total_emergencies_handled = 0;
@@ -53,6 +70,28 @@ void init_emergency_system(EmergencySystem* system) {
     }
 }
 
+// Route preemption requests to the scheduler that controls the signals
+void attach_emergency_scheduler(EmergencySystem* system, Scheduler* scheduler) {
+    if (!system) {
+        return;
+    }
+
+    pthread_mutex_lock(&system->lock);
+    system->scheduler = scheduler;
+    pthread_mutex_unlock(&system->lock);
+}
+
+// Report response times of cleared emergencies to the given metrics
+void attach_emergency_metrics(EmergencySystem* system, PerformanceMetrics* metrics) {
+    if (!system) {
+        return;
+    }
+
+    pthread_mutex_lock(&system->lock);
+    system->metrics = metrics;
+    pthread_mutex_unlock(&system->lock);
+}
+
 // Destroy emergency system
 void destroy_emergency_system(EmergencySystem* system) {
     if (!system) {
@@ -63,6 +102,9 @@ void destroy_emergency_system(EmergencySystem* system) {
     if (system->current_emergency.active) {
         system->current_emergency.active = false;
     }
+    system->pending_count = 0;
+
+    pthread_mutex_destroy(&system->lock);
 
     if (system == &g_emergency_system) {
         emergency_system_initialized = false;
@@ -75,12 +117,21 @@ void reset_emergency_system(EmergencySystem* system) {
         return;
     }
 
+    pthread_mutex_lock(&system->lock);
+
     memset(&system->current_emergency, 0, sizeof(EmergencyVehicle));
+    system->pending_count = 0;
+    system->emergencies_queued = 0;
+    system->emergencies_dropped = 0;
+    system->max_queue_delay = 0.0f;
+    reset_latency_histogram(&system->queue_delay_ns);
     system->emergency_mode = false;
     system->emergency_start_time = 0;
     system->total_emergencies_handled = 0;
     system->total_emergency_response_time = 0.0f;
     system->average_response_time = 0.0f;
+
+    pthread_mutex_unlock(&system->lock);
 }
 
 // Detect emergency vehicle in a lane
@@ -91,11 +142,11 @@ bool detect_emergency_vehicle(LaneProcess* lane) {
 
     // Random emergency vehicle generation
     if (rand() % DEFAULT_EMERGENCY_PROBABILITY == 0) {
-        EmergencyVehicle* emergency = generate_random_emergency();
-        emergency->lane_id = lane->lane_id;
+        EmergencyVehicle emergency = generate_random_emergency();
+        emergency.lane_id = lane->lane_id;
 
         EmergencySystem* system = get_global_emergency_system();
-        add_emergency_vehicle(system, emergency);
+        add_emergency_vehicle(system, &emergency);
 
         return true;
     }
@@ -103,22 +154,119 @@ bool detect_emergency_vehicle(LaneProcess* lane) {
     return false;
 }
 
-// Generate random emergency vehicle
-EmergencyVehicle* generate_random_emergency() {
-    static EmergencyVehicle emergency; // Static to return pointer
+// Generate random emergency vehicle (returned by value, safe from any thread)
+EmergencyVehicle generate_random_emergency() {
+    EmergencyVehicle emergency = {0};
 
     emergency.type = rand() % 3 + 1; // Random type 1-3
-    emergency.lane_id = rand() % 4;   // Random lane 0-3
+    emergency.lane_id = rand() % get_num_lanes();
     emergency.approach_time = DEFAULT_APPROACH_TIME_MIN +
                              (float)(rand() % (int)(DEFAULT_APPROACH_TIME_MAX - DEFAULT_APPROACH_TIME_MIN));
-    emergency.priority_level = 1; // Highest priority
+    emergency.priority_level = calculate_emergency_priority(emergency.type);
     emergency.crossing_duration = DEFAULT_CROSSING_DURATION_MIN +
                                  (float)(rand() % (int)(DEFAULT_CROSSING_DURATION_MAX - DEFAULT_CROSSING_DURATION_MIN));
     emergency.timestamp = time(NULL);
     emergency.active = true;
     emergency.vehicle_id = rand() % 10000;
 
-    return &emergency;
+    return emergency;
+}
+
+// Heap ordering: smaller key first, detection order on ties
+static bool emergency_entry_before(const EmergencyQueueEntry* a, const EmergencyQueueEntry* b) {
+    if (a->key != b->key) {
+        return a->key < b->key;
+    }
+    return a->sequence < b->sequence;
+}
+
+static void swap_emergency_entries(EmergencyQueueEntry* a, EmergencyQueueEntry* b) {
+    EmergencyQueueEntry temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+// Insert into the pending heap (caller holds system->lock)
+static bool push_pending_emergency(EmergencySystem* system, const EmergencyVehicle* emergency) {
+    if (system->pending_count >= EMERGENCY_QUEUE_CAPACITY) {
+        return false;
+    }
+
+    int index = system->pending_count++;
+    EmergencyQueueEntry* entry = &system->pending[index];
+    entry->vehicle = *emergency;
+    entry->key = (double)emergency->detected_ns / NS_PER_SEC + emergency->approach_time +
+                 (emergency->priority_level - 1) * EMERGENCY_PRIORITY_SPACING;
+    entry->sequence = system->next_sequence++;
+
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!emergency_entry_before(&system->pending[index], &system->pending[parent])) {
+            break;
+        }
+        swap_emergency_entries(&system->pending[index], &system->pending[parent]);
+        index = parent;
+    }
+
+    return true;
+}
+
+// Remove the most urgent pending emergency (caller holds system->lock)
+static bool pop_pending_emergency(EmergencySystem* system, EmergencyVehicle* emergency) {
+    if (system->pending_count == 0) {
+        return false;
+    }
+
+    *emergency = system->pending[0].vehicle;
+    system->pending[0] = system->pending[--system->pending_count];
+
+    int index = 0;
+    while (true) {
+        int left = 2 * index + 1;
+        int right = left + 1;
+        int smallest = index;
+
+        if (left < system->pending_count &&
+            emergency_entry_before(&system->pending[left], &system->pending[smallest])) {
+            smallest = left;
+        }
+        if (right < system->pending_count &&
+            emergency_entry_before(&system->pending[right], &system->pending[smallest])) {
+            smallest = right;
+        }
+        if (smallest == index) {
+            break;
+        }
+
+        swap_emergency_entries(&system->pending[index], &system->pending[smallest]);
+        index = smallest;
+    }
+
+    return true;
+}
+
+// Make the most urgent pending emergency current (caller holds system->lock)
+static void dispatch_next_emergency(EmergencySystem* system) {
+    EmergencyVehicle next;
+    if (system->current_emergency.active || !pop_pending_emergency(system, &next)) {
+        return;
+    }
+
+    long long delay_ns = monotonic_now_ns() - next.detected_ns;
+    next.queue_delay = (float)delay_ns / NS_PER_SEC;
+    histogram_record(&system->queue_delay_ns, delay_ns);
+    if (next.queue_delay > system->max_queue_delay) {
+        system->max_queue_delay = next.queue_delay;
+    }
+
+    system->current_emergency = next;
+    system->current_emergency.active = true;
+
+    LOG_DEBUG("Dispatching %s for lane %d after %.3fs in queue (%d still pending)",
+              get_emergency_type_name(next.type), next.lane_id,
+              next.queue_delay, system->pending_count);
+
+    preempt_for_emergency(system, &system->current_emergency);
 }
 
 // Add emergency vehicle to system
@@ -127,22 +275,57 @@ void add_emergency_vehicle(EmergencySystem* system, EmergencyVehicle* emergency)
         return;
     }
 
-    printf("🚨 EMERGENCY DETECTED: %s approaching lane %d (Vehicle ID: %d) 🚨\n",
+    LOG_WARN("EMERGENCY DETECTED: %s approaching lane %d (Vehicle ID: %d)",
            get_emergency_type_name(emergency->type), emergency->lane_id, emergency->vehicle_id);
 
-    // If there's already an active emergency, queue this one
-    if (system->current_emergency.active) {
-        printf("Emergency already active, queuing new emergency\n");
-        // In a more sophisticated implementation, we'd maintain a queue
+    EmergencyVehicle request = *emergency;
+    request.detected_ns = monotonic_now_ns();
+    request.arrival_ns = request.detected_ns + (long long)(request.approach_time * NS_PER_SEC);
+    request.green_ns = 0;
+    request.crossing_start_ns = 0;
+    request.queue_delay = 0.0f;
+    request.active = true;
+    if (request.priority_level <= 0) {
+        request.priority_level = calculate_emergency_priority(request.type);
+    }
+
+    trace_vehicle_event(TRACE_EMERGENCY_DETECTED, request.vehicle_id, request.lane_id, request.type,
+                        (int)(request.approach_time * 1000.0f));
+
+    pthread_mutex_lock(&system->lock);
+
+    if (!push_pending_emergency(system, &request)) {
+        system->emergencies_dropped++;
+        LOG_ERROR("Emergency queue full (%d pending), dropping %s for lane %d",
+                  system->pending_count, get_emergency_type_name(request.type), request.lane_id);
+        pthread_mutex_unlock(&system->lock);
         return;
     }
 
-    // Set as current emergency
-    memcpy(&system->current_emergency, emergency, sizeof(EmergencyVehicle));
-    system->current_emergency.active = true;
+    // If there's already an active emergency, this one waits in the heap
+    if (system->current_emergency.active) {
+        system->emergencies_queued++;
+        LOG_WARN("Emergency already active, queued %s (%d pending)",
+                 get_emergency_type_name(request.type), system->pending_count);
+    } else {
+        // Trigger immediate preemption
+        dispatch_next_emergency(system);
+    }
 
-    // Trigger immediate preemption
-    preempt_for_emergency(system, emergency);
+    pthread_mutex_unlock(&system->lock);
+}
+
+// Number of emergencies waiting behind the current one
+int get_pending_emergency_count(EmergencySystem* system) {
+    if (!system) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&system->lock);
+    int count = system->pending_count;
+    pthread_mutex_unlock(&system->lock);
+
+    return count;
 }
 
 // Preempt normal traffic for emergency vehicle
@@ -152,54 +335,113 @@ void preempt_for_emergency(EmergencySystem* system, EmergencyVehicle* emergency)
     }
 
     if (!system->preempt_enabled) {
-        printf("Preemption disabled, emergency vehicle must wait\n");
+        LOG_WARN("Preemption disabled, emergency vehicle must wait");
         return;
     }
 
-    printf("PREEMPTING: Clearing intersection for emergency vehicle\n");
-
     // Set emergency mode
     system->emergency_mode = true;
     system->emergency_start_time = time(NULL);
 
+    if (emergency->arrival_ns == 0) {
+        emergency->detected_ns = monotonic_now_ns();
+        emergency->arrival_ns = emergency->detected_ns + (long long)(emergency->approach_time * NS_PER_SEC);
+    }
+
+    // With enough lead time the scheduler drains the lane ahead of arrival;
+    // otherwise it interrupts the running lane, holds all-red for the
+    // clearance interval and then gives the emergency lane green
+    if (system->scheduler &&
+        request_emergency_preclear(system->scheduler, emergency->lane_id,
+                                   emergency->detected_ns, emergency->arrival_ns)) {
+        LOG_INFO("PRE-CLEARING: lane %d planned for %s arriving in %.1fs",
+                 emergency->lane_id, get_emergency_type_name(emergency->type),
+                 (double)(emergency->arrival_ns - monotonic_now_ns()) / NS_PER_SEC);
+        return;
+    }
+
+    LOG_INFO("PREEMPTING: Clearing intersection for emergency vehicle");
+
     // Reset intersection state to clear any current allocation
     reset_intersection_state();
 
-    // In a real implementation, we would:
-    // 1. Force current lane to stop
-    // 2. Set all signals to red
-    // 3. Set emergency lane to green
-    // 4. Monitor emergency progress
-
-    printf("Intersection cleared for emergency vehicle in lane %d\n", emergency->lane_id);
+    LOG_INFO("Intersection cleared for emergency vehicle in lane %d", emergency->lane_id);
 }
 
 // Handle emergency vehicle clearance
 void handle_emergency_clearance(EmergencySystem* system) {
-    if (!system || !system->current_emergency.active) {
+    if (!system) {
+        return;
+    }
+
+    pthread_mutex_lock(&system->lock);
+
+    if (!system->current_emergency.active) {
+        pthread_mutex_unlock(&system->lock);
         return;
     }
 
     EmergencyVehicle* emergency = &system->current_emergency;
-    time_t elapsed = time(NULL) - system->emergency_start_time;
+    long long now_ns = monotonic_now_ns();
+
+    // The crossing starts once the vehicle is at the stop line with green
+    if (emergency->crossing_start_ns == 0) {
+        long long green_since_ns = 0;
+        bool green = !system->scheduler || !system->preempt_enabled ||
+                     is_emergency_green_for_lane(system->scheduler, emergency->lane_id,
+                                                 &green_since_ns);
+        if (now_ns < emergency->arrival_ns || !green) {
+            pthread_mutex_unlock(&system->lock);
+            return;
+        }
+
+        // Without signal control the vehicle just goes when it arrives
+        emergency->green_ns = green_since_ns > 0 ? green_since_ns : emergency->arrival_ns;
+
+        // Whichever came last: arrival or green (this check may run late)
+        emergency->crossing_start_ns = emergency->arrival_ns > green_since_ns ?
+                                       emergency->arrival_ns : green_since_ns;
+        LOG_INFO("%s crossing from lane %d", get_emergency_type_name(emergency->type),
+                 emergency->lane_id);
+    }
 
     // Check if emergency vehicle should have cleared intersection
-    if (elapsed >= (time_t)emergency->crossing_duration) {
-        printf("Emergency vehicle cleared intersection\n");
+    long long cleared_ns = emergency->crossing_start_ns +
+                           (long long)(emergency->crossing_duration * NS_PER_SEC);
+    if (now_ns >= cleared_ns) {
+        LOG_INFO("Emergency vehicle cleared intersection");
 
-        // Update statistics
-        update_emergency_statistics(system, emergency->approach_time);
+        record_emergency_response(system->metrics, emergency->type, emergency->detected_ns,
+                                  emergency->green_ns, cleared_ns);
+        trace_vehicle_event(TRACE_EMERGENCY_CLEARED, emergency->vehicle_id, emergency->lane_id,
+                            emergency->type, (int)((cleared_ns - emergency->detected_ns) / NS_PER_MS));
+
+        // Update statistics: detection until the vehicle entered the intersection
+        update_emergency_statistics(system,
+                                    (float)(emergency->crossing_start_ns - emergency->detected_ns) / NS_PER_SEC);
 
         // Clear emergency
         memset(&system->current_emergency, 0, sizeof(EmergencyVehicle));
         system->current_emergency.active = false;
         system->emergency_mode = false;
 
-        // Resume normal scheduling
-        resume_normal_scheduling_after_emergency();
+        if (system->scheduler) {
+            clear_emergency_preemption(system->scheduler);
+        }
+
+        if (system->pending_count > 0) {
+            // Serve the next queued emergency before normal traffic resumes
+            LOG_INFO("Serving next queued emergency (%d pending)", system->pending_count);
+            dispatch_next_emergency(system);
+        } else {
+            // Resume normal scheduling
+            resume_normal_scheduling_after_emergency();
 
-        printf("Normal traffic scheduling resumed\n");
+            LOG_INFO("Normal traffic scheduling resumed");
+        }
     }
+
+    pthread_mutex_unlock(&system->lock);
 }
 
 // Resume normal scheduling after emergency
@@ -217,7 +459,7 @@ bool process_emergency_request(EmergencySystem* system, EmergencyVehicle* emerge
 
     // Check if preemption is allowed
     if (!system->preempt_enabled) {
-        printf("Emergency preemption is disabled\n");
+        LOG_WARN("Emergency preemption is disabled");
         return false;
     }
 
@@ -232,10 +474,8 @@ void update_emergency_progress(EmergencySystem* system) {
         return;
     }
 
-    // Handle clearance if emergency is active
-    if (system->current_emergency.active) {
-        handle_emergency_clearance(system);
-    }
+    // Handle clearance if emergency is active (checked under the lock)
+    handle_emergency_clearance(system);
 }
 
 // Check if emergency is active
@@ -253,17 +493,16 @@ void set_emergency_priority(LaneProcess* lane, int priority) {
 }
 
 
-// Calculate emergency priority based on type
+// Calculate emergency priority based on type (1 = most urgent)
 int calculate_emergency_priority(EmergencyType type) {
-    // All emergency vehicles get highest priority
-    // Can be extended for different emergency types
     switch (type) {
         case EMERGENCY_AMBULANCE:
         case EMERGENCY_FIRE_TRUCK:
+            return 1; // Life-safety response
         case EMERGENCY_POLICE:
-            return 1; // Highest priority
+            return 2;
         default:
-            return 2; // Normal priority
+            return 3; // Unclassified emergency
     }
 }
 
@@ -273,7 +512,7 @@ EmergencyVehicle create_ambulance(int lane_id) {
         .type = EMERGENCY_AMBULANCE,
         .lane_id = lane_id,
         .approach_time = DEFAULT_APPROACH_TIME_MIN + (float)(rand() % 5),
-        .priority_level = 1,
+        .priority_level = calculate_emergency_priority(EMERGENCY_AMBULANCE),
         .crossing_duration = DEFAULT_CROSSING_DURATION_MIN + (float)(rand() % 2),
         .timestamp = time(NULL),
         .active = true,
@@ -287,7 +526,7 @@ EmergencyVehicle create_fire_truck(int lane_id) {
         .type = EMERGENCY_FIRE_TRUCK,
         .lane_id = lane_id,
         .approach_time = DEFAULT_APPROACH_TIME_MIN + (float)(rand() % 8),
-        .priority_level = 1,
+        .priority_level = calculate_emergency_priority(EMERGENCY_FIRE_TRUCK),
         .crossing_duration = DEFAULT_CROSSING_DURATION_MIN + 2.0f + (float)(rand() % 2),
         .timestamp = time(NULL),
         .active = true,
@@ -301,7 +540,7 @@ EmergencyVehicle create_police_vehicle(int lane_id) {
         .type = EMERGENCY_POLICE,
         .lane_id = lane_id,
         .approach_time = DEFAULT_APPROACH_TIME_MIN + (float)(rand() % 6),
-        .priority_level = 1,
+        .priority_level = calculate_emergency_priority(EMERGENCY_POLICE),
         .crossing_duration = DEFAULT_CROSSING_DURATION_MIN + (float)(rand() % 3),
         .timestamp = time(NULL),
         .active = true,
@@ -315,7 +554,7 @@ EmergencyVehicle create_custom_emergency(EmergencyType type, int lane_id) {
         .type = type,
         .lane_id = lane_id,
         .approach_time = DEFAULT_APPROACH_TIME_MIN + (float)(rand() % 10),
-        .priority_level = 1,
+        .priority_level = calculate_emergency_priority(type),
         .crossing_duration = DEFAULT_CROSSING_DURATION_MIN + (float)(rand() % 4),
         .timestamp = time(NULL),
         .active = true,
@@ -419,6 +658,12 @@ void print_emergency_system_status(EmergencySystem* system) {
     printf("Total Emergencies Handled: %d\n", system->total_emergencies_handled);
     printf("Average Response Time: %.2f seconds\n", system->average_response_time);
     printf("Preemption Enabled: %s\n", system->preempt_enabled ? "Yes" : "No");
+    printf("Pending Emergencies: %d (queued: %d, dropped: %d)\n",
+           system->pending_count, system->emergencies_queued, system->emergencies_dropped);
+    printf("Queue Delay p50/p99/max: %.2f / %.2f / %.2f seconds\n",
+           histogram_percentile(&system->queue_delay_ns, 50.0) / (double)NS_PER_SEC,
+           histogram_percentile(&system->queue_delay_ns, 99.0) / (double)NS_PER_SEC,
+           system->max_queue_delay);
 
     if (system->current_emergency.active) {
         printf("\nCurrent Emergency:\n");
@@ -442,7 +687,7 @@ bool validate_emergency_vehicle(EmergencyVehicle* emergency) {
     }
 
     // Check lane validity
-    if (emergency->lane_id < 0 || emergency->lane_id >= 4) {
+    if (emergency->lane_id < 0 || emergency->lane_id >= get_num_lanes()) {
         return false;
     }
 
@@ -463,7 +708,7 @@ bool validate_emergency_vehicle(EmergencyVehicle* emergency) {
 void set_preemption_enabled(EmergencySystem* system, bool enabled) {
     if (system) {
         system->preempt_enabled = enabled;
-        printf("Emergency preemption %s\n", enabled ? "enabled" : "disabled");
+        LOG_INFO("Emergency preemption %s", enabled ? "enabled" : "disabled");
     }
 }
 
@@ -475,7 +720,7 @@ bool is_preemption_enabled(EmergencySystem* system) {
 // Set emergency probability (for testing)
 void set_emergency_probability(int probability) {
     // This would typically be a global variable or config setting
-    printf("Emergency probability set to 1 in %d\n", probability);
+    LOG_INFO("Emergency probability set to 1 in %d", probability);
 }
 
 // Create test emergency vehicle
@@ -485,7 +730,7 @@ EmergencyVehicle* create_test_emergency(EmergencyType type, int lane_id, float a
     test_emergency.type = type;
     test_emergency.lane_id = lane_id;
     test_emergency.approach_time = approach_time;
-    test_emergency.priority_level = 1;
+    test_emergency.priority_level = calculate_emergency_priority(type);
     test_emergency.crossing_duration = 4.0f;
     test_emergency.timestamp = time(NULL);
     test_emergency.active = true;
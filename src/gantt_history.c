@@ -0,0 +1,142 @@
+/*
+ * Gantt History Implementation - Bucket Pyramid Behind a Sequence Counter
+ *
+ * Level 0 decides whether a lane-second is new (its count is 0 or 1), so
+ * back-to-back slices that share a boundary second are not counted twice;
+ * each new green second then adds one to the covering bucket of every
+ * level. A ring slot whose id is not the bucket being written belongs to
+ * older history and is reset first.
+ *
+ * Compilation: Include gantt_history.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/gantt_history.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Create an empty history; every slot starts out as an empty bucket
+GanttHistory* create_gantt_history() {
+    GanttHistory* history = (GanttHistory*)malloc(sizeof(GanttHistory));
+    if (!history) {
+        return NULL;
+    }
+
+    memset(history, 0, sizeof(GanttHistory));
+    for (int level = 0; level < GANTT_LEVELS; level++) {
+        for (int i = 0; i < GANTT_LEVEL_BUCKETS; i++) {
+            history->buckets[level][i].id = -1;
+        }
+    }
+    pthread_mutex_init(&history->write_lock, NULL);
+    return history;
+}
+
+void destroy_gantt_history(GanttHistory* history) {
+    if (!history) {
+        return;
+    }
+    pthread_mutex_destroy(&history->write_lock);
+    free(history);
+}
+
+// Slot for bucket 'id' at 'level', reset if it still holds older history
+static GanttBucket* bucket_for(GanttHistory* history, int level, long long id) {
+    GanttBucket* bucket = &history->buckets[level][id % GANTT_LEVEL_BUCKETS];
+    if (bucket->id != id) {
+        memset(bucket, 0, sizeof(GanttBucket));
+        bucket->id = id;
+    }
+    return bucket;
+}
+
+// Fold one execution record in; the slice was green over [start, end)
+void gantt_record_interval(GanttHistory* history, int lane_id, time_t start_time,
+                           time_t end_time, int vehicles_processed) {
+    if (!history || lane_id < 0 || lane_id >= GANTT_LANES ||
+        start_time <= 0 || end_time < start_time) {
+        return;
+    }
+
+    pthread_mutex_lock(&history->write_lock);
+
+    unsigned int sequence = history->sequence;
+    __atomic_store_n(&history->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    // A slice longer than the finest ring only needs its recent part there
+    long long first = (long long)start_time;
+    long long last = (long long)end_time;
+    if (last - first > GANTT_LEVEL_BUCKETS) {
+        first = last - GANTT_LEVEL_BUCKETS;
+    }
+
+    for (long long second = first; second < last; second++) {
+        GanttBucket* base = bucket_for(history, 0, second);
+        if (base->green_seconds[lane_id] != 0) {
+            continue;
+        }
+        base->green_seconds[lane_id] = 1;
+        for (int level = 1; level < GANTT_LEVELS; level++) {
+            bucket_for(history, level, second >> level)->green_seconds[lane_id]++;
+        }
+    }
+
+    if (vehicles_processed > 0) {
+        GanttBucket* base = bucket_for(history, 0, last);
+        base->served += vehicles_processed;
+        base->served_peak = base->served;
+        for (int level = 1; level < GANTT_LEVELS; level++) {
+            GanttBucket* bucket = bucket_for(history, level, last >> level);
+            bucket->served += vehicles_processed;
+            if (base->served > bucket->served_peak) {
+                bucket->served_peak = base->served;
+            }
+        }
+    }
+
+    __atomic_add_fetch(&history->intervals_recorded, 1, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&history->sequence, sequence + 2, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&history->write_lock);
+}
+
+bool gantt_read_buckets(GanttHistory* history, int level, long long first_id,
+                        int count, GanttBucket* out) {
+    if (!history || !out || level < 0 || level >= GANTT_LEVELS ||
+        count <= 0 || count > GANTT_LEVEL_BUCKETS) {
+        return false;
+    }
+
+    unsigned int before, after;
+    do {
+        before = __atomic_load_n(&history->sequence, __ATOMIC_ACQUIRE);
+        for (int i = 0; i < count; i++) {
+            long long id = first_id + i;
+            if (id < 0) {
+                memset(&out[i], 0, sizeof(GanttBucket));
+                out[i].id = -1;
+                continue;
+            }
+            out[i] = history->buckets[level][id % GANTT_LEVEL_BUCKETS];
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&history->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+
+    // Slots that hold another bucket (older or not yet written) read as empty
+    for (int i = 0; i < count; i++) {
+        if (out[i].id != first_id + i) {
+            memset(&out[i], 0, sizeof(GanttBucket));
+            out[i].id = -1;
+        }
+    }
+    return true;
+}
+
+long long gantt_intervals_recorded(GanttHistory* history) {
+    if (!history) {
+        return 0;
+    }
+    return __atomic_load_n(&history->intervals_recorded, __ATOMIC_RELAXED);
+}
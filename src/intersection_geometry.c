@@ -0,0 +1,414 @@
+/*
+ * Intersection Geometry Implementation - Presets, Parsing and Quadrant Sets
+ *
+ * Presets are written in the geometry file format and go through the same
+ * parser as files. After parsing, each approach's exits are resolved from
+ * the bearings and each lane's quadrant set per movement is precomputed,
+ * so callers on the scheduling path only index tables.
+ *
+ * Compilation: Include intersection_geometry.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/intersection_geometry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#define GEOMETRY_FILE_MAX_BYTES 8192
+#define APPROACH_NAME_MAX 12            // Leaves room for a lane number
+
+typedef struct {
+    const char* name;
+    const char* text;
+} GeometryPreset;
+
+static const GeometryPreset geometry_presets[] = {
+    {"four-way",
+     "approach North 0 1\n"
+     "approach South 180 1\n"
+     "approach East 90 1\n"
+     "approach West 270 1\n"},
+    {"t-junction",
+     "approach East 90 1\n"
+     "approach West 270 1\n"
+     "approach South 180 1\n"},
+    {"five-leg",
+     "approach North 0 1\n"
+     "approach East 72 1\n"
+     "approach SouthEast 144 1\n"
+     "approach SouthWest 216 1\n"
+     "approach West 288 1\n"},
+    {"four-way-dual",
+     "approach North 0 2\n"
+     "approach South 180 2\n"
+     "approach East 90 2\n"
+     "approach West 270 2\n"},
+};
+
+static const char movement_letters[NUM_MOVEMENTS] = {'L', 'S', 'R', 'U'};
+
+static IntersectionGeometry g_geometry;
+static bool geometry_initialized = false;
+
+// Smallest angle between two bearings, 0-180
+static int bearing_distance(int a, int b) {
+    int d = ((a - b) % 360 + 360) % 360;
+    return d > 180 ? 360 - d : d;
+}
+
+// Approach nearest 'bearing' within the tolerance, other than 'from'; -1 if none
+static int nearest_exit(const IntersectionGeometry* geometry, int from, int bearing) {
+    int best = -1;
+    int best_distance = GEOMETRY_EXIT_TOLERANCE + 1;
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        int distance = bearing_distance(geometry->approaches[a].bearing, bearing);
+        if (a != from && distance < best_distance) {
+            best = a;
+            best_distance = distance;
+        }
+    }
+    return best;
+}
+
+// Next approach counter-clockwise (the one at the largest smaller bearing)
+static int counter_clockwise_neighbour(const IntersectionGeometry* geometry, int from) {
+    int from_bearing = geometry->approaches[from].bearing;
+    int best = from;
+    int best_gap = 361;
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        int gap = ((from_bearing - geometry->approaches[a].bearing) % 360 + 360) % 360;
+        if (a != from && gap < best_gap) {
+            best = a;
+            best_gap = gap;
+        }
+    }
+    return best;
+}
+
+// Corners swept from 'from' counter-clockwise round to 'exit' (all for a U-turn)
+static int swept_quadrants(const IntersectionGeometry* geometry, int from, int exit) {
+    int mask = 0;
+    int corner = from;
+    do {
+        corner = counter_clockwise_neighbour(geometry, corner);
+        mask |= 1 << corner;
+    } while (corner != exit);
+    return mask;
+}
+
+// Movements a lane carries when the file does not say
+static int default_lane_movements(int lane_index, int num_lanes) {
+    if (num_lanes == 1) {
+        return (1 << MOVEMENT_LEFT) | (1 << MOVEMENT_STRAIGHT) |
+               (1 << MOVEMENT_RIGHT) | (1 << MOVEMENT_U_TURN);
+    }
+    if (lane_index == 0) {
+        return (1 << MOVEMENT_LEFT) | (1 << MOVEMENT_STRAIGHT) | (1 << MOVEMENT_U_TURN);
+    }
+    if (lane_index == num_lanes - 1) {
+        return (1 << MOVEMENT_STRAIGHT) | (1 << MOVEMENT_RIGHT);
+    }
+    return 1 << MOVEMENT_STRAIGHT;
+}
+
+// "LSR" -> movement bits; -1 on an unknown letter
+static int parse_movement_letters(const char* letters) {
+    int movements = 0;
+    for (const char* c = letters; *c; c++) {
+        int found = -1;
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            if (toupper((unsigned char)*c) == movement_letters[m]) {
+                found = m;
+            }
+        }
+        if (found < 0) {
+            return -1;
+        }
+        movements |= 1 << found;
+    }
+    return movements;
+}
+
+// Add one "approach" line; prints the problem and returns false if invalid
+// ('explicit_lanes' marks lanes whose movements the line spelled out)
+static bool parse_approach_line(IntersectionGeometry* geometry, char* line,
+                                bool explicit_lanes[MAX_LANES], const char* source,
+                                int line_number) {
+    char* save = NULL;
+    char* keyword = strtok_r(line, " \t\r\n", &save);
+    char* name = strtok_r(NULL, " \t\r\n", &save);
+    char* bearing_text = strtok_r(NULL, " \t\r\n", &save);
+    char* lanes_text = strtok_r(NULL, " \t\r\n", &save);
+
+    if (strcmp(keyword, "approach") != 0 || !name || !bearing_text || !lanes_text) {
+        printf("%s:%d: expected: approach <name> <bearing> <lanes> [<movements> ...]\n",
+               source, line_number);
+        return false;
+    }
+
+    char* end;
+    long bearing = strtol(bearing_text, &end, 10);
+    if (*end != '\0') {
+        bearing = -1;
+    }
+    long lanes = strtol(lanes_text, &end, 10);
+    if (strlen(name) > APPROACH_NAME_MAX) {
+        printf("%s:%d: approach name longer than %d characters\n", source, line_number,
+               APPROACH_NAME_MAX);
+        return false;
+    }
+    if (bearing < 0 || bearing >= 360) {
+        printf("%s:%d: bearing must be 0-359 degrees\n", source, line_number);
+        return false;
+    }
+    if (lanes < 1 || *end != '\0') {
+        printf("%s:%d: an approach needs at least one lane\n", source, line_number);
+        return false;
+    }
+    if (geometry->num_approaches == MAX_APPROACHES) {
+        printf("%s:%d: more than %d approaches\n", source, line_number, MAX_APPROACHES);
+        return false;
+    }
+    if (geometry->num_lanes + lanes > MAX_LANES) {
+        printf("%s:%d: more than %d lanes in total\n", source, line_number, MAX_LANES);
+        return false;
+    }
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        if (strcmp(geometry->approaches[a].name, name) == 0 ||
+            geometry->approaches[a].bearing == bearing) {
+            printf("%s:%d: approach %s repeats a name or bearing\n", source, line_number, name);
+            return false;
+        }
+    }
+
+    int index = geometry->num_approaches++;
+    GeometryApproach* approach = &geometry->approaches[index];
+    snprintf(approach->name, sizeof(approach->name), "%s", name);
+    approach->bearing = (int)bearing;
+    approach->first_lane = geometry->num_lanes;
+    approach->num_lanes = (int)lanes;
+
+    for (int i = 0; i < lanes; i++) {
+        int lane_id = geometry->num_lanes++;
+        GeometryLane* lane = &geometry->lanes[lane_id];
+        lane->approach = index;
+        if (lanes == 1) {
+            snprintf(lane->name, sizeof(lane->name), "%s", name);
+        } else {
+            snprintf(lane->name, sizeof(lane->name), "%s %d", name, i + 1);
+        }
+
+        // Explicit movements are checked against the exits once all
+        // approaches are known; defaults are trimmed to the exits instead
+        char* letters = strtok_r(NULL, " \t\r\n", &save);
+        if (letters) {
+            lane->movements = parse_movement_letters(letters);
+            if (lane->movements <= 0) {
+                printf("%s:%d: movements are letters from LSRU, got %s\n",
+                       source, line_number, letters);
+                return false;
+            }
+            explicit_lanes[lane_id] = true;
+        } else {
+            lane->movements = default_lane_movements(i, (int)lanes);
+        }
+    }
+    if (strtok_r(NULL, " \t\r\n", &save)) {
+        printf("%s:%d: more movement groups than lanes\n", source, line_number);
+        return false;
+    }
+    return true;
+}
+
+// Resolve exits and quadrant sets once every approach is known
+static bool resolve_geometry(IntersectionGeometry* geometry, const bool explicit_lanes[MAX_LANES],
+                             const char* source) {
+    if (geometry->num_approaches < 3) {
+        printf("%s: an intersection needs at least three approaches\n", source);
+        return false;
+    }
+
+    geometry->num_quadrants = geometry->num_approaches;
+    geometry->all_quadrants = (1 << geometry->num_quadrants) - 1;
+
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        GeometryApproach* approach = &geometry->approaches[a];
+        approach->exits[MOVEMENT_STRAIGHT] = nearest_exit(geometry, a, approach->bearing + 180);
+        approach->exits[MOVEMENT_LEFT] = nearest_exit(geometry, a, approach->bearing + 90);
+        approach->exits[MOVEMENT_RIGHT] = nearest_exit(geometry, a, approach->bearing + 270);
+        approach->exits[MOVEMENT_U_TURN] = a;
+
+        // Two movements must not share an exit (a T-junction's stem has
+        // left and right, not a straight that duplicates one of them)
+        int straight = approach->exits[MOVEMENT_STRAIGHT];
+        if (straight >= 0 && (straight == approach->exits[MOVEMENT_LEFT] ||
+                              straight == approach->exits[MOVEMENT_RIGHT])) {
+            approach->exits[MOVEMENT_STRAIGHT] = -1;
+        }
+    }
+
+    for (int l = 0; l < geometry->num_lanes; l++) {
+        GeometryLane* lane = &geometry->lanes[l];
+        const GeometryApproach* approach = &geometry->approaches[lane->approach];
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            lane->quadrants[m] = 0;
+            if (!(lane->movements & (1 << m))) {
+                continue;
+            }
+            if (approach->exits[m] < 0) {
+                if (explicit_lanes[l]) {
+                    printf("%s: approach %s has no exit for movement %c\n",
+                           source, approach->name, movement_letters[m]);
+                    return false;
+                }
+                lane->movements &= ~(1 << m);
+                continue;
+            }
+            lane->quadrants[m] = swept_quadrants(geometry, lane->approach, approach->exits[m]);
+        }
+
+        if (lane->movements == 0) {
+            printf("%s: lane %s carries no movement\n", source, lane->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parse_geometry_text(IntersectionGeometry* geometry, char* text, const char* source) {
+    memset(geometry, 0, sizeof(IntersectionGeometry));
+    snprintf(geometry->name, sizeof(geometry->name), "%s", source);
+
+    bool explicit_lanes[MAX_LANES] = {false};
+    int line_number = 0;
+    char* save = NULL;
+    for (char* line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        if (strspn(line, " \t\r") == strlen(line)) {
+            continue;
+        }
+        if (!parse_approach_line(geometry, line, explicit_lanes, source, line_number)) {
+            return false;
+        }
+    }
+
+    return resolve_geometry(geometry, explicit_lanes, source);
+}
+
+// Load a built-in preset by name, or else a geometry file
+bool load_intersection_geometry(IntersectionGeometry* geometry, const char* spec) {
+    if (!geometry || !spec) {
+        return false;
+    }
+
+    char text[GEOMETRY_FILE_MAX_BYTES];
+    for (size_t i = 0; i < sizeof(geometry_presets) / sizeof(geometry_presets[0]); i++) {
+        if (strcmp(spec, geometry_presets[i].name) == 0) {
+            snprintf(text, sizeof(text), "%s", geometry_presets[i].text);
+            return parse_geometry_text(geometry, text, spec);
+        }
+    }
+
+    FILE* file = fopen(spec, "r");
+    if (!file) {
+        printf("Cannot open geometry %s (presets: four-way, t-junction, five-leg, four-way-dual)\n",
+               spec);
+        return false;
+    }
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    bool truncated = !feof(file);
+    fclose(file);
+    if (truncated) {
+        printf("%s: geometry file larger than %d bytes\n", spec, GEOMETRY_FILE_MAX_BYTES - 1);
+        return false;
+    }
+    text[length] = '\0';
+
+    return parse_geometry_text(geometry, text, spec);
+}
+
+// Install the geometry every module reads; call before any lane is set up
+void set_intersection_geometry(const IntersectionGeometry* geometry) {
+    if (!geometry) {
+        return;
+    }
+    g_geometry = *geometry;
+    geometry_initialized = true;
+}
+
+// Active geometry, the four-way preset until one is set
+const IntersectionGeometry* get_intersection_geometry() {
+    if (!geometry_initialized) {
+        load_intersection_geometry(&g_geometry, DEFAULT_GEOMETRY);
+        geometry_initialized = true;
+    }
+    return &g_geometry;
+}
+
+int get_num_lanes() {
+    return get_intersection_geometry()->num_lanes;
+}
+
+const char* get_geometry_lane_name(int lane_id) {
+    const IntersectionGeometry* geometry = get_intersection_geometry();
+    if (lane_id < 0 || lane_id >= geometry->num_lanes) {
+        return "Unknown";
+    }
+    return geometry->lanes[lane_id].name;
+}
+
+// Quadrant bitmask of 'movement' from 'lane_id'; 0 if the lane does not carry it
+int get_movement_quadrant_mask(int lane_id, VehicleMovement movement) {
+    const IntersectionGeometry* geometry = get_intersection_geometry();
+    if (lane_id < 0 || lane_id >= geometry->num_lanes ||
+        movement < 0 || movement >= NUM_MOVEMENTS) {
+        return 0;
+    }
+    return geometry->lanes[lane_id].quadrants[movement];
+}
+
+bool lane_allows_movement(int lane_id, VehicleMovement movement) {
+    return get_movement_quadrant_mask(lane_id, movement) != 0;
+}
+
+// 'wanted' if the lane carries it, else straight, else its first movement
+VehicleMovement fit_movement_to_lane(int lane_id, VehicleMovement wanted) {
+    if (lane_allows_movement(lane_id, wanted)) {
+        return wanted;
+    }
+    if (lane_allows_movement(lane_id, MOVEMENT_STRAIGHT)) {
+        return MOVEMENT_STRAIGHT;
+    }
+    for (int m = 0; m < NUM_MOVEMENTS; m++) {
+        if (lane_allows_movement(lane_id, (VehicleMovement)m)) {
+            return (VehicleMovement)m;
+        }
+    }
+    return wanted;
+}
+
+void print_intersection_geometry(const IntersectionGeometry* geometry) {
+    if (!geometry) {
+        return;
+    }
+
+    printf("Geometry: %s, %d approaches, %d lanes, %d quadrants\n", geometry->name,
+           geometry->num_approaches, geometry->num_lanes, geometry->num_quadrants);
+    for (int l = 0; l < geometry->num_lanes; l++) {
+        const GeometryLane* lane = &geometry->lanes[l];
+        printf("  %2d %-15s %3d deg ", l, lane->name,
+               geometry->approaches[lane->approach].bearing);
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            if (lane->movements & (1 << m)) {
+                printf(" %c:%#04x", movement_letters[m], lane->quadrants[m]);
+            }
+        }
+        printf("\n");
+    }
+}
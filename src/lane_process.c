@@ -11,6 +11,8 @@
 #include "../include/lane_process.h"
 #include "../include/synchronization.h"
 #include "../include/trafficguru.h"
+#include "../include/vehicle_trace.h"
+#include "../include/sim_clock.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
@@ -18,23 +20,29 @@
 #include <string.h>
 #include <assert.h>
 
-static const char* lane_names[] = {"North", "South", "East", "West"};
-
 void init_lane_process(LaneProcess* lane, int lane_id, int max_capacity) {
-    if (!lane || lane_id < 0 || lane_id >= 4 || max_capacity <= 0) {
+    init_lane_process_with_pool(lane, lane_id, max_capacity, NULL);
+}
+
+// Lane whose queue spills back past max_capacity using chunks from 'pool'
+// (NULL: a private queue that drops arrivals at max_capacity)
+void init_lane_process_with_pool(LaneProcess* lane, int lane_id, int max_capacity,
+                                 QueueChunkPool* pool) {
+    if (!lane || lane_id < 0 || lane_id >= MAX_LANES || max_capacity <= 0) {
         return;
     }
 
     lane->lane_id = lane_id;
-    lane->queue = create_queue(max_capacity);
+    lane->queue = create_pooled_queue(max_capacity, pool);
     lane->queue_length = 0;
     lane->max_queue_length = max_capacity;
     lane->state = WAITING;
     lane->priority = 2;
     lane->waiting_time = 0;
+    lane->ready_since_ns = monotonic_now_ns();
     lane->thread_id = 0;
     lane->last_arrival_time = time(NULL);
-    lane->last_service_time = 0;
+    lane->last_service_time = time(NULL);
     lane->total_vehicles_served = 0;
     lane->total_waiting_time = 0;
     lane->requested_quadrants = 0;
@@ -122,20 +130,34 @@ void* lane_process_thread(void* arg) {
     return NULL;
 }
 
-// Add vehicle to lane queue
+// Add vehicle to lane queue (a car going straight, arriving now)
 void add_vehicle_to_lane(LaneProcess* lane, int vehicle_id) {
-    if (!lane || !lane->queue) {
-        return;
+    VehicleRecord vehicle = {vehicle_id, monotonic_now_ns(), MOVEMENT_STRAIGHT, VEHICLE_CAR, 0};
+    add_vehicle_record_to_lane(lane, &vehicle);
+}
+
+// Add a vehicle record to the lane queue; false if it was dropped. The
+// trace aux carries movement | class << 8
+bool add_vehicle_record_to_lane(LaneProcess* lane, const VehicleRecord* vehicle) {
+    if (!lane || !lane->queue || !vehicle) {
+        return false;
     }
 
+    int aux = (int)vehicle->movement | ((int)vehicle->vehicle_class << 8);
+
     pthread_mutex_lock(&lane->queue_lock);
 
-    if (enqueue(lane->queue, vehicle_id)) {
+    bool queued = enqueue_vehicle(lane->queue, vehicle);
+    if (queued) {
         lane->queue_length = get_size(lane->queue);
         lane->last_arrival_time = time(NULL);
+        trace_vehicle_event(TRACE_ARRIVAL, vehicle->id, lane->lane_id, aux, lane->queue_length);
+    } else {
+        trace_vehicle_event(TRACE_OVERFLOW, vehicle->id, lane->lane_id, aux, lane->queue_length);
     }
 
     pthread_mutex_unlock(&lane->queue_lock);
+    return queued;
 }
 
 // Remove vehicle from lane queue (with locking)
@@ -168,6 +190,53 @@ int remove_vehicle_from_lane_unlocked(LaneProcess* lane) {
     return vehicle_id;
 }
 
+// Remove the head vehicle's full record WITHOUT locking
+bool remove_vehicle_record_from_lane_unlocked(LaneProcess* lane, VehicleRecord* vehicle) {
+    if (!lane || !lane->queue) {
+        return false;
+    }
+
+    // NOTE: Caller must hold lane->queue_lock
+    bool removed = dequeue_vehicle(lane->queue, vehicle);
+    lane->queue_length = get_size(lane->queue);
+
+    return removed;
+}
+
+// Copy the head vehicle's record; false if the queue is empty
+bool peek_lane_head_vehicle(LaneProcess* lane, VehicleRecord* vehicle) {
+    if (!lane || !lane->queue || !vehicle) {
+        return false;
+    }
+
+    pthread_mutex_lock(&lane->queue_lock);
+    bool found = peek_vehicle(lane->queue, vehicle);
+    pthread_mutex_unlock(&lane->queue_lock);
+
+    return found;
+}
+
+// Movement for a uniform roll in [0, 100)
+VehicleMovement pick_vehicle_movement(int roll) {
+    if (roll < TURN_SHARE_LEFT) {
+        return MOVEMENT_LEFT;
+    }
+    roll -= TURN_SHARE_LEFT;
+    if (roll < TURN_SHARE_RIGHT) {
+        return MOVEMENT_RIGHT;
+    }
+    roll -= TURN_SHARE_RIGHT;
+    if (roll < TURN_SHARE_U_TURN) {
+        return MOVEMENT_U_TURN;
+    }
+    return MOVEMENT_STRAIGHT;
+}
+
+// Class for a uniform roll in [0, 100)
+VehicleClass pick_vehicle_class(int roll) {
+    return roll < HEAVY_VEHICLE_SHARE ? VEHICLE_HEAVY : VEHICLE_CAR;
+}
+
 // Get current queue length
 int get_lane_queue_length(LaneProcess* lane) {
     if (!lane) {
@@ -181,6 +250,19 @@ int get_lane_queue_length(LaneProcess* lane) {
     return length;
 }
 
+// Vehicles currently held upstream of the lane's storage
+int get_lane_spillback_length(LaneProcess* lane) {
+    if (!lane) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&lane->queue_lock);
+    int length = get_spillback_length(lane->queue);
+    pthread_mutex_unlock(&lane->queue_lock);
+
+    return length;
+}
+
 // Update lane state
 void update_lane_state(LaneProcess* lane, LaneState new_state) {
     if (!lane) {
@@ -188,6 +270,9 @@ void update_lane_state(LaneProcess* lane, LaneState new_state) {
     }
 
     pthread_mutex_lock(&lane->queue_lock);
+    if (new_state == READY && lane->state != READY) {
+        lane->ready_since_ns = monotonic_now_ns();
+    }
     lane->state = new_state;
     pthread_cond_signal(&lane->queue_cond);
     pthread_mutex_unlock(&lane->queue_lock);
@@ -284,12 +369,9 @@ void release_intersection_quadrants(LaneProcess* lane) {
     pthread_mutex_unlock(&lane->queue_lock);
 }
 
-// Get lane name
+// Get lane name (from the active geometry)
 const char* get_lane_name(int lane_id) {
-    if (lane_id >= 0 && lane_id < 4) {
-        return lane_names[lane_id];
-    }
-    return "Unknown";
+    return get_geometry_lane_name(lane_id);
 }
 
 // Print lane information for debugging
@@ -303,7 +385,8 @@ void print_lane_info(LaneProcess* lane) {
 
     printf("Lane %d (%s):\n", lane->lane_id, get_lane_name(lane->lane_id));
     printf("  State: %d\n", lane->state);
-    printf("  Queue Length: %d/%d\n", lane->queue_length, lane->max_queue_length);
+    printf("  Queue Length: %d/%d (%d spilled back)\n", lane->queue_length, lane->max_queue_length,
+           get_spillback_length(lane->queue));
     printf("  Priority: %d\n", lane->priority);
     printf("  Waiting Time: %d\n", lane->waiting_time);
     printf("  Total Served: %d\n", lane->total_vehicles_served);
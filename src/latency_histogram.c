@@ -0,0 +1,216 @@
+/*
+ * Latency Histogram Implementation - Log-Linear Buckets
+ *
+ * Bucket layout: index v for v < 16; otherwise, with e the position of the
+ * highest set bit, index (e - 3) * 16 + the next four bits below it.
+ * Values beyond 2^48 are clamped into the last bucket.
+ *
+ * Compilation: Include latency_histogram.h
+ */
+
+#include "../include/latency_histogram.h"
+#include <string.h>
+#include <limits.h>
+#include <stdbool.h>
+
+// Map a sample to its bucket index
+static int bucket_index(long long value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return value < 0 ? 0 : (int)value;
+    }
+
+    int exponent = 63 - __builtin_clzll((unsigned long long)value);
+    if (exponent > HISTOGRAM_MAX_EXPONENT) {
+        return HISTOGRAM_BUCKET_COUNT - 1;
+    }
+
+    int sub_bucket = (int)((value >> (exponent - HISTOGRAM_SUB_BUCKET_BITS)) &
+                           (HISTOGRAM_SUB_BUCKETS - 1));
+    return (exponent - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKETS + sub_bucket;
+}
+
+// Smallest value that maps to a bucket
+static long long bucket_lower_bound(int index) {
+    if (index < HISTOGRAM_SUB_BUCKETS) {
+        return index;
+    }
+
+    int exponent = index / HISTOGRAM_SUB_BUCKETS + HISTOGRAM_SUB_BUCKET_BITS - 1;
+    int sub_bucket = index % HISTOGRAM_SUB_BUCKETS;
+    return (long long)(HISTOGRAM_SUB_BUCKETS + sub_bucket) << (exponent - HISTOGRAM_SUB_BUCKET_BITS);
+}
+
+// Representative value reported for a bucket
+static long long bucket_midpoint(int index) {
+    long long lower = bucket_lower_bound(index);
+    if (index < HISTOGRAM_SUB_BUCKETS || index == HISTOGRAM_BUCKET_COUNT - 1) {
+        return lower;
+    }
+    return lower + (bucket_lower_bound(index + 1) - lower) / 2;
+}
+
+void init_latency_histogram(LatencyHistogram* histogram) {
+    if (!histogram) {
+        return;
+    }
+
+    memset(histogram->counts, 0, sizeof(histogram->counts));
+    histogram->total_count = 0;
+    histogram->sum = 0;
+    histogram->min_value = LLONG_MAX;
+    histogram->max_value = 0;
+}
+
+// Not atomic with respect to concurrent recorders; reset between runs
+void reset_latency_histogram(LatencyHistogram* histogram) {
+    init_latency_histogram(histogram);
+}
+
+// Record a single sample (lock-free, safe from any thread)
+void histogram_record(LatencyHistogram* histogram, long long value) {
+    if (!histogram) {
+        return;
+    }
+
+    if (value < 0) {
+        value = 0;
+    }
+
+    __atomic_fetch_add(&histogram->counts[bucket_index(value)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->total_count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&histogram->sum, value, __ATOMIC_RELAXED);
+
+    long long current = __atomic_load_n(&histogram->min_value, __ATOMIC_RELAXED);
+    while (value < current &&
+           !__atomic_compare_exchange_n(&histogram->min_value, &current, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+
+    current = __atomic_load_n(&histogram->max_value, __ATOMIC_RELAXED);
+    while (value > current &&
+           !__atomic_compare_exchange_n(&histogram->max_value, &current, value, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+// Add every sample in source into destination
+void histogram_merge(LatencyHistogram* destination, const LatencyHistogram* source) {
+    if (!destination || !source) {
+        return;
+    }
+
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        long long count = __atomic_load_n(&source->counts[i], __ATOMIC_RELAXED);
+        if (count > 0) {
+            __atomic_fetch_add(&destination->counts[i], count, __ATOMIC_RELAXED);
+        }
+    }
+
+    __atomic_fetch_add(&destination->total_count,
+                       __atomic_load_n(&source->total_count, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+    __atomic_fetch_add(&destination->sum,
+                       __atomic_load_n(&source->sum, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+
+    long long source_min = histogram_min(source);
+    long long source_max = histogram_max(source);
+    if (histogram_count(source) > 0) {
+        if (source_min < destination->min_value) {
+            destination->min_value = source_min;
+        }
+        if (source_max > destination->max_value) {
+            destination->max_value = source_max;
+        }
+    }
+}
+
+long long histogram_count(const LatencyHistogram* histogram) {
+    return histogram ? __atomic_load_n(&histogram->total_count, __ATOMIC_RELAXED) : 0;
+}
+
+long long histogram_min(const LatencyHistogram* histogram) {
+    if (histogram_count(histogram) == 0) {
+        return 0;
+    }
+    return __atomic_load_n(&histogram->min_value, __ATOMIC_RELAXED);
+}
+
+long long histogram_max(const LatencyHistogram* histogram) {
+    if (histogram_count(histogram) == 0) {
+        return 0;
+    }
+    return __atomic_load_n(&histogram->max_value, __ATOMIC_RELAXED);
+}
+
+double histogram_mean(const LatencyHistogram* histogram) {
+    long long count = histogram_count(histogram);
+    if (count == 0) {
+        return 0.0;
+    }
+    return (double)__atomic_load_n(&histogram->sum, __ATOMIC_RELAXED) / count;
+}
+
+// Value below which the given percentage (0-100) of samples fall
+long long histogram_percentile(const LatencyHistogram* histogram, double percentile) {
+    long long count = histogram_count(histogram);
+    if (count == 0) {
+        return 0;
+    }
+
+    if (percentile <= 0.0) {
+        return histogram_min(histogram);
+    }
+    if (percentile >= 100.0) {
+        return histogram_max(histogram);
+    }
+
+    long long target = (long long)(percentile / 100.0 * count + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+
+    long long seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        seen += __atomic_load_n(&histogram->counts[i], __ATOMIC_RELAXED);
+        if (seen >= target) {
+            long long value = bucket_midpoint(i);
+            long long max_value = histogram_max(histogram);
+            return value > max_value ? max_value : value;
+        }
+    }
+
+    return histogram_max(histogram);
+}
+
+// Percentile of the samples recorded since snapshot was taken
+long long histogram_percentile_since(const LatencyHistogram* histogram,
+                                     const LatencyHistogram* snapshot, double percentile) {
+    if (!snapshot) {
+        return histogram_percentile(histogram, percentile);
+    }
+
+    long long count = histogram_count(histogram) - histogram_count(snapshot);
+    if (count <= 0) {
+        return 0;
+    }
+
+    long long target = (long long)(percentile / 100.0 * count + 0.5);
+    if (target < 1) {
+        target = 1;
+    }
+    if (target > count) {
+        target = count;
+    }
+
+    long long seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKET_COUNT; i++) {
+        seen += __atomic_load_n(&histogram->counts[i], __ATOMIC_RELAXED) -
+                __atomic_load_n(&snapshot->counts[i], __ATOMIC_RELAXED);
+        if (seen >= target) {
+            long long value = bucket_midpoint(i);
+            long long max_value = histogram_max(histogram);
+            return value > max_value ? max_value : value;
+        }
+    }
+
+    return histogram_max(histogram);
+}
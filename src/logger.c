@@ -0,0 +1,574 @@
+/*
+ * Logger Implementation - Per-Thread Rings and Background Writer
+ *
+ * Each producing thread claims one single-producer/single-consumer ring on its
+ * first log call. log_message() captures the format pointer and the argument
+ * values into a fixed-size record and publishes it with a release store; it
+ * never blocks and drops the record if the ring is full. The writer thread
+ * polls all rings, formats records, applies the rate limit and writes lines
+ * to the log file. A ring is retired when its thread exits and is reused once
+ * the writer has drained it.
+ *
+ * Compilation: Include logger.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#define LOG_WRITER_IDLE_US 10000
+#define LOG_LINE_SIZE 512
+#define LOG_SPEC_SIZE 32
+
+typedef enum {
+    RING_FREE = 0,
+    RING_OWNED = 1,
+    RING_RETIRED = 2
+} RingState;
+
+typedef enum {
+    CONV_PERCENT,
+    CONV_INT,
+    CONV_LONG,
+    CONV_LONG_LONG,
+    CONV_SIZE,
+    CONV_DOUBLE,
+    CONV_STRING,
+    CONV_POINTER,
+    CONV_UNSUPPORTED
+} ConversionKind;
+
+typedef union {
+    long long i;
+    double d;
+    const void* p;
+    int text_offset;
+} LogArg;
+
+typedef struct {
+    long long timestamp_ns;
+    const char* format;
+    LogArg args[LOG_MAX_ARGS];
+    unsigned char level;
+    unsigned char nargs;
+    char text[LOG_INLINE_TEXT_SIZE];
+} LogRecord;
+
+typedef struct {
+    LogRecord records[LOG_RING_CAPACITY];
+    unsigned long head __attribute__((aligned(64)));  // Written by producer
+    unsigned long tail __attribute__((aligned(64)));  // Written by writer thread
+    long long dropped;
+    long long dropped_reported;                       // Writer thread only
+    int state;
+} LogRing;
+
+typedef struct {
+    FILE* file;
+    pthread_t writer_thread;
+    pthread_key_t ring_key;
+    bool running;
+    int min_level;
+    int rate_limit;
+    double tokens;
+    struct timespec last_refill;
+    long long pending_suppressed;
+    long long records_written;
+    long long records_suppressed;
+    long long records_dropped_no_ring;
+    int ring_high_water;
+} Logger;
+
+static LogRing g_log_rings[LOG_MAX_RINGS];
+static Logger g_logger = {0};
+static __thread LogRing* tls_ring = NULL;
+
+static const char* level_names[] = {"ERROR", "WARN", "INFO", "DEBUG"};
+
+// Parse one conversion specification starting at '%'.
+// Returns its length including the '%' and reports the argument kind.
+static int parse_conversion(const char* p, ConversionKind* kind) {
+    const char* start = p++;
+
+    if (*p == '%') {
+        *kind = CONV_PERCENT;
+        return 2;
+    }
+
+    while (*p && strchr("-+ #0", *p)) p++;
+    while (*p >= '0' && *p <= '9') p++;
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') p++;
+    }
+
+    int longs = 0;
+    bool size = false;
+    while (*p == 'h') p++;
+    while (*p == 'l') {
+        longs++;
+        p++;
+    }
+    if (*p == 'z') {
+        size = true;
+        p++;
+    }
+
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'x': case 'X': case 'o': case 'c':
+            *kind = size ? CONV_SIZE : (longs >= 2 ? CONV_LONG_LONG :
+                                        (longs == 1 ? CONV_LONG : CONV_INT));
+            break;
+        case 'f': case 'F': case 'e': case 'E': case 'g': case 'G':
+            *kind = CONV_DOUBLE;
+            break;
+        case 's':
+            *kind = CONV_STRING;
+            break;
+        case 'p':
+            *kind = CONV_POINTER;
+            break;
+        case '\0':
+            *kind = CONV_UNSUPPORTED;
+            return (int)(p - start);
+        default:
+            *kind = CONV_UNSUPPORTED;
+            break;
+    }
+
+    return (int)(p - start) + 1;
+}
+
+static long long realtime_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void release_thread_ring(void* ring) {
+    if (ring) {
+        __atomic_store_n(&((LogRing*)ring)->state, RING_RETIRED, __ATOMIC_RELEASE);
+    }
+}
+
+// Claim a ring for the calling thread on first use
+static LogRing* acquire_thread_ring(void) {
+    if (tls_ring) {
+        return tls_ring;
+    }
+
+    for (int i = 0; i < LOG_MAX_RINGS; i++) {
+        int expected = RING_FREE;
+        if (__atomic_compare_exchange_n(&g_log_rings[i].state, &expected, RING_OWNED,
+                                        false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            tls_ring = &g_log_rings[i];
+            pthread_setspecific(g_logger.ring_key, tls_ring);
+
+            int high_water = __atomic_load_n(&g_logger.ring_high_water, __ATOMIC_RELAXED);
+            while (high_water < i + 1 &&
+                   !__atomic_compare_exchange_n(&g_logger.ring_high_water, &high_water, i + 1,
+                                                true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            }
+            return tls_ring;
+        }
+    }
+
+    return NULL;
+}
+
+// Producer side: capture the record and publish it (never blocks)
+void log_message(LogLevel level, const char* format, ...) {
+    if (!format || !__atomic_load_n(&g_logger.running, __ATOMIC_ACQUIRE) ||
+        (int)level > __atomic_load_n(&g_logger.min_level, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    LogRing* ring = acquire_thread_ring();
+    if (!ring) {
+        __atomic_fetch_add(&g_logger.records_dropped_no_ring, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    unsigned long head = ring->head;
+    unsigned long tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= LOG_RING_CAPACITY) {
+        __atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    LogRecord* record = &ring->records[head & (LOG_RING_CAPACITY - 1)];
+    record->timestamp_ns = realtime_ns();
+    record->format = format;
+    record->level = (unsigned char)level;
+
+    va_list ap;
+    va_start(ap, format);
+
+    int nargs = 0;
+    int text_used = 0;
+    const char* p = format;
+    while (*p && nargs < LOG_MAX_ARGS) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+
+        ConversionKind kind;
+        p += parse_conversion(p, &kind);
+
+        if (kind == CONV_UNSUPPORTED) {
+            break; // Remaining arguments cannot be walked safely
+        }
+
+        switch (kind) {
+            case CONV_INT:
+                record->args[nargs++].i = va_arg(ap, int);
+                break;
+            case CONV_LONG:
+                record->args[nargs++].i = va_arg(ap, long);
+                break;
+            case CONV_LONG_LONG:
+                record->args[nargs++].i = va_arg(ap, long long);
+                break;
+            case CONV_SIZE:
+                record->args[nargs++].i = (long long)va_arg(ap, size_t);
+                break;
+            case CONV_DOUBLE:
+                record->args[nargs++].d = va_arg(ap, double);
+                break;
+            case CONV_POINTER:
+                record->args[nargs++].p = va_arg(ap, void*);
+                break;
+            case CONV_STRING: {
+                const char* text = va_arg(ap, const char*);
+                if (!text) text = "(null)";
+
+                // Strings are copied so callers may pass transient buffers
+                int avail = LOG_INLINE_TEXT_SIZE - text_used;
+                if (avail <= 0) {
+                    record->args[nargs++].text_offset = -1;
+                    break;
+                }
+                int len = (int)strlen(text);
+                if (len > avail - 1) len = avail - 1;
+                memcpy(&record->text[text_used], text, len);
+                record->text[text_used + len] = '\0';
+                record->args[nargs++].text_offset = text_used;
+                text_used += len + 1;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    va_end(ap);
+    record->nargs = (unsigned char)nargs;
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Writer side: "YYYY-mm-dd HH:MM:SS.mmm [LEVEL] " prefix
+static int format_prefix(long long timestamp_ns, int level, char* line, int size) {
+    char stamp[32];
+    time_t seconds = (time_t)(timestamp_ns / 1000000000LL);
+    int millis = (int)((timestamp_ns / 1000000LL) % 1000);
+    struct tm tm_info;
+    localtime_r(&seconds, &tm_info);
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+
+    return snprintf(line, size, "%s.%03d [%-5s] ", stamp, millis,
+                    level_names[level >= 0 && level <= LOG_LEVEL_DEBUG ? level : 0]);
+}
+
+// Writer side: expand a captured record into a text line
+static int format_record(const LogRecord* record, char* line, int size) {
+    int len = format_prefix(record->timestamp_ns, record->level, line, size);
+
+    int arg = 0;
+    const char* p = record->format;
+    while (*p && len < size - 2) {
+        if (*p != '%') {
+            line[len++] = *p++;
+            continue;
+        }
+
+        ConversionKind kind;
+        int spec_len = parse_conversion(p, &kind);
+        char spec[LOG_SPEC_SIZE];
+        int written = 0;
+
+        if (kind == CONV_PERCENT) {
+            line[len++] = '%';
+            p += spec_len;
+            continue;
+        }
+
+        if (kind == CONV_UNSUPPORTED || arg >= record->nargs || spec_len >= LOG_SPEC_SIZE) {
+            // Emit the specification verbatim
+            written = snprintf(line + len, size - len, "%.*s", spec_len, p);
+        } else {
+            memcpy(spec, p, spec_len);
+            spec[spec_len] = '\0';
+            const LogArg* value = &record->args[arg++];
+
+            switch (kind) {
+                case CONV_INT:
+                    written = snprintf(line + len, size - len, spec, (int)value->i);
+                    break;
+                case CONV_LONG:
+                    written = snprintf(line + len, size - len, spec, (long)value->i);
+                    break;
+                case CONV_LONG_LONG:
+                    written = snprintf(line + len, size - len, spec, value->i);
+                    break;
+                case CONV_SIZE:
+                    written = snprintf(line + len, size - len, spec, (size_t)value->i);
+                    break;
+                case CONV_DOUBLE:
+                    written = snprintf(line + len, size - len, spec, value->d);
+                    break;
+                case CONV_POINTER:
+                    written = snprintf(line + len, size - len, spec, value->p);
+                    break;
+                case CONV_STRING:
+                    written = snprintf(line + len, size - len, spec,
+                                       value->text_offset >= 0 ? &record->text[value->text_offset] : "");
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        p += spec_len;
+        if (written > 0) {
+            len += written;
+            if (len > size - 2) len = size - 2;
+        }
+    }
+
+    line[len++] = '\n';
+    line[len] = '\0';
+    return len;
+}
+
+// Token bucket; errors always pass
+static bool rate_limit_allows(int level) {
+    if (g_logger.rate_limit <= 0 || level == LOG_LEVEL_ERROR) {
+        return true;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    double elapsed = (now.tv_sec - g_logger.last_refill.tv_sec) +
+                     (now.tv_nsec - g_logger.last_refill.tv_nsec) / 1e9;
+    g_logger.last_refill = now;
+
+    g_logger.tokens += elapsed * g_logger.rate_limit;
+    if (g_logger.tokens > g_logger.rate_limit) {
+        g_logger.tokens = g_logger.rate_limit;
+    }
+
+    if (g_logger.tokens >= 1.0) {
+        g_logger.tokens -= 1.0;
+        return true;
+    }
+    return false;
+}
+
+// Writer-generated notice (suppression and drop reports)
+static void write_notice(const char* what, long long count, int ring) {
+    char line[LOG_LINE_SIZE];
+    int len = format_prefix(realtime_ns(), LOG_LEVEL_WARN, line, sizeof(line));
+    if (ring >= 0) {
+        snprintf(line + len, sizeof(line) - len, "%lld log records %s (ring %d full)\n",
+                 count, what, ring);
+    } else {
+        snprintf(line + len, sizeof(line) - len, "%lld log records %s\n", count, what);
+    }
+    fputs(line, g_logger.file);
+}
+
+static void write_record(const LogRecord* record) {
+    char line[LOG_LINE_SIZE];
+
+    if (!rate_limit_allows(record->level)) {
+        g_logger.pending_suppressed++;
+        __atomic_fetch_add(&g_logger.records_suppressed, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    if (g_logger.pending_suppressed > 0) {
+        write_notice("suppressed by rate limit", g_logger.pending_suppressed, -1);
+        g_logger.pending_suppressed = 0;
+    }
+
+    int len = format_record(record, line, sizeof(line));
+    fwrite(line, 1, len, g_logger.file);
+    __atomic_fetch_add(&g_logger.records_written, 1, __ATOMIC_RELAXED);
+}
+
+// Drain every ring once; returns number of records consumed
+static int drain_log_rings(void) {
+    int consumed = 0;
+    int high_water = __atomic_load_n(&g_logger.ring_high_water, __ATOMIC_ACQUIRE);
+
+    for (int i = 0; i < high_water; i++) {
+        LogRing* ring = &g_log_rings[i];
+        int state = __atomic_load_n(&ring->state, __ATOMIC_ACQUIRE);
+        if (state == RING_FREE) {
+            continue;
+        }
+
+        unsigned long tail = ring->tail;
+        unsigned long head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+        while (tail != head) {
+            write_record(&ring->records[tail & (LOG_RING_CAPACITY - 1)]);
+            tail++;
+            consumed++;
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+        long long dropped = __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+        if (dropped > ring->dropped_reported) {
+            write_notice("dropped", dropped - ring->dropped_reported, i);
+            ring->dropped_reported = dropped;
+        }
+
+        // The owning thread has exited and everything it wrote is drained
+        if (state == RING_RETIRED && tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+            __atomic_store_n(&ring->state, RING_FREE, __ATOMIC_RELEASE);
+        }
+    }
+
+    if (consumed > 0) {
+        fflush(g_logger.file);
+    }
+    return consumed;
+}
+
+static void* logger_writer_thread(void* arg) {
+    (void)arg;
+
+    while (__atomic_load_n(&g_logger.running, __ATOMIC_ACQUIRE)) {
+        if (drain_log_rings() == 0) {
+            usleep(LOG_WRITER_IDLE_US);
+        }
+    }
+
+    // Final drain after producers have been told to stop
+    drain_log_rings();
+    fflush(g_logger.file);
+    return NULL;
+}
+
+// Initialize the logger and start the writer thread
+int init_logger(const char* filename, LogLevel min_level, int max_records_per_second) {
+    if (g_logger.running) {
+        return 0;
+    }
+
+    g_logger.file = fopen(filename ? filename : LOG_DEFAULT_FILE, "a");
+    if (!g_logger.file) {
+        return -1;
+    }
+
+    g_logger.min_level = min_level;
+    g_logger.rate_limit = max_records_per_second;
+    g_logger.tokens = max_records_per_second;
+    g_logger.pending_suppressed = 0;
+    clock_gettime(CLOCK_MONOTONIC, &g_logger.last_refill);
+
+    if (pthread_key_create(&g_logger.ring_key, release_thread_ring) != 0) {
+        fclose(g_logger.file);
+        g_logger.file = NULL;
+        return -1;
+    }
+
+    __atomic_store_n(&g_logger.running, true, __ATOMIC_RELEASE);
+    if (pthread_create(&g_logger.writer_thread, NULL, logger_writer_thread, NULL) != 0) {
+        __atomic_store_n(&g_logger.running, false, __ATOMIC_RELEASE);
+        pthread_key_delete(g_logger.ring_key);
+        fclose(g_logger.file);
+        g_logger.file = NULL;
+        return -1;
+    }
+
+    return 0;
+}
+
+// Stop the writer thread after a final drain and close the file
+void destroy_logger() {
+    if (!__atomic_load_n(&g_logger.running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    __atomic_store_n(&g_logger.running, false, __ATOMIC_RELEASE);
+    pthread_join(g_logger.writer_thread, NULL);
+    pthread_key_delete(g_logger.ring_key);
+
+    fclose(g_logger.file);
+    g_logger.file = NULL;
+}
+
+void set_log_level(LogLevel level) {
+    __atomic_store_n(&g_logger.min_level, (int)level, __ATOMIC_RELAXED);
+}
+
+LogLevel get_log_level() {
+    return (LogLevel)__atomic_load_n(&g_logger.min_level, __ATOMIC_RELAXED);
+}
+
+bool is_log_level_enabled(LogLevel level) {
+    return __atomic_load_n(&g_logger.running, __ATOMIC_ACQUIRE) &&
+           (int)level <= __atomic_load_n(&g_logger.min_level, __ATOMIC_RELAXED);
+}
+
+// Parse a level name (error|warn|info|debug)
+bool parse_log_level(const char* name, LogLevel* level) {
+    if (!name || !level) {
+        return false;
+    }
+
+    static const char* names[] = {"error", "warn", "info", "debug"};
+    for (int i = 0; i <= LOG_LEVEL_DEBUG; i++) {
+        if (strcmp(name, names[i]) == 0) {
+            *level = (LogLevel)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* get_log_level_name(LogLevel level) {
+    if (level >= LOG_LEVEL_ERROR && level <= LOG_LEVEL_DEBUG) {
+        return level_names[level];
+    }
+    return "UNKNOWN";
+}
+
+// Get logger counters
+void get_logger_stats(LoggerStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(LoggerStats));
+    stats->records_written = __atomic_load_n(&g_logger.records_written, __ATOMIC_RELAXED);
+    stats->records_suppressed = __atomic_load_n(&g_logger.records_suppressed, __ATOMIC_RELAXED);
+    stats->records_dropped = __atomic_load_n(&g_logger.records_dropped_no_ring, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < LOG_MAX_RINGS; i++) {
+        stats->records_dropped += __atomic_load_n(&g_log_rings[i].dropped, __ATOMIC_RELAXED);
+        if (__atomic_load_n(&g_log_rings[i].state, __ATOMIC_RELAXED) == RING_OWNED) {
+            stats->rings_in_use++;
+        }
+    }
+}
@@ -17,18 +17,180 @@
 
 #define _XOPEN_SOURCE 600
 #include "../include/trafficguru.h"
+#include "../include/sim_clock.h"
 #include <getopt.h>
 #include <signal.h>
 #include <ncurses.h>
 
+#define GENERATOR_SLEEP_SLICE_NS (500 * NS_PER_MS)
+#define METRICS_SAMPLE_INTERVAL_NS (METRICS_SAMPLE_INTERVAL_MS * NS_PER_MS)
+
 TrafficGuruSystem* g_traffic_system = NULL;
 
 volatile bool keep_running = true;
 static volatile bool pause_requested = false;
 
+// Queue one generated vehicle (and the emergency vehicle it brings, if any)
+static void admit_generated_vehicle(int lane_idx, VehicleMovement movement, bool emergency_vehicle) {
+    LaneProcess* lane = &g_traffic_system->lanes[lane_idx];
+
+    int new_vehicle_id = 0;
+    pthread_mutex_lock(&g_traffic_system->global_state_lock);
+    new_vehicle_id = g_traffic_system->total_vehicles_generated++;
+    pthread_mutex_unlock(&g_traffic_system->global_state_lock);
+    
+    VehicleRecord vehicle;
+    vehicle.id = new_vehicle_id;
+    vehicle.arrival_ns = monotonic_now_ns();
+    vehicle.movement = movement;
+    vehicle.vehicle_class = pick_vehicle_class(rand() % 100);
+    vehicle.storage_ns = 0;
+    if (!add_vehicle_record_to_lane(lane, &vehicle)) {
+        // Only the queue memory cap drops vehicles; a full lane spills back
+        update_queue_overflow_count(&g_traffic_system->metrics);
+    }
+
+    if (emergency_vehicle) {
+        EmergencyVehicle emergency = generate_random_emergency();
+        emergency.lane_id = lane_idx;
+        add_emergency_vehicle(&(g_traffic_system->emergency_system), &emergency);
+    }
+    
+    pthread_mutex_lock(&lane->queue_lock);
+    if (lane->state == WAITING) {
+        lane->state = READY;
+        lane->waiting_time = 0;
+        lane->ready_since_ns = monotonic_now_ns();
+    }
+    pthread_mutex_unlock(&lane->queue_lock);
+
+    // Arrivals land while the simulation thread sleeps through a crossing
+    capture_simulation_snapshot();
+}
+
+// Sleep in short slices so a quit is not held up by a long gap
+static void sleep_while_running(long long duration_ns) {
+    while (duration_ns > 0 && g_traffic_system->simulation_running && keep_running) {
+        long long slice_ns = duration_ns < GENERATOR_SLEEP_SLICE_NS ? duration_ns
+                                                                    : GENERATOR_SLEEP_SLICE_NS;
+        sleep_ns(slice_ns);
+        duration_ns -= slice_ns;
+    }
+}
+
+// Scenario arrivals: sampled gaps advance the scenario clock, so a pause
+// holds the time of day where it was
+static void generate_scenario_arrivals(const TrafficScenario* scenario) {
+    unsigned int seed = (unsigned int)rand();
+    long long scenario_elapsed_ns = g_traffic_system->scenario_elapsed_ns;  // Non-zero after a restore
+    int applied_policy = -1;
+
+    while (g_traffic_system && g_traffic_system->simulation_running && keep_running) {
+        if (g_traffic_system->simulation_paused) {
+            usleep(500000);
+            continue;
+        }
+
+        ScenarioArrival arrival;
+        sample_scenario_arrival(scenario, scenario_elapsed_ns, &seed, &arrival);
+
+        // Follow the policy schedule; a manual switch holds until the next change
+        if (arrival.policy >= 0 && arrival.policy != applied_policy) {
+            set_scheduling_algorithm(&g_traffic_system->scheduler, (SchedulingAlgorithm)arrival.policy);
+            if ((int)get_scheduling_algorithm(&g_traffic_system->scheduler) == arrival.policy) {
+                applied_policy = arrival.policy;
+                LOG_INFO("Scenario policy: %s",
+                         get_algorithm_name((SchedulingAlgorithm)arrival.policy));
+            }
+        }
+
+        sleep_while_running(arrival.gap_ns);
+        scenario_elapsed_ns += arrival.gap_ns;
+        __atomic_store_n(&g_traffic_system->scenario_elapsed_ns, scenario_elapsed_ns,
+                         __ATOMIC_RELAXED);
+        if (arrival.lane_id >= 0 && g_traffic_system->simulation_running) {
+            admit_generated_vehicle(arrival.lane_id, arrival.movement, arrival.emergency);
+        }
+    }
+}
+
+// Detector arrivals: recorded gaps divided by the replay speed. Turning
+// movements and emergencies are not in detector data, so they are drawn
+// as for generated arrivals
+static void replay_detector_arrivals(DetectorReplay* replay) {
+    double speed = get_detector_replay_speed();
+    long long replay_ns = g_traffic_system->replay_elapsed_ns;  // Non-zero after a restore
+    DetectorArrival arrival;
+
+    while (g_traffic_system->simulation_running && keep_running &&
+           next_detector_arrival(replay, &arrival)) {
+        if (arrival.time_ns < replay_ns) {
+            continue;   // Replayed before the checkpoint
+        }
+        while (g_traffic_system->simulation_paused && g_traffic_system->simulation_running &&
+               keep_running) {
+            usleep(500000);
+        }
+
+        sleep_while_running((long long)((arrival.time_ns - replay_ns) / speed));
+        replay_ns = arrival.time_ns;
+        __atomic_store_n(&g_traffic_system->replay_elapsed_ns, replay_ns, __ATOMIC_RELAXED);
+        if (g_traffic_system->simulation_running) {
+            VehicleMovement movement = fit_movement_to_lane(arrival.lane_id,
+                                                            pick_vehicle_movement(rand() % 100));
+            admit_generated_vehicle(arrival.lane_id, movement,
+                                    (rand() % EMERGENCY_PROBABILITY) == 0);
+        }
+    }
+
+    LOG_INFO("Detector replay %s: %lld records, %lld vehicles, %lld lines skipped, %lld out of order",
+             replay->path, replay->records, replay->vehicles, replay->skipped, replay->out_of_order);
+}
+
+// Process arrivals: per-lane streams merged in time order
+static void generate_process_arrivals(const ArrivalProcessConfig* config) {
+    static ArrivalProcess process;
+    init_arrival_process(&process, config, g_traffic_system->num_lanes, (unsigned long long)rand());
+    long long elapsed_ns = 0;
+
+    while (g_traffic_system->simulation_running && keep_running) {
+        if (g_traffic_system->simulation_paused) {
+            usleep(500000);
+            continue;
+        }
+
+        int lane_idx;
+        long long arrival_ns = next_process_arrival(&process, &lane_idx);
+        sleep_while_running(arrival_ns - elapsed_ns);
+        elapsed_ns = arrival_ns;
+        if (g_traffic_system->simulation_running) {
+            VehicleMovement movement = fit_movement_to_lane(lane_idx, pick_vehicle_movement(rand() % 100));
+            admit_generated_vehicle(lane_idx, movement, (rand() % EMERGENCY_PROBABILITY) == 0);
+        }
+    }
+}
+
 void* vehicle_generator_loop(void* arg) {
     (void)arg;
 
+    DetectorReplay* replay = get_detector_replay();
+    if (replay) {
+        replay_detector_arrivals(replay);
+        return NULL;
+    }
+
+    const TrafficScenario* scenario = get_traffic_scenario();
+    if (scenario) {
+        generate_scenario_arrivals(scenario);
+        return NULL;
+    }
+
+    const ArrivalProcessConfig* process_config = get_arrival_process_config();
+    if (process_config) {
+        generate_process_arrivals(process_config);
+        return NULL;
+    }
+
     while (g_traffic_system && g_traffic_system->simulation_running && keep_running) {
         if (!g_traffic_system->simulation_paused) {
             int min_sec = g_traffic_system->min_arrival_rate;
@@ -38,30 +200,9 @@ void* vehicle_generator_loop(void* arg) {
             int sleep_time_sec = (rand() % (max_sec - min_sec + 1)) + min_sec;
             long sleep_time_us = (sleep_time_sec * 1000000) + (rand() % 1000 * 1000);
             
-            int lane_idx = rand() % NUM_LANES;
-            LaneProcess* lane = &g_traffic_system->lanes[lane_idx];
-
-            int new_vehicle_id = 0;
-            pthread_mutex_lock(&g_traffic_system->global_state_lock);
-            new_vehicle_id = g_traffic_system->total_vehicles_generated++;
-            pthread_mutex_unlock(&g_traffic_system->global_state_lock);
-            
-            add_vehicle_to_lane(lane, new_vehicle_id);
-
-            if ((rand() % EMERGENCY_PROBABILITY) == 0) {
-                EmergencyVehicle* emergency = generate_random_emergency();
-                if (emergency) {
-                    emergency->lane_id = lane_idx;
-                    add_emergency_vehicle(&(g_traffic_system->emergency_system), emergency);
-                }
-            }
-            
-            pthread_mutex_lock(&lane->queue_lock);
-            if (lane->state == WAITING) {
-                lane->state = READY;
-                lane->waiting_time = 0;
-            }
-            pthread_mutex_unlock(&lane->queue_lock);
+            int lane_idx = rand() % g_traffic_system->num_lanes;
+            VehicleMovement movement = fit_movement_to_lane(lane_idx, pick_vehicle_movement(rand() % 100));
+            admit_generated_vehicle(lane_idx, movement, (rand() % EMERGENCY_PROBABILITY) == 0);
             
             usleep(sleep_time_us);
         } else {
@@ -100,11 +241,37 @@ CommandLineArgs parse_command_line_args(int argc, char* argv[]) {
         .min_arrival_rate = VEHICLE_ARRIVAL_RATE_MIN,
         .max_arrival_rate = VEHICLE_ARRIVAL_RATE_MAX,
         .time_quantum = DEFAULT_TIME_QUANTUM,
+        .queue_memory_kb = QUEUE_MEMORY_DEFAULT_KB,
+        .geometry = NULL,
+        .scenario = NULL,
+        .replay_file = NULL,
+        .replay_speed = 1.0,
+        .arrival_process = false,
+        .lane_weights = false,
         .algorithm = SJF,
         .debug_mode = false,
         .no_color = false,
-        .help_requested = false
+        .help_requested = false,
+        .log_file = LOG_DEFAULT_FILE,
+        .log_level = LOG_LEVEL_INFO,
+        .log_rate_limit = LOG_DEFAULT_RATE_LIMIT,
+        .bench_mutex = false,
+        .trace_file = NULL,
+        .compare_algorithms = false,
+        .replications = 0,
+        .network_file = NULL,
+        .ci_target = 0.0,
+        .checkpoint_file = NULL,
+        .checkpoint_interval = 0,
+        .restore_file = NULL,
+        .duration_given = false,
+        .algorithm_given = false,
+        .quantum_given = false
     };
+    init_mutex_benchmark_config(&args.bench_config);
+    init_metrics_exporter_config(&args.export_config);
+    init_metrics_endpoint_config(&args.endpoint_config);
+    init_algorithm_comparison_config(&args.compare_config);
 
     static struct option long_options[] = {
         {"duration",     required_argument, 0, 'd'},
@@ -117,15 +284,46 @@ CommandLineArgs parse_command_line_args(int argc, char* argv[]) {
         {"help",         no_argument,       0, 'h'},
         {"version",      no_argument,       0, 'v'},
         {"benchmark",    no_argument,       0, 'b'},
+        {"log-file",     required_argument, 0, 'l'},
+        {"log-level",    required_argument, 0, 'L'},
+        {"log-rate",     required_argument, 0, 'R'},
+        {"bench-mutex",  no_argument,       0, 'M'},
+        {"bench-threads", required_argument, 0, 'T'},
+        {"bench-seconds", required_argument, 0, 'S'},
+        {"bench-rate",   required_argument, 0, 'I'},
+        {"bench-hold",   required_argument, 0, 'H'},
+        {"export",       required_argument, 0, 'E'},
+        {"export-interval", required_argument, 0, 'i'},
+        {"export-format", required_argument, 0, 'F'},
+        {"metrics-port", required_argument, 0, 'P'},
+        {"metrics-socket", required_argument, 0, 'U'},
+        {"trace",        required_argument, 0, 't'},
+        {"compare",      required_argument, 0, 'C'},
+        {"compare-seeds", required_argument, 0, 'N'},
+        {"compare-trace", required_argument, 0, 'Y'},
+        {"queue-memory", required_argument, 0, 'Q'},
+        {"geometry",     required_argument, 0, 'G'},
+        {"scenario",     required_argument, 0, 's'},
+        {"replay",       required_argument, 0, 'r'},
+        {"replay-speed", required_argument, 0, 'x'},
+        {"arrivals",     required_argument, 0, 'p'},
+        {"lane-weights", required_argument, 0, 'w'},
+        {"checkpoint",   required_argument, 0, 'k'},
+        {"checkpoint-interval", required_argument, 0, 'K'},
+        {"restore",      required_argument, 0, 'o'},
+        {"replications", required_argument, 0, 'm'},
+        {"ci-target",    required_argument, 0, 'Z'},
+        {"network",      required_argument, 0, 'J'},
         {0, 0, 0, 0}
     };
 
     int c;
-    while ((c = getopt_long(argc, argv, "d:a:A:q:g:Dnhvb", long_options, NULL)) != -1) {
+    while ((c = getopt_long(argc, argv, "d:a:A:q:g:Dnhvbl:L:R:MT:S:I:H:E:i:F:P:U:t:C:N:Y:Q:G:s:r:x:p:w:k:K:o:m:Z:J:", long_options, NULL)) != -1) {
         switch (c) {
             case 'd':
                 args.duration = atoi(optarg);
                 if (args.duration <= 0) args.duration = SIMULATION_DURATION;
+                args.duration_given = true;
                 break;
             case 'a':
                 args.min_arrival_rate = atoi(optarg);
@@ -138,6 +336,7 @@ CommandLineArgs parse_command_line_args(int argc, char* argv[]) {
             case 'q':
                 args.time_quantum = atoi(optarg);
                 if (args.time_quantum <= 0) args.time_quantum = DEFAULT_TIME_QUANTUM;
+                args.quantum_given = true;
                 break;
             case 'g':
                 if (strcmp(optarg, "sjf") == 0) {
@@ -150,9 +349,11 @@ CommandLineArgs parse_command_line_args(int argc, char* argv[]) {
                     printf("Unknown algorithm: %s\n", optarg);
                     args.help_requested = true;
                 }
+                args.algorithm_given = true;
                 break;
             case 'D':
                 args.debug_mode = true;
+                args.log_level = LOG_LEVEL_DEBUG;
                 break;
             case 'n':
                 args.no_color = true;
@@ -167,8 +368,158 @@ CommandLineArgs parse_command_line_args(int argc, char* argv[]) {
             case 'b':
                 printf("Running in benchmark mode\n");
                 args.duration = 60;
+                args.duration_given = true;
                 args.debug_mode = false;
                 break;
+            case 'l':
+                args.log_file = optarg;
+                break;
+            case 'L':
+                if (!parse_log_level(optarg, &args.log_level)) {
+                    printf("Unknown log level: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'R':
+                args.log_rate_limit = atoi(optarg);
+                if (args.log_rate_limit < 0) args.log_rate_limit = 0;
+                break;
+            case 'M':
+                args.bench_mutex = true;
+                break;
+            case 'T':
+                if (!parse_benchmark_thread_counts(optarg, &args.bench_config)) {
+                    printf("Invalid thread count list: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'S':
+                args.bench_config.duration_seconds = atoi(optarg);
+                if (args.bench_config.duration_seconds <= 0) {
+                    args.bench_config.duration_seconds = BENCH_DEFAULT_SECONDS;
+                }
+                break;
+            case 'I':
+                args.bench_config.arrival_rate = atoi(optarg);
+                if (args.bench_config.arrival_rate < 0) args.bench_config.arrival_rate = 0;
+                break;
+            case 'H':
+                args.bench_config.hold_time_us = atoi(optarg);
+                if (args.bench_config.hold_time_us < 0) args.bench_config.hold_time_us = 0;
+                break;
+            case 'E':
+                snprintf(args.export_config.path, sizeof(args.export_config.path), "%s", optarg);
+                break;
+            case 'i':
+                args.export_config.interval_ms = atoi(optarg);
+                if (args.export_config.interval_ms <= 0) {
+                    args.export_config.interval_ms = EXPORT_DEFAULT_INTERVAL_MS;
+                }
+                break;
+            case 'F':
+                if (!parse_export_format(optarg, &args.export_config.format)) {
+                    printf("Unknown export format: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'P':
+                args.endpoint_config.tcp_port = atoi(optarg);
+                if (args.endpoint_config.tcp_port <= 0 || args.endpoint_config.tcp_port > 65535) {
+                    printf("Invalid metrics port: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'U':
+                snprintf(args.endpoint_config.unix_path, sizeof(args.endpoint_config.unix_path),
+                         "%s", optarg);
+                break;
+            case 't':
+                args.trace_file = optarg;
+                break;
+            case 'C':
+                args.compare_algorithms = true;
+                if (!parse_comparison_algorithms(optarg, &args.compare_config)) {
+                    printf("Invalid algorithm list (need 2-3 of sjf,multilevel,priority): %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'N':
+                args.compare_config.seeds = atoi(optarg);
+                if (args.compare_config.seeds <= 0 || args.compare_config.seeds > COMPARE_MAX_SEEDS) {
+                    printf("Invalid number of seeds: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'Y':
+                args.compare_config.trace_file = optarg;
+                break;
+            case 'Q':
+                args.queue_memory_kb = atoi(optarg);
+                if (args.queue_memory_kb <= 0) {
+                    printf("Invalid queue memory cap: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'G':
+                args.geometry = optarg;
+                break;
+            case 's':
+                args.scenario = optarg;
+                break;
+            case 'r':
+                args.replay_file = optarg;
+                break;
+            case 'x':
+                args.replay_speed = atof(optarg);
+                if (args.replay_speed <= 0) {
+                    printf("Invalid replay speed: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'p':
+                args.arrival_process = parse_arrival_process(optarg, &args.arrival_config);
+                if (!args.arrival_process) {
+                    printf("Invalid arrival process: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'w':
+                args.lane_weights = parse_lane_weights(optarg, &args.arrival_config);
+                if (!args.lane_weights) {
+                    printf("Invalid lane weights: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'k':
+                args.checkpoint_file = optarg;
+                break;
+            case 'K':
+                args.checkpoint_interval = atoi(optarg);
+                if (args.checkpoint_interval <= 0) {
+                    printf("Invalid checkpoint interval: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'o':
+                args.restore_file = optarg;
+                break;
+            case 'm':
+                args.replications = atoi(optarg);
+                if (args.replications <= 0 || args.replications > REPLICATION_MAX) {
+                    printf("Invalid number of replications: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'Z':
+                args.ci_target = atof(optarg) / 100.0;
+                if (args.ci_target <= 0) {
+                    printf("Invalid confidence interval target: %s\n", optarg);
+                    args.help_requested = true;
+                }
+                break;
+            case 'J':
+                args.network_file = optarg;
+                break;
             case '?':
                 args.help_requested = true;
                 break;
@@ -200,6 +551,50 @@ void print_command_line_help() {
     printf("  -D, --debug                Enable debug mode\n");
     printf("  -n, --no-color             Disable color output\n");
     printf("  -b, --benchmark            Run in benchmark mode (60 seconds)\n");
+    printf("  -l, --log-file PATH        Log file (default: trafficguru.log)\n");
+    printf("  -L, --log-level LEVEL      Log level (error|warn|info|debug, default: info)\n");
+    printf("  -R, --log-rate N           Max log lines per second, 0 = unlimited (default: 200)\n");
+    printf("  -M, --bench-mutex          Run the headless mutex contention benchmark and exit\n");
+    printf("  -T, --bench-threads LIST   Lane thread counts, one per lane, capped at the lanes (default: 1,2,4,8,16)\n");
+    printf("  -S, --bench-seconds N      Duration of each benchmark case (default: 2)\n");
+    printf("  -I, --bench-rate N         Attempts per second per thread, 0 = back-to-back (default: 0)\n");
+    printf("  -H, --bench-hold US        Microseconds each acquisition holds the intersection (default: 50)\n");
+    printf("  -E, --export PATH          Append metrics rows to PATH while the simulation runs\n");
+    printf("  -i, --export-interval MS   Interval between exported rows (default: 1000)\n");
+    printf("  -F, --export-format FMT    Export format (csv|binary, default: csv)\n");
+    printf("  -P, --metrics-port PORT    Serve Prometheus metrics on 127.0.0.1:PORT/metrics\n");
+    printf("  -U, --metrics-socket PATH  Serve Prometheus metrics on a Unix domain socket\n");
+    printf("  -t, --trace FILE           Write a binary per-vehicle event trace (see trafficguru-trace)\n");
+    printf("  -C, --compare LIST         Replay identical arrivals against algorithms, first is baseline\n");
+    printf("                             (e.g. sjf,multilevel,priority); uses -d, -a, -A, -q and exits\n");
+    printf("  -N, --compare-seeds N      Replications for --compare confidence intervals (default: 10)\n");
+    printf("  -Y, --compare-trace FILE   Take --compare arrivals from a --trace file instead\n");
+    printf("  -Q, --queue-memory KB      Memory cap for lane queues; beyond storage (%d vehicles)\n"
+           "                             a lane spills back, beyond the cap it drops (default: %d)\n",
+           MAX_QUEUE_CAPACITY, QUEUE_MEMORY_DEFAULT_KB);
+    printf("  -G, --geometry NAME|FILE   Intersection layout: four-way (default), t-junction, five-leg,\n"
+           "                             four-way-dual, or a geometry file (see README)\n");
+    printf("  -s, --scenario FILE        Time-of-day demand, turning ratios, emergency rate and\n"
+           "                             policy from FILE instead of -a/-A (see README)\n");
+    printf("  -r, --replay FILE          Replay arrivals from detector counts (CSV or binary, see\n"
+           "                             README) instead of generating them; --compare uses them too\n");
+    printf("  -x, --replay-speed X       Replay at X times real time (default: 1)\n");
+    printf("  -p, --arrivals SPEC        Arrival process instead of -a/-A gaps: poisson:VEH_H,\n"
+           "                             mmpp:VEH_H,BURST_VEH_H,CALM_S,BURST_S or\n"
+           "                             platoon:VEH_H,CYCLE_S[,HEADWAY_S]; --compare uses it too\n");
+    printf("  -w, --lane-weights LIST    Share of the --arrivals rate per lane (e.g. 3,1,2,1)\n");
+    printf("  -m, --replications N       Run N seeded headless replications of -g on all cores and\n"
+           "                             report each metric's mean, std dev and 95%% CI; uses -d,\n"
+           "                             -a, -A, -q, -s and -p, and exits\n");
+    printf("  -Z, --ci-target PCT        Stop --replications once every 95%% CI is within PCT%% of\n"
+           "                             its mean\n");
+    printf("  -J, --network FILE         Simulate the intersections and links of FILE (see README),\n"
+           "                             each with -G's layout; uses -d, -q and -g, and exits\n");
+    printf("  -k, --checkpoint FILE      Save the simulation state to FILE at the end and on 'c'\n");
+    printf("  -K, --checkpoint-interval S\n"
+           "                             Also save it every S seconds (needs -k)\n");
+    printf("  -o, --restore FILE         Continue from a checkpoint; runs for the time it had left\n"
+           "                             unless -d is given, -g and -q override its settings\n");
     printf("  -h, --help                 Show this help message\n");
     printf("  -v, --version              Show version information\n\n");
     printf("Algorithms:\n");
@@ -210,6 +605,7 @@ void print_command_line_help() {
     printf("  1-3            - Switch scheduling algorithms\n");
     printf("  SPACE          - Pause/Resume simulation\n");
     printf("  e              - Trigger emergency vehicle\n");
+    printf("  c              - Save a checkpoint (with -k)\n");
     printf("  r              - Reset simulation\n");
     printf("  q              - Quit simulation\n");
     printf("  h              - Show help screen\n\n");
@@ -218,6 +614,20 @@ void print_command_line_help() {
     printf("  trafficguru -d 60 -g multilevel         # 60-second simulation with Multilevel Feedback\n");
     printf("  trafficguru --debug --duration 120      # Debug mode for 2 minutes\n");
     printf("  trafficguru --benchmark                   # Run 60-second benchmark\n");
+    printf("  trafficguru --bench-mutex -T 1,4,8 -I 500 -G four-way-dual  # Compare allocation strategies under load\n");
+    printf("  trafficguru -d 3600 -E soak.csv -i 5000  # Record metrics every 5 s for an hour\n");
+    printf("  trafficguru -P 9464                      # Expose metrics for Prometheus scrapes\n");
+    printf("  trafficguru -d 300 -t run.trace          # Trace every vehicle for trafficguru-trace\n");
+    printf("  trafficguru -C sjf,multilevel -N 20      # A/B two algorithms over 20 seeds\n");
+    printf("  trafficguru -G t-junction                # Simulate a three-leg junction\n");
+    printf("  trafficguru -s weekday.scn -d 1440       # A day of demand with the clock at 60x\n");
+    printf("  trafficguru -r loops.csv -x 60           # Detector counts replayed at 60x\n");
+    printf("  trafficguru -p mmpp:600,2400,300,60      # Bursty Poisson arrivals\n");
+    printf("  trafficguru -r may.csv -C sjf,priority -d 2678400  # A/B over a month of counts\n");
+    printf("  trafficguru -m 1000 -Z 2 -g multilevel   # Replicate until every CI is within 2%%\n");
+    printf("  trafficguru -J corridor.net -d 3600      # An hour of a linked corridor\n");
+    printf("  trafficguru -k run.ckpt -K 60            # Checkpoint every minute\n");
+    printf("  trafficguru -o run.ckpt -g priority      # Continue it under another policy\n");
 }
 
 void validate_command_line_args(CommandLineArgs* args) {
@@ -225,7 +635,9 @@ void validate_command_line_args(CommandLineArgs* args) {
         printf("Warning: Duration too short, setting to 10 seconds\n");
         args->duration = 10;
     }
-    if (args->duration > 3600) {
+    // --compare, --replications and --network run in virtual time, so they may cover days
+    if (args->duration > 3600 && !args->compare_algorithms && !args->replications &&
+        !args->network_file) {
         printf("Warning: Duration too long, setting to 1 hour\n");
         args->duration = 3600;
     }
@@ -237,7 +649,11 @@ int init_traffic_guru_system() {
         return 0; // Already initialized
     }
 
-    g_traffic_system = (TrafficGuruSystem*)malloc(sizeof(TrafficGuruSystem));
+    // Cache-line aligned so the per-lane metric shards don't false-share
+    if (posix_memalign((void**)&g_traffic_system, METRICS_CACHE_LINE_SIZE,
+                       sizeof(TrafficGuruSystem)) != 0) {
+        g_traffic_system = NULL;
+    }
     if (!g_traffic_system) {
         printf("Failed to allocate memory for traffic system\n");
         return -1;
@@ -249,9 +665,33 @@ int init_traffic_guru_system() {
     // Initialize random seed
     srand(time(NULL));
 
-    // Initialize lane processes
-    for (int i = 0; i < NUM_LANES; i++) {
-        init_lane_process(&g_traffic_system->lanes[i], i, MAX_QUEUE_CAPACITY);
+    // Run-scoped memory: lane queues and their chunks are carved from it up
+    // front, so the running simulation never goes to the heap for them
+    g_traffic_system->arena = create_run_arena(RUN_ARENA_DEFAULT_BLOCK);
+    if (!g_traffic_system->arena) {
+        printf("Failed to allocate the run arena\n");
+        free(g_traffic_system);
+        g_traffic_system = NULL;
+        return -1;
+    }
+
+    // One lane process per lane of the geometry, in one contiguous array;
+    // their queues share one chunk pool
+    g_traffic_system->num_lanes = get_num_lanes();
+    g_traffic_system->lanes = arena_alloc(g_traffic_system->arena,
+                                          g_traffic_system->num_lanes * sizeof(LaneProcess));
+    g_traffic_system->lane_queue_pool = create_queue_chunk_pool(g_traffic_system->arena,
+                                                                (size_t)QUEUE_MEMORY_DEFAULT_KB * 1024);
+    if (!g_traffic_system->lanes) {
+        printf("Failed to allocate the lanes\n");
+        destroy_run_arena(g_traffic_system->arena);
+        free(g_traffic_system);
+        g_traffic_system = NULL;
+        return -1;
+    }
+    for (int i = 0; i < g_traffic_system->num_lanes; i++) {
+        init_lane_process_with_pool(&g_traffic_system->lanes[i], i, MAX_QUEUE_CAPACITY,
+                                    g_traffic_system->lane_queue_pool);
     }
 
     // Initialize scheduler
@@ -266,8 +706,10 @@ int init_traffic_guru_system() {
     // Initialize performance metrics
     init_performance_metrics(&g_traffic_system->metrics);
 
-    // Initialize emergency system
+    // Initialize emergency system; preemptions go through the scheduler
     init_emergency_system(&g_traffic_system->emergency_system);
+    attach_emergency_scheduler(&g_traffic_system->emergency_system, &g_traffic_system->scheduler);
+    attach_emergency_metrics(&g_traffic_system->emergency_system, &g_traffic_system->metrics);
 
     // Initialize traffic mutex system
     init_traffic_mutex_system();
@@ -296,10 +738,6 @@ int init_traffic_guru_system() {
     // Initialize global state lock
     pthread_mutex_init(&g_traffic_system->global_state_lock, NULL);
 
-    // --- DELETED ---
-    // The snapshot and its mutex are removed.
-    // --- END DELETED ---
-
     // Don't printf after init_visualization, it messes up ncurses
     // printf("TrafficGuru system initialized successfully\n");
     return 0;
@@ -343,16 +781,24 @@ void destroy_traffic_guru_system() {
     destroy_scheduler(&g_traffic_system->scheduler);
 
     // Destroy lane processes
-    for (int i = 0; i < NUM_LANES; i++) {
+    for (int i = 0; i < g_traffic_system->num_lanes; i++) {
         destroy_lane_process(&g_traffic_system->lanes[i]);
     }
+    destroy_queue_chunk_pool(g_traffic_system->lane_queue_pool);
+
+    // Everything carved from the arena goes at once
+    RunAllocationStats allocations;
+    get_run_allocation_stats(&allocations);
+    printf("Run memory: %zu KB reserved, %zu KB peak; heap allocations after start-up: %lld\n",
+           g_traffic_system->arena->bytes_reserved / 1024,
+           g_traffic_system->arena->peak_bytes_used / 1024, allocations.steady_heap_allocations);
+    LOG_INFO("Run memory: %zu KB reserved, %lld heap allocations after start-up",
+             g_traffic_system->arena->bytes_reserved / 1024, allocations.steady_heap_allocations);
+    destroy_run_arena(g_traffic_system->arena);
 
     // Destroy global state lock
     pthread_mutex_destroy(&g_traffic_system->global_state_lock);
 
-    // --- DELETED ---
-    // Removed snapshot mutex destroy
-    // --- END DELETED ---
 
     // Free system structure
     free(g_traffic_system);
@@ -377,7 +823,10 @@ int start_traffic_simulation() {
 
     g_traffic_system->simulation_running = true;
     g_traffic_system->simulation_paused = false;
-    g_traffic_system->simulation_start_time = time(NULL);
+    g_traffic_system->simulation_start_time = time(NULL) - g_traffic_system->restored_elapsed_seconds;
+
+    // Pools are sized by now; any run allocation from here on is steady-state traffic
+    mark_run_allocations_steady();
 
     // Start scheduler
     start_scheduler(&g_traffic_system->scheduler);
@@ -401,6 +850,14 @@ int start_traffic_simulation() {
     }
     // --- END FIX ---
 
+    if (pthread_create(&g_traffic_system->metrics_sampler_thread, NULL,
+                      metrics_sampler_loop, NULL) != 0) {
+        g_traffic_system->simulation_running = false;
+        pthread_join(g_traffic_system->simulation_thread, NULL);
+        pthread_join(g_traffic_system->vehicle_generator_thread, NULL);
+        return -1;
+    }
+
 
     // printf("Traffic simulation started\n");
     return 0;
@@ -433,6 +890,14 @@ void stop_traffic_simulation() {
     }
     // --- END FIX ---
 
+    if (g_traffic_system->metrics_sampler_thread) {
+        pthread_join(g_traffic_system->metrics_sampler_thread, NULL);
+        g_traffic_system->metrics_sampler_thread = 0;
+    }
+
+    // Fold in whatever was served after the sampler's last tick
+    sample_simulation_metrics();
+
 
     // printf("Traffic simulation stopped\n");
 }
@@ -469,8 +934,20 @@ void* simulation_main_loop(void* arg) {
             process_traffic_events();
         }
 
-        // Sleep to control simulation speed
-        usleep(SIMULATION_UPDATE_INTERVAL);
+        // Between time slices no lane is crossing: a consistent point to save
+        checkpoint_tick();
+
+        // Sleep to control simulation speed; while running, an emergency
+        // preemption request wakes the loop so all-red starts without
+        // waiting out the tick
+        if (g_traffic_system->simulation_paused) {
+            usleep(SIMULATION_UPDATE_INTERVAL);
+        } else {
+            pthread_mutex_lock(&g_traffic_system->scheduler.scheduler_lock);
+            scheduler_wait_unless_preempted(&g_traffic_system->scheduler,
+                                            (long long)SIMULATION_UPDATE_INTERVAL * NS_PER_US);
+            pthread_mutex_unlock(&g_traffic_system->scheduler.scheduler_lock);
+        }
     }
 
     // printf("Simulation main loop ended\n");
@@ -485,22 +962,77 @@ void update_simulation_state() {
 
     // --- DEADLOCK FIX: Lock only for metrics update ---
     pthread_mutex_lock(&g_traffic_system->global_state_lock);
-    // Update metrics
-    update_time_based_metrics(&g_traffic_system->metrics, time(NULL));
     // Update emergency system
     update_emergency_progress(&g_traffic_system->emergency_system);
     pthread_mutex_unlock(&g_traffic_system->global_state_lock);
     // --- END DEADLOCK FIX ---
 
+    // Readers (UI, metrics endpoint) only ever see the published copy
+    capture_simulation_snapshot();
+    publish_metrics_endpoint_snapshot(&g_traffic_system->metrics, &g_traffic_system->scheduler);
+
 
     // Check for deadlocks (must be outside the global lock)
     static int deadlock_check_counter = 0;
     if (++deadlock_check_counter >= 100) { // Check every 100 iterations
-        detect_and_resolve_advanced_deadlock(g_traffic_system->lanes);
+        detect_and_resolve_advanced_deadlock(g_traffic_system->lanes, g_traffic_system->num_lanes);
         deadlock_check_counter = 0;
     }
 }
 
+// Aggregate the metrics and advance the rolling windows
+void sample_simulation_metrics() {
+    if (!g_traffic_system) {
+        return;
+    }
+
+    for (int i = 0; i < g_traffic_system->num_lanes; i++) {
+        record_lane_queue_length(&g_traffic_system->metrics, i,
+                                 __atomic_load_n(&g_traffic_system->lanes[i].queue_length,
+                                                 __ATOMIC_RELAXED));
+    }
+
+    pthread_mutex_lock(&g_traffic_system->global_state_lock);
+    update_time_based_metrics(&g_traffic_system->metrics, time(NULL));
+    metrics_exporter_tick(&g_traffic_system->metrics);
+    pthread_mutex_unlock(&g_traffic_system->global_state_lock);
+}
+
+// Metrics sampler loop: the simulation thread sleeps through whole
+// crossings, so sampling runs on its own fixed grid instead. This thread
+// is the only caller of update_time_based_metrics() and of the exporter
+// while the run is live; it also wakes when an export row is due, so rows
+// land on the --export-interval grid rather than the next sampler tick.
+void* metrics_sampler_loop(void* arg) {
+    (void)arg;
+
+    long long next_ns = monotonic_now_ns();
+    while (g_traffic_system && g_traffic_system->simulation_running && keep_running) {
+        // Stay on the grid; after a stall resume from now rather than catch up
+        long long now_ns = monotonic_now_ns();
+        if (now_ns >= next_ns) {
+            next_ns += METRICS_SAMPLE_INTERVAL_NS;
+            if (next_ns <= now_ns) {
+                next_ns = now_ns + METRICS_SAMPLE_INTERVAL_NS;
+            }
+        }
+
+        sample_simulation_metrics();
+
+        long long wake_ns = next_ns;
+        long long export_due_ns = metrics_exporter_next_due_ns();
+        if (export_due_ns > 0 && export_due_ns < wake_ns) {
+            wake_ns = export_due_ns;
+        }
+        now_ns = monotonic_now_ns();
+        if (wake_ns > now_ns) {
+            sleep_ns(wake_ns - now_ns);
+        }
+    }
+
+    return NULL;
+}
+
 // Process traffic events
 void process_traffic_events() {
     if (!g_traffic_system) {
@@ -509,7 +1041,7 @@ void process_traffic_events() {
 
     // Run scheduling algorithm
     int next_lane = schedule_next_lane(&g_traffic_system->scheduler,
-                                      g_traffic_system->lanes);
+                                      g_traffic_system->lanes, g_traffic_system->num_lanes);
 
     if (next_lane != -1) {
         // Execute time slice for selected lane
@@ -546,6 +1078,11 @@ void print_usage(const char* program_name) {
 void cleanup_and_exit(int exit_code) {
     destroy_traffic_guru_system();
     // ncurses cleanup should happen in destroy_visualization
+    stop_metrics_exporter(); // Sampler thread has stopped producing rows
+    stop_metrics_endpoint();
+    stop_vehicle_trace(); // Lane and scheduler threads have been joined
+    close_detector_replay(get_detector_replay()); // Generator has been joined
+    destroy_logger(); // Flush remaining log records last
     exit(exit_code);
 }
 
@@ -593,39 +1130,30 @@ void set_time_quantum(int seconds) {
     }
 }
 
+void set_queue_memory_limit(int kilobytes) {
+    if (g_traffic_system && kilobytes > 0) {
+        set_queue_chunk_pool_limit(g_traffic_system->lane_queue_pool, (size_t)kilobytes * 1024);
+    }
+}
+
 void set_debug_mode(bool enabled) {
-    // printf("Debug mode %s\n", enabled ? "enabled" : "disabled");
-    
-    // --- FIX: Suppress unused parameter warning ---
-    (void)enabled;
+    if (enabled) {
+        set_log_level(LOG_LEVEL_DEBUG);
+    }
+    LOG_INFO("Debug mode %s", enabled ? "enabled" : "disabled");
 }
 
-// Logging functions
+// Logging functions (asynchronous, safe while ncurses owns the screen)
 void log_system_event(const char* event) {
-    time_t now = time(NULL);
-    // printf("[%ld] EVENT: %s\n", now, event);
-
-    // --- FIX: Suppress unused warnings ---
-    (void)event;
-    (void)now;
+    LOG_INFO("EVENT: %s", event);
 }
 
 void log_error(const char* error) {
-    time_t now = time(NULL);
-    // fprintf(stderr, "[%ld] ERROR: %s\n", now, error);
-
-    // --- FIX: Suppress unused warnings ---
-    (void)error;
-    (void)now;
+    LOG_ERROR("%s", error);
 }
 
 void log_debug(const char* message) {
-    time_t now = time(NULL);
-    // printf("[%ld] DEBUG: %s\n", now, message);
-
-    // --- FIX: Suppress unused warnings ---
-    (void)message;
-    (void)now;
+    LOG_DEBUG("%s", message);
 }
 
 void log_performance_summary() {
@@ -639,9 +1167,53 @@ void log_performance_summary() {
     printf("===========================\n\n");
 }
 
-// --- DELETED ---
-// The update_visualization_snapshot function is removed.
-// --- END DELETED ---
+// Copy what the UI and endpoint show into a SimSnapshot. Runs under the
+// snapshot publish lock; takes each lane lock and then global_state_lock,
+// one at a time.
+static void fill_simulation_snapshot(SimSnapshot* snapshot) {
+    snapshot->num_lanes = g_traffic_system->num_lanes;
+    for (int i = 0; i < g_traffic_system->num_lanes; i++) {
+        LaneProcess* lane = &g_traffic_system->lanes[i];
+        pthread_mutex_lock(&lane->queue_lock);
+        snapshot->lane_queue_length[i] = lane->queue_length;
+        snapshot->lane_spillback[i] = get_spillback_length(lane->queue);
+        snapshot->lane_waiting_time[i] = lane->waiting_time;
+        snapshot->lane_state[i] = lane->state;
+        pthread_mutex_unlock(&lane->queue_lock);
+    }
+
+    snapshot->algorithm = __atomic_load_n(&g_traffic_system->scheduler.algorithm, __ATOMIC_RELAXED);
+    snapshot->current_lane = __atomic_load_n(&g_traffic_system->scheduler.current_lane,
+                                            __ATOMIC_RELAXED);
+
+    PerformanceMetrics* metrics = &g_traffic_system->metrics;
+    pthread_mutex_lock(&g_traffic_system->global_state_lock);
+    snapshot->emergency_mode = g_traffic_system->emergency_system.emergency_mode;
+    snapshot->total_vehicles_generated = g_traffic_system->total_vehicles_generated;
+    snapshot->vehicles_per_minute = metrics->vehicles_per_minute;
+    snapshot->avg_wait_time = metrics->avg_wait_time;
+    snapshot->utilization = metrics->utilization;
+    snapshot->fairness_index = metrics->fairness_index;
+    snapshot->emergency_response_time = metrics->emergency_response_time;
+    snapshot->total_vehicles_processed = metrics->total_vehicles_processed;
+    snapshot->context_switches = metrics->context_switches;
+    snapshot->deadlocks_prevented = metrics->deadlocks_prevented;
+    snapshot->queue_overflow_count = metrics->queue_overflow_count;
+    snapshot->spillback_vehicles = metrics->spillback_vehicles;
+    snapshot->spillback_delay = metrics->spillback_delay;
+    snapshot->simulation_seconds = metrics->total_simulation_time;
+    pthread_mutex_unlock(&g_traffic_system->global_state_lock);
+
+}
+
+// Capture and publish the simulation state. Callers must hold no lane lock
+// and not global_state_lock.
+void capture_simulation_snapshot() {
+    if (!g_traffic_system) {
+        return;
+    }
+    capture_and_publish_sim_snapshot(fill_simulation_snapshot);
+}
 
 
 // --- RENAMED FUNCTION ---
@@ -673,22 +1245,215 @@ int main(int argc, char* argv[]) {
         print_system_info();
     }
 
+    // Start the background log writer before any component can log
+    if (init_logger(args.log_file, args.log_level, args.log_rate_limit) != 0) {
+        printf("Warning: could not open log file %s, logging disabled\n", args.log_file);
+    }
+
+    // A scenario may name its geometry, so it is parsed first
+    static TrafficScenario scenario;
+    if (args.scenario && !load_traffic_scenario(&scenario, args.scenario)) {
+        destroy_logger();
+        return 1;
+    }
+
+    // Every mode sizes its lanes, quadrants and tables from the geometry
+    const char* geometry_spec = args.geometry;
+    if (!geometry_spec) {
+        geometry_spec = args.scenario && scenario.geometry[0] ? scenario.geometry : DEFAULT_GEOMETRY;
+    }
+    IntersectionGeometry geometry;
+    if (!load_intersection_geometry(&geometry, geometry_spec)) {
+        destroy_logger();
+        return 1;
+    }
+    set_intersection_geometry(&geometry);
+    if (args.debug_mode) {
+        print_intersection_geometry(&geometry);
+    }
+
+    if (args.scenario) {
+        if (!resolve_traffic_scenario(&scenario, &geometry)) {
+            destroy_logger();
+            return 1;
+        }
+        set_traffic_scenario(&scenario);
+        if (args.debug_mode) {
+            print_traffic_scenario(&scenario);
+        }
+    }
+
+    // Detector lanes are resolved by name, so the geometry must be set first
+    static DetectorReplay replay;
+    if (args.replay_file) {
+        if (args.scenario || args.compare_config.trace_file) {
+            printf("--replay cannot be combined with --scenario or --compare-trace\n");
+            destroy_logger();
+            return 1;
+        }
+        if (!open_detector_replay(&replay, args.replay_file)) {
+            destroy_logger();
+            return 1;
+        }
+        set_detector_replay(&replay, args.replay_speed);
+    }
+
+    // Lane weights are per lane of the geometry
+    if (args.lane_weights && !args.arrival_process) {
+        printf("--lane-weights needs --arrivals\n");
+        destroy_logger();
+        return 1;
+    }
+    if (args.arrival_process) {
+        if (args.scenario || args.replay_file || args.compare_config.trace_file) {
+            printf("--arrivals cannot be combined with --scenario, --replay or --compare-trace\n");
+            destroy_logger();
+            return 1;
+        }
+        if (!resolve_arrival_process(&args.arrival_config, geometry.num_lanes)) {
+            destroy_logger();
+            return 1;
+        }
+        set_arrival_process_config(&args.arrival_config);
+    }
+
+    // Headless contention benchmark: no simulation, no ncurses
+    if (args.bench_mutex) {
+        int result = run_mutex_benchmark(&args.bench_config);
+        destroy_logger();
+        return result == 0 ? 0 : 1;
+    }
+
+    // Headless road network: every intersection replayed in virtual time
+    if (args.network_file) {
+        if (args.compare_algorithms || args.replications || args.scenario || args.replay_file ||
+            args.arrival_process || args.compare_config.trace_file) {
+            printf("--network draws its arrivals from its sources; it cannot be combined with\n"
+                   "--compare, --replications, --scenario, --replay, --arrivals or --compare-trace\n");
+            close_detector_replay(get_detector_replay());
+            destroy_logger();
+            return 1;
+        }
+        static RoadNetwork network;
+        int result = -1;
+        if (load_road_network(&network, args.network_file, &geometry)) {
+            RoadNetworkConfig network_config;
+            init_road_network_config(&network_config);
+            network_config.algorithm = args.algorithm;
+            network_config.run.duration_seconds = args.duration;
+            network_config.run.time_quantum = args.time_quantum;
+            result = run_road_network(&network, &network_config);
+        }
+        destroy_logger();
+        return result == 0 ? 0 : 1;
+    }
+
+    // Headless Monte Carlo replications of one algorithm on all cores
+    if (args.ci_target > 0 && !args.replications) {
+        printf("--ci-target needs --replications\n");
+        close_detector_replay(get_detector_replay());
+        destroy_logger();
+        return 1;
+    }
+    if (args.replications) {
+        if (args.compare_algorithms || args.replay_file || args.compare_config.trace_file) {
+            printf("--replications draws its own arrivals; it cannot be combined with\n"
+                   "--compare, --replay or --compare-trace\n");
+            close_detector_replay(get_detector_replay());
+            destroy_logger();
+            return 1;
+        }
+        ReplicationConfig replication_config;
+        init_replication_config(&replication_config);
+        replication_config.algorithm = args.algorithm;
+        replication_config.replications = args.replications;
+        replication_config.ci_target = args.ci_target;
+        replication_config.run.duration_seconds = args.duration;
+        replication_config.run.min_arrival_rate = args.min_arrival_rate;
+        replication_config.run.max_arrival_rate = args.max_arrival_rate;
+        replication_config.run.time_quantum = args.time_quantum;
+        int result = run_replications(&replication_config);
+        destroy_logger();
+        return result == 0 ? 0 : 1;
+    }
+
+    // Headless A/B comparison: virtual-time replays, no simulation threads
+    if (args.compare_algorithms) {
+        args.compare_config.duration_seconds = args.duration;
+        args.compare_config.min_arrival_rate = args.min_arrival_rate;
+        args.compare_config.max_arrival_rate = args.max_arrival_rate;
+        args.compare_config.time_quantum = args.time_quantum;
+        int result = run_algorithm_comparison(&args.compare_config);
+        close_detector_replay(get_detector_replay());
+        destroy_logger();
+        return result == 0 ? 0 : 1;
+    }
+
+    // Checkpoints are live-simulation state; a bad file is reported before ncurses starts
+    if (args.checkpoint_interval && !args.checkpoint_file) {
+        printf("--checkpoint-interval needs --checkpoint\n");
+        close_detector_replay(get_detector_replay());
+        destroy_logger();
+        return 1;
+    }
+    if (args.restore_file && !load_checkpoint(args.restore_file)) {
+        close_detector_replay(get_detector_replay());
+        destroy_logger();
+        return 1;
+    }
+
     // Initialize system
     if (init_traffic_guru_system() != 0) {
         printf("Failed to initialize TrafficGuru system\n");
+        destroy_logger();
         return 1;
     }
+    log_system_event("TrafficGuru system initialized");
+
+    // Periodic metrics export runs on its own writer thread
+    if (args.export_config.path[0] != '\0' && start_metrics_exporter(&args.export_config) != 0) {
+        printf("Warning: could not start metrics export to %s, export disabled\n", args.export_config.path);
+    }
+
+    // Prometheus scrapes read a published snapshot, never simulation state
+    if (is_metrics_endpoint_configured(&args.endpoint_config) &&
+        start_metrics_endpoint(&args.endpoint_config) != 0) {
+        printf("Warning: could not start the metrics endpoint\n");
+    }
+
+    // Vehicle trace records go to per-thread buffers, flushed on stop
+    if (args.trace_file && start_vehicle_trace(args.trace_file) != 0) {
+        printf("Warning: could not open trace file %s, tracing disabled\n", args.trace_file);
+    }
 
     // Apply configuration from command line
     set_simulation_duration(args.duration);
     set_vehicle_arrival_rate(args.min_arrival_rate, args.max_arrival_rate);
     set_time_quantum(args.time_quantum);
+    set_queue_memory_limit(args.queue_memory_kb);
     set_debug_mode(args.debug_mode);
 
     // Set scheduling algorithm
     set_scheduling_algorithm(&g_traffic_system->scheduler, args.algorithm);
     // printf("Using scheduling algorithm: %s\n", get_algorithm_name(args.algorithm));
 
+    // Continue a checkpointed run; options given on this command line win
+    if (args.restore_file) {
+        int remaining_seconds = 0;
+        restore_checkpoint(&remaining_seconds);
+        if (!args.duration_given && remaining_seconds > 0) {
+            set_simulation_duration(remaining_seconds);
+        }
+        if (args.algorithm_given) {
+            set_scheduling_algorithm(&g_traffic_system->scheduler, args.algorithm);
+        }
+        if (args.quantum_given) {
+            set_time_quantum(args.time_quantum);
+        }
+        log_system_event("Simulation restored from checkpoint");
+    }
+    set_checkpoint_schedule(args.checkpoint_file, args.checkpoint_interval);
+
     // Start simulation
     if (start_traffic_simulation() != 0) {
         // ncurses is active, so we can't just printf
@@ -723,13 +1488,8 @@ int main(int argc, char* argv[]) {
     // Main loop - handle user input and maintain simulation
     while (keep_running && g_traffic_system->simulation_running) {
         
-        // --- DELETED ---
-        // update_visualization_snapshot() is removed.
-        // --- END DELETED ---
-
-        // Display real-time visualization
-        // This function must be drawing to the ncurses screen
-        display_real_time_status(); // This will now use the snapshot
+        // Display real-time visualization from the published snapshot
+        display_real_time_status();
 
         // --- MODIFICATION ---
         // We will call your project's built-in input handler,
@@ -771,8 +1531,10 @@ int main(int argc, char* argv[]) {
         // --- END MODIFICATION ---
     }
 
-    // Stop simulation
+    // Stop simulation; the final checkpoint keeps any time the run had left
+    time_t planned_end_time = g_traffic_system->simulation_end_time;
     stop_traffic_simulation();
+    save_final_checkpoint(planned_end_time);
 
     // Cleanup (destroy_visualization will call endwin())
     // and exit
@@ -0,0 +1,540 @@
+/*
+ * Metrics Endpoint Implementation - Snapshot Publication and HTTP Server
+ *
+ * One server thread polls the listening sockets, answers each connection
+ * with a single HTTP/1.0 response and closes it. Requests are handled one
+ * at a time with short socket timeouts; a scrape is a few kilobytes, so
+ * there is no need for more.
+ *
+ * Compilation: Include metrics_endpoint.h, traffic_mutex.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/metrics_endpoint.h"
+#include "../include/sim_snapshot.h"
+#include "../include/traffic_mutex.h"
+#include "../include/logger.h"
+#include "../include/sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define ENDPOINT_POLL_MS 250
+#define ENDPOINT_IO_TIMEOUT_SEC 1
+#define ENDPOINT_REQUEST_SIZE 2048
+#define ENDPOINT_RESPONSE_SIZE 32768
+
+typedef struct {
+    MetricsEndpointConfig config;
+    int tcp_fd;
+    int unix_fd;
+    pthread_t server_thread;
+    bool running;
+    long long next_publish_ns;
+    long long scrapes_served;
+} MetricsEndpoint;
+
+static MetricsEndpoint g_endpoint = { .tcp_fd = -1, .unix_fd = -1 };
+static MetricsEndpointSnapshot g_snapshot;
+static unsigned int g_snapshot_sequence = 0;   // Odd while a publish is in progress
+
+static const double summary_quantiles[METRICS_ENDPOINT_QUANTILES] = { 0.5, 0.95, 0.99 };
+
+void init_metrics_endpoint_config(MetricsEndpointConfig* config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(MetricsEndpointConfig));
+}
+
+bool is_metrics_endpoint_configured(const MetricsEndpointConfig* config) {
+    return config && (config->tcp_port > 0 || config->unix_path[0] != '\0');
+}
+
+// Summarize a histogram, scaling its samples to seconds
+static void summarize_histogram(const LatencyHistogram* histogram, double unit,
+                                MetricsEndpointSummary* summary) {
+    summary->count = histogram_count(histogram);
+    summary->sum = histogram_mean(histogram) * summary->count / unit;
+    for (int q = 0; q < METRICS_ENDPOINT_QUANTILES; q++) {
+        summary->quantiles[q] = histogram_percentile(histogram, summary_quantiles[q] * 100.0) / unit;
+    }
+}
+
+// Simulation thread: copy the current numbers into the published snapshot
+void publish_metrics_endpoint_snapshot(PerformanceMetrics* metrics, Scheduler* scheduler) {
+    if (!metrics || !__atomic_load_n(&g_endpoint.running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    long long now_ns = monotonic_now_ns();
+    if (now_ns < g_endpoint.next_publish_ns) {
+        return;
+    }
+    g_endpoint.next_publish_ns = now_ns + METRICS_ENDPOINT_PUBLISH_MS * NS_PER_MS;
+
+    // Core gauges come from the simulation snapshot, the same copy the UI shows
+    SimSnapshot sim;
+    read_sim_snapshot(&sim);
+
+    MetricsEndpointSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.published_ns = now_ns;
+    snapshot.vehicles_per_minute = sim.vehicles_per_minute;
+    snapshot.avg_wait_time = sim.avg_wait_time;
+    snapshot.utilization = sim.utilization;
+    snapshot.fairness_index = sim.fairness_index;
+    snapshot.emergency_response_time = sim.emergency_response_time;
+    snapshot.total_vehicles = sim.total_vehicles_processed;
+    snapshot.context_switches = sim.context_switches;
+    snapshot.deadlocks_prevented = sim.deadlocks_prevented;
+    snapshot.queue_overflows = sim.queue_overflow_count;
+    snapshot.spillback_vehicles = sim.spillback_vehicles;
+    snapshot.spillback_delay_seconds = sim.spillback_delay;
+    snapshot.simulation_seconds = sim.simulation_seconds;
+    snapshot.num_lanes = metrics->num_lanes;
+    for (int i = 0; i < snapshot.num_lanes; i++) {
+        snapshot.lane_vehicles[i] = metrics->lane_throughput[i];
+        snapshot.lane_wait_seconds[i] = metrics->lane_wait_times[i];
+        snapshot.lane_queue_length[i] = sim.lane_queue_length[i];
+        snapshot.lane_spillback[i] = sim.lane_spillback[i];
+    }
+    summarize_histogram(&metrics->wait_time_ms, 1e3, &snapshot.vehicle_wait);
+    summarize_histogram(&metrics->preemption_latency_ns, 1e9, &snapshot.emergency_preemption);
+    snapshot.emergency_preclears = __atomic_load_n(&metrics->emergency_preclears, __ATOMIC_RELAXED);
+    snapshot.emergency_preemptions = __atomic_load_n(&metrics->emergency_preemptions, __ATOMIC_RELAXED);
+
+    MutexPerformanceStats lock_stats;
+    get_mutex_performance_stats(&lock_stats);
+    snapshot.lock_acquisitions = lock_stats.total_acquisitions;
+    snapshot.lock_successes = lock_stats.successful_acquisitions;
+    snapshot.lock_failures = lock_stats.failed_acquisitions;
+    snapshot.lock_timeouts = lock_stats.timeouts;
+    snapshot.lock_preemptions = lock_stats.preemptive_acquisitions;
+    summarize_histogram(get_mutex_acquire_latency_histogram(), 1e9, &snapshot.lock_acquire);
+
+    if (scheduler) {
+        summarize_histogram(&scheduler->decision_latency_ns, 1e9, &snapshot.scheduler_decision);
+    }
+
+    unsigned int sequence = g_snapshot_sequence;
+    __atomic_store_n(&g_snapshot_sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    g_snapshot = snapshot;
+    __atomic_store_n(&g_snapshot_sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+// Copy the latest snapshot; false if nothing has been published yet
+bool read_metrics_endpoint_snapshot(MetricsEndpointSnapshot* snapshot) {
+    if (!snapshot) {
+        return false;
+    }
+
+    unsigned int before, after;
+    do {
+        before = __atomic_load_n(&g_snapshot_sequence, __ATOMIC_ACQUIRE);
+        *snapshot = g_snapshot;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&g_snapshot_sequence, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+
+    return before != 0;
+}
+
+// snprintf into the remaining space; returns the new used length
+static int append_text(char* buffer, int size, int used, const char* format, ...)
+    __attribute__((format(printf, 4, 5)));
+
+static int append_text(char* buffer, int size, int used, const char* format, ...) {
+    if (used >= size) {
+        return used;
+    }
+
+    va_list ap;
+    va_start(ap, format);
+    int written = vsnprintf(buffer + used, size - used, format, ap);
+    va_end(ap);
+
+    if (written < 0) {
+        return used;
+    }
+    return used + written < size ? used + written : size;
+}
+
+static int append_metric_header(char* buffer, int size, int used, const char* name,
+                                const char* type, const char* help) {
+    used = append_text(buffer, size, used, "# HELP %s %s\n", name, help);
+    return append_text(buffer, size, used, "# TYPE %s %s\n", name, type);
+}
+
+static int append_summary(char* buffer, int size, int used, const char* name, const char* help,
+                          const MetricsEndpointSummary* summary) {
+    used = append_metric_header(buffer, size, used, name, "summary", help);
+    for (int q = 0; q < METRICS_ENDPOINT_QUANTILES; q++) {
+        used = append_text(buffer, size, used, "%s{quantile=\"%g\"} %.9f\n",
+                           name, summary_quantiles[q], summary->quantiles[q]);
+    }
+    used = append_text(buffer, size, used, "%s_sum %.9f\n", name, summary->sum);
+    return append_text(buffer, size, used, "%s_count %lld\n", name, summary->count);
+}
+
+// Render a snapshot in Prometheus text exposition format; returns its length
+int format_prometheus_metrics(const MetricsEndpointSnapshot* snapshot, char* buffer, int size) {
+    if (!snapshot || !buffer || size <= 0) {
+        return 0;
+    }
+
+    int used = 0;
+    double age = (double)(monotonic_now_ns() - snapshot->published_ns) / NS_PER_SEC;
+
+    used = append_metric_header(buffer, size, used, "trafficguru_snapshot_age_seconds", "gauge",
+                                "Seconds since the simulation thread published these values.");
+    used = append_text(buffer, size, used, "trafficguru_snapshot_age_seconds %.3f\n", age);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_simulation_seconds", "gauge",
+                                "Elapsed simulation time.");
+    used = append_text(buffer, size, used, "trafficguru_simulation_seconds %d\n",
+                       snapshot->simulation_seconds);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_vehicles_processed_total", "counter",
+                                "Vehicles that have crossed the intersection.");
+    used = append_text(buffer, size, used, "trafficguru_vehicles_processed_total %d\n",
+                       snapshot->total_vehicles);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_throughput_vehicles_per_minute",
+                                "gauge", "Average throughput since the run started.");
+    used = append_text(buffer, size, used, "trafficguru_throughput_vehicles_per_minute %.3f\n",
+                       snapshot->vehicles_per_minute);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_wait_seconds_average", "gauge",
+                                "Average wait per lane since the run started.");
+    used = append_text(buffer, size, used, "trafficguru_wait_seconds_average %.3f\n",
+                       snapshot->avg_wait_time);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_utilization_ratio", "gauge",
+                                "Intersection utilization (0-1).");
+    used = append_text(buffer, size, used, "trafficguru_utilization_ratio %.4f\n",
+                       snapshot->utilization);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_fairness_index", "gauge",
+                                "Jain's fairness index over lane wait times.");
+    used = append_text(buffer, size, used, "trafficguru_fairness_index %.4f\n",
+                       snapshot->fairness_index);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_context_switches_total", "counter",
+                                "Signal changes between lanes.");
+    used = append_text(buffer, size, used, "trafficguru_context_switches_total %d\n",
+                       snapshot->context_switches);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_deadlocks_prevented_total",
+                                "counter", "Requests denied to avoid an unsafe state.");
+    used = append_text(buffer, size, used, "trafficguru_deadlocks_prevented_total %d\n",
+                       snapshot->deadlocks_prevented);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_queue_overflows_total", "counter",
+                                "Vehicles dropped because the lane queues reached their memory cap.");
+    used = append_text(buffer, size, used, "trafficguru_queue_overflows_total %d\n",
+                       snapshot->queue_overflows);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_spillback_vehicles_total", "counter",
+                                "Served vehicles that first waited upstream of a full lane.");
+    used = append_text(buffer, size, used, "trafficguru_spillback_vehicles_total %d\n",
+                       snapshot->spillback_vehicles);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_spillback_delay_seconds_total",
+                                "counter", "Time served vehicles spent upstream of a full lane.");
+    used = append_text(buffer, size, used, "trafficguru_spillback_delay_seconds_total %.3f\n",
+                       snapshot->spillback_delay_seconds);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_lane_vehicles_processed_total",
+                                "counter", "Vehicles served per lane.");
+    for (int i = 0; i < snapshot->num_lanes; i++) {
+        used = append_text(buffer, size, used,
+                           "trafficguru_lane_vehicles_processed_total{lane=\"%d\"} %d\n",
+                           i, snapshot->lane_vehicles[i]);
+    }
+
+    used = append_metric_header(buffer, size, used, "trafficguru_lane_wait_seconds_total", "counter",
+                                "Total wait of vehicles served per lane.");
+    for (int i = 0; i < snapshot->num_lanes; i++) {
+        used = append_text(buffer, size, used, "trafficguru_lane_wait_seconds_total{lane=\"%d\"} %.3f\n",
+                           i, snapshot->lane_wait_seconds[i]);
+    }
+
+    used = append_metric_header(buffer, size, used, "trafficguru_lane_queue_length", "gauge",
+                                "Vehicles currently queued per lane.");
+    for (int i = 0; i < snapshot->num_lanes; i++) {
+        used = append_text(buffer, size, used, "trafficguru_lane_queue_length{lane=\"%d\"} %d\n",
+                           i, snapshot->lane_queue_length[i]);
+    }
+
+    used = append_metric_header(buffer, size, used, "trafficguru_lane_spillback_length", "gauge",
+                                "Queued vehicles held upstream of the lane's storage.");
+    for (int i = 0; i < snapshot->num_lanes; i++) {
+        used = append_text(buffer, size, used, "trafficguru_lane_spillback_length{lane=\"%d\"} %d\n",
+                           i, snapshot->lane_spillback[i]);
+    }
+
+    used = append_summary(buffer, size, used, "trafficguru_vehicle_wait_seconds",
+                          "Wait of each served vehicle.", &snapshot->vehicle_wait);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_intersection_lock_attempts_total",
+                                "counter", "Intersection acquisition attempts by outcome.");
+    used = append_text(buffer, size, used,
+                       "trafficguru_intersection_lock_attempts_total{result=\"success\"} %lld\n",
+                       snapshot->lock_successes);
+    used = append_text(buffer, size, used,
+                       "trafficguru_intersection_lock_attempts_total{result=\"failure\"} %lld\n",
+                       snapshot->lock_failures);
+    used = append_text(buffer, size, used,
+                       "trafficguru_intersection_lock_attempts_total{result=\"timeout\"} %lld\n",
+                       snapshot->lock_timeouts);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_intersection_lock_preemptions_total",
+                                "counter", "Acquisitions that preempted another lane.");
+    used = append_text(buffer, size, used, "trafficguru_intersection_lock_preemptions_total %lld\n",
+                       snapshot->lock_preemptions);
+
+    used = append_summary(buffer, size, used, "trafficguru_intersection_lock_wait_seconds",
+                          "Time spent acquiring the intersection.", &snapshot->lock_acquire);
+
+    used = append_summary(buffer, size, used, "trafficguru_scheduler_decision_seconds",
+                          "Time the scheduling algorithm takes to pick a lane.",
+                          &snapshot->scheduler_decision);
+
+    used = append_summary(buffer, size, used, "trafficguru_emergency_preemption_latency_seconds",
+                          "Emergency detection to green.", &snapshot->emergency_preemption);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_emergency_greens_total", "counter",
+                                "Emergency greens by how they were obtained.");
+    used = append_text(buffer, size, used, "trafficguru_emergency_greens_total{mode=\"preclear\"} %d\n",
+                       snapshot->emergency_preclears);
+    used = append_text(buffer, size, used, "trafficguru_emergency_greens_total{mode=\"preempt\"} %d\n",
+                       snapshot->emergency_preemptions);
+
+    used = append_metric_header(buffer, size, used, "trafficguru_emergency_response_seconds", "gauge",
+                                "Mean emergency stop-line delay.");
+    used = append_text(buffer, size, used, "trafficguru_emergency_response_seconds %.3f\n",
+                       snapshot->emergency_response_time);
+
+    return used;
+}
+
+// Write the whole buffer, giving up on error or timeout
+static void write_fully(int fd, const char* data, int length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        length -= (int)written;
+    }
+}
+
+// Read one request, answer it, close the connection
+static void serve_client(int client_fd) {
+    struct timeval timeout = { ENDPOINT_IO_TIMEOUT_SEC, 0 };
+    setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    char request[ENDPOINT_REQUEST_SIZE];
+    int received = 0;
+    while (received < (int)sizeof(request) - 1) {
+        ssize_t n = read(client_fd, request + received, sizeof(request) - 1 - received);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        received += (int)n;
+        request[received] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n")) {
+            break;
+        }
+    }
+    request[received] = '\0';
+
+    static char body[ENDPOINT_RESPONSE_SIZE];
+    char header[256];
+    int body_length;
+    const char* status;
+
+    if (strncmp(request, "GET /metrics", 12) == 0) {
+        MetricsEndpointSnapshot snapshot;
+        if (read_metrics_endpoint_snapshot(&snapshot)) {
+            status = "200 OK";
+            body_length = format_prometheus_metrics(&snapshot, body, sizeof(body));
+        } else {
+            status = "503 Service Unavailable";
+            body_length = snprintf(body, sizeof(body), "no snapshot published yet\n");
+        }
+    } else {
+        status = "404 Not Found";
+        body_length = snprintf(body, sizeof(body), "metrics are served at /metrics\n");
+    }
+
+    int header_length = snprintf(header, sizeof(header),
+                                 "HTTP/1.0 %s\r\n"
+                                 "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                                 "Content-Length: %d\r\n"
+                                 "Connection: close\r\n\r\n",
+                                 status, body_length);
+    write_fully(client_fd, header, header_length);
+    write_fully(client_fd, body, body_length);
+
+    __atomic_fetch_add(&g_endpoint.scrapes_served, 1, __ATOMIC_RELAXED);
+}
+
+static void* metrics_endpoint_thread(void* arg) {
+    (void)arg;
+
+    while (__atomic_load_n(&g_endpoint.running, __ATOMIC_ACQUIRE)) {
+        struct pollfd fds[2];
+        int count = 0;
+        if (g_endpoint.tcp_fd >= 0) {
+            fds[count].fd = g_endpoint.tcp_fd;
+            fds[count].events = POLLIN;
+            count++;
+        }
+        if (g_endpoint.unix_fd >= 0) {
+            fds[count].fd = g_endpoint.unix_fd;
+            fds[count].events = POLLIN;
+            count++;
+        }
+
+        if (poll(fds, count, ENDPOINT_POLL_MS) <= 0) {
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (!(fds[i].revents & POLLIN)) {
+                continue;
+            }
+            int client_fd = accept(fds[i].fd, NULL, NULL);
+            if (client_fd >= 0) {
+                serve_client(client_fd);
+                close(client_fd);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static int open_tcp_listener(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons((unsigned short)port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int open_unix_listener(const char* path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+
+    unlink(path); // Stale socket from an earlier run
+    if (bind(fd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(fd, 8) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Open the configured listeners and start the server thread
+int start_metrics_endpoint(const MetricsEndpointConfig* config) {
+    if (!is_metrics_endpoint_configured(config) || g_endpoint.running) {
+        return -1;
+    }
+
+    g_endpoint.config = *config;
+    g_endpoint.tcp_fd = -1;
+    g_endpoint.unix_fd = -1;
+
+    if (config->tcp_port > 0) {
+        g_endpoint.tcp_fd = open_tcp_listener(config->tcp_port);
+        if (g_endpoint.tcp_fd < 0) {
+            LOG_ERROR("Metrics endpoint: cannot listen on 127.0.0.1:%d", config->tcp_port);
+        }
+    }
+    if (config->unix_path[0] != '\0') {
+        g_endpoint.unix_fd = open_unix_listener(config->unix_path);
+        if (g_endpoint.unix_fd < 0) {
+            LOG_ERROR("Metrics endpoint: cannot listen on %s", config->unix_path);
+        }
+    }
+
+    if (g_endpoint.tcp_fd < 0 && g_endpoint.unix_fd < 0) {
+        return -1;
+    }
+
+    g_endpoint.next_publish_ns = 0;
+    __atomic_store_n(&g_endpoint.running, true, __ATOMIC_RELEASE);
+    if (pthread_create(&g_endpoint.server_thread, NULL, metrics_endpoint_thread, NULL) != 0) {
+        __atomic_store_n(&g_endpoint.running, false, __ATOMIC_RELEASE);
+        stop_metrics_endpoint();
+        return -1;
+    }
+
+    LOG_INFO("Metrics endpoint serving /metrics (tcp port %d, socket %s)",
+             g_endpoint.tcp_fd >= 0 ? config->tcp_port : 0,
+             g_endpoint.unix_fd >= 0 ? config->unix_path : "none");
+    return 0;
+}
+
+// Stop the server thread and close the listeners
+void stop_metrics_endpoint() {
+    if (__atomic_load_n(&g_endpoint.running, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&g_endpoint.running, false, __ATOMIC_RELEASE);
+        pthread_join(g_endpoint.server_thread, NULL);
+        LOG_INFO("Metrics endpoint stopped after %lld scrapes", g_endpoint.scrapes_served);
+    }
+
+    if (g_endpoint.tcp_fd >= 0) {
+        close(g_endpoint.tcp_fd);
+        g_endpoint.tcp_fd = -1;
+    }
+    if (g_endpoint.unix_fd >= 0) {
+        close(g_endpoint.unix_fd);
+        unlink(g_endpoint.config.unix_path);
+        g_endpoint.unix_fd = -1;
+    }
+}
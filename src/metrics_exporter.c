@@ -0,0 +1,494 @@
+/*
+ * Metrics Exporter Implementation - SPSC Ring and Background Writer
+ *
+ * metrics_exporter_tick() runs on the metrics sampler thread right after
+ * the metrics are aggregated; it only copies numbers into the ring. The
+ * sampler sleeps until metrics_exporter_next_due_ns(), so rows follow the
+ * interval grid whatever the crossings are doing. The writer
+ * thread polls the ring like the log writer does, formats CSV rows or
+ * buffers binary rows into a columnar block, and flushes after each drain
+ * so a long soak run loses at most the last interval on a crash.
+ *
+ * Compilation: Include metrics_exporter.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/metrics_exporter.h"
+#include "../include/logger.h"
+#include "../include/sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#define EXPORT_WRITER_IDLE_US 50000
+#define EXPORT_BLOCK_FLUSH_NS (5 * NS_PER_SEC)
+#define EXPORT_FILE_BUFFER_SIZE 65536
+
+typedef enum {
+    COLUMN_INT32 = 0,
+    COLUMN_INT64 = 1,
+    COLUMN_FLOAT32 = 2
+} ColumnType;
+
+typedef struct {
+    const char* name;
+    ColumnType type;
+    size_t offset;
+} ExportColumn;
+
+#define EXPORT_COLUMN(name, type, field) { name, type, offsetof(MetricsExportRecord, field) }
+
+// Intersection-wide columns; the per-lane ones follow for each lane in use
+static const ExportColumn global_columns[] = {
+    EXPORT_COLUMN("timestamp_ms", COLUMN_INT64, timestamp_ms),
+    EXPORT_COLUMN("elapsed_ms", COLUMN_INT64, elapsed_ms),
+    EXPORT_COLUMN("total_vehicles", COLUMN_INT32, total_vehicles),
+    EXPORT_COLUMN("vehicles_per_minute", COLUMN_FLOAT32, vehicles_per_minute),
+    EXPORT_COLUMN("recent_vehicles_per_minute", COLUMN_FLOAT32, recent_vehicles_per_minute),
+    EXPORT_COLUMN("avg_wait_time", COLUMN_FLOAT32, avg_wait_time),
+    EXPORT_COLUMN("recent_p95_wait", COLUMN_FLOAT32, recent_p95_wait),
+    EXPORT_COLUMN("utilization", COLUMN_FLOAT32, utilization),
+    EXPORT_COLUMN("fairness_index", COLUMN_FLOAT32, fairness_index),
+    EXPORT_COLUMN("context_switches", COLUMN_INT32, context_switches),
+    EXPORT_COLUMN("deadlocks_prevented", COLUMN_INT32, deadlocks_prevented),
+    EXPORT_COLUMN("queue_overflows", COLUMN_INT32, queue_overflows),
+    EXPORT_COLUMN("emergency_response_time", COLUMN_FLOAT32, emergency_response_time),
+};
+
+#define EXPORT_GLOBAL_COLUMNS ((int)(sizeof(global_columns) / sizeof(global_columns[0])))
+#define EXPORT_LANE_COLUMNS 3
+#define EXPORT_MAX_COLUMNS (EXPORT_GLOBAL_COLUMNS + EXPORT_LANE_COLUMNS * MAX_LANES)
+#define EXPORT_COLUMN_NAME_SIZE 32
+
+typedef struct {
+    MetricsExportRecord records[EXPORT_RING_CAPACITY];
+    unsigned long head __attribute__((aligned(64)));  // Written by the simulation thread
+    unsigned long tail __attribute__((aligned(64)));  // Written by the writer thread
+} ExportRing;
+
+typedef struct {
+    MetricsExporterConfig config;
+    FILE* file;
+    char* file_buffer;
+    pthread_t writer_thread;
+    bool running;
+    long long start_ns;
+    long long next_export_ns;
+    long long records_exported;
+    long long records_dropped;
+    long long write_errors;
+    MetricsExportRecord block[EXPORT_BLOCK_ROWS];   // Writer thread only
+    int block_rows;
+    long long block_started_ns;
+    int num_lanes;
+    int num_columns;
+    ExportColumn columns[EXPORT_MAX_COLUMNS];
+    char column_names[EXPORT_MAX_COLUMNS][EXPORT_COLUMN_NAME_SIZE];
+} MetricsExporter;
+
+static ExportRing g_export_ring;
+static MetricsExporter g_exporter = {0};
+
+void init_metrics_exporter_config(MetricsExporterConfig* config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(MetricsExporterConfig));
+    config->format = EXPORT_FORMAT_CSV;
+    config->interval_ms = EXPORT_DEFAULT_INTERVAL_MS;
+}
+
+// Parse a format name (csv|binary)
+bool parse_export_format(const char* name, ExportFormat* format) {
+    if (!name || !format) {
+        return false;
+    }
+
+    if (strcmp(name, "csv") == 0) {
+        *format = EXPORT_FORMAT_CSV;
+        return true;
+    }
+    if (strcmp(name, "binary") == 0) {
+        *format = EXPORT_FORMAT_BINARY;
+        return true;
+    }
+    return false;
+}
+
+static void add_lane_column(int lane, const char* suffix, ColumnType type, size_t offset) {
+    int c = g_exporter.num_columns++;
+    snprintf(g_exporter.column_names[c], EXPORT_COLUMN_NAME_SIZE, "lane%d_%s", lane, suffix);
+    g_exporter.columns[c].name = g_exporter.column_names[c];
+    g_exporter.columns[c].type = type;
+    g_exporter.columns[c].offset = offset;
+}
+
+// Column table for this run: the global columns, then lane<i>_* for each lane
+static void build_export_columns(int num_lanes) {
+    g_exporter.num_lanes = num_lanes;
+    g_exporter.num_columns = EXPORT_GLOBAL_COLUMNS;
+    memcpy(g_exporter.columns, global_columns, sizeof(global_columns));
+
+    for (int i = 0; i < num_lanes; i++) {
+        add_lane_column(i, "vehicles", COLUMN_INT32,
+                        offsetof(MetricsExportRecord, lane_vehicles) + i * sizeof(int));
+    }
+    for (int i = 0; i < num_lanes; i++) {
+        add_lane_column(i, "avg_wait", COLUMN_FLOAT32,
+                        offsetof(MetricsExportRecord, lane_avg_wait) + i * sizeof(float));
+    }
+    for (int i = 0; i < num_lanes; i++) {
+        add_lane_column(i, "queue_length", COLUMN_INT32,
+                        offsetof(MetricsExportRecord, lane_queue_length) + i * sizeof(int));
+    }
+}
+
+static const char csv_header[] =
+    "timestamp_ms,elapsed_ms,scope,vehicles,vehicles_per_minute,"
+    "recent_vehicles_per_minute,avg_wait_time,recent_p95_wait,queue_length,"
+    "utilization,fairness_index,context_switches,deadlocks_prevented,"
+    "queue_overflows,emergency_response_time\n";
+
+static void write_csv_header(FILE* file) {
+    fputs(csv_header, file);
+}
+
+// One row for the intersection, then one per lane (lane rows leave global columns empty)
+static void write_csv_record(FILE* file, const MetricsExportRecord* record) {
+    int queued = 0;
+    for (int i = 0; i < g_exporter.num_lanes; i++) {
+        queued += record->lane_queue_length[i];
+    }
+
+    fprintf(file, "%lld,%lld,all,%d,%.2f,%.2f,%.3f,%.3f,%d,%.3f,%.3f,%d,%d,%d,%.3f\n",
+            record->timestamp_ms, record->elapsed_ms, record->total_vehicles,
+            record->vehicles_per_minute, record->recent_vehicles_per_minute,
+            record->avg_wait_time, record->recent_p95_wait, queued,
+            record->utilization, record->fairness_index, record->context_switches,
+            record->deadlocks_prevented, record->queue_overflows,
+            record->emergency_response_time);
+
+    for (int i = 0; i < g_exporter.num_lanes; i++) {
+        fprintf(file, "%lld,%lld,lane%d,%d,,,%.3f,,%d,,,,,,\n",
+                record->timestamp_ms, record->elapsed_ms, i, record->lane_vehicles[i],
+                record->lane_avg_wait[i], record->lane_queue_length[i]);
+    }
+}
+
+static void write_binary_header(FILE* file) {
+    uint32_t version = EXPORT_BINARY_VERSION;
+    uint32_t columns = (uint32_t)g_exporter.num_columns;
+
+    fwrite(EXPORT_BINARY_MAGIC, 1, 4, file);
+    fwrite(&version, sizeof(version), 1, file);
+    fwrite(&columns, sizeof(columns), 1, file);
+
+    for (int c = 0; c < g_exporter.num_columns; c++) {
+        uint8_t type = (uint8_t)g_exporter.columns[c].type;
+        uint8_t length = (uint8_t)strlen(g_exporter.columns[c].name);
+        fwrite(&type, 1, 1, file);
+        fwrite(&length, 1, 1, file);
+        fwrite(g_exporter.columns[c].name, 1, length, file);
+    }
+}
+
+// True if the file starts with exactly the CSV header this run writes
+static bool csv_header_matches(FILE* file) {
+    char line[sizeof(csv_header)];
+    return fgets(line, sizeof(line), file) && strcmp(line, csv_header) == 0;
+}
+
+// True if the file starts with exactly the binary header this run writes
+static bool binary_header_matches(FILE* file) {
+    char magic[4];
+    uint32_t version, columns;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, EXPORT_BINARY_MAGIC, 4) != 0 ||
+        fread(&version, sizeof(version), 1, file) != 1 || version != EXPORT_BINARY_VERSION ||
+        fread(&columns, sizeof(columns), 1, file) != 1 ||
+        columns != (uint32_t)g_exporter.num_columns) {
+        return false;
+    }
+
+    for (int c = 0; c < g_exporter.num_columns; c++) {
+        uint8_t type, length;
+        char name[UINT8_MAX];
+        if (fread(&type, 1, 1, file) != 1 || type != (uint8_t)g_exporter.columns[c].type ||
+            fread(&length, 1, 1, file) != 1 || length != strlen(g_exporter.columns[c].name) ||
+            fread(name, 1, length, file) != length ||
+            memcmp(name, g_exporter.columns[c].name, length) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static size_t column_width(ColumnType type) {
+    return type == COLUMN_INT64 ? sizeof(int64_t) : sizeof(int32_t);
+}
+
+// Write the buffered rows as one columnar block
+static void flush_binary_block(void) {
+    if (g_exporter.block_rows == 0) {
+        return;
+    }
+
+    uint32_t rows = (uint32_t)g_exporter.block_rows;
+    fwrite(&rows, sizeof(rows), 1, g_exporter.file);
+
+    for (int c = 0; c < g_exporter.num_columns; c++) {
+        size_t width = column_width(g_exporter.columns[c].type);
+        for (int r = 0; r < g_exporter.block_rows; r++) {
+            const char* row = (const char*)&g_exporter.block[r];
+            fwrite(row + g_exporter.columns[c].offset, width, 1, g_exporter.file);
+        }
+    }
+
+    g_exporter.block_rows = 0;
+}
+
+// Drain the ring once; returns the number of records consumed
+static int drain_export_ring(void) {
+    unsigned long tail = g_export_ring.tail;
+    unsigned long head = __atomic_load_n(&g_export_ring.head, __ATOMIC_ACQUIRE);
+    int consumed = 0;
+
+    while (tail != head) {
+        const MetricsExportRecord* record = &g_export_ring.records[tail & (EXPORT_RING_CAPACITY - 1)];
+
+        if (g_exporter.config.format == EXPORT_FORMAT_BINARY) {
+            if (g_exporter.block_rows == 0) {
+                g_exporter.block_started_ns = monotonic_now_ns();
+            }
+            g_exporter.block[g_exporter.block_rows++] = *record;
+            if (g_exporter.block_rows == EXPORT_BLOCK_ROWS) {
+                flush_binary_block();
+            }
+        } else {
+            write_csv_record(g_exporter.file, record);
+        }
+
+        tail++;
+        consumed++;
+    }
+    __atomic_store_n(&g_export_ring.tail, tail, __ATOMIC_RELEASE);
+
+    bool wrote = consumed > 0;
+
+    // Partial binary blocks are written once they are a few seconds old
+    if (g_exporter.block_rows > 0 &&
+        monotonic_now_ns() - g_exporter.block_started_ns >= EXPORT_BLOCK_FLUSH_NS) {
+        flush_binary_block();
+        wrote = true;
+    }
+
+    __atomic_fetch_add(&g_exporter.records_exported, consumed, __ATOMIC_RELAXED);
+    if (wrote) {
+        if (fflush(g_exporter.file) != 0 || ferror(g_exporter.file)) {
+            __atomic_fetch_add(&g_exporter.write_errors, 1, __ATOMIC_RELAXED);
+            clearerr(g_exporter.file);
+        }
+    }
+    return consumed;
+}
+
+static void* metrics_exporter_thread(void* arg) {
+    (void)arg;
+
+    while (__atomic_load_n(&g_exporter.running, __ATOMIC_ACQUIRE)) {
+        if (drain_export_ring() == 0) {
+            usleep(EXPORT_WRITER_IDLE_US);
+        }
+    }
+
+    // Final drain after the producer has stopped
+    drain_export_ring();
+    if (g_exporter.config.format == EXPORT_FORMAT_BINARY) {
+        flush_binary_block();
+    }
+    fflush(g_exporter.file);
+    return NULL;
+}
+
+// Open the export file (appending) and start the writer thread
+int start_metrics_exporter(const MetricsExporterConfig* config) {
+    if (!config || config->path[0] == '\0' || g_exporter.running) {
+        return -1;
+    }
+
+    g_exporter.config = *config;
+    if (g_exporter.config.interval_ms <= 0) {
+        g_exporter.config.interval_ms = EXPORT_DEFAULT_INTERVAL_MS;
+    }
+
+    bool binary = g_exporter.config.format == EXPORT_FORMAT_BINARY;
+    g_exporter.file = fopen(g_exporter.config.path, binary ? "a+b" : "a+");
+    if (!g_exporter.file) {
+        LOG_ERROR("Failed to open metrics export file %s", g_exporter.config.path);
+        return -1;
+    }
+
+    g_exporter.file_buffer = malloc(EXPORT_FILE_BUFFER_SIZE);
+    if (g_exporter.file_buffer) {
+        setvbuf(g_exporter.file, g_exporter.file_buffer, _IOFBF, EXPORT_FILE_BUFFER_SIZE);
+    }
+
+    build_export_columns(get_num_lanes());
+
+    // Header only for a new file; an appended run must share the existing
+    // one exactly (same format and columns), or its rows would be misread
+    fseek(g_exporter.file, 0, SEEK_END);
+    if (ftell(g_exporter.file) == 0) {
+        if (binary) {
+            write_binary_header(g_exporter.file);
+        } else {
+            write_csv_header(g_exporter.file);
+        }
+    } else {
+        rewind(g_exporter.file);
+        bool matches = binary ? binary_header_matches(g_exporter.file)
+                              : csv_header_matches(g_exporter.file);
+        if (!matches) {
+            printf("%s does not start with this run's %s export header; "
+                   "choose another export file\n", g_exporter.config.path,
+                   binary ? "binary" : "csv");
+            LOG_ERROR("Metrics export file %s has a different header", g_exporter.config.path);
+            fclose(g_exporter.file);
+            g_exporter.file = NULL;
+            free(g_exporter.file_buffer);
+            g_exporter.file_buffer = NULL;
+            return -1;
+        }
+        fseek(g_exporter.file, 0, SEEK_END);
+    }
+
+    g_export_ring.head = 0;
+    g_export_ring.tail = 0;
+    g_exporter.records_exported = 0;
+    g_exporter.records_dropped = 0;
+    g_exporter.write_errors = 0;
+    g_exporter.block_rows = 0;
+    g_exporter.start_ns = monotonic_now_ns();
+    g_exporter.next_export_ns = g_exporter.start_ns;
+
+    __atomic_store_n(&g_exporter.running, true, __ATOMIC_RELEASE);
+    if (pthread_create(&g_exporter.writer_thread, NULL, metrics_exporter_thread, NULL) != 0) {
+        __atomic_store_n(&g_exporter.running, false, __ATOMIC_RELEASE);
+        fclose(g_exporter.file);
+        g_exporter.file = NULL;
+        free(g_exporter.file_buffer);
+        g_exporter.file_buffer = NULL;
+        return -1;
+    }
+
+    LOG_INFO("Exporting metrics to %s every %d ms (%s)", g_exporter.config.path,
+             g_exporter.config.interval_ms,
+             g_exporter.config.format == EXPORT_FORMAT_BINARY ? "binary" : "csv");
+    return 0;
+}
+
+// Stop the writer thread after a final drain and close the file
+void stop_metrics_exporter() {
+    if (!__atomic_load_n(&g_exporter.running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    __atomic_store_n(&g_exporter.running, false, __ATOMIC_RELEASE);
+    pthread_join(g_exporter.writer_thread, NULL);
+
+    fclose(g_exporter.file);
+    g_exporter.file = NULL;
+    free(g_exporter.file_buffer);
+    g_exporter.file_buffer = NULL;
+
+    LOG_INFO("Metrics export finished: %lld records, %lld dropped",
+             g_exporter.records_exported, g_exporter.records_dropped);
+}
+
+bool is_metrics_exporter_running() {
+    return __atomic_load_n(&g_exporter.running, __ATOMIC_ACQUIRE);
+}
+
+// Monotonic time the next row is due, or 0 when the exporter is stopped.
+// Read and advanced only by the producer thread.
+long long metrics_exporter_next_due_ns() {
+    if (!__atomic_load_n(&g_exporter.running, __ATOMIC_ACQUIRE)) {
+        return 0;
+    }
+    return g_exporter.next_export_ns;
+}
+
+// Producer side: snapshot the metrics into the ring when the interval is due.
+// Called by the metrics sampler thread after update_time_based_metrics().
+void metrics_exporter_tick(PerformanceMetrics* metrics) {
+    if (!metrics || !__atomic_load_n(&g_exporter.running, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    long long now_ns = monotonic_now_ns();
+    if (now_ns < g_exporter.next_export_ns) {
+        return;
+    }
+
+    // Stay on the interval grid; skip missed slots rather than bursting
+    long long interval_ns = g_exporter.config.interval_ms * NS_PER_MS;
+    g_exporter.next_export_ns += interval_ns;
+    if (g_exporter.next_export_ns <= now_ns) {
+        g_exporter.next_export_ns = now_ns + interval_ns;
+    }
+
+    unsigned long head = g_export_ring.head;
+    unsigned long tail = __atomic_load_n(&g_export_ring.tail, __ATOMIC_ACQUIRE);
+    if (head - tail >= EXPORT_RING_CAPACITY) {
+        __atomic_fetch_add(&g_exporter.records_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    MetricsExportRecord* record = &g_export_ring.records[head & (EXPORT_RING_CAPACITY - 1)];
+    memset(record, 0, sizeof(MetricsExportRecord));
+
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    record->timestamp_ms = (long long)wall.tv_sec * 1000 + wall.tv_nsec / NS_PER_MS;
+    record->elapsed_ms = (now_ns - g_exporter.start_ns) / NS_PER_MS;
+    record->total_vehicles = metrics->total_vehicles_processed;
+    record->vehicles_per_minute = metrics->vehicles_per_minute;
+    record->avg_wait_time = metrics->avg_wait_time;
+    record->utilization = metrics->utilization;
+    record->fairness_index = metrics->fairness_index;
+    record->context_switches = metrics->context_switches;
+    record->deadlocks_prevented = metrics->deadlocks_prevented;
+    record->queue_overflows = metrics->queue_overflow_count;
+    record->emergency_response_time = metrics->emergency_response_time;
+
+    TimeSeriesSample recent;
+    if (timeseries_latest(&metrics->timeseries, TIMESERIES_1S, &recent)) {
+        record->recent_vehicles_per_minute = recent.vehicles_per_minute;
+        record->recent_p95_wait = recent.p95_wait;
+    }
+
+    for (int i = 0; i < metrics->num_lanes; i++) {
+        record->lane_vehicles[i] = metrics->lane_throughput[i];
+        record->lane_avg_wait[i] = metrics->lane_throughput[i] > 0 ?
+                                   metrics->lane_wait_times[i] / metrics->lane_throughput[i] : 0.0f;
+        record->lane_queue_length[i] = __atomic_load_n(&metrics->lane_queue_lengths[i],
+                                                       __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&g_export_ring.head, head + 1, __ATOMIC_RELEASE);
+}
+
+void get_metrics_exporter_stats(MetricsExporterStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    stats->records_exported = __atomic_load_n(&g_exporter.records_exported, __ATOMIC_RELAXED);
+    stats->records_dropped = __atomic_load_n(&g_exporter.records_dropped, __ATOMIC_RELAXED);
+    stats->write_errors = __atomic_load_n(&g_exporter.write_errors, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,193 @@
+/*
+ * Metrics Time Series Implementation - Seqlocked Sample Rings
+ *
+ * Each resolution keeps its own window accumulator, so the 10 s and 60 s
+ * series are exact deltas of the cumulative counters rather than averages
+ * of 1 s samples. A window closes on the first update at or after its end;
+ * if the writer stalled, the sample records the longer actual duration.
+ *
+ * Compilation: Include metrics_timeseries.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/metrics_timeseries.h"
+#include "../include/sim_clock.h"
+#include <string.h>
+
+static const int resolution_seconds[TIMESERIES_RESOLUTIONS] = { 1, 10, 60 };
+static const int resolution_slots[TIMESERIES_RESOLUTIONS] = {
+    TIMESERIES_1S_SLOTS, TIMESERIES_10S_SLOTS, TIMESERIES_60S_SLOTS
+};
+
+// Start a new window at the given cumulative totals
+static void open_window(TimeSeriesWindow* window, const TimeSeriesInput* input, long long now_ns) {
+    window->start_ns = now_ns;
+    window->vehicles_processed = input->vehicles_processed;
+    window->wait_time_ms = input->wait_time_ms;
+    window->context_switches = input->context_switches;
+    for (int i = 0; i < MAX_LANES; i++) {
+        window->queue_length_sum[i] = 0.0;
+    }
+    window->queue_samples = 0;
+
+    init_latency_histogram(&window->wait_snapshot_ms);
+    if (input->wait_time_histogram_ms) {
+        histogram_merge(&window->wait_snapshot_ms, input->wait_time_histogram_ms);
+    }
+}
+
+// Turn the finished window into a sample
+static void close_window(const TimeSeriesWindow* window, const TimeSeriesInput* input,
+                         long long now_ns, TimeSeriesSample* sample) {
+    memset(sample, 0, sizeof(TimeSeriesSample));
+    sample->start_ns = window->start_ns;
+    sample->duration_ms = (int)((now_ns - window->start_ns) / NS_PER_MS);
+
+    double seconds = (double)(now_ns - window->start_ns) / NS_PER_SEC;
+    long long vehicles = input->vehicles_processed - window->vehicles_processed;
+    if (seconds > 0.0) {
+        sample->vehicles_per_minute = (float)(vehicles * 60.0 / seconds);
+
+        double expected = input->expected_arrivals_per_sec * seconds;
+        if (expected > 0.0) {
+            sample->utilization = (float)(vehicles / expected);
+            if (sample->utilization > 1.0f) sample->utilization = 1.0f;
+        }
+    }
+
+    if (vehicles > 0) {
+        sample->mean_wait = (float)(input->wait_time_ms - window->wait_time_ms) / 1000.0f / vehicles;
+        if (input->wait_time_histogram_ms) {
+            sample->p95_wait = histogram_percentile_since(input->wait_time_histogram_ms,
+                                                          &window->wait_snapshot_ms, 95.0) / 1000.0f;
+        }
+    }
+
+    if (window->queue_samples > 0) {
+        for (int i = 0; i < MAX_LANES; i++) {
+            sample->queue_length[i] = (float)(window->queue_length_sum[i] / window->queue_samples);
+        }
+    }
+
+    sample->context_switches = (int)(input->context_switches - window->context_switches);
+}
+
+// Write one sample into the ring (single writer)
+static void publish_sample(MetricsTimeSeries* series, TimeSeriesRing* ring,
+                           const TimeSeriesSample* sample) {
+    long long published = ring->published;
+    TimeSeriesSlot* slot = &series->storage[ring->offset + (int)(published % ring->capacity)];
+
+    unsigned int sequence = slot->sequence;
+    __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    slot->sample = *sample;
+    __atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&ring->published, published + 1, __ATOMIC_RELEASE);
+}
+
+// Copy a slot, retrying while the writer is in the middle of it
+static void read_slot(const TimeSeriesSlot* slot, TimeSeriesSample* sample) {
+    unsigned int before, after;
+    do {
+        before = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        *sample = slot->sample;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&slot->sequence, __ATOMIC_RELAXED);
+    } while ((before & 1) || before != after);
+}
+
+void init_metrics_timeseries(MetricsTimeSeries* series) {
+    if (!series) {
+        return;
+    }
+
+    memset(series, 0, sizeof(MetricsTimeSeries));
+
+    int offset = 0;
+    for (int r = 0; r < TIMESERIES_RESOLUTIONS; r++) {
+        TimeSeriesRing* ring = &series->rings[r];
+        ring->resolution_seconds = resolution_seconds[r];
+        ring->capacity = resolution_slots[r];
+        ring->offset = offset;
+        ring->published = 0;
+        ring->window.start_ns = 0;
+        init_latency_histogram(&ring->window.wait_snapshot_ms);
+        offset += ring->capacity;
+    }
+}
+
+// Fold the current totals into every window, publishing those that ended
+void timeseries_update(MetricsTimeSeries* series, const TimeSeriesInput* input, long long now_ns) {
+    if (!series || !input) {
+        return;
+    }
+
+    for (int r = 0; r < TIMESERIES_RESOLUTIONS; r++) {
+        TimeSeriesRing* ring = &series->rings[r];
+        TimeSeriesWindow* window = &ring->window;
+
+        if (window->start_ns == 0) {
+            open_window(window, input, now_ns);
+        }
+
+        for (int i = 0; i < MAX_LANES; i++) {
+            window->queue_length_sum[i] += input->queue_length[i];
+        }
+        window->queue_samples++;
+
+        if (now_ns - window->start_ns >= ring->resolution_seconds * NS_PER_SEC) {
+            TimeSeriesSample sample;
+            close_window(window, input, now_ns, &sample);
+            publish_sample(series, ring, &sample);
+            open_window(window, input, now_ns);
+        }
+    }
+}
+
+// Copy up to max_samples samples, newest first; returns how many were copied
+int timeseries_read(const MetricsTimeSeries* series, TimeSeriesResolution resolution,
+                    TimeSeriesSample* samples, int max_samples) {
+    if (!series || !samples || resolution < 0 || resolution >= TIMESERIES_RESOLUTIONS) {
+        return 0;
+    }
+
+    const TimeSeriesRing* ring = &series->rings[resolution];
+    long long published = __atomic_load_n(&ring->published, __ATOMIC_ACQUIRE);
+    long long available = published < ring->capacity ? published : ring->capacity;
+
+    int copied = 0;
+    while (copied < max_samples && copied < available) {
+        long long index = (published - 1 - copied) % ring->capacity;
+        read_slot(&series->storage[ring->offset + (int)index], &samples[copied]);
+
+        // The writer lapped us: this slot now holds a newer sample
+        if (copied > 0 && samples[copied].start_ns >= samples[copied - 1].start_ns) {
+            break;
+        }
+        copied++;
+    }
+
+    return copied;
+}
+
+// Most recent completed sample at a resolution
+bool timeseries_latest(const MetricsTimeSeries* series, TimeSeriesResolution resolution,
+                       TimeSeriesSample* sample) {
+    return timeseries_read(series, resolution, sample, 1) == 1;
+}
+
+long long timeseries_published_count(const MetricsTimeSeries* series, TimeSeriesResolution resolution) {
+    if (!series || resolution < 0 || resolution >= TIMESERIES_RESOLUTIONS) {
+        return 0;
+    }
+    return __atomic_load_n(&series->rings[resolution].published, __ATOMIC_ACQUIRE);
+}
+
+int timeseries_resolution_seconds(TimeSeriesResolution resolution) {
+    if (resolution < 0 || resolution >= TIMESERIES_RESOLUTIONS) {
+        return 0;
+    }
+    return resolution_seconds[resolution];
+}
@@ -11,14 +11,20 @@
  * - Starvation prevention with aging threshold
  * - Variable time quanta per priority level (2-6 seconds)
  *
+ * The promotion, aging and demotion rules and their thresholds are
+ * select_lane_multilevel() in scheduling_policy.c, shared with the
+ * --compare replays; this file keeps the live level table.
+ *
  * Thread Safety: Uses pthread_mutex for priority tracking updates
  */
 
 #include "../include/scheduler.h"
 #include "../include/lane_process.h"
 #include "../include/trafficguru.h"
+#include "../include/checkpoint.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <pthread.h>
 
@@ -38,15 +44,10 @@ typedef struct {
     int time_in_current_level;
 } LanePriorityInfo;
 
-static LanePriorityInfo lane_priorities[4];
+static LanePriorityInfo lane_priorities[MAX_LANES];
 static bool priorities_initialized = false;
 static pthread_mutex_t priority_lock = PTHREAD_MUTEX_INITIALIZER;
 
-#define PROMOTION_THRESHOLD 10
-#define DEMOTION_THRESHOLD 5
-#define AGING_THRESHOLD 15
-static const int time_quanta[NUM_PRIORITY_LEVELS] = {2, 4, 6};
-
 // Initialize priority tracking
 void init_lane_priorities() {
     if (priorities_initialized) {
@@ -55,7 +56,7 @@ void init_lane_priorities() {
 
     time_t current_time = time(NULL);
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < MAX_LANES; i++) {
         lane_priorities[i].lane_id = i;
         lane_priorities[i].current_priority = PRIORITY_MEDIUM; // Start at medium
         lane_priorities[i].consecutive_runs = 0;
@@ -67,61 +68,9 @@ void init_lane_priorities() {
     priorities_initialized = true;
 }
 
-// Update lane priorities based on behavior
-void update_lane_priority(LaneProcess* lane) {
-        pthread_mutex_lock(&priority_lock);  // Protect priority updates
-    if (!lane || !priorities_initialized) {
-        pthread_mutex_unlock(&priority_lock);
-            return;}
-
-    LanePriorityInfo* priority_info = &lane_priorities[lane->lane_id];
-    time_t current_time = time(NULL);
-
-    // Update time in current priority level
-    priority_info->time_in_current_level = current_time - priority_info->last_promotion;
-
-    // Check for promotion (lane has waited too long)
-    if (lane->waiting_time > PROMOTION_THRESHOLD &&
-        priority_info->current_priority > PRIORITY_HIGH) {
-
-        priority_info->current_priority--;
-        priority_info->last_promotion = current_time;
-        priority_info->consecutive_runs = 0;
-        lane->priority = priority_info->current_priority + 1; // Convert to 1-based
-    }
-
-    // Check for aging (prevent starvation)
-    if (priority_info->time_in_current_level > AGING_THRESHOLD &&
-        priority_info->current_priority > PRIORITY_HIGH) {
-
-        priority_info->current_priority = PRIORITY_HIGH;
-        priority_info->last_promotion = current_time;
-        priority_info->consecutive_runs = 0;
-        lane->priority = 1;
-    }
-
-    // Update consecutive runs counter
-    if (lane->state == RUNNING) {
-        priority_info->consecutive_runs++;
-
-        // Check for demotion (lane has run too long)
-        if (priority_info->consecutive_runs > DEMOTION_THRESHOLD &&
-            priority_info->current_priority < PRIORITY_LOW) {
-
-            priority_info->current_priority++;
-            priority_info->last_demotion = current_time;
-            priority_info->consecutive_runs = 0;
-            lane->priority = priority_info->current_priority + 1;
-        }
-    } else {
-        // Reset consecutive runs when lane is not running
-        priority_info->consecutive_runs = 0;
-    }
-    pthread_mutex_unlock(&priority_lock);  // Release lock before returning
-}
-
-// Multilevel Feedback Queue scheduling algorithm
-int schedule_next_lane_multilevel(Scheduler* scheduler, LaneProcess lanes[4]) {
+// Multilevel Feedback Queue scheduling algorithm: the levels live in
+// lane_priorities, the rule is select_lane_multilevel()
+int schedule_next_lane_multilevel(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -131,55 +80,54 @@ int schedule_next_lane_multilevel(Scheduler* scheduler, LaneProcess lanes[4]) {
         init_lane_priorities();
     }
 
-    // Update all lane priorities
-    for (int i = 0; i < 4; i++) {
-        update_lane_priority(&lanes[i]);
+    LanePolicyView views[MAX_LANES];
+    fill_lane_policy_views(lanes, num_lanes, views);
+
+    pthread_mutex_lock(&priority_lock);
+    time_t current_time = time(NULL);
+    MultilevelLaneState levels[MAX_LANES];
+    for (int i = 0; i < num_lanes; i++) {
+        levels[i].level = lane_priorities[i].current_priority;
+        levels[i].consecutive_runs = lane_priorities[i].consecutive_runs;
+        levels[i].level_since = lane_priorities[i].last_promotion;
     }
 
-    // Check each priority level from highest to lowest
-    for (PriorityLevel level = PRIORITY_HIGH; level < NUM_PRIORITY_LEVELS; level++) {
-        int best_lane_in_level = -1;
-        int max_wait_time = -1;
-
-        // Find best lane in this priority level
-        for (int i = 0; i < 4; i++) {
-            if (is_lane_ready(&lanes[i]) &&
-                !is_lane_blocked(&lanes[i]) &&
-                lane_priorities[i].current_priority == level) {
-
-                // Within same priority level, use Round Robin based on waiting time
-                if (lanes[i].waiting_time > max_wait_time) {
-                    max_wait_time = lanes[i].waiting_time;
-                    best_lane_in_level = i;
-                }
-            }
-        }
+    int quantum = scheduler->time_quantum;
+    int next_lane = select_lane_multilevel(views, num_lanes, current_time, levels, &quantum);
 
-        // If we found a lane in this level, return it
-        if (best_lane_in_level != -1) {
-            // Set appropriate time quantum for this priority level
-            scheduler->time_quantum = time_quanta[level];
-            return best_lane_in_level;
+    for (int i = 0; i < num_lanes; i++) {
+        LanePriorityInfo* priority_info = &lane_priorities[i];
+        if (levels[i].level > (int)priority_info->current_priority) {
+            priority_info->last_demotion = current_time;
         }
+        if (levels[i].level != (int)priority_info->current_priority) {
+            lanes[i].priority = levels[i].level + 1; // Convert to 1-based
+        }
+        priority_info->current_priority = (PriorityLevel)levels[i].level;
+        priority_info->consecutive_runs = levels[i].consecutive_runs;
+        priority_info->last_promotion = (time_t)levels[i].level_since;
+        priority_info->time_in_current_level = (int)(current_time - priority_info->last_promotion);
     }
+    pthread_mutex_unlock(&priority_lock);
 
-    // No ready lanes found
-    return -1;
+    if (next_lane != -1) {
+        scheduler->time_quantum = quantum;
+    }
+    return next_lane;
 }
 
 // Get time quantum for a specific lane
 int get_time_quantum_for_lane(int lane_id) {
-    if (!priorities_initialized || lane_id < 0 || lane_id >= 4) {
+    if (!priorities_initialized || lane_id < 0 || lane_id >= MAX_LANES) {
         return DEFAULT_TIME_QUANTUM;
     }
 
-    PriorityLevel priority = lane_priorities[lane_id].current_priority;
-    return time_quanta[priority];
+    return multilevel_time_quantum(lane_priorities[lane_id].current_priority);
 }
 
 // Promote lane to higher priority
 void promote_lane(int lane_id) {
-    if (!priorities_initialized || lane_id < 0 || lane_id >= 4) {
+    if (!priorities_initialized || lane_id < 0 || lane_id >= MAX_LANES) {
         return;
     }
 
@@ -194,7 +142,7 @@ void promote_lane(int lane_id) {
 
 // Demote lane to lower priority
 void demote_lane(int lane_id) {
-    if (!priorities_initialized || lane_id < 0 || lane_id >= 4) {
+    if (!priorities_initialized || lane_id < 0 || lane_id >= MAX_LANES) {
         return;
     }
 
@@ -209,7 +157,7 @@ void demote_lane(int lane_id) {
 
 // Get current priority of a lane
 PriorityLevel get_lane_priority(int lane_id) {
-    if (!priorities_initialized || lane_id < 0 || lane_id >= 4) {
+    if (!priorities_initialized || lane_id < 0 || lane_id >= MAX_LANES) {
         return PRIORITY_MEDIUM;
     }
 
@@ -222,6 +170,36 @@ void reset_lane_priorities() {
     init_lane_priorities();
 }
 
+// Checkpoint the priority table as it stands
+void save_multilevel_checkpoint(CheckpointMultilevel* state) {
+    pthread_mutex_lock(&priority_lock);
+    memset(state, 0, sizeof(CheckpointMultilevel));
+    state->initialized = priorities_initialized;
+    for (int i = 0; i < MAX_LANES; i++) {
+        state->lanes[i].level = lane_priorities[i].current_priority;
+        state->lanes[i].consecutive_runs = lane_priorities[i].consecutive_runs;
+        state->lanes[i].last_promotion = lane_priorities[i].last_promotion;
+        state->lanes[i].last_demotion = lane_priorities[i].last_demotion;
+        state->lanes[i].time_in_current_level = lane_priorities[i].time_in_current_level;
+    }
+    pthread_mutex_unlock(&priority_lock);
+}
+
+// Put a checkpointed priority table back, its times moved on by 'wall_shift'
+void restore_multilevel_checkpoint(const CheckpointMultilevel* state, time_t wall_shift) {
+    pthread_mutex_lock(&priority_lock);
+    for (int i = 0; i < MAX_LANES; i++) {
+        lane_priorities[i].lane_id = i;
+        lane_priorities[i].current_priority = (PriorityLevel)state->lanes[i].level;
+        lane_priorities[i].consecutive_runs = state->lanes[i].consecutive_runs;
+        lane_priorities[i].last_promotion = (time_t)state->lanes[i].last_promotion + wall_shift;
+        lane_priorities[i].last_demotion = (time_t)state->lanes[i].last_demotion + wall_shift;
+        lane_priorities[i].time_in_current_level = state->lanes[i].time_in_current_level;
+    }
+    priorities_initialized = state->initialized;
+    pthread_mutex_unlock(&priority_lock);
+}
+
 // Print priority information for debugging
 void print_lane_priorities() {
     if (!priorities_initialized) {
@@ -232,7 +210,7 @@ void print_lane_priorities() {
     printf("\n=== LANE PRIORITIES ===\n");
     const char* priority_names[] = {"HIGH", "MEDIUM", "LOW"};
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < get_num_lanes(); i++) {
         LanePriorityInfo* info = &lane_priorities[i];
         printf("Lane %d: Priority=%s, Consecutive Runs=%d, Time in Level=%ds\n",
                i, priority_names[info->current_priority],
@@ -242,7 +220,7 @@ void print_lane_priorities() {
 }
 
 // Enhanced multilevel feedback with dynamic thresholds
-int schedule_next_lane_adaptive_multilevel(Scheduler* scheduler, LaneProcess lanes[4]) {
+int schedule_next_lane_adaptive_multilevel(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -256,7 +234,7 @@ int schedule_next_lane_adaptive_multilevel(Scheduler* scheduler, LaneProcess lan
     int total_queue_length = 0;
     int ready_lanes = 0;
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         total_queue_length += get_lane_queue_length(&lanes[i]);
         if (is_lane_ready(&lanes[i])) {
             ready_lanes++;
@@ -265,11 +243,11 @@ int schedule_next_lane_adaptive_multilevel(Scheduler* scheduler, LaneProcess lan
 
     // Adjust thresholds based on system load
     float system_load = ready_lanes > 0 ? (float)total_queue_length / ready_lanes : 0;
-    int adaptive_promotion_threshold = system_load > 5 ? PROMOTION_THRESHOLD / 2 : PROMOTION_THRESHOLD;
-    int adaptive_demotion_threshold = system_load < 2 ? DEMOTION_THRESHOLD * 2 : DEMOTION_THRESHOLD;
+    int adaptive_promotion_threshold = system_load > 5 ? MLFQ_PROMOTION_SECONDS / 2 : MLFQ_PROMOTION_SECONDS;
+    int adaptive_demotion_threshold = system_load < 2 ? MLFQ_DEMOTION_RUNS * 2 : MLFQ_DEMOTION_RUNS;
 
     // Update priorities with adaptive thresholds
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (lanes[i].waiting_time > adaptive_promotion_threshold &&
             lane_priorities[i].current_priority > PRIORITY_HIGH) {
             promote_lane(i);
@@ -282,5 +260,5 @@ int schedule_next_lane_adaptive_multilevel(Scheduler* scheduler, LaneProcess lan
     }
 
     // Use standard multilevel scheduling with updated priorities
-    return schedule_next_lane_multilevel(scheduler, lanes);
+    return schedule_next_lane_multilevel(scheduler, lanes, num_lanes);
 }
@@ -0,0 +1,303 @@
+/*
+ * Mutex Benchmark Implementation - Strategy Contention Harness
+ *
+ * Uses the global intersection and Banker's state directly, resetting both
+ * (together with the mutex statistics) before every case. Worker threads
+ * stop at the deadline; the coordinator keeps signalling the lane
+ * condition variables until every worker has left acquire_intersection().
+ *
+ * Compilation: Include mutex_benchmark.h, traffic_mutex.h, sim_clock.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/mutex_benchmark.h"
+#include "../include/traffic_mutex.h"
+#include "../include/lane_process.h"
+#include "../include/sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#define BENCH_LANE_QUEUE_CAPACITY 4
+
+typedef struct {
+    LaneProcess lane;
+    unsigned int seed;
+    const MutexBenchmarkConfig* config;
+    long long deadline_ns;
+} BenchmarkWorker;
+
+static int g_workers_running = 0;
+static int g_workers_inside = 0;
+static int g_peak_inside = 0;
+
+// Count a worker into the intersection and keep the peak
+static void enter_intersection_count() {
+    int inside = __atomic_add_fetch(&g_workers_inside, 1, __ATOMIC_RELAXED);
+    int peak = __atomic_load_n(&g_peak_inside, __ATOMIC_RELAXED);
+    while (inside > peak &&
+           !__atomic_compare_exchange_n(&g_peak_inside, &peak, inside, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+void init_mutex_benchmark_config(MutexBenchmarkConfig* config) {
+    if (!config) {
+        return;
+    }
+
+    static const int default_counts[] = {1, 2, 4, 8, 16};
+
+    config->num_thread_counts = sizeof(default_counts) / sizeof(default_counts[0]);
+    for (int i = 0; i < config->num_thread_counts; i++) {
+        config->thread_counts[i] = default_counts[i];
+    }
+    config->duration_seconds = BENCH_DEFAULT_SECONDS;
+    config->arrival_rate = BENCH_DEFAULT_ARRIVAL_RATE;
+    config->hold_time_us = BENCH_DEFAULT_HOLD_US;
+}
+
+// Parse a comma-separated list of thread counts, e.g. "1,2,4,8"
+bool parse_benchmark_thread_counts(const char* list, MutexBenchmarkConfig* config) {
+    if (!list || !config) {
+        return false;
+    }
+
+    int count = 0;
+    const char* cursor = list;
+
+    while (*cursor && count < BENCH_MAX_THREAD_COUNTS) {
+        char* end = NULL;
+        long threads = strtol(cursor, &end, 10);
+        if (end == cursor || threads <= 0 || threads > BENCH_MAX_THREADS) {
+            return false;
+        }
+
+        config->thread_counts[count++] = (int)threads;
+
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            return false;
+        }
+        cursor = end;
+    }
+
+    if (count == 0 || *cursor != '\0') {
+        return false;
+    }
+
+    config->num_thread_counts = count;
+    return true;
+}
+
+// Exponential inter-arrival time for a Poisson arrival process
+static long long next_arrival_gap_ns(BenchmarkWorker* worker) {
+    if (worker->config->arrival_rate <= 0) {
+        return 0;
+    }
+
+    double uniform = (rand_r(&worker->seed) + 1.0) / ((double)RAND_MAX + 2.0);
+    double gap_seconds = -log(uniform) / worker->config->arrival_rate;
+    return (long long)(gap_seconds * NS_PER_SEC);
+}
+
+static void* benchmark_worker_loop(void* arg) {
+    BenchmarkWorker* worker = (BenchmarkWorker*)arg;
+    long long hold_ns = (long long)worker->config->hold_time_us * NS_PER_US;
+
+    while (monotonic_now_ns() < worker->deadline_ns) {
+        sleep_ns(next_arrival_gap_ns(worker));
+
+        // The arriving vehicle's movement decides which quadrants are requested
+        VehicleRecord vehicle = {0};
+        vehicle.arrival_ns = monotonic_now_ns();
+        vehicle.movement = fit_movement_to_lane(worker->lane.lane_id,
+                                                pick_vehicle_movement(rand_r(&worker->seed) % 100));
+        vehicle.vehicle_class = VEHICLE_CAR;
+        enqueue_vehicle(worker->lane.queue, &vehicle);
+
+        if (acquire_intersection_with_bankers(&worker->lane)) {
+            enter_intersection_count();
+            sleep_ns(hold_ns);
+            __atomic_sub_fetch(&g_workers_inside, 1, __ATOMIC_RELAXED);
+            release_intersection_with_bankers(&worker->lane);
+        }
+
+        dequeue_vehicle(worker->lane.queue, &vehicle);
+    }
+
+    __atomic_fetch_sub(&g_workers_running, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Run one (strategy, thread count) case and collect its statistics
+bool run_mutex_benchmark_case(const MutexBenchmarkConfig* config, int strategy,
+                              int threads, MutexBenchmarkResult* result) {
+    if (!config || !result || threads <= 0 || threads > get_num_lanes()) {
+        return false;
+    }
+
+    BenchmarkWorker* workers = calloc(threads, sizeof(BenchmarkWorker));
+    pthread_t* thread_ids = calloc(threads, sizeof(pthread_t));
+    if (!workers || !thread_ids) {
+        free(workers);
+        free(thread_ids);
+        return false;
+    }
+
+    init_traffic_mutex_system();
+    reset_traffic_mutex_system();
+    set_allocation_strategy(strategy);
+
+    long long start_ns = monotonic_now_ns();
+    long long deadline_ns = start_ns + (long long)config->duration_seconds * NS_PER_SEC;
+    int started = 0;
+
+    __atomic_store_n(&g_workers_running, threads, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_workers_inside, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_peak_inside, 0, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < threads; i++) {
+        init_lane_process(&workers[i].lane, i, BENCH_LANE_QUEUE_CAPACITY);
+        workers[i].seed = (unsigned int)(start_ns ^ (i * 2654435761u));
+        workers[i].config = config;
+        workers[i].deadline_ns = deadline_ns;
+
+        if (pthread_create(&thread_ids[i], NULL, benchmark_worker_loop, &workers[i]) != 0) {
+            __atomic_fetch_sub(&g_workers_running, threads - i, __ATOMIC_RELAXED);
+            destroy_lane_process(&workers[i].lane);
+            break;
+        }
+        started++;
+    }
+
+    // Wake workers still parked in acquire_intersection() once time is up
+    while (__atomic_load_n(&g_workers_running, __ATOMIC_ACQUIRE) > 0) {
+        if (monotonic_now_ns() >= deadline_ns) {
+            signal_all_lanes();
+        }
+        sleep_ns(NS_PER_MS);
+    }
+
+    for (int i = 0; i < started; i++) {
+        pthread_join(thread_ids[i], NULL);
+        destroy_lane_process(&workers[i].lane);
+    }
+
+    long long elapsed_ns = monotonic_now_ns() - start_ns;
+
+    MutexPerformanceStats stats;
+    get_mutex_performance_stats(&stats);
+    const LatencyHistogram* latency = get_mutex_acquire_latency_histogram();
+
+    memset(result, 0, sizeof(*result));
+    result->strategy = strategy;
+    result->threads = started;
+    result->attempts = stats.total_acquisitions;
+    result->acquisitions = stats.successful_acquisitions;
+    result->denials = stats.failed_acquisitions;
+    result->deadlock_preventions = get_deadlock_prevention_count(get_global_bankers_state());
+    result->peak_holders = __atomic_load_n(&g_peak_inside, __ATOMIC_RELAXED);
+    result->elapsed_seconds = (double)elapsed_ns / NS_PER_SEC;
+    result->acquisitions_per_second =
+        result->elapsed_seconds > 0 ? result->acquisitions / result->elapsed_seconds : 0.0;
+    result->p50_latency_us = histogram_percentile(latency, 50.0) / (double)NS_PER_US;
+    result->p99_latency_us = histogram_percentile(latency, 99.0) / (double)NS_PER_US;
+    result->max_latency_us = histogram_max(latency) / (double)NS_PER_US;
+
+    free(workers);
+    free(thread_ids);
+
+    // Leave the shared state clean for whoever runs next
+    reset_traffic_mutex_system();
+    return started == threads;
+}
+
+void print_mutex_benchmark_header() {
+    printf("%-9s %7s %12s %12s %10s %10s %10s %10s %9s %5s\n",
+           "Strategy", "Lanes", "Attempts", "Acq/s",
+           "p50(us)", "p99(us)", "max(us)", "Denials", "DL-Prev", "Peak");
+    printf("%-9s %7s %12s %12s %10s %10s %10s %10s %9s %5s\n",
+           "--------", "-------", "--------", "-----",
+           "-------", "-------", "-------", "-------", "-------", "----");
+}
+
+void print_mutex_benchmark_result(const MutexBenchmarkResult* result) {
+    if (!result) {
+        return;
+    }
+
+    printf("%-9s %7d %12lld %12.1f %10.1f %10.1f %10.1f %10lld %9d %5d\n",
+           get_allocation_strategy_name(result->strategy),
+           result->threads,
+           result->attempts,
+           result->acquisitions_per_second,
+           result->p50_latency_us,
+           result->p99_latency_us,
+           result->max_latency_us,
+           result->denials,
+           result->deadlock_preventions,
+           result->peak_holders);
+}
+
+// Run every strategy at every configured thread count and print a table
+int run_mutex_benchmark(const MutexBenchmarkConfig* config) {
+    if (!config) {
+        return -1;
+    }
+
+    printf("=== MUTEX CONTENTION BENCHMARK ===\n");
+    printf("Duration per case: %d s, arrival rate: ", config->duration_seconds);
+    if (config->arrival_rate > 0) {
+        printf("%d/s per thread", config->arrival_rate);
+    } else {
+        printf("back-to-back");
+    }
+    printf(", hold time: %d us\n", config->hold_time_us);
+
+    // One thread per lane: a second thread on a lane would share its
+    // Banker's row and condition variable and contend with itself
+    int num_lanes = get_num_lanes();
+    int counts[BENCH_MAX_THREAD_COUNTS];
+    int num_counts = 0;
+    bool capped = false;
+    for (int i = 0; i < config->num_thread_counts; i++) {
+        int threads = config->thread_counts[i];
+        if (threads > num_lanes) {
+            threads = num_lanes;
+            capped = true;
+        }
+        bool seen = false;
+        for (int c = 0; c < num_counts; c++) {
+            seen = seen || counts[c] == threads;
+        }
+        if (!seen) {
+            counts[num_counts++] = threads;
+        }
+    }
+    printf("One thread per lane of %s", get_intersection_geometry()->name);
+    if (capped) {
+        printf("; thread counts capped at its %d lanes", num_lanes);
+    }
+    printf("\n\n");
+
+    print_mutex_benchmark_header();
+
+    int failures = 0;
+    for (int strategy = 0; strategy < BENCH_NUM_STRATEGIES; strategy++) {
+        for (int i = 0; i < num_counts; i++) {
+            MutexBenchmarkResult result;
+            if (!run_mutex_benchmark_case(config, strategy, counts[i], &result)) {
+                failures++;
+            }
+            print_mutex_benchmark_result(&result);
+            fflush(stdout);
+        }
+    }
+
+    printf("==================================\n");
+    return failures == 0 ? 0 : -1;
+}
@@ -9,22 +9,37 @@
 
 #define _XOPEN_SOURCE 600
 #include "../include/performance_metrics.h"
+#include "../include/emergency_system.h"
+#include "../include/logger.h"
+#include "../include/sim_clock.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <math.h>
 
+#define METRICS_EXPECTED_ARRIVALS_PER_SEC 0.5f  // Average of the 1-3 second arrival gap
+
 void init_performance_metrics(PerformanceMetrics* metrics) {
     if (!metrics) return;
 
     memset(metrics, 0, sizeof(PerformanceMetrics));
     metrics->measurement_start_time = time(NULL);
     metrics->last_update_time = metrics->measurement_start_time;
+    metrics->num_lanes = get_num_lanes();
     metrics->fairness_index = 1.0f; // Perfect fairness initially
+    init_latency_histogram(&metrics->preemption_latency_ns);
+    init_latency_histogram(&metrics->emergency_arrival_delay_ns);
+    for (int t = 0; t < METRICS_EMERGENCY_TYPES; t++) {
+        init_latency_histogram(&metrics->emergency_by_type[t].detection_to_green_ns);
+        init_latency_histogram(&metrics->emergency_by_type[t].green_to_clear_ns);
+        init_latency_histogram(&metrics->emergency_by_type[t].end_to_end_ns);
+    }
+    init_latency_histogram(&metrics->wait_time_ms);
+    init_metrics_timeseries(&metrics->timeseries);
 
     // Initialize lane-specific metrics
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < metrics->num_lanes; i++) {
         metrics->lane_wait_times[i] = 0.0f;
         metrics->lane_throughput[i] = 0;
     }
@@ -52,13 +67,31 @@ void reset_performance_metrics(PerformanceMetrics* metrics) {
     metrics->emergency_response_time = 0.0f;
     metrics->total_vehicles_processed = 0;
     metrics->queue_overflow_count = 0;
+    metrics->spillback_vehicles = 0;
+    metrics->spillback_delay = 0.0f;
     metrics->total_simulation_time = 0;
 
     // Reset lane-specific metrics
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < metrics->num_lanes; i++) {
         metrics->lane_wait_times[i] = 0.0f;
         metrics->lane_throughput[i] = 0;
+        __atomic_store_n(&metrics->lane_counters[i].vehicles_processed, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&metrics->lane_counters[i].wait_time_ms, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&metrics->lane_counters[i].spillback_vehicles, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&metrics->lane_counters[i].spillback_delay_ms, 0, __ATOMIC_RELAXED);
     }
+    __atomic_store_n(&metrics->scheduler_counters.context_switches, 0, __ATOMIC_RELAXED);
+    reset_latency_histogram(&metrics->preemption_latency_ns);
+    reset_latency_histogram(&metrics->emergency_arrival_delay_ns);
+    for (int t = 0; t < METRICS_EMERGENCY_TYPES; t++) {
+        reset_latency_histogram(&metrics->emergency_by_type[t].detection_to_green_ns);
+        reset_latency_histogram(&metrics->emergency_by_type[t].green_to_clear_ns);
+        reset_latency_histogram(&metrics->emergency_by_type[t].end_to_end_ns);
+    }
+    reset_latency_histogram(&metrics->wait_time_ms);
+    init_metrics_timeseries(&metrics->timeseries);
+    __atomic_store_n(&metrics->emergency_preclears, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&metrics->emergency_preemptions, 0, __ATOMIC_RELAXED);
 
     metrics->measurement_start_time = current_time;
     metrics->last_update_time = current_time;
@@ -75,7 +108,7 @@ void calculate_throughput_metrics(PerformanceMetrics* metrics, time_t current_ti
 }
 
 // Calculate wait time metrics
-void calculate_wait_time_metrics(PerformanceMetrics* metrics, float lane_wait_times[4]) {
+void calculate_wait_time_metrics(PerformanceMetrics* metrics, float lane_wait_times[MAX_LANES]) {
     if (!metrics || !lane_wait_times) return;
 
     float total_wait = 0.0f;
@@ -83,7 +116,7 @@ void calculate_wait_time_metrics(PerformanceMetrics* metrics, float lane_wait_ti
 
     // --- FIX: Calculate average wait time across all lanes ---
     // Use both accumulated wait times and per-lane throughput for proper averaging
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < metrics->num_lanes; i++) {
         metrics->lane_wait_times[i] = lane_wait_times[i];
         if (metrics->lane_throughput[i] > 0) {
             // Average = total_wait_time_for_lane / vehicles_processed_in_lane
@@ -106,13 +139,13 @@ void calculate_utilization_metrics(PerformanceMetrics* metrics, time_t active_ti
 }
 
 // Calculate fairness index metrics
-void calculate_fairness_index_metrics(PerformanceMetrics* metrics, float wait_times[4]) {
+void calculate_fairness_index_metrics(PerformanceMetrics* metrics, float wait_times[MAX_LANES]) {
     if (!metrics || !wait_times) return;
 
     float sum_wait = 0.0f, sum_wait_sq = 0.0f;
     int active_lanes = 0;
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < metrics->num_lanes; i++) {
         if (wait_times[i] > 0) {
             sum_wait += wait_times[i];
             sum_wait_sq += wait_times[i] * wait_times[i];
@@ -129,29 +162,87 @@ void calculate_fairness_index_metrics(PerformanceMetrics* metrics, float wait_ti
     if (metrics->fairness_index > 1.0f) metrics->fairness_index = 1.0f;
 }
 
-// Update vehicle count for a lane
+// Record one served vehicle and its wait time (lock-free, safe from any thread)
+void record_vehicle_served(PerformanceMetrics* metrics, int lane_id, float wait_time) {
+    if (!metrics || lane_id < 0 || lane_id >= MAX_LANES) return;
+
+    LaneCounterShard* shard = &metrics->lane_counters[lane_id];
+    __atomic_fetch_add(&shard->vehicles_processed, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&shard->wait_time_ms, (long long)(wait_time * 1000.0f), __ATOMIC_RELAXED);
+    histogram_record(&metrics->wait_time_ms, (long long)(wait_time * 1000.0f));
+}
+
+// Record the time a served vehicle spent spilled back upstream (lock-free)
+void record_spillback_delay(PerformanceMetrics* metrics, int lane_id, long long delay_ns) {
+    if (!metrics || lane_id < 0 || lane_id >= MAX_LANES || delay_ns <= 0) return;
+
+    LaneCounterShard* shard = &metrics->lane_counters[lane_id];
+    __atomic_fetch_add(&shard->spillback_vehicles, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&shard->spillback_delay_ms, delay_ns / NS_PER_MS, __ATOMIC_RELAXED);
+}
+
+// Sample a lane's current queue length for the time series
+void record_lane_queue_length(PerformanceMetrics* metrics, int lane_id, int queue_length) {
+    if (!metrics || lane_id < 0 || lane_id >= MAX_LANES) return;
+
+    __atomic_store_n(&metrics->lane_queue_lengths[lane_id], queue_length, __ATOMIC_RELAXED);
+}
+
+// Update vehicle count for a lane (lock-free)
 void update_vehicle_count(PerformanceMetrics* metrics, int lane_id, int vehicle_count) {
-    if (!metrics || lane_id < 0 || lane_id >= 4) return;
+    if (!metrics || lane_id < 0 || lane_id >= MAX_LANES) return;
 
-    metrics->total_vehicles_processed += vehicle_count;
-    metrics->lane_throughput[lane_id] += vehicle_count;
-    metrics->last_update_time = time(NULL);
+    __atomic_fetch_add(&metrics->lane_counters[lane_id].vehicles_processed,
+                       (long long)vehicle_count, __ATOMIC_RELAXED);
 }
 
-// Update wait time for a lane
+// Update accumulated wait time for a lane (lock-free)
 void update_wait_time(PerformanceMetrics* metrics, int lane_id, float wait_time) {
-    if (!metrics || lane_id < 0 || lane_id >= 4) return;
+    if (!metrics || lane_id < 0 || lane_id >= MAX_LANES) return;
 
-    metrics->lane_wait_times[lane_id] = wait_time;
-    metrics->last_update_time = time(NULL);
+    __atomic_store_n(&metrics->lane_counters[lane_id].wait_time_ms,
+                     (long long)(wait_time * 1000.0f), __ATOMIC_RELAXED);
 }
 
-// Update context switch count
+// Update context switch count (lock-free)
 void update_context_switch_count(PerformanceMetrics* metrics) {
     if (!metrics) return;
 
-    metrics->context_switches++;
-    metrics->last_update_time = time(NULL);
+    __atomic_fetch_add(&metrics->scheduler_counters.context_switches, 1, __ATOMIC_RELAXED);
+}
+
+// Fold the lock-free shards into the aggregate counters.
+// Readers of the aggregate fields see values as of the last call.
+void aggregate_metric_shards(PerformanceMetrics* metrics) {
+    if (!metrics) return;
+
+    long long total_vehicles = 0;
+    long long spillback_vehicles = 0;
+    long long spillback_delay_ms = 0;
+    for (int i = 0; i < metrics->num_lanes; i++) {
+        spillback_vehicles += __atomic_load_n(&metrics->lane_counters[i].spillback_vehicles,
+                                              __ATOMIC_RELAXED);
+        spillback_delay_ms += __atomic_load_n(&metrics->lane_counters[i].spillback_delay_ms,
+                                              __ATOMIC_RELAXED);
+        long long served = __atomic_load_n(&metrics->lane_counters[i].vehicles_processed,
+                                           __ATOMIC_RELAXED);
+        long long wait_ms = __atomic_load_n(&metrics->lane_counters[i].wait_time_ms,
+                                            __ATOMIC_RELAXED);
+        metrics->lane_throughput[i] = (int)served;
+        metrics->lane_wait_times[i] = (float)wait_ms / 1000.0f;
+        total_vehicles += served;
+    }
+
+    metrics->total_vehicles_processed = (int)total_vehicles;
+    metrics->spillback_vehicles = (int)spillback_vehicles;
+    metrics->spillback_delay = (float)spillback_delay_ms / 1000.0f;
+    metrics->context_switches = (int)__atomic_load_n(&metrics->scheduler_counters.context_switches,
+                                                     __ATOMIC_RELAXED);
+
+    if (histogram_count(&metrics->emergency_arrival_delay_ns) > 0) {
+        metrics->emergency_response_time =
+            (float)(histogram_mean(&metrics->emergency_arrival_delay_ns) / 1e9);
+    }
 }
 
 // Update emergency response time
@@ -168,6 +259,34 @@ void update_emergency_response_time(PerformanceMetrics* metrics, float response_
     metrics->last_update_time = time(NULL);
 }
 
+// Record detection-to-green latency of an emergency preemption (lock-free)
+void record_preemption_latency(PerformanceMetrics* metrics, long long latency_ns) {
+    if (!metrics) return;
+
+    histogram_record(&metrics->preemption_latency_ns, latency_ns);
+}
+
+// Record how long an emergency vehicle waited at the stop line for green
+void record_emergency_arrival_delay(PerformanceMetrics* metrics, long long delay_ns, bool preclear) {
+    if (!metrics) return;
+
+    histogram_record(&metrics->emergency_arrival_delay_ns, delay_ns);
+    __atomic_fetch_add(preclear ? &metrics->emergency_preclears : &metrics->emergency_preemptions,
+                       1, __ATOMIC_RELAXED);
+}
+
+// Record the response phases of one cleared emergency (monotonic ns timestamps)
+void record_emergency_response(PerformanceMetrics* metrics, int type, long long detected_ns,
+                               long long green_ns, long long cleared_ns) {
+    if (!metrics) return;
+    if (type < 0 || type >= METRICS_EMERGENCY_TYPES) type = 0;
+
+    EmergencyResponseHistograms* h = &metrics->emergency_by_type[type];
+    histogram_record(&h->detection_to_green_ns, green_ns - detected_ns);
+    histogram_record(&h->green_to_clear_ns, cleared_ns - green_ns);
+    histogram_record(&h->end_to_end_ns, cleared_ns - detected_ns);
+}
+
 // Update deadlock prevention count
 void update_deadlock_prevention_count(PerformanceMetrics* metrics) {
     if (!metrics) return;
@@ -176,11 +295,11 @@ void update_deadlock_prevention_count(PerformanceMetrics* metrics) {
     metrics->last_update_time = time(NULL);
 }
 
-// Update queue overflow count
+// Count an arrival dropped because the queues hit their memory cap
 void update_queue_overflow_count(PerformanceMetrics* metrics) {
     if (!metrics) return;
 
-    metrics->queue_overflow_count++;
+    __atomic_fetch_add(&metrics->queue_overflow_count, 1, __ATOMIC_RELAXED);
     metrics->last_update_time = time(NULL);
 }
 
@@ -218,6 +337,8 @@ float get_emergency_response_time(PerformanceMetrics* metrics) {
 void update_time_based_metrics(PerformanceMetrics* metrics, time_t current_time) {
     if (!metrics) return;
 
+    aggregate_metric_shards(metrics);
+
     metrics->total_simulation_time = (int)(current_time - metrics->measurement_start_time);
     calculate_throughput_metrics(metrics, current_time);
     
@@ -230,16 +351,29 @@ void update_time_based_metrics(PerformanceMetrics* metrics, time_t current_time)
     // --- NEW: Calculate utilization metrics ---
     // Utilization = vehicles processed / (total_time * expected_arrivals_per_second)
     if (metrics->total_simulation_time > 0) {
-        // Expected arrivals per second (based on arrival rate between 1-3 sec)
-        float expected_arrivals_per_sec = 1.0f / 2.0f;  // Average of 1-3 seconds
-        float expected_vehicles = expected_arrivals_per_sec * metrics->total_simulation_time;
+        float expected_vehicles = METRICS_EXPECTED_ARRIVALS_PER_SEC * metrics->total_simulation_time;
         if (expected_vehicles > 0) {
             metrics->utilization = (float)metrics->total_vehicles_processed / expected_vehicles;
             if (metrics->utilization > 1.0f) metrics->utilization = 1.0f;
         }
     }
     // --- END NEW ---
-    
+
+    // Advance the rolling windows from the freshly aggregated totals
+    TimeSeriesInput input;
+    memset(&input, 0, sizeof(input));
+    long long wait_ms = 0;
+    for (int i = 0; i < metrics->num_lanes; i++) {
+        wait_ms += __atomic_load_n(&metrics->lane_counters[i].wait_time_ms, __ATOMIC_RELAXED);
+        input.queue_length[i] = __atomic_load_n(&metrics->lane_queue_lengths[i], __ATOMIC_RELAXED);
+    }
+    input.vehicles_processed = metrics->total_vehicles_processed;
+    input.wait_time_ms = wait_ms;
+    input.context_switches = metrics->context_switches;
+    input.wait_time_histogram_ms = &metrics->wait_time_ms;
+    input.expected_arrivals_per_sec = METRICS_EXPECTED_ARRIVALS_PER_SEC;
+    timeseries_update(&metrics->timeseries, &input, monotonic_now_ns());
+
     metrics->last_update_time = current_time;
 }
 
@@ -258,12 +392,74 @@ void print_performance_metrics(PerformanceMetrics* metrics) {
     printf("Total Vehicles Processed: %d\n", metrics->total_vehicles_processed);
     printf("Context Switches: %d\n", metrics->context_switches);
     printf("Emergency Response Time: %.2f seconds\n", metrics->emergency_response_time);
+    printf("Emergency Greens: %d pre-cleared, %d preempted\n",
+           metrics->emergency_preclears, metrics->emergency_preemptions);
+    printf("Stop-line Delay: p50 %.3fs, p99 %.3fs, max %.3fs\n",
+           histogram_percentile(&metrics->emergency_arrival_delay_ns, 50.0) / 1e9,
+           histogram_percentile(&metrics->emergency_arrival_delay_ns, 99.0) / 1e9,
+           histogram_max(&metrics->emergency_arrival_delay_ns) / 1e9);
+    printf("Detection to Green (%lld): p50 %.3fs, p99 %.3fs, max %.3fs\n",
+           histogram_count(&metrics->preemption_latency_ns),
+           histogram_percentile(&metrics->preemption_latency_ns, 50.0) / 1e9,
+           histogram_percentile(&metrics->preemption_latency_ns, 99.0) / 1e9,
+           histogram_max(&metrics->preemption_latency_ns) / 1e9);
+    for (int t = EMERGENCY_AMBULANCE; t < METRICS_EMERGENCY_TYPES; t++) {
+        EmergencyResponseHistograms* h = &metrics->emergency_by_type[t];
+        if (histogram_count(&h->end_to_end_ns) == 0) continue;
+        printf("  %-10s (%lld): green p95 %.2fs p99 %.2fs | clear p95 %.2fs p99 %.2fs"
+               " | total p95 %.2fs p99 %.2fs\n",
+               get_emergency_type_name((EmergencyType)t), histogram_count(&h->end_to_end_ns),
+               histogram_percentile(&h->detection_to_green_ns, 95.0) / 1e9,
+               histogram_percentile(&h->detection_to_green_ns, 99.0) / 1e9,
+               histogram_percentile(&h->green_to_clear_ns, 95.0) / 1e9,
+               histogram_percentile(&h->green_to_clear_ns, 99.0) / 1e9,
+               histogram_percentile(&h->end_to_end_ns, 95.0) / 1e9,
+               histogram_percentile(&h->end_to_end_ns, 99.0) / 1e9);
+    }
     printf("Deadlocks Prevented: %d\n", metrics->deadlocks_prevented);
     printf("Queue Overflows: %d\n", metrics->queue_overflow_count);
+    printf("Spillback: %d vehicles, %.1f s upstream (mean %.1f s)\n", metrics->spillback_vehicles,
+           metrics->spillback_delay,
+           metrics->spillback_vehicles ? metrics->spillback_delay / metrics->spillback_vehicles : 0.0f);
     printf("Simulation Time: %d seconds\n", metrics->total_simulation_time);
     printf("===========================\n\n");
 }
 
+// Side-by-side comparison of two runs; deltas are the second minus the first
+void compare_algorithm_performance(PerformanceMetrics* metrics1, PerformanceMetrics* metrics2,
+                                  const char* algo1_name, const char* algo2_name) {
+    if (!metrics1 || !metrics2) return;
+
+    const char* names[] = {
+        "Throughput (veh/min)", "Avg wait (s)", "p95 wait (s)", "Fairness index",
+        "Vehicles processed", "Context switches", "Queue overflows"
+    };
+    double first[] = {
+        metrics1->vehicles_per_minute, metrics1->avg_wait_time,
+        histogram_percentile(&metrics1->wait_time_ms, 95.0) / 1000.0, metrics1->fairness_index,
+        metrics1->total_vehicles_processed, metrics1->context_switches,
+        metrics1->queue_overflow_count
+    };
+    double second[] = {
+        metrics2->vehicles_per_minute, metrics2->avg_wait_time,
+        histogram_percentile(&metrics2->wait_time_ms, 95.0) / 1000.0, metrics2->fairness_index,
+        metrics2->total_vehicles_processed, metrics2->context_switches,
+        metrics2->queue_overflow_count
+    };
+
+    printf("\n=== %s vs %s ===\n", algo1_name ? algo1_name : "A", algo2_name ? algo2_name : "B");
+    printf("%-22s %12s %12s %12s %9s\n", "Metric", "First", "Second", "Delta", "Change");
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        double delta = second[i] - first[i];
+        printf("%-22s %12.3f %12.3f %+12.3f", names[i], first[i], second[i], delta);
+        if (first[i] != 0.0) {
+            printf(" %+8.1f%%\n", 100.0 * delta / first[i]);
+        } else {
+            printf(" %9s\n", "-");
+        }
+    }
+}
+
 // Validate metrics consistency
 bool validate_metrics_consistency(PerformanceMetrics* metrics) {
     if (!metrics) return false;
@@ -301,35 +497,43 @@ void sanitize_metrics(PerformanceMetrics* metrics) {
     if (metrics->emergency_response_time < 0) metrics->emergency_response_time = 0;
 }
 
-// Copy metrics structure
-PerformanceMetrics* copy_metrics(PerformanceMetrics* original) {
-    if (!original) return NULL;
+// Copy metrics into caller-owned storage (e.g. from a run arena)
+void copy_metrics(const PerformanceMetrics* original, PerformanceMetrics* copy) {
+    if (!original || !copy) return;
 
-    PerformanceMetrics* copy = (PerformanceMetrics*)malloc(sizeof(PerformanceMetrics));
-    if (copy) {
-        memcpy(copy, original, sizeof(PerformanceMetrics));
-    }
-
-    return copy;
+    memcpy(copy, original, sizeof(PerformanceMetrics));
 }
 
 // Export metrics to CSV file
 void export_metrics_to_csv(PerformanceMetrics* metrics, const char* filename) {
     if (!metrics || !filename) return;
 
-    FILE* file = fopen(filename, "w");
+    // Append so repeated exports build up a history instead of one row
+    FILE* file = fopen(filename, "a");
     if (!file) {
-        printf("Failed to open file %s for writing\n", filename);
+        LOG_ERROR("Failed to open file %s for writing", filename);
         return;
     }
 
-    // Write header
-    fprintf(file, "timestamp,vehicles_per_minute,avg_wait_time,utilization,fairness_index,");
-    fprintf(file, "total_vehicles,context_switches,emergency_response_time,");
-    fprintf(file, "deadlocks_prevented,queue_overflows,simulation_time\n");
+    // Write header (new file only)
+    fseek(file, 0, SEEK_END);
+    if (ftell(file) == 0) {
+        fprintf(file, "timestamp,vehicles_per_minute,avg_wait_time,utilization,fairness_index,");
+        fprintf(file, "total_vehicles,context_switches,emergency_response_time,");
+        fprintf(file, "deadlocks_prevented,queue_overflows,simulation_time,");
+        fprintf(file, "preemption_latency_p50,preemption_latency_p99");
+        const char* types[METRICS_EMERGENCY_TYPES] = {"unknown", "ambulance", "fire_truck", "police"};
+        const char* phases[] = {"green", "clear", "total"};
+        for (int t = EMERGENCY_AMBULANCE; t < METRICS_EMERGENCY_TYPES; t++) {
+            for (int p = 0; p < 3; p++) {
+                fprintf(file, ",%s_%s_p95,%s_%s_p99", types[t], phases[p], types[t], phases[p]);
+            }
+        }
+        fprintf(file, "\n");
+    }
 
     // Write data
-    fprintf(file, "%ld,%.2f,%.2f,%.3f,%.3f,%d,%d,%.2f,%d,%d,%d\n",
+    fprintf(file, "%ld,%.2f,%.2f,%.3f,%.3f,%d,%d,%.2f,%d,%d,%d,%.3f,%.3f",
             time(NULL),
             metrics->vehicles_per_minute,
             metrics->avg_wait_time,
@@ -340,8 +544,20 @@ void export_metrics_to_csv(PerformanceMetrics* metrics, const char* filename) {
             metrics->emergency_response_time,
             metrics->deadlocks_prevented,
             metrics->queue_overflow_count,
-            metrics->total_simulation_time);
+            metrics->total_simulation_time,
+            histogram_percentile(&metrics->preemption_latency_ns, 50.0) / 1e9,
+            histogram_percentile(&metrics->preemption_latency_ns, 99.0) / 1e9);
+    for (int t = EMERGENCY_AMBULANCE; t < METRICS_EMERGENCY_TYPES; t++) {
+        EmergencyResponseHistograms* h = &metrics->emergency_by_type[t];
+        LatencyHistogram* phases[] = {&h->detection_to_green_ns, &h->green_to_clear_ns,
+                                      &h->end_to_end_ns};
+        for (int p = 0; p < 3; p++) {
+            fprintf(file, ",%.3f,%.3f", histogram_percentile(phases[p], 95.0) / 1e9,
+                    histogram_percentile(phases[p], 99.0) / 1e9);
+        }
+    }
+    fprintf(file, "\n");
 
     fclose(file);
-    printf("Metrics exported to %s\n", filename);
+    LOG_INFO("Metrics exported to %s", filename);
 }
\ No newline at end of file
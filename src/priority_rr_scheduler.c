@@ -6,9 +6,12 @@
  *
  * Priority Levels:
  * 1. Emergency vehicles (highest priority)
- * 2. Normal traffic (queue length > 3)
+ * 2. Normal traffic (queue length > 3, or unserved for 30 s)
  * 3. Low traffic (queue length ≤ 3)
  *
+ * The classes and the round-robin order are select_lane_priority_rr() in
+ * scheduling_policy.c, shared with the --compare replays.
+ *
  * Key Features:
  * - Fixed time quantum (3 seconds) per lane
  * - Dynamic priority adjustment based on queue depth
@@ -22,8 +25,10 @@
 #include "../include/lane_process.h"
 #include "../include/emergency_system.h"
 #include "../include/trafficguru.h"
+#include "../include/checkpoint.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 typedef enum {
@@ -40,12 +45,10 @@ typedef struct {
     bool in_ready_queue;
 } LaneRRInfo;
 
-static LaneRRInfo lane_rr_info[4];
+static LaneRRInfo lane_rr_info[MAX_LANES];
 static bool rr_initialized = false;
 static int current_round_robin_index = 0;
 
-#define RR_TIME_QUANTUM 3
-
 // Initialize Round Robin tracking
 void init_round_robin_tracking() {
     if (rr_initialized) {
@@ -54,7 +57,7 @@ void init_round_robin_tracking() {
 
     time_t current_time = time(NULL);
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < MAX_LANES; i++) {
         lane_rr_info[i].lane_id = i;
         lane_rr_info[i].priority = PRIORITY_NORMAL;
         lane_rr_info[i].last_service_time = current_time;
@@ -66,55 +69,9 @@ void init_round_robin_tracking() {
     rr_initialized = true;
 }
 
-// Update lane priority based on conditions
-void update_lane_rr_priority(LaneProcess* lane) {
-    if (!lane || !rr_initialized) {
-        return;
-    }
-
-    LaneRRInfo* rr_info = &lane_rr_info[lane->lane_id];
-    int queue_length = get_lane_queue_length(lane);
-
-    // Check for emergency vehicles (highest priority)
-    // In a real implementation, this would check with emergency system
-    if (lane->priority == 1) { // Emergency priority set externally
-        rr_info->priority = PRIORITY_EMERGENCY;
-    } else if (queue_length > 3) {
-        rr_info->priority = PRIORITY_NORMAL;
-    } else {
-        rr_info->priority = PRIORITY_LOW;
-    }
-}
-
-// Get next lane in Round Robin order for specific priority
-int get_next_rr_lane(LaneProcess lanes[4], TrafficPriority priority) {
-    if (!rr_initialized) {
-        return -1;
-    }
-
-    int start_index = current_round_robin_index;
-    int lanes_checked = 0;
-
-    while (lanes_checked < 4) {
-        int lane_id = start_index % 4;
-
-        if (is_lane_ready(&lanes[lane_id]) &&
-            !is_lane_blocked(&lanes[lane_id]) &&
-            lane_rr_info[lane_id].priority == priority) {
-
-            current_round_robin_index = (lane_id + 1) % 4;
-            return lane_id;
-        }
-
-        start_index++;
-        lanes_checked++;
-    }
-
-    return -1; // No lane found with this priority
-}
-
-// Priority Round Robin scheduling algorithm
-int schedule_next_lane_priority_rr(Scheduler* scheduler, LaneProcess lanes[4]) {
+// Priority Round Robin scheduling algorithm: classes and order come from
+// select_lane_priority_rr(); this file keeps the live round-robin position
+int schedule_next_lane_priority_rr(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -124,41 +81,21 @@ int schedule_next_lane_priority_rr(Scheduler* scheduler, LaneProcess lanes[4]) {
         init_round_robin_tracking();
     }
 
-    // Update all lane priorities
-    for (int i = 0; i < 4; i++) {
-        update_lane_rr_priority(&lanes[i]);
+    LanePolicyView views[MAX_LANES];
+    fill_lane_policy_views(lanes, num_lanes, views);
+    for (int i = 0; i < num_lanes; i++) {
+        lane_rr_info[i].priority = (TrafficPriority)round_robin_class(&views[i]);
     }
 
     // Set standard time quantum for Priority Round Robin
     scheduler->time_quantum = RR_TIME_QUANTUM;
 
-    // Process priorities in order: Emergency -> Normal -> Low
-
-    // Priority 1: Emergency vehicles
-    int emergency_lane = get_next_rr_lane(lanes, PRIORITY_EMERGENCY);
-    if (emergency_lane != -1) {
-        return emergency_lane;
-    }
-
-    // Priority 2: Normal traffic lanes
-    int normal_lane = get_next_rr_lane(lanes, PRIORITY_NORMAL);
-    if (normal_lane != -1) {
-        return normal_lane;
-    }
-
-    // Priority 3: Low traffic lanes
-    int low_lane = get_next_rr_lane(lanes, PRIORITY_LOW);
-    if (low_lane != -1) {
-        return low_lane;
-    }
-
-    // No ready lanes found
-    return -1;
+    return select_lane_priority_rr(views, num_lanes, &current_round_robin_index);
 }
 
 // Handle emergency vehicle preemption
-int preempt_for_emergency_rr(Scheduler* scheduler, LaneProcess lanes[4], int emergency_lane_id) {
-    if (!scheduler || !lanes || emergency_lane_id < 0 || emergency_lane_id >= 4) {
+int preempt_for_emergency_rr(Scheduler* scheduler, LaneProcess* lanes, int num_lanes, int emergency_lane_id) {
+    if (!scheduler || !lanes || emergency_lane_id < 0 || emergency_lane_id >= num_lanes) {
         return -1;
     }
 
@@ -175,48 +112,22 @@ int preempt_for_emergency_rr(Scheduler* scheduler, LaneProcess lanes[4], int eme
 
 // Clear emergency priority after vehicle passes
 void clear_emergency_priority(int lane_id) {
-    if (!rr_initialized || lane_id < 0 || lane_id >= 4) {
+    if (!rr_initialized || lane_id < 0 || lane_id >= MAX_LANES) {
         return;
     }
 
     lane_rr_info[lane_id].priority = PRIORITY_NORMAL;
 }
 
-// Enhanced Priority Round Robin with fairness considerations
-int schedule_next_lane_priority_rr_fair(Scheduler* scheduler, LaneProcess lanes[4]) {
-    if (!scheduler || !lanes) {
-        return -1;
-    }
-
-    if (!rr_initialized) {
-        init_round_robin_tracking();
-    }
-
-    // Update lane priorities
-    for (int i = 0; i < 4; i++) {
-        update_lane_rr_priority(&lanes[i]);
-    }
-
-    time_t current_time = time(NULL);
-    scheduler->time_quantum = RR_TIME_QUANTUM;
-
-    // Check for lanes that haven't been served recently (fairness)
-    for (int i = 0; i < 4; i++) {
-        time_t time_since_service = current_time - lane_rr_info[i].last_service_time;
-
-        // Boost priority if lane hasn't been served for too long
-        if (time_since_service > 30 && lane_rr_info[i].priority == PRIORITY_LOW) {
-            lane_rr_info[i].priority = PRIORITY_NORMAL;
-        }
-    }
-
-    // Process with standard priority order
-    return schedule_next_lane_priority_rr(scheduler, lanes);
+// Enhanced Priority Round Robin with fairness considerations: the boost
+// for lanes unserved for RR_STARVATION_SECONDS is part of the standard rule
+int schedule_next_lane_priority_rr_fair(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
+    return schedule_next_lane_priority_rr(scheduler, lanes, num_lanes);
 }
 
 // Update lane service information
 void update_lane_service_info(int lane_id) {
-    if (!rr_initialized || lane_id < 0 || lane_id >= 4) {
+    if (!rr_initialized || lane_id < 0 || lane_id >= MAX_LANES) {
         return;
     }
 
@@ -226,7 +137,7 @@ void update_lane_service_info(int lane_id) {
 
 // Get lane service statistics
 void get_lane_service_stats(int lane_id, time_t* last_service, int* service_count) {
-    if (!rr_initialized || lane_id < 0 || lane_id >= 4) {
+    if (!rr_initialized || lane_id < 0 || lane_id >= MAX_LANES) {
         if (last_service) *last_service = 0;
         if (service_count) *service_count = 0;
         return;
@@ -243,6 +154,32 @@ void reset_round_robin_tracking() {
     init_round_robin_tracking();
 }
 
+// Checkpoint the round-robin table and position
+void save_round_robin_checkpoint(CheckpointRoundRobin* state) {
+    memset(state, 0, sizeof(CheckpointRoundRobin));
+    state->initialized = rr_initialized;
+    state->round_robin_index = current_round_robin_index;
+    for (int i = 0; i < MAX_LANES; i++) {
+        state->lanes[i].priority = lane_rr_info[i].priority;
+        state->lanes[i].last_service_time = lane_rr_info[i].last_service_time;
+        state->lanes[i].service_count = lane_rr_info[i].service_count;
+        state->lanes[i].in_ready_queue = lane_rr_info[i].in_ready_queue;
+    }
+}
+
+// Put a checkpointed table back, its service times moved on by 'wall_shift'
+void restore_round_robin_checkpoint(const CheckpointRoundRobin* state, time_t wall_shift) {
+    for (int i = 0; i < MAX_LANES; i++) {
+        lane_rr_info[i].lane_id = i;
+        lane_rr_info[i].priority = (TrafficPriority)state->lanes[i].priority;
+        lane_rr_info[i].last_service_time = (time_t)state->lanes[i].last_service_time + wall_shift;
+        lane_rr_info[i].service_count = state->lanes[i].service_count;
+        lane_rr_info[i].in_ready_queue = state->lanes[i].in_ready_queue;
+    }
+    current_round_robin_index = state->round_robin_index;
+    rr_initialized = state->initialized;
+}
+
 // Print Round Robin information for debugging
 void print_round_robin_info() {
     if (!rr_initialized) {
@@ -253,7 +190,7 @@ void print_round_robin_info() {
     printf("\n=== ROUND ROBIN INFO ===\n");
     const char* priority_names[] = {"", "EMERGENCY", "NORMAL", "LOW"};
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < get_num_lanes(); i++) {
         LaneRRInfo* info = &lane_rr_info[i];
         time_t time_since_service = time(NULL) - info->last_service_time;
 
@@ -265,7 +202,7 @@ void print_round_robin_info() {
 }
 
 // Adaptive Priority Round Robin with dynamic time quantum
-int schedule_next_lane_adaptive_priority_rr(Scheduler* scheduler, LaneProcess lanes[4]) {
+int schedule_next_lane_adaptive_priority_rr(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -278,7 +215,7 @@ int schedule_next_lane_adaptive_priority_rr(Scheduler* scheduler, LaneProcess la
     int total_vehicles = 0;
     int ready_lanes = 0;
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (is_lane_ready(&lanes[i])) {
             total_vehicles += get_lane_queue_length(&lanes[i]);
             ready_lanes++;
@@ -299,5 +236,5 @@ int schedule_next_lane_adaptive_priority_rr(Scheduler* scheduler, LaneProcess la
     }
 
     // Use standard priority scheduling with adaptive time quantum
-    return schedule_next_lane_priority_rr(scheduler, lanes);
+    return schedule_next_lane_priority_rr(scheduler, lanes, num_lanes);
 }
\ No newline at end of file
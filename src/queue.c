@@ -1,76 +1,206 @@
 /*
  * Queue Implementation - FIFO Vehicle Queue Management
  *
- * Circular queue implementation for managing vehicle arrivals at traffic lanes.
- * Provides efficient FIFO operations with dynamic resizing and statistics.
+ * Segmented queue implementation for managing vehicle arrivals at traffic
+ * lanes. Vehicles sit in a linked list of fixed-size chunks; fields live in
+ * parallel arrays inside each chunk, indexed by the same slot. A private
+ * queue keeps its last drained chunk as a spare (and its head chunk when
+ * empty), so one oscillating around a chunk boundary does not go back to
+ * malloc every time. A pooled queue hands every drained chunk straight
+ * back, so idle lanes never hold memory another lane could use.
  *
- * Compilation: Include queue.h
+ * Compilation: Include queue.h, run_arena.h, sim_clock.h
  */
 
 #include "../include/queue.h"
+#include "../include/sim_clock.h"
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
 #include <assert.h>
 
-Queue* create_queue(int capacity) {
-    if (capacity <= 0) {
+static int chunks_for_bytes(size_t max_bytes) {
+    size_t chunks = max_bytes / sizeof(QueueChunk);
+    return chunks > 0x7fffffff ? 0x7fffffff : (int)chunks;
+}
+
+// Pool capped at max_bytes of chunks; with an arena, every chunk up to the
+// cap is created now
+QueueChunkPool* create_queue_chunk_pool(RunArena* arena, size_t max_bytes) {
+    QueueChunkPool* pool = arena ? (QueueChunkPool*)arena_alloc(arena, sizeof(QueueChunkPool))
+                                 : (QueueChunkPool*)malloc(sizeof(QueueChunkPool));
+    if (!pool) {
         return NULL;
     }
 
-    Queue* queue = (Queue*)malloc(sizeof(Queue));
-    if (!queue) {
+    int max_chunks = chunks_for_bytes(max_bytes);
+    pool->arena = arena;
+    if (!init_object_pool(&pool->chunks, arena, sizeof(QueueChunk), max_chunks,
+                          arena ? max_chunks : 0)) {
+        destroy_object_pool(&pool->chunks);
+        if (!arena) {
+            free(pool);
+        }
+        return NULL;
+    }
+    return pool;
+}
+
+// Free the pool's idle chunks; queues using it must already be destroyed
+void destroy_queue_chunk_pool(QueueChunkPool* pool) {
+    if (!pool) {
+        return;
+    }
+
+    destroy_object_pool(&pool->chunks);
+    if (!pool->arena) {
+        free(pool);
+    }
+}
+
+// Change the memory cap; chunks already handed out above it are kept
+void set_queue_chunk_pool_limit(QueueChunkPool* pool, size_t max_bytes) {
+    if (!pool) {
+        return;
+    }
+
+    int max_chunks = chunks_for_bytes(max_bytes);
+    set_object_pool_limit(&pool->chunks, max_chunks);
+    if (pool->arena) {
+        reserve_object_pool(&pool->chunks, max_chunks);
+    }
+}
+
+size_t get_queue_chunk_pool_bytes_in_use(QueueChunkPool* pool) {
+    if (!pool) {
+        return 0;
+    }
+    return (size_t)__atomic_load_n(&pool->chunks.in_use, __ATOMIC_RELAXED) * sizeof(QueueChunk);
+}
+
+size_t get_queue_chunk_pool_peak_bytes(QueueChunkPool* pool) {
+    if (!pool) {
+        return 0;
+    }
+    return (size_t)__atomic_load_n(&pool->chunks.peak_in_use, __ATOMIC_RELAXED) * sizeof(QueueChunk);
+}
+
+// Next chunk for 'queue': its spare, else the pool (or malloc); NULL at the cap
+static QueueChunk* take_chunk(Queue* queue) {
+    QueueChunk* chunk = queue->spare_chunk;
+    if (chunk) {
+        queue->spare_chunk = NULL;
+    } else if (!queue->pool) {
+        chunk = (QueueChunk*)malloc(sizeof(QueueChunk));
+    } else {
+        chunk = (QueueChunk*)object_pool_take(&queue->pool->chunks);
+    }
+
+    if (chunk) {
+        chunk->next = NULL;
+    }
+    return chunk;
+}
+
+// Return a chunk to the pool (or free it), bypassing the spare
+static void release_chunk(Queue* queue, QueueChunk* chunk) {
+    if (!queue->pool) {
+        free(chunk);
+        return;
+    }
+
+    object_pool_give(&queue->pool->chunks, chunk);
+}
+
+// A drained chunk becomes a private queue's spare, or goes back
+static void retire_chunk(Queue* queue, QueueChunk* chunk) {
+    if (!queue->pool && !queue->spare_chunk) {
+        chunk->next = NULL;
+        queue->spare_chunk = chunk;
+    } else {
+        release_chunk(queue, chunk);
+    }
+}
+
+Queue* create_pooled_queue(int capacity, QueueChunkPool* pool) {
+    if (capacity <= 0) {
         return NULL;
     }
 
-    queue->vehicles = (int*)malloc(capacity * sizeof(int));
-    if (!queue->vehicles) {
-        free(queue);
+    // Queues on an arena-backed pool live in the arena as well
+    bool in_arena = pool && pool->arena;
+    Queue* queue = in_arena ? (Queue*)arena_alloc(pool->arena, sizeof(Queue))
+                            : (Queue*)malloc(sizeof(Queue));
+    if (!queue) {
         return NULL;
     }
 
-    queue->front = 0;
-    queue->rear = -1;
-    queue->size = 0;
+    memset(queue, 0, sizeof(Queue));
     queue->capacity = capacity;
-    queue->enqueue_count = 0;
-    queue->dequeue_count = 0;
-    queue->overflow_count = 0;
+    queue->pool = pool;
 
     return queue;
 }
 
+Queue* create_queue(int capacity) {
+    return create_pooled_queue(capacity, NULL);
+}
+
 void destroy_queue(Queue* queue) {
     if (queue) {
-        free(queue->vehicles);
-        free(queue);
+        clear_queue(queue);
+        if (queue->head_chunk) {
+            release_chunk(queue, queue->head_chunk);
+        }
+        if (queue->spare_chunk) {
+            release_chunk(queue, queue->spare_chunk);
+        }
+        if (!queue->pool || !queue->pool->arena) {
+            free(queue);
+        }
     }
 }
 
-void resize_queue(Queue* queue, int new_capacity) {
-    if (!queue || new_capacity <= 0 || new_capacity < queue->size) {
-        return;
+// Chunk and slot of the vehicle 'position' places behind the head
+static QueueChunk* locate(Queue* queue, int position, int* slot) {
+    QueueChunk* chunk = queue->head_chunk;
+    int index = queue->head_slot + position;
+    while (index >= QUEUE_CHUNK_VEHICLES) {
+        index -= QUEUE_CHUNK_VEHICLES;
+        chunk = chunk->next;
     }
+    *slot = index;
+    return chunk;
+}
 
-    int* new_vehicles = (int*)malloc(new_capacity * sizeof(int));
-    if (!new_vehicles) {
-        return;
+// Vehicles at positions [first, last) have moved up into storage
+static void mark_entered_storage(Queue* queue, int first, int last) {
+    long long now_ns = monotonic_now_ns();
+    for (int position = first; position < last; position++) {
+        int slot;
+        QueueChunk* chunk = locate(queue, position, &slot);
+        if (chunk->storage_ns[slot] == 0) {
+            chunk->storage_ns[slot] = now_ns;
+        }
     }
+}
 
-    for (int i = 0; i < queue->size; i++) {
-        int index = (queue->front + i) % queue->capacity;
-        new_vehicles[i] = queue->vehicles[index];
+// Change the storage capacity in place. A private queue cannot shrink below
+// its current size; a pooled one can, and vehicles already in storage stay.
+void resize_queue(Queue* queue, int new_capacity) {
+    if (!queue || new_capacity <= 0 || (!queue->pool && new_capacity < queue->size)) {
+        return;
     }
 
-    free(queue->vehicles);
-    queue->vehicles = new_vehicles;
+    if (new_capacity > queue->capacity && queue->size > queue->capacity) {
+        int last = queue->size < new_capacity ? queue->size : new_capacity;
+        mark_entered_storage(queue, queue->capacity, last);
+    }
     queue->capacity = new_capacity;
-    queue->front = 0;
-    queue->rear = queue->size - 1;
 }
 
-bool enqueue(Queue* queue, int vehicle_id) {
-    if (!queue) {
+bool enqueue_vehicle(Queue* queue, const VehicleRecord* vehicle) {
+    if (!queue || !vehicle) {
         return false;
     }
 
@@ -79,30 +209,136 @@ bool enqueue(Queue* queue, int vehicle_id) {
         return false;
     }
 
-    queue->rear = (queue->rear + 1) % queue->capacity;
-    queue->vehicles[queue->rear] = vehicle_id;
+    if (!queue->tail_chunk || queue->tail_slot == QUEUE_CHUNK_VEHICLES) {
+        QueueChunk* chunk = take_chunk(queue);
+        if (!chunk) {
+            queue->overflow_count++;
+            return false;
+        }
+        if (queue->tail_chunk) {
+            queue->tail_chunk->next = chunk;
+        } else {
+            queue->head_chunk = chunk;
+            queue->head_slot = 0;
+        }
+        queue->tail_chunk = chunk;
+        queue->tail_slot = 0;
+    }
+
+    QueueChunk* chunk = queue->tail_chunk;
+    int slot = queue->tail_slot++;
+    bool in_storage = queue->size < queue->capacity;
+
+    chunk->vehicles[slot] = vehicle->id;
+    chunk->arrival_ns[slot] = vehicle->arrival_ns;
+    chunk->storage_ns[slot] = in_storage ? vehicle->arrival_ns : 0;
+    chunk->movements[slot] = (unsigned char)vehicle->movement;
+    chunk->classes[slot] = (unsigned char)vehicle->vehicle_class;
     queue->size++;
     queue->enqueue_count++;
+    if (!in_storage) {
+        queue->spillback_count++;
+    }
+    if (queue->size > queue->peak_size) {
+        queue->peak_size = queue->size;
+    }
 
     return true;
 }
 
-int dequeue(Queue* queue) {
+// Copy the record in 'slot' of 'chunk'
+static void read_vehicle(QueueChunk* chunk, int slot, VehicleRecord* vehicle) {
+    vehicle->id = chunk->vehicles[slot];
+    vehicle->arrival_ns = chunk->arrival_ns[slot];
+    vehicle->movement = (VehicleMovement)chunk->movements[slot];
+    vehicle->vehicle_class = (VehicleClass)chunk->classes[slot];
+    vehicle->storage_ns = chunk->storage_ns[slot];
+}
+
+bool dequeue_vehicle(Queue* queue, VehicleRecord* vehicle) {
     if (!queue || is_empty(queue)) {
-        return -1;
+        return false;
     }
 
-    int vehicle_id = queue->vehicles[queue->front];
-    queue->front = (queue->front + 1) % queue->capacity;
+    QueueChunk* chunk = queue->head_chunk;
+    if (vehicle) {
+        read_vehicle(chunk, queue->head_slot, vehicle);
+        if (vehicle->storage_ns == 0) {
+            vehicle->storage_ns = monotonic_now_ns();
+        }
+    }
+    queue->head_slot++;
     queue->size--;
     queue->dequeue_count++;
 
     if (queue->size == 0) {
-        queue->front = 0;
-        queue->rear = -1;
+        if (queue->pool) {
+            queue->head_chunk = NULL;
+            queue->tail_chunk = NULL;
+            retire_chunk(queue, chunk);
+        }
+        // A private queue keeps its one chunk and starts it over
+        queue->head_slot = 0;
+        queue->tail_slot = 0;
+    } else if (queue->head_slot == QUEUE_CHUNK_VEHICLES) {
+        queue->head_chunk = chunk->next;
+        queue->head_slot = 0;
+        retire_chunk(queue, chunk);
+    }
+
+    // The first spilled-back vehicle moves up into the freed storage
+    if (queue->size >= queue->capacity) {
+        mark_entered_storage(queue, queue->capacity - 1, queue->capacity);
+    }
+
+    return true;
+}
+
+// Copy up to 'max_vehicles' queued records, head first; returns how many
+int copy_queued_vehicles(Queue* queue, VehicleRecord* vehicles, int max_vehicles) {
+    if (!queue || !vehicles) {
+        return 0;
+    }
+
+    QueueChunk* chunk = queue->head_chunk;
+    int slot = queue->head_slot;
+    int count = 0;
+    while (count < queue->size && count < max_vehicles) {
+        if (slot == QUEUE_CHUNK_VEHICLES) {
+            chunk = chunk->next;
+            slot = 0;
+        }
+        read_vehicle(chunk, slot++, &vehicles[count++]);
+    }
+    return count;
+}
+
+// Append a copied record as it was, including when it entered storage
+bool restore_queued_vehicle(Queue* queue, const VehicleRecord* vehicle) {
+    if (!enqueue_vehicle(queue, vehicle)) {
+        return false;
+    }
+    queue->tail_chunk->storage_ns[queue->tail_slot - 1] = vehicle->storage_ns;
+    return true;
+}
+
+bool peek_vehicle(Queue* queue, VehicleRecord* vehicle) {
+    if (!queue || !vehicle || is_empty(queue)) {
+        return false;
     }
 
-    return vehicle_id;
+    read_vehicle(queue->head_chunk, queue->head_slot, vehicle);
+    return true;
+}
+
+bool enqueue(Queue* queue, int vehicle_id) {
+    VehicleRecord vehicle = {vehicle_id, monotonic_now_ns(), MOVEMENT_STRAIGHT, VEHICLE_CAR, 0};
+    return enqueue_vehicle(queue, &vehicle);
+}
+
+int dequeue(Queue* queue) {
+    VehicleRecord vehicle;
+    return dequeue_vehicle(queue, &vehicle) ? vehicle.id : -1;
 }
 
 int peek(Queue* queue) {
@@ -110,15 +346,26 @@ int peek(Queue* queue) {
         return -1;
     }
 
-    return queue->vehicles[queue->front];
+    return queue->head_chunk->vehicles[queue->head_slot];
+}
+
+const char* get_movement_name(VehicleMovement movement) {
+    switch (movement) {
+        case MOVEMENT_LEFT: return "left";
+        case MOVEMENT_STRAIGHT: return "straight";
+        case MOVEMENT_RIGHT: return "right";
+        case MOVEMENT_U_TURN: return "u-turn";
+        default: return "unknown";
+    }
 }
 
 bool is_empty(Queue* queue) {
     return queue ? queue->size == 0 : true;
 }
 
+// A pooled queue is only full when the pool is; that shows up at enqueue
 bool is_full(Queue* queue) {
-    return queue ? queue->size == queue->capacity : true;
+    return queue ? (!queue->pool && queue->size >= queue->capacity) : true;
 }
 
 int get_size(Queue* queue) {
@@ -129,10 +376,25 @@ int get_capacity(Queue* queue) {
     return queue ? queue->capacity : 0;
 }
 
+// Empty the queue; a private queue keeps its head chunk (and spare)
 void clear_queue(Queue* queue) {
     if (queue) {
-        queue->front = 0;
-        queue->rear = -1;
+        if (queue->head_chunk) {
+            QueueChunk* chunk = queue->pool ? queue->head_chunk : queue->head_chunk->next;
+            while (chunk) {
+                QueueChunk* next = chunk->next;
+                release_chunk(queue, chunk);
+                chunk = next;
+            }
+            if (queue->pool) {
+                queue->head_chunk = NULL;
+            } else {
+                queue->head_chunk->next = NULL;
+            }
+            queue->tail_chunk = queue->head_chunk;
+        }
+        queue->head_slot = 0;
+        queue->tail_slot = 0;
         queue->size = 0;
     }
 }
@@ -147,8 +409,12 @@ void print_queue(Queue* queue) {
 
     if (queue->size > 0) {
         for (int i = 0; i < queue->size; i++) {
-            int index = (queue->front + i) % queue->capacity;
-            printf("%d", queue->vehicles[index]);
+            int slot;
+            QueueChunk* chunk = locate(queue, i, &slot);
+            printf("%d", chunk->vehicles[slot]);
+            if (i == queue->capacity - 1 && i < queue->size - 1) {
+                printf(" |");   // Storage ends here; the rest is spilled back
+            }
             if (i < queue->size - 1) {
                 printf(", ");
             }
@@ -182,6 +448,16 @@ int get_overflow_count(Queue* queue) {
     return queue ? queue->overflow_count : 0;
 }
 
+// Arrivals that had to wait upstream because storage was full
+int get_spillback_count(Queue* queue) {
+    return queue ? queue->spillback_count : 0;
+}
+
+// Vehicles currently waiting upstream of the lane's storage
+int get_spillback_length(Queue* queue) {
+    return (queue && queue->size > queue->capacity) ? queue->size - queue->capacity : 0;
+}
+
 // Calculate average queue length over time period
 float get_average_queue_length(Queue* queue, time_t start_time) {
     if (!queue || start_time <= 0) {
@@ -0,0 +1,251 @@
+/*
+ * Replications Implementation - Work-Claiming Thread Pool
+ *
+ * Workers take replication indices from a shared counter and store each
+ * result in its slot. A worker that completes the lowest outstanding index
+ * advances the completed prefix and tests the stopping rule at every
+ * prefix length it passes, so the run stops at the first prefix that meets
+ * the target whichever thread got there. Replications still in flight
+ * past that point are discarded.
+ *
+ * Compilation: Include replications.h, sim_clock.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/replications.h"
+#include "../include/trafficguru.h"
+#include "../include/sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+
+typedef struct {
+    const ReplicationConfig* config;
+    pthread_mutex_t lock;
+    int next_index;                 // Next replication to claim
+    int prefix;                     // Replications 0..prefix-1 are all done
+    int used;                       // Replications in the report
+    bool stop;
+    bool stopped_early;
+    bool failed;
+    bool* done;
+    ComparisonRunResult* results;
+} ReplicationPool;
+
+void init_replication_config(ReplicationConfig* config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+    config->algorithm = SJF;
+    config->replications = 0;
+    config->ci_target = 0.0;
+    init_algorithm_comparison_config(&config->run);
+}
+
+// Mean, sample standard deviation and 95% half-width of one metric over
+// the first 'count' replications
+static void metric_statistics(const ComparisonRunResult* results, int count, int metric,
+                              double* mean, double* std_dev, double* half_width) {
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += get_comparison_metric(&results[i], metric);
+    }
+    *mean = count > 0 ? sum / count : 0.0;
+
+    double squares = 0.0;
+    for (int i = 0; i < count; i++) {
+        double deviation = get_comparison_metric(&results[i], metric) - *mean;
+        squares += deviation * deviation;
+    }
+    *std_dev = count > 1 ? sqrt(squares / (count - 1)) : 0.0;
+    *half_width = count > 1 ? t_quantile_95(count - 1) * *std_dev / sqrt(count) : 0.0;
+}
+
+static bool target_met(const ReplicationPool* pool, int count) {
+    for (int m = 0; m < COMPARE_NUM_METRICS; m++) {
+        double mean, std_dev, half_width;
+        metric_statistics(pool->results, count, m, &mean, &std_dev, &half_width);
+        if (half_width > pool->config->ci_target * fabs(mean)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Called with the pool lock held after a replication completes
+static void advance_prefix(ReplicationPool* pool) {
+    const ReplicationConfig* config = pool->config;
+    while (!pool->stop && pool->prefix < config->replications && pool->done[pool->prefix]) {
+        pool->prefix++;
+        if (config->ci_target > 0 && pool->prefix >= REPLICATION_MIN_FOR_STOP &&
+            pool->prefix < config->replications && target_met(pool, pool->prefix)) {
+            pool->stop = true;
+            pool->stopped_early = true;
+        }
+    }
+    pool->used = pool->prefix;
+}
+
+static void* replication_worker(void* arg) {
+    ReplicationPool* pool = (ReplicationPool*)arg;
+    const ReplicationConfig* config = pool->config;
+
+    ComparisonWorker* worker = create_comparison_worker();
+    if (!worker) {
+        pthread_mutex_lock(&pool->lock);
+        pool->failed = true;
+        pool->stop = true;
+        pthread_mutex_unlock(&pool->lock);
+        return NULL;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        if (pool->stop || pool->next_index >= config->replications) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+        int index = pool->next_index++;
+        pthread_mutex_unlock(&pool->lock);
+
+        ComparisonRunResult result;
+        unsigned int seed = config->run.base_seed + (unsigned int)index * 7919u;
+        bool ok = run_comparison_replication(worker, &config->run, config->algorithm, seed, &result);
+
+        pthread_mutex_lock(&pool->lock);
+        if (!ok) {
+            pool->failed = true;
+            pool->stop = true;
+        } else {
+            pool->results[index] = result;
+            pool->done[index] = true;
+            advance_prefix(pool);
+        }
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    destroy_comparison_worker(worker);
+    return NULL;
+}
+
+static int pool_thread_count(int replications) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    if (threads > REPLICATION_MAX_THREADS) {
+        threads = REPLICATION_MAX_THREADS;
+    }
+    return threads < replications ? threads : replications;
+}
+
+static void print_arrival_source(const ReplicationConfig* config) {
+    if (get_arrival_process_config()) {
+        char description[128];
+        format_arrival_process(get_arrival_process_config(), description, sizeof(description));
+        printf("Arrivals: %s, drawn per replication\n", description);
+    } else if (get_traffic_scenario()) {
+        printf("Arrivals: generated from scenario %s, drawn per replication\n",
+               get_traffic_scenario()->name);
+    } else {
+        printf("Arrivals: generated, %d-%d s apart, drawn per replication\n",
+               config->run.min_arrival_rate, config->run.max_arrival_rate);
+    }
+}
+
+static void print_replication_report(const ReplicationPool* pool, int threads, double seconds) {
+    const ReplicationConfig* config = pool->config;
+
+    printf("Replications: %d of %d on %d threads in %.2f s", pool->used, config->replications,
+           threads, seconds);
+    if (pool->stopped_early) {
+        printf(", stopped: every 95%% CI within %.1f%% of its mean", config->ci_target * 100.0);
+    } else if (config->ci_target > 0) {
+        printf(", target of %.1f%% not reached", config->ci_target * 100.0);
+    }
+    printf("\n\n%-22s %12s %12s  %-26s %9s\n", "Metric", "Mean", "Std dev", "95% CI", "CI/mean");
+
+    for (int m = 0; m < COMPARE_NUM_METRICS; m++) {
+        double mean, std_dev, half_width;
+        metric_statistics(pool->results, pool->used, m, &mean, &std_dev, &half_width);
+        printf("%-22s %12.3f %12.3f  [%11.3f, %11.3f]", get_comparison_metric_name(m), mean,
+               std_dev, mean - half_width, mean + half_width);
+        if (mean != 0.0) {
+            printf(" %8.1f%%\n", half_width / fabs(mean) * 100.0);
+        } else {
+            printf(" %9s\n", "-");
+        }
+    }
+
+    long long arrived = 0;
+    long long left_queued = 0;
+    for (int i = 0; i < pool->used; i++) {
+        arrived += pool->results[i].vehicles_arrived;
+        left_queued += pool->results[i].vehicles_left_queued;
+    }
+    printf("\nPer replication: %.1f vehicles arrived, %.1f left queued at the end\n",
+           (double)arrived / pool->used, (double)left_queued / pool->used);
+}
+
+// Run up to config->replications seeded replications on all cores and report
+int run_replications(const ReplicationConfig* config) {
+    if (!config || config->replications <= 0 || config->replications > REPLICATION_MAX) {
+        return -1;
+    }
+
+    ReplicationPool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.config = config;
+    pool.done = calloc((size_t)config->replications, sizeof(bool));
+    pool.results = calloc((size_t)config->replications, sizeof(ComparisonRunResult));
+    int threads = pool_thread_count(config->replications);
+    pthread_t* workers = calloc((size_t)threads, sizeof(pthread_t));
+    if (!pool.done || !pool.results || !workers) {
+        printf("Out of memory for %d replications\n", config->replications);
+        free(pool.done);
+        free(pool.results);
+        free(workers);
+        return -1;
+    }
+    pthread_mutex_init(&pool.lock, NULL);
+
+    printf("=== MONTE CARLO REPLICATIONS ===\n");
+    printf("Algorithm: %s, %d s virtual time per replication, base seed %u\n",
+           get_algorithm_name(config->algorithm), config->run.duration_seconds,
+           config->run.base_seed);
+    print_arrival_source(config);
+
+    long long start_ns = monotonic_now_ns();
+    int started = 0;
+    for (int t = 0; t < threads; t++) {
+        if (pthread_create(&workers[t], NULL, replication_worker, &pool) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        replication_worker(&pool);      // No thread available: run them here
+    }
+    for (int t = 0; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    double seconds = (double)(monotonic_now_ns() - start_ns) / NS_PER_SEC;
+
+    int result = 0;
+    if (pool.failed || pool.used == 0) {
+        printf("Replications failed (out of memory)\n");
+        result = -1;
+    } else {
+        print_replication_report(&pool, started > 0 ? started : 1, seconds);
+    }
+    printf("================================\n");
+
+    pthread_mutex_destroy(&pool.lock);
+    free(pool.done);
+    free(pool.results);
+    free(workers);
+    return result;
+}
@@ -0,0 +1,762 @@
+/*
+ * Road Network Implementation - Windowed Replay of Linked Intersections
+ *
+ * Each intersection is a ReplayIntersection with hooks back into this
+ * file: can_depart() holds a vehicle whose exit link is full, depart()
+ * takes a place on the exit link, and cleared() sends the vehicle down the
+ * link (or out of the network). The replay crosses one vehicle at a time,
+ * so there are no quadrants to arbitrate between vehicles.
+ *
+ * Vehicles bound for an intersection wait in its inbound buffer until the
+ * window they arrive in starts; they are then sorted, given a movement and
+ * lane from that intersection's own stream and added to its replay. A link
+ * counts entries (upstream) and departures (downstream) separately during
+ * a window and folds them into its occupancy at the end, so within a
+ * window each intersection reads only what the previous window settled.
+ *
+ * Compilation: Include road_network.h, sim_clock.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/road_network.h"
+#include "../include/trafficguru.h"
+#include "../include/sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+
+#define NETWORK_FILE_MAX_BYTES 32768
+#define NETWORK_TURN_LEFT 20            // Default turning weights, no U-turns
+#define NETWORK_TURN_STRAIGHT 60
+#define NETWORK_TURN_RIGHT 20
+
+static const char movement_letters[NUM_MOVEMENTS] = {'L', 'S', 'R', 'U'};
+
+static const struct {
+    const char* name;
+    SchedulingAlgorithm algorithm;
+} policy_names[] = {
+    {"sjf", SJF}, {"multilevel", MULTILEVEL_FEEDBACK}, {"priority", PRIORITY_ROUND_ROBIN}
+};
+
+typedef struct {
+    ReplayVehicle vehicle;              // Lane and movement are chosen on admission
+    int approach;
+} PendingArrival;
+
+typedef struct {
+    PendingArrival* items;
+    int count;
+    int capacity;
+} ArrivalBuffer;
+
+typedef struct {
+    int occupancy;                      // As settled at the end of the last window
+    int entered;                        // This window, by the upstream intersection
+    int left;                           // This window, by the downstream intersection
+    int peak;
+    long long vehicles;
+    long long full_ns;
+} LinkState;
+
+typedef struct NetworkRun NetworkRun;
+
+typedef struct {
+    NetworkRun* run;
+    ReplayIntersection* replay;
+    ArrivalBuffer inbound;
+    unsigned int route_seed;
+    int link_out[MAX_APPROACHES];       // Link leaving by each approach, -1 if none
+    unsigned char turn_cumulative[MAX_APPROACHES][NUM_MOVEMENTS];   // Percent, ends at 100
+    SchedulingAlgorithm algorithm;
+    ComparisonRunResult result;
+} IntersectionRun;
+
+typedef struct {
+    long long next_ns;
+    unsigned int seed;
+} SourceRun;
+
+struct NetworkRun {
+    const RoadNetwork* network;
+    const IntersectionGeometry* geometry;
+    IntersectionRun* intersections;
+    LinkState* links;
+    SourceRun* sources;
+    unsigned char movement_lanes[MAX_APPROACHES][NUM_MOVEMENTS][MAX_LANES];
+    unsigned char movement_lane_count[MAX_APPROACHES][NUM_MOVEMENTS];
+    long long entered;
+    long long exited;
+    LatencyHistogram journey_ms;
+    bool out_of_memory;
+};
+
+static int find_intersection(const RoadNetwork* network, const char* name) {
+    for (int i = 0; i < network->num_intersections; i++) {
+        if (strcmp(network->intersections[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int find_approach(const IntersectionGeometry* geometry, const char* name) {
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        if (strcmp(geometry->approaches[a].name, name) == 0) {
+            return a;
+        }
+    }
+    return -1;
+}
+
+// "<intersection> <approach>" into indices; false (and a message) if either
+// is missing or unknown
+static bool parse_place(const RoadNetwork* network, const IntersectionGeometry* geometry,
+                        char** save, int* intersection, int* approach, const char* usage,
+                        const char* source, int line_number) {
+    char* node = strtok_r(NULL, " \t\r", save);
+    char* leg = strtok_r(NULL, " \t\r", save);
+    if (!node || !leg) {
+        printf("%s:%d: expected: %s\n", source, line_number, usage);
+        return false;
+    }
+
+    *intersection = find_intersection(network, node);
+    if (*intersection < 0) {
+        printf("%s:%d: intersection %s is not declared\n", source, line_number, node);
+        return false;
+    }
+    *approach = find_approach(geometry, leg);
+    if (*approach < 0) {
+        printf("%s:%d: geometry %s has no approach %s\n", source, line_number, geometry->name, leg);
+        return false;
+    }
+    return true;
+}
+
+static bool parse_intersection(RoadNetwork* network, char** save, const char* source,
+                               int line_number) {
+    char* name = strtok_r(NULL, " \t\r", save);
+    char* policy = strtok_r(NULL, " \t\r", save);
+    if (!name || strlen(name) >= NETWORK_NAME_LENGTH) {
+        printf("%s:%d: expected: intersection <name> [sjf|multilevel|priority]\n", source,
+               line_number);
+        return false;
+    }
+    if (find_intersection(network, name) >= 0) {
+        printf("%s:%d: intersection %s declared twice\n", source, line_number, name);
+        return false;
+    }
+    if (network->num_intersections == NETWORK_MAX_INTERSECTIONS) {
+        printf("%s:%d: more than %d intersections\n", source, line_number, NETWORK_MAX_INTERSECTIONS);
+        return false;
+    }
+
+    NetworkIntersection* intersection = &network->intersections[network->num_intersections];
+    snprintf(intersection->name, sizeof(intersection->name), "%s", name);
+    intersection->algorithm = -1;
+    if (policy) {
+        for (size_t i = 0; i < sizeof(policy_names) / sizeof(policy_names[0]); i++) {
+            if (strcmp(policy, policy_names[i].name) == 0) {
+                intersection->algorithm = policy_names[i].algorithm;
+            }
+        }
+        if (intersection->algorithm < 0) {
+            printf("%s:%d: unknown policy %s\n", source, line_number, policy);
+            return false;
+        }
+    }
+    for (int a = 0; a < MAX_APPROACHES; a++) {
+        intersection->turn_weight[a][MOVEMENT_LEFT] = NETWORK_TURN_LEFT;
+        intersection->turn_weight[a][MOVEMENT_STRAIGHT] = NETWORK_TURN_STRAIGHT;
+        intersection->turn_weight[a][MOVEMENT_RIGHT] = NETWORK_TURN_RIGHT;
+        intersection->turn_weight[a][MOVEMENT_U_TURN] = 0.0f;
+    }
+    network->num_intersections++;
+    return true;
+}
+
+static bool parse_link(RoadNetwork* network, const IntersectionGeometry* geometry, char** save,
+                       const char* source, int line_number) {
+    static const char* usage = "link <from> <approach> <to> <approach> <travel s> <storage veh>";
+    NetworkLink link;
+    if (!parse_place(network, geometry, save, &link.from, &link.exit_approach, usage, source,
+                     line_number) ||
+        !parse_place(network, geometry, save, &link.to, &link.entry_approach, usage, source,
+                     line_number)) {
+        return false;
+    }
+    char* travel = strtok_r(NULL, " \t\r", save);
+    char* storage = strtok_r(NULL, " \t\r", save);
+    if (!travel || !storage) {
+        printf("%s:%d: expected: %s\n", source, line_number, usage);
+        return false;
+    }
+    link.travel_seconds = atoi(travel);
+    link.storage = atoi(storage);
+    if (link.travel_seconds < 1 || link.storage < 1) {
+        printf("%s:%d: travel time and storage must be at least 1\n", source, line_number);
+        return false;
+    }
+    if (network->num_links == NETWORK_MAX_LINKS) {
+        printf("%s:%d: more than %d links\n", source, line_number, NETWORK_MAX_LINKS);
+        return false;
+    }
+
+    for (int i = 0; i < network->num_links; i++) {
+        const NetworkLink* other = &network->links[i];
+        if (other->from == link.from && other->exit_approach == link.exit_approach) {
+            printf("%s:%d: %s already has a link leaving by %s\n", source, line_number,
+                   network->intersections[link.from].name,
+                   geometry->approaches[link.exit_approach].name);
+            return false;
+        }
+        if (other->to == link.to && other->entry_approach == link.entry_approach) {
+            printf("%s:%d: %s already has a link arriving on %s\n", source, line_number,
+                   network->intersections[link.to].name,
+                   geometry->approaches[link.entry_approach].name);
+            return false;
+        }
+    }
+
+    network->links[network->num_links++] = link;
+    return true;
+}
+
+static bool parse_source(RoadNetwork* network, const IntersectionGeometry* geometry, char** save,
+                         const char* source, int line_number) {
+    static const char* usage = "source <intersection> <approach> <veh/h>";
+    NetworkSource entry;
+    if (!parse_place(network, geometry, save, &entry.intersection, &entry.approach, usage, source,
+                     line_number)) {
+        return false;
+    }
+    char* rate = strtok_r(NULL, " \t\r", save);
+    if (!rate) {
+        printf("%s:%d: expected: %s\n", source, line_number, usage);
+        return false;
+    }
+    entry.vehicles_per_hour = strtof(rate, NULL);
+    if (entry.vehicles_per_hour <= 0) {
+        printf("%s:%d: source rate must be positive\n", source, line_number);
+        return false;
+    }
+    if (network->num_sources == NETWORK_MAX_SOURCES) {
+        printf("%s:%d: more than %d sources\n", source, line_number, NETWORK_MAX_SOURCES);
+        return false;
+    }
+
+    network->sources[network->num_sources++] = entry;
+    return true;
+}
+
+static bool parse_turns(RoadNetwork* network, const IntersectionGeometry* geometry, char** save,
+                        const char* source, int line_number) {
+    char* node = strtok_r(NULL, " \t\r", save);
+    char* leg = strtok_r(NULL, " \t\r", save);
+    int intersection = node ? find_intersection(network, node) : -1;
+    int approach = leg && strcmp(leg, "*") != 0 ? find_approach(geometry, leg) : -1;
+    if (intersection < 0 || !leg || (approach < 0 && strcmp(leg, "*") != 0)) {
+        printf("%s:%d: expected: turns <declared intersection> <approach|*> <L|S|R|U> <weight> ...\n",
+               source, line_number);
+        return false;
+    }
+
+    float weight[NUM_MOVEMENTS] = {0};
+    char* letter;
+    while ((letter = strtok_r(NULL, " \t\r", save)) != NULL) {
+        char* weight_text = strtok_r(NULL, " \t\r", save);
+        int movement = -1;
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            if (strlen(letter) == 1 && toupper((unsigned char)letter[0]) == movement_letters[m]) {
+                movement = m;
+            }
+        }
+        char* end = NULL;
+        float value = weight_text ? strtof(weight_text, &end) : -1.0f;
+        if (movement < 0 || !weight_text || *end != '\0' || value < 0) {
+            printf("%s:%d: expected <L|S|R|U> <weight> pairs\n", source, line_number);
+            return false;
+        }
+        weight[movement] = value;
+    }
+
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        if (approach < 0 || a == approach) {
+            memcpy(network->intersections[intersection].turn_weight[a], weight, sizeof(weight));
+        }
+    }
+    return true;
+}
+
+static bool parse_network_line(RoadNetwork* network, const IntersectionGeometry* geometry,
+                               char* line, const char* source, int line_number) {
+    char* save = NULL;
+    char* keyword = strtok_r(line, " \t\r", &save);
+
+    if (strcmp(keyword, "intersection") == 0) {
+        return parse_intersection(network, &save, source, line_number);
+    }
+    if (strcmp(keyword, "link") == 0) {
+        return parse_link(network, geometry, &save, source, line_number);
+    }
+    if (strcmp(keyword, "source") == 0) {
+        return parse_source(network, geometry, &save, source, line_number);
+    }
+    if (strcmp(keyword, "turns") == 0) {
+        return parse_turns(network, geometry, &save, source, line_number);
+    }
+
+    printf("%s:%d: unknown directive %s\n", source, line_number, keyword);
+    return false;
+}
+
+// Weight of the movements an approach's lanes carry
+static float routable_weight(const IntersectionGeometry* geometry, int approach,
+                             const float weight[NUM_MOVEMENTS], int movement) {
+    const GeometryApproach* leg = &geometry->approaches[approach];
+    for (int l = leg->first_lane; l < leg->first_lane + leg->num_lanes; l++) {
+        if (geometry->lanes[l].movements & (1 << movement)) {
+            return weight[movement];
+        }
+    }
+    return 0.0f;
+}
+
+// Every approach that receives traffic must leave vehicles a movement to take
+static bool check_network_turns(const RoadNetwork* network, const IntersectionGeometry* geometry) {
+    for (int i = 0; i < network->num_links + network->num_sources; i++) {
+        int intersection = i < network->num_links ? network->links[i].to
+                                                  : network->sources[i - network->num_links].intersection;
+        int approach = i < network->num_links ? network->links[i].entry_approach
+                                              : network->sources[i - network->num_links].approach;
+        const NetworkIntersection* node = &network->intersections[intersection];
+
+        float total = 0.0f;
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            total += routable_weight(geometry, approach, node->turn_weight[approach], m);
+        }
+        if (total <= 0.0f) {
+            printf("%s: vehicles reach %s %s but can take none of its movements\n", network->name,
+                   node->name, geometry->approaches[approach].name);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Parse a network file against the geometry every intersection shares
+bool load_road_network(RoadNetwork* network, const char* path, const IntersectionGeometry* geometry) {
+    if (!network || !path || !geometry) {
+        return false;
+    }
+
+    static char text[NETWORK_FILE_MAX_BYTES];
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("Cannot open network %s\n", path);
+        return false;
+    }
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    bool truncated = !feof(file);
+    fclose(file);
+    if (truncated) {
+        printf("%s: network file larger than %d bytes\n", path, NETWORK_FILE_MAX_BYTES - 1);
+        return false;
+    }
+    text[length] = '\0';
+
+    memset(network, 0, sizeof(RoadNetwork));
+    snprintf(network->name, sizeof(network->name), "%s", path);
+
+    int line_number = 0;
+    char* save = NULL;
+    for (char* line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        if (strspn(line, " \t\r") == strlen(line)) {
+            continue;
+        }
+        if (!parse_network_line(network, geometry, line, path, line_number)) {
+            return false;
+        }
+    }
+
+    if (network->num_sources == 0) {
+        printf("%s: no source lines\n", path);
+        return false;
+    }
+    return check_network_turns(network, geometry);
+}
+
+void init_road_network_config(RoadNetworkConfig* config) {
+    if (!config) {
+        return;
+    }
+
+    memset(config, 0, sizeof(*config));
+    config->algorithm = SJF;
+    init_algorithm_comparison_config(&config->run);
+}
+
+static bool push_arrival(NetworkRun* run, ArrivalBuffer* buffer, const PendingArrival* arrival) {
+    if (buffer->count == buffer->capacity) {
+        int capacity = buffer->capacity ? buffer->capacity * 2 : 256;
+        PendingArrival* grown = realloc(buffer->items, (size_t)capacity * sizeof(PendingArrival));
+        if (!grown) {
+            run->out_of_memory = true;
+            return false;
+        }
+        buffer->items = grown;
+        buffer->capacity = capacity;
+    }
+    buffer->items[buffer->count++] = *arrival;
+    return true;
+}
+
+// The link a vehicle turns into, -1 if it leaves the network
+static int exit_link(const IntersectionRun* node, const ReplayVehicle* vehicle) {
+    const IntersectionGeometry* geometry = node->run->geometry;
+    int approach = geometry->lanes[vehicle->lane_id].approach;
+    int exit = geometry->approaches[approach].exits[vehicle->movement];
+    return exit >= 0 ? node->link_out[exit] : -1;
+}
+
+static bool network_can_depart(void* context, const ReplayVehicle* vehicle) {
+    IntersectionRun* node = (IntersectionRun*)context;
+
+    int link = exit_link(node, vehicle);
+    if (link >= 0) {
+        const LinkState* state = &node->run->links[link];
+        if (state->occupancy + state->entered >= node->run->network->links[link].storage) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void network_depart(void* context, const ReplayVehicle* vehicle, long long now_ns) {
+    IntersectionRun* node = (IntersectionRun*)context;
+    (void)now_ns;
+
+    int link = exit_link(node, vehicle);
+    if (link >= 0) {
+        node->run->links[link].entered++;
+    }
+    if (vehicle->tag >= 0) {
+        node->run->links[vehicle->tag].left++;
+    }
+}
+
+static void network_cleared(void* context, const ReplayVehicle* vehicle, long long now_ns) {
+    IntersectionRun* node = (IntersectionRun*)context;
+    NetworkRun* run = node->run;
+
+    int link = exit_link(node, vehicle);
+    if (link < 0) {
+        run->exited++;
+        histogram_record(&run->journey_ms, (now_ns - vehicle->origin_ns) / NS_PER_MS);
+        return;
+    }
+
+    const NetworkLink* spec = &run->network->links[link];
+    PendingArrival arrival;
+    memset(&arrival, 0, sizeof(arrival));
+    arrival.vehicle.arrival_ns = now_ns + (long long)spec->travel_seconds * NS_PER_SEC;
+    arrival.vehicle.tag = link;
+    arrival.vehicle.vehicle_class = vehicle->vehicle_class;
+    arrival.vehicle.origin_ns = vehicle->origin_ns;
+    arrival.approach = spec->entry_approach;
+    push_arrival(run, &run->intersections[spec->to].inbound, &arrival);
+}
+
+// Source arrivals before 'until_ns' into their intersections' buffers
+static void generate_source_arrivals(NetworkRun* run, long long until_ns) {
+    for (int s = 0; s < run->network->num_sources; s++) {
+        const NetworkSource* spec = &run->network->sources[s];
+        SourceRun* source = &run->sources[s];
+        double rate = spec->vehicles_per_hour / 3600.0;
+
+        while (source->next_ns < until_ns) {
+            PendingArrival arrival;
+            memset(&arrival, 0, sizeof(arrival));
+            arrival.vehicle.arrival_ns = source->next_ns;
+            arrival.vehicle.tag = -1;
+            arrival.vehicle.vehicle_class = pick_vehicle_class(rand_r(&source->seed) % 100);
+            arrival.vehicle.origin_ns = source->next_ns;
+            arrival.approach = spec->approach;
+            if (!push_arrival(run, &run->intersections[spec->intersection].inbound, &arrival)) {
+                return;
+            }
+            run->entered++;
+
+            double uniform = ((double)rand_r(&source->seed) + 1.0) / ((double)RAND_MAX + 2.0);
+            source->next_ns += (long long)(-log(uniform) / rate * NS_PER_SEC);
+        }
+    }
+}
+
+// Fully ordered, so the result does not depend on which upstream pushed first
+static int compare_pending(const void* a, const void* b) {
+    const PendingArrival* left = (const PendingArrival*)a;
+    const PendingArrival* right = (const PendingArrival*)b;
+    if (left->vehicle.arrival_ns != right->vehicle.arrival_ns) {
+        return left->vehicle.arrival_ns < right->vehicle.arrival_ns ? -1 : 1;
+    }
+    if (left->vehicle.origin_ns != right->vehicle.origin_ns) {
+        return left->vehicle.origin_ns < right->vehicle.origin_ns ? -1 : 1;
+    }
+    return (left->vehicle.tag > right->vehicle.tag) - (left->vehicle.tag < right->vehicle.tag);
+}
+
+// Hand the buffered arrivals before 'until_ns' to the replay, in time order,
+// each with a movement and lane drawn from this intersection's stream
+static void admit_inbound(IntersectionRun* node, long long until_ns) {
+    ArrivalBuffer* buffer = &node->inbound;
+    qsort(buffer->items, (size_t)buffer->count, sizeof(PendingArrival), compare_pending);
+
+    int taken = 0;
+    while (taken < buffer->count && buffer->items[taken].vehicle.arrival_ns < until_ns) {
+        PendingArrival* arrival = &buffer->items[taken++];
+        int approach = arrival->approach;
+
+        int roll = rand_r(&node->route_seed) % 100;
+        int movement = 0;
+        while (movement < NUM_MOVEMENTS - 1 && roll >= node->turn_cumulative[approach][movement]) {
+            movement++;
+        }
+        int lanes = node->run->movement_lane_count[approach][movement];
+        arrival->vehicle.movement = (VehicleMovement)movement;
+        arrival->vehicle.lane_id =
+            node->run->movement_lanes[approach][movement][rand_r(&node->route_seed) % lanes];
+
+        if (!add_replay_arrival(node->replay, &arrival->vehicle)) {
+            node->run->out_of_memory = true;
+        }
+    }
+
+    memmove(buffer->items, buffer->items + taken,
+            (size_t)(buffer->count - taken) * sizeof(PendingArrival));
+    buffer->count -= taken;
+}
+
+// Fold the window's entries and departures into each link's occupancy
+static void settle_links(NetworkRun* run, long long window_ns) {
+    for (int l = 0; l < run->network->num_links; l++) {
+        LinkState* link = &run->links[l];
+        link->occupancy += link->entered - link->left;
+        link->vehicles += link->entered;
+        link->entered = 0;
+        link->left = 0;
+        if (link->occupancy > link->peak) {
+            link->peak = link->occupancy;
+        }
+        if (link->occupancy >= run->network->links[l].storage) {
+            link->full_ns += window_ns;
+        }
+    }
+}
+
+// Movement shares per approach, without movements no lane carries
+static void resolve_turns(NetworkRun* run, IntersectionRun* node, const NetworkIntersection* spec) {
+    for (int a = 0; a < run->geometry->num_approaches; a++) {
+        float total = 0.0f;
+        float weight[NUM_MOVEMENTS];
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            weight[m] = routable_weight(run->geometry, a, spec->turn_weight[a], m);
+            total += weight[m];
+        }
+        if (total <= 0.0f) {
+            continue;                   // Nothing arrives here (checked on load)
+        }
+
+        float running = 0.0f;
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            running += weight[m];
+            node->turn_cumulative[a][m] = (unsigned char)(100.0f * running / total + 0.5f);
+        }
+        node->turn_cumulative[a][NUM_MOVEMENTS - 1] = 100;
+    }
+}
+
+static bool setup_network_run(NetworkRun* run, const RoadNetwork* network,
+                              const RoadNetworkConfig* config) {
+    const IntersectionGeometry* geometry = run->geometry;
+
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        const GeometryApproach* approach = &geometry->approaches[a];
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            for (int l = approach->first_lane; l < approach->first_lane + approach->num_lanes; l++) {
+                if (geometry->lanes[l].movements & (1 << m)) {
+                    run->movement_lanes[a][m][run->movement_lane_count[a][m]++] = (unsigned char)l;
+                }
+            }
+        }
+    }
+
+    for (int s = 0; s < network->num_sources; s++) {
+        run->sources[s].seed = (config->run.base_seed + (unsigned int)s * 104729u) ^ 0xc2b2ae35u;
+        double uniform = ((double)rand_r(&run->sources[s].seed) + 1.0) / ((double)RAND_MAX + 2.0);
+        run->sources[s].next_ns =
+            (long long)(-log(uniform) * 3600.0 / network->sources[s].vehicles_per_hour * NS_PER_SEC);
+    }
+
+    for (int i = 0; i < network->num_intersections; i++) {
+        const NetworkIntersection* spec = &network->intersections[i];
+        IntersectionRun* node = &run->intersections[i];
+        unsigned int seed = config->run.base_seed + (unsigned int)i * 7919u;
+
+        for (int a = 0; a < MAX_APPROACHES; a++) {
+            node->link_out[a] = -1;
+        }
+        for (int l = 0; l < network->num_links; l++) {
+            if (network->links[l].from == i) {
+                node->link_out[network->links[l].exit_approach] = l;
+            }
+        }
+
+        node->run = run;
+        node->route_seed = seed ^ 0x85ebca6bu;
+        node->algorithm = spec->algorithm >= 0 ? (SchedulingAlgorithm)spec->algorithm : config->algorithm;
+        resolve_turns(run, node, spec);
+
+        ReplayHooks hooks = {network_can_depart, network_depart, network_cleared, node};
+        node->replay = create_replay_intersection(&config->run, node->algorithm,
+                                                  seed ^ 0x9e3779b9u, &hooks);
+        if (!node->replay) {
+            printf("Out of memory for intersection %s\n", spec->name);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_network_report(const NetworkRun* run, const RoadNetworkConfig* config,
+                                 long long window_ns, double seconds) {
+    const RoadNetwork* network = run->network;
+
+    printf("Completed in %.2f s\n\n", seconds);
+    printf("%-16s %-26s %8s %8s %9s %9s %6s %7s %9s\n", "Intersection", "Policy", "Arrived",
+           "Veh/min", "Avg wait", "p95 wait", "Util", "Queued", "Spillback");
+    for (int i = 0; i < network->num_intersections; i++) {
+        const IntersectionRun* node = &run->intersections[i];
+        const ComparisonRunResult* result = &node->result;
+        printf("%-16s %-26s %8d %8.2f %8.1fs %8.1fs %5.0f%% %7d %9.0f\n",
+               network->intersections[i].name, get_algorithm_name(node->algorithm),
+               result->vehicles_arrived, result->vehicles_per_minute, result->avg_wait_time,
+               result->p95_wait_time, result->utilization * 100.0, result->vehicles_left_queued,
+               result->spillback_vehicles);
+    }
+
+    if (network->num_links > 0) {
+        printf("\n%-36s %7s %8s %9s %5s %6s\n", "Link", "Travel", "Storage", "Vehicles", "Peak",
+               "Full");
+        for (int l = 0; l < network->num_links; l++) {
+            const NetworkLink* spec = &network->links[l];
+            const LinkState* link = &run->links[l];
+            char name[4 * NETWORK_NAME_LENGTH + 8];
+            snprintf(name, sizeof(name), "%s %s -> %s %s", network->intersections[spec->from].name,
+                     run->geometry->approaches[spec->exit_approach].name,
+                     network->intersections[spec->to].name,
+                     run->geometry->approaches[spec->entry_approach].name);
+            printf("%-36s %6ds %8d %9lld %5d %5.1f%%\n", name, spec->travel_seconds, spec->storage,
+                   link->vehicles, link->peak,
+                   100.0 * link->full_ns / ((long long)config->run.duration_seconds * NS_PER_SEC));
+        }
+    }
+
+    printf("\nVehicles: %lld entered, %lld left, %lld still in the network\n", run->entered,
+           run->exited, run->entered - run->exited);
+    if (histogram_count(&run->journey_ms) > 0) {
+        printf("Journey time: mean %.1f s, p95 %.1f s, max %.1f s\n",
+               histogram_mean(&run->journey_ms) / 1000.0,
+               histogram_percentile(&run->journey_ms, 95.0) / 1000.0,
+               histogram_max(&run->journey_ms) / 1000.0);
+    }
+    if (network->num_links > 0) {
+        printf("Replayed in windows of %.1f s, the shortest link travel time\n",
+               (double)window_ns / NS_PER_SEC);
+    }
+}
+
+// Replay the whole network for config->run.duration_seconds and report
+int run_road_network(const RoadNetwork* network, const RoadNetworkConfig* config) {
+    if (!network || !config || network->num_intersections == 0) {
+        return -1;
+    }
+
+    NetworkRun run;
+    memset(&run, 0, sizeof(run));
+    run.network = network;
+    run.geometry = get_intersection_geometry();
+    init_latency_histogram(&run.journey_ms);
+    run.intersections = calloc((size_t)network->num_intersections, sizeof(IntersectionRun));
+    run.links = calloc((size_t)network->num_links + 1, sizeof(LinkState));
+    run.sources = calloc((size_t)network->num_sources + 1, sizeof(SourceRun));
+    if (!run.intersections || !run.links || !run.sources) {
+        printf("Out of memory for the network\n");
+        free(run.intersections);
+        free(run.links);
+        free(run.sources);
+        return -1;
+    }
+
+    int result = -1;
+    long long end_ns = (long long)config->run.duration_seconds * NS_PER_SEC;
+    long long window_ns = end_ns;
+    for (int l = 0; l < network->num_links; l++) {
+        long long travel_ns = (long long)network->links[l].travel_seconds * NS_PER_SEC;
+        window_ns = travel_ns < window_ns ? travel_ns : window_ns;
+    }
+
+    printf("=== ROAD NETWORK ===\n");
+    printf("Network: %s, %d intersections, %d links, %d sources on geometry %s\n", network->name,
+           network->num_intersections, network->num_links, network->num_sources,
+           run.geometry->name);
+    printf("Virtual time: %d s, base seed %u\n", config->run.duration_seconds, config->run.base_seed);
+
+    if (setup_network_run(&run, network, config)) {
+        long long start_ns = monotonic_now_ns();
+        for (long long window_start = 0; window_start < end_ns && !run.out_of_memory;
+             window_start += window_ns) {
+            long long window_end = window_start + window_ns < end_ns ? window_start + window_ns : end_ns;
+            generate_source_arrivals(&run, window_end);
+            for (int i = 0; i < network->num_intersections; i++) {
+                admit_inbound(&run.intersections[i], window_end);
+            }
+            for (int i = 0; i < network->num_intersections; i++) {
+                advance_replay_intersection(run.intersections[i].replay, window_end);
+            }
+            settle_links(&run, window_end - window_start);
+        }
+
+        if (run.out_of_memory) {
+            printf("Out of memory during the network run\n");
+        } else {
+            for (int i = 0; i < network->num_intersections; i++) {
+                finish_replay_intersection(run.intersections[i].replay, &run.intersections[i].result);
+            }
+            print_network_report(&run, config, window_ns,
+                                 (double)(monotonic_now_ns() - start_ns) / NS_PER_SEC);
+            result = 0;
+        }
+    }
+    printf("====================\n");
+
+    for (int i = 0; i < network->num_intersections; i++) {
+        IntersectionRun* node = &run.intersections[i];
+        if (node->replay) {
+            destroy_replay_intersection(node->replay);
+        }
+        free(node->inbound.items);
+    }
+    free(run.intersections);
+    free(run.links);
+    free(run.sources);
+    return result;
+}
@@ -0,0 +1,276 @@
+/*
+ * Run Arena Implementation - Bump Allocation Over Retained Blocks
+ *
+ * Blocks are only ever added, never freed, until the arena is destroyed.
+ * A reset rewinds every block and carving restarts from the oldest, so a
+ * run that needs no more memory than the previous one allocates nothing.
+ * A request larger than the block size gets a block of its own.
+ *
+ * Compilation: Include run_arena.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/run_arena.h"
+#include <stdlib.h>
+#include <string.h>
+
+static long long g_heap_allocations = 0;
+static long long g_heap_bytes = 0;
+static long long g_steady_mark = 0;
+
+// Counted malloc for everything the arenas and pools obtain from the heap
+static void* counted_alloc(size_t size) {
+    void* memory = NULL;
+    if (posix_memalign(&memory, RUN_ARENA_ALIGNMENT, size) != 0) {
+        return NULL;
+    }
+    __atomic_fetch_add(&g_heap_allocations, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&g_heap_bytes, (long long)size, __ATOMIC_RELAXED);
+    return memory;
+}
+
+static size_t align_up(size_t size) {
+    return (size + RUN_ARENA_ALIGNMENT - 1) & ~(size_t)(RUN_ARENA_ALIGNMENT - 1);
+}
+
+// Header is padded so the first object in a block is aligned too
+static const size_t block_header_size = (sizeof(ArenaBlock) + RUN_ARENA_ALIGNMENT - 1) &
+                                        ~(size_t)(RUN_ARENA_ALIGNMENT - 1);
+
+RunArena* create_run_arena(size_t block_size) {
+    RunArena* arena = (RunArena*)malloc(sizeof(RunArena));
+    if (!arena) {
+        return NULL;
+    }
+
+    memset(arena, 0, sizeof(RunArena));
+    arena->block_size = block_size > 0 ? align_up(block_size) : RUN_ARENA_DEFAULT_BLOCK;
+    pthread_mutex_init(&arena->lock, NULL);
+    return arena;
+}
+
+// Release every block; memory handed out by the arena is invalid afterwards
+void destroy_run_arena(RunArena* arena) {
+    if (!arena) {
+        return;
+    }
+
+    ArenaBlock* block = arena->blocks;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    pthread_mutex_destroy(&arena->lock);
+    free(arena);
+}
+
+// Rewind for the next run, keeping every block
+void reset_run_arena(RunArena* arena) {
+    if (!arena) {
+        return;
+    }
+
+    pthread_mutex_lock(&arena->lock);
+    ArenaBlock* oldest = NULL;
+    for (ArenaBlock* block = arena->blocks; block; block = block->next) {
+        block->used = 0;
+        oldest = block;
+    }
+    arena->current = oldest;
+    arena->bytes_used = 0;
+    pthread_mutex_unlock(&arena->lock);
+}
+
+// Blocks are listed newest first; carving moves from the oldest towards it
+static ArenaBlock* next_block_after(RunArena* arena, ArenaBlock* block) {
+    ArenaBlock* newer = NULL;
+    for (ArenaBlock* b = arena->blocks; b && b != block; b = b->next) {
+        newer = b;
+    }
+    return newer;
+}
+
+// Zeroed, RUN_ARENA_ALIGNMENT-aligned memory that lives until reset/destroy
+void* arena_alloc(RunArena* arena, size_t size) {
+    if (!arena || size == 0) {
+        return NULL;
+    }
+
+    size = align_up(size);
+    pthread_mutex_lock(&arena->lock);
+
+    // Use the current block, or a retained one further on that fits
+    ArenaBlock* block = arena->current;
+    while (block && block->size - block->used < size) {
+        block = next_block_after(arena, block);
+    }
+
+    if (!block) {
+        size_t block_size = size > arena->block_size ? size : arena->block_size;
+        block = (ArenaBlock*)counted_alloc(block_header_size + block_size);
+        if (!block) {
+            pthread_mutex_unlock(&arena->lock);
+            return NULL;
+        }
+        block->size = block_size;
+        block->used = 0;
+        block->next = arena->blocks;
+        arena->blocks = block;
+        arena->bytes_reserved += block_size;
+        arena->block_allocations++;
+    }
+
+    void* memory = (char*)block + block_header_size + block->used;
+    block->used += size;
+    arena->current = block;
+    arena->bytes_used += size;
+    if (arena->bytes_used > arena->peak_bytes_used) {
+        arena->peak_bytes_used = arena->bytes_used;
+    }
+
+    pthread_mutex_unlock(&arena->lock);
+
+    memset(memory, 0, size);
+    return memory;
+}
+
+// New object for the pool (caller holds pool->lock)
+static void* create_pool_object(ObjectPool* pool) {
+    void* object = pool->arena ? arena_alloc(pool->arena, pool->object_size)
+                               : counted_alloc(pool->object_size);
+    if (object) {
+        pool->allocated++;
+    }
+    return object;
+}
+
+// Pool of max_objects objects of object_size bytes, 'preallocate' of them
+// created now. Objects must be at least pointer-sized.
+bool init_object_pool(ObjectPool* pool, RunArena* arena, size_t object_size,
+                      int max_objects, int preallocate) {
+    if (!pool || object_size < sizeof(void*) || max_objects < 0) {
+        return false;
+    }
+
+    memset(pool, 0, sizeof(ObjectPool));
+    pool->arena = arena;
+    pool->object_size = object_size;
+    pool->max_objects = max_objects;
+    pthread_mutex_init(&pool->lock, NULL);
+
+    return reserve_object_pool(pool, preallocate);
+}
+
+// Create objects up front until 'objects' exist (at most max_objects)
+bool reserve_object_pool(ObjectPool* pool, int objects) {
+    if (!pool) {
+        return false;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    if (objects > pool->max_objects) {
+        objects = pool->max_objects;
+    }
+    bool reserved = true;
+    while (pool->allocated < objects) {
+        void* object = create_pool_object(pool);
+        if (!object) {
+            reserved = false;
+            break;
+        }
+        *(void**)object = pool->free_list;
+        pool->free_list = object;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return reserved;
+}
+
+// Free idle heap objects; objects still taken must have been given back.
+// Arena objects go with their arena.
+void destroy_object_pool(ObjectPool* pool) {
+    if (!pool) {
+        return;
+    }
+
+    if (!pool->arena) {
+        while (pool->free_list) {
+            void* object = pool->free_list;
+            pool->free_list = *(void**)object;
+            free(object);
+        }
+    }
+    pool->free_list = NULL;
+    pthread_mutex_destroy(&pool->lock);
+}
+
+// Take an object (contents undefined); NULL once max_objects are in use
+void* object_pool_take(ObjectPool* pool) {
+    if (!pool) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    void* object = NULL;
+    if (pool->in_use < pool->max_objects) {
+        if (pool->free_list) {
+            object = pool->free_list;
+            pool->free_list = *(void**)object;
+        } else {
+            object = create_pool_object(pool);
+        }
+    }
+
+    if (object) {
+        pool->in_use++;
+        if (pool->in_use > pool->peak_in_use) {
+            pool->peak_in_use = pool->in_use;
+        }
+    } else {
+        pool->exhausted_count++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    return object;
+}
+
+void object_pool_give(ObjectPool* pool, void* object) {
+    if (!pool || !object) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    *(void**)object = pool->free_list;
+    pool->free_list = object;
+    pool->in_use--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Change the cap; objects already taken above it are kept
+void set_object_pool_limit(ObjectPool* pool, int max_objects) {
+    if (!pool || max_objects < 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->max_objects = max_objects;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// Start-up is over: later heap allocations count as steady-state traffic
+void mark_run_allocations_steady() {
+    __atomic_store_n(&g_steady_mark, __atomic_load_n(&g_heap_allocations, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+}
+
+void get_run_allocation_stats(RunAllocationStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    stats->heap_allocations = __atomic_load_n(&g_heap_allocations, __ATOMIC_RELAXED);
+    stats->heap_bytes = __atomic_load_n(&g_heap_bytes, __ATOMIC_RELAXED);
+    stats->steady_heap_allocations =
+        stats->heap_allocations - __atomic_load_n(&g_steady_mark, __ATOMIC_RELAXED);
+}
@@ -6,6 +6,11 @@
  * 2. Multilevel Feedback Queue
  * 3. Priority Round Robin
  *
+ * Emergency preemption bypasses the active algorithm: a pending request
+ * triggers all-red clearance and then a held green for the emergency lane.
+ * A planned pre-clear switches to the emergency lane at a slice boundary
+ * instead, early enough to drain its queue before the vehicle arrives.
+ *
  * Compilation: Include scheduler.h, lane_process.h, trafficguru.h
  */
 
@@ -14,11 +19,14 @@
 #include "../include/lane_process.h"
 #include "../include/trafficguru.h"
 #include "../include/performance_metrics.h"
+#include "../include/sim_clock.h"
+#include "../include/vehicle_trace.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <time.h>
+#include <errno.h>
 
 static const char* algorithm_names[] = {
     "Shortest Job First",
@@ -26,7 +34,14 @@ static const char* algorithm_names[] = {
     "Priority Round Robin"
 };
 
-bool validate_single_lane_running(LaneProcess lanes[4]);
+bool validate_single_lane_running(LaneProcess* lanes, int num_lanes);
+
+static bool scheduler_timed_wait(Scheduler* scheduler, long long duration_ns, bool interruptible);
+static void stop_running_lane(LaneProcess* lane);
+static int perform_emergency_preemption(Scheduler* scheduler, LaneProcess* lanes);
+static int start_emergency_preclear(Scheduler* scheduler, LaneProcess* lanes);
+static void record_emergency_green(Scheduler* scheduler, int lane_id, bool preclear);
+static bool is_preclear_overdue(Scheduler* scheduler, long long now_ns);
 
 // Initialize scheduler
 void init_scheduler(Scheduler* scheduler, SchedulingAlgorithm algorithm) {
@@ -42,9 +57,21 @@ void init_scheduler(Scheduler* scheduler, SchedulingAlgorithm algorithm) {
     scheduler->execution_history = NULL;
     scheduler->history_size = 1000; // Keep last 1000 execution records
     scheduler->history_index = 0;
+    scheduler->gantt = create_gantt_history();
     scheduler->total_context_switches = 0;
     scheduler->last_schedule_time = time(NULL);
     scheduler->scheduler_running = false;
+    scheduler->preempt_pending = false;
+    scheduler->preclear_pending = false;
+    scheduler->preempt_lane = -1;
+    scheduler->preempt_detected_ns = 0;
+    scheduler->preempt_arrival_ns = 0;
+    scheduler->emergency_green_lane = -1;
+    scheduler->emergency_green_ns = 0;
+    scheduler->all_red_clearance_ms = ALL_RED_CLEARANCE_MS;
+    scheduler->total_preemptions = 0;
+    scheduler->total_preclears = 0;
+    init_latency_histogram(&scheduler->decision_latency_ns);
 
     // Allocate execution history buffer
     scheduler->execution_history = (ExecutionRecord*)malloc(
@@ -53,9 +80,13 @@ void init_scheduler(Scheduler* scheduler, SchedulingAlgorithm algorithm) {
         scheduler->history_size = 0;
     }
 
-    // Initialize synchronization primitives
+    // Initialize synchronization primitives; timed waits use the monotonic clock
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
     pthread_mutex_init(&scheduler->scheduler_lock, NULL);
-    pthread_cond_init(&scheduler->scheduler_cond, NULL);
+    pthread_cond_init(&scheduler->scheduler_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
 }
 
 // Destroy scheduler and cleanup resources
@@ -74,6 +105,9 @@ void destroy_scheduler(Scheduler* scheduler) {
         scheduler->execution_history = NULL;
     }
 
+    destroy_gantt_history(scheduler->gantt);
+    scheduler->gantt = NULL;
+
     pthread_mutex_destroy(&scheduler->scheduler_lock);
     pthread_cond_destroy(&scheduler->scheduler_cond);
 }
@@ -99,12 +133,253 @@ void stop_scheduler(Scheduler* scheduler) {
 
     pthread_mutex_lock(&scheduler->scheduler_lock);
     scheduler->scheduler_running = false;
-    pthread_cond_signal(&scheduler->scheduler_cond);
+    pthread_cond_broadcast(&scheduler->scheduler_cond); // Cut short any timed wait
+    pthread_mutex_unlock(&scheduler->scheduler_lock);
+}
+
+// Ask the scheduler to give green to an emergency lane as soon as possible
+void request_emergency_preemption(Scheduler* scheduler, int lane_id,
+                                  long long detected_ns, long long arrival_ns) {
+    if (!scheduler || lane_id < 0 || lane_id >= get_num_lanes()) {
+        return;
+    }
+
+    long long now_ns = monotonic_now_ns();
+
+    pthread_mutex_lock(&scheduler->scheduler_lock);
+    scheduler->preempt_pending = true;
+    scheduler->preclear_pending = false;
+    scheduler->preempt_lane = lane_id;
+    scheduler->preempt_detected_ns = detected_ns > 0 ? detected_ns : now_ns;
+    scheduler->preempt_arrival_ns = arrival_ns > 0 ? arrival_ns : now_ns;
+    pthread_cond_broadcast(&scheduler->scheduler_cond); // Interrupt crossing / switch
+    pthread_mutex_unlock(&scheduler->scheduler_lock);
+}
+
+// Plan a green for an emergency lane ahead of the vehicle's arrival. Falls
+// back to an immediate preemption (returning false) when the lead time is
+// too short to switch at a slice boundary.
+bool request_emergency_preclear(Scheduler* scheduler, int lane_id,
+                                long long detected_ns, long long arrival_ns) {
+    if (!scheduler || lane_id < 0 || lane_id >= get_num_lanes()) {
+        return false;
+    }
+
+    long long now_ns = monotonic_now_ns();
+    if (arrival_ns - now_ns < (long long)PRECLEAR_SWITCH_MARGIN_MS * NS_PER_MS) {
+        request_emergency_preemption(scheduler, lane_id, detected_ns, arrival_ns);
+        return false;
+    }
+
+    pthread_mutex_lock(&scheduler->scheduler_lock);
+    scheduler->preclear_pending = true;
+    scheduler->preempt_pending = false;
+    scheduler->preempt_lane = lane_id;
+    scheduler->preempt_detected_ns = detected_ns > 0 ? detected_ns : now_ns;
+    scheduler->preempt_arrival_ns = arrival_ns;
+    // No broadcast: the switch happens at the next slice boundary
+    pthread_mutex_unlock(&scheduler->scheduler_lock);
+
+    return true;
+}
+
+// Emergency has cleared: release the held green and resume the algorithm
+void clear_emergency_preemption(Scheduler* scheduler) {
+    if (!scheduler) {
+        return;
+    }
+
+    pthread_mutex_lock(&scheduler->scheduler_lock);
+    scheduler->preempt_pending = false;
+    scheduler->preclear_pending = false;
+    scheduler->emergency_green_lane = -1;
+    pthread_mutex_unlock(&scheduler->scheduler_lock);
+}
+
+bool is_emergency_green_active(Scheduler* scheduler) {
+    if (!scheduler) {
+        return false;
+    }
+
+    pthread_mutex_lock(&scheduler->scheduler_lock);
+    bool active = scheduler->emergency_green_lane >= 0 || scheduler->preempt_pending ||
+                  scheduler->preclear_pending;
+    pthread_mutex_unlock(&scheduler->scheduler_lock);
+
+    return active;
+}
+
+// True once the emergency lane actually has its green (and since when)
+bool is_emergency_green_for_lane(Scheduler* scheduler, int lane_id, long long* green_since_ns) {
+    if (!scheduler) {
+        return false;
+    }
+
+    pthread_mutex_lock(&scheduler->scheduler_lock);
+    bool green = scheduler->emergency_green_lane == lane_id;
+    if (green && green_since_ns) {
+        *green_since_ns = scheduler->emergency_green_ns;
+    }
     pthread_mutex_unlock(&scheduler->scheduler_lock);
+
+    return green;
+}
+
+// A planned pre-clear that still has no green when the vehicle arrives
+static bool is_preclear_overdue(Scheduler* scheduler, long long now_ns) {
+    return scheduler->preclear_pending && now_ns >= scheduler->preempt_arrival_ns;
+}
+
+// Timed wait on scheduler_cond (caller holds scheduler_lock). Returns true if
+// cut short by the scheduler stopping or, when interruptible, by a preemption
+// or by a pre-clear becoming overdue.
+static bool scheduler_timed_wait(Scheduler* scheduler, long long duration_ns, bool interruptible) {
+    long long deadline_ns = monotonic_now_ns() + duration_ns;
+
+    while (scheduler->scheduler_running) {
+        long long wake_ns = deadline_ns;
+
+        if (interruptible) {
+            if (scheduler->preempt_pending || is_preclear_overdue(scheduler, monotonic_now_ns())) {
+                return true;
+            }
+            if (scheduler->preclear_pending && scheduler->preempt_arrival_ns < wake_ns) {
+                wake_ns = scheduler->preempt_arrival_ns; // Escalation point
+            }
+        }
+
+        struct timespec wake = {
+            .tv_sec = (time_t)(wake_ns / NS_PER_SEC),
+            .tv_nsec = (long)(wake_ns % NS_PER_SEC)
+        };
+        if (pthread_cond_timedwait(&scheduler->scheduler_cond, &scheduler->scheduler_lock,
+                                   &wake) == ETIMEDOUT && wake_ns == deadline_ns) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Sleep for the given time unless an emergency preemption arrives first
+// (caller holds scheduler_lock)
+bool scheduler_wait_unless_preempted(Scheduler* scheduler, long long duration_ns) {
+    if (!scheduler || duration_ns <= 0) {
+        return false;
+    }
+    return scheduler_timed_wait(scheduler, duration_ns, true);
+}
+
+// All-red clearance, then green for the emergency lane (caller holds scheduler_lock)
+static int perform_emergency_preemption(Scheduler* scheduler, LaneProcess* lanes) {
+    int lane_id = scheduler->preempt_lane;
+    scheduler->preempt_pending = false;
+    scheduler->preclear_pending = false;
+
+    // All red: stop whichever lane currently has green
+    if (scheduler->current_lane >= 0) {
+        stop_running_lane(&lanes[scheduler->current_lane]);
+    }
+    scheduler->current_lane = -1;
+
+    // Let vehicles already in the box clear; not cut short by further requests
+    scheduler_timed_wait(scheduler, (long long)scheduler->all_red_clearance_ms * NS_PER_MS, false);
+
+    if (scheduler->preempt_pending || scheduler->preclear_pending) {
+        // A newer request superseded this one during clearance
+        lane_id = scheduler->preempt_lane;
+        scheduler->preempt_pending = false;
+        scheduler->preclear_pending = false;
+    }
+
+    LaneProcess* lane = &lanes[lane_id];
+    pthread_mutex_lock(&lane->queue_lock);
+    lane->state = RUNNING;
+    lane->waiting_time = 0;
+    pthread_cond_signal(&lane->queue_cond);
+    trace_vehicle_event(TRACE_GREEN, -1, lane_id, 1, lane->queue_length);
+    pthread_mutex_unlock(&lane->queue_lock);
+
+    scheduler->current_lane = lane_id;
+    scheduler->total_preemptions++;
+    scheduler->total_context_switches++;
+    update_context_switch_count(&g_traffic_system->metrics);
+    record_emergency_green(scheduler, lane_id, false);
+
+    return lane_id;
+}
+
+// Planned green for the emergency lane at a slice boundary (caller holds
+// scheduler_lock). Returns the lane, or -1 if it is not yet time to switch.
+static int start_emergency_preclear(Scheduler* scheduler, LaneProcess* lanes) {
+    int lane_id = scheduler->preempt_lane;
+    LaneProcess* lane = &lanes[lane_id];
+
+    pthread_mutex_lock(&lane->queue_lock);
+    int queued = lane->queue_length;
+    pthread_mutex_unlock(&lane->queue_lock);
+
+    // Start early enough that the vehicles ahead have crossed by arrival
+    long long drain_ns = (long long)queued * PRECLEAR_SECONDS_PER_VEHICLE * NS_PER_SEC +
+                         (long long)PRECLEAR_SWITCH_MARGIN_MS * NS_PER_MS;
+    if (monotonic_now_ns() < scheduler->preempt_arrival_ns - drain_ns) {
+        return -1;
+    }
+
+    scheduler->preclear_pending = false;
+    scheduler->total_preclears++;
+
+    LOG_INFO("Pre-clearing lane %d: %d vehicles ahead, emergency arrives in %.1fs",
+             lane_id, queued,
+             (double)(scheduler->preempt_arrival_ns - monotonic_now_ns()) / NS_PER_SEC);
+    record_emergency_green(scheduler, lane_id, true);
+
+    // The ordinary context switch in schedule_next_lane() hands over green
+    return lane_id;
+}
+
+// Hold green for the emergency lane and record its latencies
+static void record_emergency_green(Scheduler* scheduler, int lane_id, bool preclear) {
+    long long now_ns = monotonic_now_ns();
+    long long latency_ns = now_ns - scheduler->preempt_detected_ns;
+    long long arrival_delay_ns = now_ns - scheduler->preempt_arrival_ns;
+
+    scheduler->emergency_green_lane = lane_id;
+    scheduler->emergency_green_ns = now_ns;
+    trace_vehicle_event(TRACE_EMERGENCY_GREEN, -1, lane_id, preclear ? 1 : 0,
+                        (int)(latency_ns / NS_PER_MS));
+
+    record_preemption_latency(&g_traffic_system->metrics, latency_ns);
+    record_emergency_arrival_delay(&g_traffic_system->metrics,
+                                   arrival_delay_ns > 0 ? arrival_delay_ns : 0, preclear);
+    LOG_INFO("Emergency green for lane %d (%s), %.3fs after detection",
+             lane_id, preclear ? "pre-clear" : "preemption", (double)latency_ns / NS_PER_SEC);
+}
+
+// Read each lane under its lock into the view the shared policies decide on
+void fill_lane_policy_views(LaneProcess* lanes, int num_lanes, LanePolicyView* views) {
+    long long now_ns = monotonic_now_ns();
+    time_t now = time(NULL);
+
+    for (int i = 0; i < num_lanes; i++) {
+        LaneProcess* lane = &lanes[i];
+        LanePolicyView* view = &views[i];
+
+        pthread_mutex_lock(&lane->queue_lock);
+        view->ready = lane->state == READY && lane->queue_length > 0;
+        view->running = lane->state == RUNNING && lane->queue_length > 0;
+        view->emergency = lane->priority == 1;
+        view->queue_length = lane->queue_length;
+        view->last_arrival_ns = (long long)lane->last_arrival_time * NS_PER_SEC;
+        view->waiting_seconds = view->ready ? (now_ns - lane->ready_since_ns) / NS_PER_SEC : 0;
+        view->idle_seconds = (long long)(now - lane->last_service_time);
+        lane->waiting_time = (int)view->waiting_seconds;
+        pthread_mutex_unlock(&lane->queue_lock);
+    }
 }
 
 // Main scheduling function - delegates to specific algorithm
-int schedule_next_lane(Scheduler* scheduler, LaneProcess lanes[4]) {
+int schedule_next_lane(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -114,24 +389,37 @@ int schedule_next_lane(Scheduler* scheduler, LaneProcess lanes[4]) {
 
     int next_lane = -1;
 
-    // --- Select next lane based on algorithm ---
-    switch (scheduler->algorithm) {
-        case SJF:
-            // Assuming schedule_next_lane_sjf is defined in sjf_scheduler.c
-            next_lane = schedule_next_lane_sjf(scheduler, lanes);
-            break;
-        case MULTILEVEL_FEEDBACK:
-            // Assuming schedule_next_lane_multilevel is defined in multilevel_scheduler.c
-            next_lane = schedule_next_lane_multilevel(scheduler, lanes);
-            break;
-        case PRIORITY_ROUND_ROBIN:
-            // Assuming schedule_next_lane_priority_rr is defined in priority_rr_scheduler.c
-            next_lane = schedule_next_lane_priority_rr(scheduler, lanes);
-            break;
-        default:
-            // Fallback
-            next_lane = schedule_next_lane_sjf(scheduler, lanes);
-            break;
+    // Emergency preemption overrides every algorithm
+    if (scheduler->preempt_pending || is_preclear_overdue(scheduler, monotonic_now_ns())) {
+        next_lane = perform_emergency_preemption(scheduler, lanes);
+    } else if (scheduler->emergency_green_lane >= 0) {
+        next_lane = scheduler->emergency_green_lane; // Hold green until cleared
+    } else if (scheduler->preclear_pending &&
+               (next_lane = start_emergency_preclear(scheduler, lanes)) != -1) {
+        // Planned switch to the emergency lane; context switch below
+    } else {
+        long long decision_start_ns = monotonic_now_ns();
+
+        // --- Select next lane based on algorithm ---
+        switch (scheduler->algorithm) {
+            case SJF:
+                // Assuming schedule_next_lane_sjf is defined in sjf_scheduler.c
+                next_lane = schedule_next_lane_sjf(scheduler, lanes, num_lanes);
+                break;
+            case MULTILEVEL_FEEDBACK:
+                // Assuming schedule_next_lane_multilevel is defined in multilevel_scheduler.c
+                next_lane = schedule_next_lane_multilevel(scheduler, lanes, num_lanes);
+                break;
+            case PRIORITY_ROUND_ROBIN:
+                // Assuming schedule_next_lane_priority_rr is defined in priority_rr_scheduler.c
+                next_lane = schedule_next_lane_priority_rr(scheduler, lanes, num_lanes);
+                break;
+            default:
+                // Fallback
+                next_lane = schedule_next_lane_sjf(scheduler, lanes, num_lanes);
+                break;
+        }
+        histogram_record(&scheduler->decision_latency_ns, monotonic_now_ns() - decision_start_ns);
     }
 
     // --- Perform context switch if needed ---
@@ -142,23 +430,29 @@ int schedule_next_lane(Scheduler* scheduler, LaneProcess lanes[4]) {
                       &lanes[next_lane]);
         scheduler->current_lane = next_lane;
         
-        // --- METRICS FIX ---
-        // We lock global state to update metrics
-        // --- DEADLOCK FIX: Use trylock ---
-        if (pthread_mutex_trylock(&g_traffic_system->global_state_lock) == 0) {
-            update_context_switch_count(&g_traffic_system->metrics);
-            pthread_mutex_unlock(&g_traffic_system->global_state_lock);
-        }
-                
+        // Lock-free shard update; never dropped on contention
+        scheduler->total_context_switches++;
+        update_context_switch_count(&g_traffic_system->metrics);
+
+
         // --- VALIDATION: Ensure only one lane is running ---
         // This verifies mutual exclusion after context switch
-        if (!validate_single_lane_running(lanes)) {
+        if (!validate_single_lane_running(lanes, num_lanes)) {
             // Critical error: Multiple lanes running simultaneously!
             // This should never happen and indicates a synchronization bug
             // In production, you might want to log this error or trigger an alert
         }
         // --- END VALIDATION ---
-        // --- END DEADLOCK FIX ---
+    } else if (next_lane != -1) {
+        // Green never left this lane; if it emptied and refilled meanwhile
+        // it is running again
+        LaneProcess* lane = &lanes[next_lane];
+        pthread_mutex_lock(&lane->queue_lock);
+        if (lane->state == READY) {
+            lane->state = RUNNING;
+            lane->waiting_time = 0;
+        }
+        pthread_mutex_unlock(&lane->queue_lock);
     }
 
     scheduler->last_schedule_time = time(NULL);
@@ -179,53 +473,49 @@ void execute_lane_time_slice(Scheduler* scheduler, LaneProcess* lane, int time_q
 
     time_t start_time = time(NULL);
     int vehicles_processed = 0;
-    int vehicle_id = -1;
-    int wait_time_sec = 0;
+    VehicleRecord vehicle;
 
     // State is already set to RUNNING by context_switch.
     // We do NOT call update_lane_state(lane, RUNNING) here.
 
-    // --- DEADLOCK FIX: Enforce lock order: global -> lane ---
-    // We must lock the global state FIRST, then the lane state.
-    pthread_mutex_lock(&g_traffic_system->global_state_lock);
+    // Only the lane lock is needed here: served-vehicle counters are
+    // recorded into lock-free per-lane shards, not under global_state_lock.
     pthread_mutex_lock(&lane->queue_lock);
     
-    // 1. Get vehicle ID from queue (using unlocked version since we hold the lock)
-    vehicle_id = remove_vehicle_from_lane_unlocked(lane);
-    
-    if (vehicle_id != -1) { // Assuming -1 means empty queue
+    // 1. Take the head vehicle's record (using unlocked version since we hold the lock)
+    if (remove_vehicle_record_from_lane_unlocked(lane, &vehicle)) {
         // We successfully processed one vehicle
         vehicles_processed = 1;
+        lane->last_service_time = time(NULL);
         
-        // 2. Calculate wait time
-        time_t now = time(NULL);
-        if (wait_time_sec < 0) wait_time_sec = 0; // Sanity check
-        // 3. --- FIX: UPDATE RAW METRICS ---
-        // Calculate wait time: use queue waiting time if available, else estimate from last arrival
-        if (lane->waiting_time > 0) {
-            wait_time_sec = lane->waiting_time;  // Use accumulated waiting time
-        } else if (lane->last_arrival_time > 0) {
-            wait_time_sec = (int)(now - lane->last_arrival_time);  // Estimate from last arrival
-        } else {
-            wait_time_sec = lane->queue_length * 2;  // Rough estimate: 2 sec per vehicle in queue
-        }        // We are holding the global_state_lock, so this is safe.
-        g_traffic_system->metrics.total_vehicles_processed++;
-        g_traffic_system->metrics.lane_throughput[lane->lane_id]++;
-        g_traffic_system->metrics.lane_wait_times[lane->lane_id] += (float)wait_time_sec; 
+        // 2. Wait time is exact: the record carries its arrival time
+        long long wait_ns = monotonic_now_ns() - vehicle.arrival_ns;
+        if (wait_ns < 0) wait_ns = 0; // Sanity check
+
+        // 3. Record into the lane's counter shard (lock-free)
+        record_vehicle_served(&g_traffic_system->metrics, lane->lane_id, (float)wait_ns / NS_PER_SEC);
+        record_spillback_delay(&g_traffic_system->metrics, lane->lane_id,
+                               vehicle.storage_ns - vehicle.arrival_ns);
+        trace_vehicle_event(TRACE_DEPARTURE, vehicle.id, lane->lane_id, (int)vehicle.movement,
+                            (int)(wait_ns / NS_PER_MS));
         
-        // --- NEW: Add processing delay to make vehicle allocation visible ---
         // Unlock before sleeping to allow other threads to run
         pthread_mutex_unlock(&lane->queue_lock);
-        pthread_mutex_unlock(&g_traffic_system->global_state_lock);
+
+        // Show the new green and the departure before the crossing wait
+        capture_simulation_snapshot();
         
-        // Sleep to simulate vehicle crossing the intersection (2-4 seconds)
-        usleep(2000000 + (rand() % 2000000));  // 2-4 seconds
+        // Simulate vehicle crossing the intersection (2-4 seconds, one more
+        // for heavy vehicles); an emergency preemption cuts this short so
+        // all-red can start at once
+        long long crossing_ns = vehicle_crossing_ns(vehicle.vehicle_class,
+                                                    rand() % VEHICLE_CROSS_SPREAD_MS);
+        pthread_mutex_lock(&scheduler->scheduler_lock);
+        scheduler_wait_unless_preempted(scheduler, crossing_ns);
+        pthread_mutex_unlock(&scheduler->scheduler_lock);
         
-        // Re-acquire locks for cleanup
-        pthread_mutex_lock(&g_traffic_system->global_state_lock);
         pthread_mutex_lock(&lane->queue_lock);
     }
-    // --- END FIX ---
 
     time_t end_time = time(NULL);
 
@@ -238,13 +528,11 @@ void execute_lane_time_slice(Scheduler* scheduler, LaneProcess* lane, int time_q
     if (lane->queue_length == 0 && lane->state == RUNNING) {
         // Queue is empty, so this lane is done.
         lane->state = WAITING; 
+        trace_vehicle_event(TRACE_GREEN_END, -1, lane->lane_id, 0, 0);
     }
     // If queue is not empty, we leave it as RUNNING.
     
-    // --- DEADLOCK FIX: Unlock in reverse order ---
     pthread_mutex_unlock(&lane->queue_lock);
-    pthread_mutex_unlock(&g_traffic_system->global_state_lock);
-    // --- END DEADLOCK FIX ---
 }
 // --- END MODIFIED FUNCTION ---
 
@@ -256,20 +544,7 @@ void context_switch(Scheduler* scheduler, LaneProcess* from_lane, LaneProcess* t
 
     // Stop previous lane if exists
     if (from_lane) {
-        // Lock before changing state
-        pthread_mutex_lock(&from_lane->queue_lock);
-        if (from_lane->state == RUNNING) {
-            // --- FIX: Change state directly without calling update_lane_state ---
-            // (update_lane_state tries to lock again, causing deadlock)
-            // If queue is empty, context switch will set to WAITING
-            if (from_lane->queue_length > 0) {
-                from_lane->state = READY;
-            } else {
-                from_lane->state = WAITING;
-            }
-            pthread_cond_signal(&from_lane->queue_cond);
-        }
-        pthread_mutex_unlock(&from_lane->queue_lock);
+        stop_running_lane(from_lane);
     }
 
     // Start new lane if exists
@@ -282,14 +557,36 @@ void context_switch(Scheduler* scheduler, LaneProcess* from_lane, LaneProcess* t
             to_lane->state = RUNNING;
             to_lane->waiting_time = 0;  // Reset wait time when entering RUNNING
             pthread_cond_signal(&to_lane->queue_cond);
+            trace_vehicle_event(TRACE_GREEN, -1, to_lane->lane_id, 0, to_lane->queue_length);
         }
         pthread_mutex_unlock(&to_lane->queue_lock);
     }
     // scheduler->total_context_switches++; // Moved to schedule_next_lane
 
-    // Simulate context switch overhead (increased delay for visibility)
-    usleep(scheduler->context_switch_time * 1000);
-    usleep(1000000);  // Additional 1 second delay to show lane transitions clearly
+    // Simulate context switch overhead plus 1 second so lane transitions are
+    // visible; called with scheduler_lock held, cut short by a preemption
+    scheduler_wait_unless_preempted(scheduler,
+                                    (long long)scheduler->context_switch_time * NS_PER_MS + NS_PER_SEC);
+}
+
+// Take green away from a lane (RUNNING -> READY or WAITING)
+static void stop_running_lane(LaneProcess* lane) {
+    // Lock before changing state
+    pthread_mutex_lock(&lane->queue_lock);
+    if (lane->state == RUNNING) {
+        // --- FIX: Change state directly without calling update_lane_state ---
+        // (update_lane_state tries to lock again, causing deadlock)
+        // If queue is empty, context switch will set to WAITING
+        if (lane->queue_length > 0) {
+            lane->state = READY;
+            lane->ready_since_ns = monotonic_now_ns();
+        } else {
+            lane->state = WAITING;
+        }
+        pthread_cond_signal(&lane->queue_cond);
+        trace_vehicle_event(TRACE_GREEN_END, -1, lane->lane_id, 0, lane->queue_length);
+    }
+    pthread_mutex_unlock(&lane->queue_lock);
 }
 
 // Set scheduling algorithm
@@ -309,13 +606,14 @@ void set_scheduling_algorithm(Scheduler* scheduler, SchedulingAlgorithm algorith
         // This ensures clean transition and no lane remains running from previous algorithm
         extern TrafficGuruSystem* g_traffic_system;  // Access global system
         if (g_traffic_system && g_traffic_system->simulation_running) {
-            for (int i = 0; i < 4; i++) {
+            for (int i = 0; i < g_traffic_system->num_lanes; i++) {
                 LaneProcess* lane = &g_traffic_system->lanes[i];
                 pthread_mutex_lock(&lane->queue_lock);
                 
                 // Stop any running lane
                 if (lane->state == RUNNING) {
                     lane->state = (lane->queue_length > 0) ? READY : WAITING;
+                    lane->ready_since_ns = monotonic_now_ns();
                     pthread_cond_signal(&lane->queue_cond);
                 }
                 
@@ -358,7 +656,14 @@ const char* get_algorithm_name(SchedulingAlgorithm algorithm) {
 // Record execution in history
 void record_execution(Scheduler* scheduler, int lane_id, time_t start_time,
                       time_t end_time, int vehicles_processed) {
-    if (!scheduler || !scheduler->execution_history) {
+    if (!scheduler) {
+        return;
+    }
+
+    // The Gantt history has its own writer lock, so no record is lost there
+    gantt_record_interval(scheduler->gantt, lane_id, start_time, end_time, vehicles_processed);
+
+    if (!scheduler->execution_history) {
         return;
     }
 
@@ -435,7 +740,7 @@ ExecutionRecord* get_execution_history(Scheduler* scheduler, int* count) {
 }
 
 // Calculate average waiting time
-float calculate_average_wait_time(Scheduler* scheduler, LaneProcess lanes[4]) {
+float calculate_average_wait_time(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return 0.0f;
     }
@@ -443,7 +748,7 @@ float calculate_average_wait_time(Scheduler* scheduler, LaneProcess lanes[4]) {
     float total_wait = 0.0f;
     int active_lanes = 0;
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         // This function should be thread-safe (lock inside)
         float lane_wait = get_lane_average_wait_time(&lanes[i]);
         if (lane_wait > 0) {
@@ -464,42 +769,32 @@ float calculate_throughput(Scheduler* scheduler, time_t time_period) {
     int total_vehicles = 0;
     int count = 0;
     
-    // --- DEADLOCK FIX: Lock before getting history ---
+    // Summing in place is as short as copying the ring would be, and
+    // needs no allocation
     pthread_mutex_lock(&scheduler->scheduler_lock);
     ExecutionRecord* history = scheduler->execution_history;
     count = (scheduler->history_index < scheduler->history_size) ?
                  scheduler->history_index : scheduler->history_size;
-                 
-    // Copy data to avoid holding lock during iteration
-    ExecutionRecord* history_copy = (ExecutionRecord*)malloc(count * sizeof(ExecutionRecord));
-    if (history_copy) {
-         memcpy(history_copy, history, count * sizeof(ExecutionRecord));
+    for (int i = 0; i < count; i++) {
+        total_vehicles += history[i].vehicles_processed;
     }
     pthread_mutex_unlock(&scheduler->scheduler_lock);
-    // --- END FIX ---
-
-    if (history_copy) {
-        for (int i = 0; i < count; i++) {
-            total_vehicles += history_copy[i].vehicles_processed;
-        }
-        free(history_copy);
-    }
 
     double minutes = time_period / 60.0;
     return minutes > 0 ? (total_vehicles / minutes) : 0.0f;
 }
 
 // Calculate fairness index (Jain's fairness index)
-float calculate_fairness_index(Scheduler* scheduler, LaneProcess lanes[4]) {
+float calculate_fairness_index(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return 0.0f;
     }
 
-    float wait_times[4];
+    float wait_times[MAX_LANES];
     float sum_wait = 0.0f, sum_wait_sq = 0.0f;
     int active_lanes = 0;
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         // This function should be thread-safe
         wait_times[i] = get_lane_average_wait_time(&lanes[i]);
         if (wait_times[i] > 0) {
@@ -577,7 +872,7 @@ bool is_ready_queue_empty(Scheduler* scheduler) {
 
 // --- NEW FUNCTION: Validate only one lane is running ---
 // This ensures mutual exclusion at intersection level
-bool validate_single_lane_running(LaneProcess lanes[4]) {
+bool validate_single_lane_running(LaneProcess* lanes, int num_lanes) {
     if (!lanes) {
         return false;
     }
@@ -585,12 +880,13 @@ bool validate_single_lane_running(LaneProcess lanes[4]) {
     int running_count = 0;
 
     
-    for (int i = 0; i < 4; i++) {
-        // Try to lock each lane to safely check state
-            if (lanes[i].state == RUNNING) {
-                running_count++;
-            }
-            pthread_mutex_unlock(&lanes[i].queue_lock);
+    for (int i = 0; i < num_lanes; i++) {
+        // Lock each lane to safely check state
+        pthread_mutex_lock(&lanes[i].queue_lock);
+        if (lanes[i].state == RUNNING) {
+            running_count++;
+        }
+        pthread_mutex_unlock(&lanes[i].queue_lock);
     }
     
     // Validation: At most one lane should be RUNNING
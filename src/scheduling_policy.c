@@ -0,0 +1,153 @@
+/*
+ * Scheduling Policy Implementation - Pure Lane Selection Rules
+ *
+ * No locks, no clocks, no file-level state: everything a rule needs comes
+ * in through the views and the caller's policy state, so the live
+ * scheduler and any number of replay threads can use the same code.
+ *
+ * Compilation: Include scheduling_policy.h, sim_clock.h
+ */
+
+#include "../include/scheduling_policy.h"
+#include "../include/sim_clock.h"
+
+static const int mlfq_time_quanta[MLFQ_LEVELS] = {2, 4, 6};
+
+long long vehicle_crossing_ns(VehicleClass vehicle_class, int spread_ms) {
+    long long crossing_ns = (VEHICLE_CROSS_MIN_MS + (long long)spread_ms) * NS_PER_MS;
+    if (vehicle_class == VEHICLE_HEAVY) {
+        crossing_ns += HEAVY_VEHICLE_EXTRA_MS * NS_PER_MS;
+    }
+    return crossing_ns;
+}
+
+void init_multilevel_lane_states(MultilevelLaneState* levels, int num_lanes, long long now) {
+    for (int i = 0; i < num_lanes; i++) {
+        levels[i].level = MLFQ_START_LEVEL;
+        levels[i].consecutive_runs = 0;
+        levels[i].level_since = now;
+    }
+}
+
+int multilevel_time_quantum(int level) {
+    if (level < 0 || level >= MLFQ_LEVELS) {
+        level = MLFQ_START_LEVEL;
+    }
+    return mlfq_time_quanta[level];
+}
+
+// Ready lanes; the green lane only when nobody else is ready
+static int mark_candidates(const LanePolicyView* lanes, int num_lanes, bool candidate[MAX_LANES]) {
+    int count = 0;
+    for (int i = 0; i < num_lanes; i++) {
+        candidate[i] = lanes[i].ready;
+        count += candidate[i];
+    }
+    if (count == 0) {
+        for (int i = 0; i < num_lanes; i++) {
+            candidate[i] = lanes[i].running;
+            count += candidate[i];
+        }
+    }
+    return count;
+}
+
+int select_lane_sjf(const LanePolicyView* lanes, int num_lanes) {
+    bool candidate[MAX_LANES];
+    if (mark_candidates(lanes, num_lanes, candidate) == 0) {
+        return -1;
+    }
+
+    int best = -1;
+    for (int i = 0; i < num_lanes; i++) {
+        if (!candidate[i]) {
+            continue;
+        }
+        if (best < 0 || lanes[i].queue_length < lanes[best].queue_length ||
+            (lanes[i].queue_length == lanes[best].queue_length &&
+             lanes[i].last_arrival_ns < lanes[best].last_arrival_ns)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Promote, age and demote every lane, then longest wait in the top level
+int select_lane_multilevel(const LanePolicyView* lanes, int num_lanes, long long now,
+                           MultilevelLaneState* levels, int* quantum) {
+    for (int i = 0; i < num_lanes; i++) {
+        MultilevelLaneState* state = &levels[i];
+        long long in_level = now - state->level_since;
+
+        if (lanes[i].waiting_seconds > MLFQ_PROMOTION_SECONDS && state->level > 0) {
+            state->level--;
+            state->level_since = now;
+            state->consecutive_runs = 0;
+        }
+        if (in_level > MLFQ_AGING_SECONDS && state->level > 0) {
+            state->level = 0;
+            state->level_since = now;
+            state->consecutive_runs = 0;
+        }
+
+        if (lanes[i].running) {
+            if (++state->consecutive_runs > MLFQ_DEMOTION_RUNS && state->level < MLFQ_LEVELS - 1) {
+                state->level++;
+                state->consecutive_runs = 0;
+            }
+        } else {
+            state->consecutive_runs = 0;
+        }
+    }
+
+    bool candidate[MAX_LANES];
+    if (mark_candidates(lanes, num_lanes, candidate) == 0) {
+        return -1;
+    }
+
+    for (int level = 0; level < MLFQ_LEVELS; level++) {
+        int best = -1;
+        for (int i = 0; i < num_lanes; i++) {
+            if (candidate[i] && levels[i].level == level &&
+                (best < 0 || lanes[i].waiting_seconds > lanes[best].waiting_seconds)) {
+                best = i;
+            }
+        }
+        if (best >= 0) {
+            if (quantum) {
+                *quantum = mlfq_time_quanta[level];
+            }
+            return best;
+        }
+    }
+    return -1;
+}
+
+RoundRobinClass round_robin_class(const LanePolicyView* lane) {
+    if (lane->emergency) {
+        return RR_CLASS_EMERGENCY;
+    }
+    if (lane->queue_length > RR_NORMAL_QUEUE_LENGTH || lane->idle_seconds > RR_STARVATION_SECONDS) {
+        return RR_CLASS_NORMAL;
+    }
+    return RR_CLASS_LOW;
+}
+
+// Round robin within each class, starting after the lane served last
+int select_lane_priority_rr(const LanePolicyView* lanes, int num_lanes, int* rr_index) {
+    bool candidate[MAX_LANES];
+    if (mark_candidates(lanes, num_lanes, candidate) == 0) {
+        return -1;
+    }
+
+    for (int rank = RR_CLASS_EMERGENCY; rank <= RR_CLASS_LOW; rank++) {
+        for (int checked = 0; checked < num_lanes; checked++) {
+            int i = (*rr_index + checked) % num_lanes;
+            if (candidate[i] && (int)round_robin_class(&lanes[i]) == rank) {
+                *rr_index = (i + 1) % num_lanes;
+                return i;
+            }
+        }
+    }
+    return -1;
+}
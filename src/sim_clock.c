@@ -0,0 +1,34 @@
+/*
+ * Simulation Clock Implementation - Monotonic Time Sources
+ *
+ * Compilation: Include sim_clock.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/sim_clock.h"
+#include <time.h>
+#include <errno.h>
+
+// Monotonic timestamp in nanoseconds (unaffected by wall-clock changes)
+long long monotonic_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * NS_PER_SEC + ts.tv_nsec;
+}
+
+// Sleep for the given duration, resuming after signal interruptions
+void sleep_ns(long long duration_ns) {
+    if (duration_ns <= 0) {
+        return;
+    }
+
+    struct timespec request = {
+        .tv_sec = (time_t)(duration_ns / NS_PER_SEC),
+        .tv_nsec = (long)(duration_ns % NS_PER_SEC)
+    };
+    struct timespec remaining;
+
+    while (nanosleep(&request, &remaining) != 0 && errno == EINTR) {
+        request = remaining;
+    }
+}
@@ -10,6 +10,9 @@
  * - Tie-breaker: FIFO order (earliest arrival)
  * - SRTF variant: Preemptive version considering remaining work
  *
+ * schedule_next_lane_sjf() applies select_lane_sjf() from
+ * scheduling_policy.c, the same rule the --compare replays use.
+ *
  * Thread Safety: Safe lane data reads via mutex locking per lane
  * Advantages: Minimizes average wait time
  *
@@ -23,48 +26,17 @@
 #include <limits.h>
 #include <float.h>
 
-int schedule_next_lane_sjf(Scheduler* scheduler, LaneProcess lanes[4]) {
+int schedule_next_lane_sjf(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
 
-    int best_lane = -1;
-    int min_estimated_time = INT_MAX;
-    time_t earliest_arrival = time(NULL);
-
-    LaneState state[4];
-    int queue_length[4];
-    time_t arrival_time[4];
-
-    for (int i = 0; i < 4; i++) {
-        pthread_mutex_lock(&lanes[i].queue_lock);
-        state[i] = lanes[i].state;
-        queue_length[i] = lanes[i].queue_length;
-        arrival_time[i] = lanes[i].last_arrival_time;
-        pthread_mutex_unlock(&lanes[i].queue_lock);
-    }
-
-    for (int i = 0; i < 4; i++) {
-        if (state[i] == READY) {
-            int estimated_time = queue_length[i] * VEHICLE_CROSS_TIME;
-
-            if (estimated_time < min_estimated_time) {
-                min_estimated_time = estimated_time;
-                best_lane = i;
-                earliest_arrival = arrival_time[i];
-            } else if (estimated_time == min_estimated_time) {
-                if (arrival_time[i] < earliest_arrival) {
-                    best_lane = i;
-                    earliest_arrival = arrival_time[i];
-                }
-            }
-        }
-    }
-
-    return best_lane;
+    LanePolicyView views[MAX_LANES];
+    fill_lane_policy_views(lanes, num_lanes, views);
+    return select_lane_sjf(views, num_lanes);
 }
 
-int schedule_next_lane_srtf(Scheduler* scheduler, LaneProcess lanes[4]) {
+int schedule_next_lane_srtf(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -72,16 +44,16 @@ int schedule_next_lane_srtf(Scheduler* scheduler, LaneProcess lanes[4]) {
     int best_lane = -1;
     int min_remaining_time = INT_MAX;
 
-    LaneState state[4];
-    int queue_length[4];
-    for (int i = 0; i < 4; i++) {
+    LaneState state[MAX_LANES];
+    int queue_length[MAX_LANES];
+    for (int i = 0; i < num_lanes; i++) {
         pthread_mutex_lock(&lanes[i].queue_lock);
         state[i] = lanes[i].state;
         queue_length[i] = lanes[i].queue_length;
         pthread_mutex_unlock(&lanes[i].queue_lock);
     }
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (state[i] == READY) {
             int remaining_time = queue_length[i] * VEHICLE_CROSS_TIME;
 
@@ -97,7 +69,7 @@ int schedule_next_lane_srtf(Scheduler* scheduler, LaneProcess lanes[4]) {
 
 // SJF with aging to prevent starvation
 // --- FIX: This function must also be thread-safe ---
-int schedule_next_lane_sjf_with_aging(Scheduler* scheduler, LaneProcess lanes[4]) {
+int schedule_next_lane_sjf_with_aging(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -106,10 +78,10 @@ int schedule_next_lane_sjf_with_aging(Scheduler* scheduler, LaneProcess lanes[4]
     float min_priority_score = FLT_MAX;
     
     // --- FIX: Read data safely ---
-    LaneState state[4];
-    int queue_length[4];
-    int waiting_time[4];
-    for (int i = 0; i < 4; i++) {
+    LaneState state[MAX_LANES];
+    int queue_length[MAX_LANES];
+    int waiting_time[MAX_LANES];
+    for (int i = 0; i < num_lanes; i++) {
         pthread_mutex_lock(&lanes[i].queue_lock);
         state[i] = lanes[i].state;
         queue_length[i] = lanes[i].queue_length;
@@ -118,7 +90,7 @@ int schedule_next_lane_sjf_with_aging(Scheduler* scheduler, LaneProcess lanes[4]
     }
     // --- END FIX ---
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (state[i] == READY) {
             // Calculate priority score: estimated_time - aging_factor
             float estimated_time = queue_length[i] * VEHICLE_CROSS_TIME;
@@ -137,7 +109,7 @@ int schedule_next_lane_sjf_with_aging(Scheduler* scheduler, LaneProcess lanes[4]
 
 // Enhanced SJF with multiple factors
 // --- FIX: This function must also be thread-safe ---
-int schedule_next_lane_enhanced_sjf(Scheduler* scheduler, LaneProcess lanes[4]) {
+int schedule_next_lane_enhanced_sjf(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -146,11 +118,11 @@ int schedule_next_lane_enhanced_sjf(Scheduler* scheduler, LaneProcess lanes[4])
     float min_weighted_score = FLT_MAX;
     
     // --- FIX: Read data safely ---
-    LaneState state[4];
-    int queue_length[4];
-    int waiting_time[4];
-    float avg_wait[4];
-    for (int i = 0; i < 4; i++) {
+    LaneState state[MAX_LANES];
+    int queue_length[MAX_LANES];
+    int waiting_time[MAX_LANES];
+    float avg_wait[MAX_LANES];
+    for (int i = 0; i < num_lanes; i++) {
         pthread_mutex_lock(&lanes[i].queue_lock);
         state[i] = lanes[i].state;
         queue_length[i] = lanes[i].queue_length;
@@ -162,7 +134,7 @@ int schedule_next_lane_enhanced_sjf(Scheduler* scheduler, LaneProcess lanes[4])
     }
     // --- END FIX ---
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (state[i] == READY) {
             // Calculate weighted score considering multiple factors
             float processing_time = queue_length[i] * VEHICLE_CROSS_TIME;
@@ -183,7 +155,7 @@ int schedule_next_lane_enhanced_sjf(Scheduler* scheduler, LaneProcess lanes[4])
 
 // SJF with burst time prediction
 // --- FIX: This function must also be thread-safe ---
-int schedule_next_lane_predictive_sjf(Scheduler* scheduler, LaneProcess lanes[4]) {
+int schedule_next_lane_predictive_sjf(Scheduler* scheduler, LaneProcess* lanes, int num_lanes) {
     if (!scheduler || !lanes) {
         return -1;
     }
@@ -192,10 +164,10 @@ int schedule_next_lane_predictive_sjf(Scheduler* scheduler, LaneProcess lanes[4]
     float min_predicted_time = FLT_MAX;
 
     // --- FIX: Read data safely ---
-    LaneState state[4];
-    int queue_length[4];
-    int throughput[4];
-    for (int i = 0; i < 4; i++) {
+    LaneState state[MAX_LANES];
+    int queue_length[MAX_LANES];
+    int throughput[MAX_LANES];
+    for (int i = 0; i < num_lanes; i++) {
         pthread_mutex_lock(&lanes[i].queue_lock);
         state[i] = lanes[i].state;
         queue_length[i] = lanes[i].queue_length;
@@ -204,7 +176,7 @@ int schedule_next_lane_predictive_sjf(Scheduler* scheduler, LaneProcess lanes[4]
     }
     // --- END FIX ---
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (state[i] == READY) {
             // Predict processing time based on historical throughput
             float avg_service_time = throughput[i] > 0 ? (60.0f / throughput[i]) : VEHICLE_CROSS_TIME;
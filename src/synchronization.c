@@ -9,6 +9,7 @@
 
 #define _XOPEN_SOURCE 600
 #include "../include/synchronization.h"
+#include "../include/logger.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -29,10 +30,14 @@ void init_intersection_mutex(IntersectionMutex* intersection) {
     pthread_mutex_init(&intersection->intersection_lock, NULL);
 
     // Initialize condition variables for each lane
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < MAX_LANES; i++) {
         pthread_cond_init(&intersection->condition_vars[i], NULL);
     }
 
+    for (int i = 0; i < MAX_LANES; i++) {
+        intersection->lane_holders[i] = 0;
+        intersection->lane_quadrants[i] = 0;
+    }
     intersection->current_lane = -1; // No lane currently occupying intersection
     intersection->lock_holder = 0;
     intersection->lock_acquisition_time = 0;
@@ -53,7 +58,7 @@ void destroy_intersection_mutex(IntersectionMutex* intersection) {
 
     pthread_mutex_destroy(&intersection->intersection_lock);
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < MAX_LANES; i++) {
         pthread_cond_destroy(&intersection->condition_vars[i]);
     }
 
@@ -70,6 +75,80 @@ IntersectionMutex* get_global_intersection() {
     return &g_intersection;
 }
 
+// Quadrants a lane asks for; no request means the whole intersection
+static int claimed_quadrants(LaneProcess* lane) {
+    return lane->requested_quadrants ? lane->requested_quadrants
+                                     : get_intersection_geometry()->all_quadrants;
+}
+
+// True if 'lane' would overlap a quadrant held by another lane
+// (caller holds intersection_lock)
+static bool conflicts_with_holders(IntersectionMutex* intersection, LaneProcess* lane) {
+    int held_by_others = intersection->active_quadrants &
+                         ~intersection->lane_quadrants[lane->lane_id];
+    return (claimed_quadrants(lane) & held_by_others) != 0;
+}
+
+// Admit 'lane' (caller holds intersection_lock and checked for conflicts)
+static void admit_lane(IntersectionMutex* intersection, LaneProcess* lane) {
+    int quadrants = claimed_quadrants(lane);
+
+    intersection->lane_holders[lane->lane_id]++;
+    intersection->lane_quadrants[lane->lane_id] |= quadrants;
+    intersection->active_quadrants |= quadrants;
+    intersection->intersection_available = false;
+    intersection->current_lane = lane->lane_id;
+    intersection->lock_holder = pthread_self();
+    intersection->lock_acquisition_time = time(NULL);
+}
+
+// Recompute the held quadrants after lanes left and wake every waiter
+// (caller holds intersection_lock)
+static void settle_holders(IntersectionMutex* intersection) {
+    intersection->active_quadrants = 0;
+    intersection->current_lane = -1;
+    for (int i = 0; i < MAX_LANES; i++) {
+        intersection->active_quadrants |= intersection->lane_quadrants[i];
+        if (intersection->lane_holders[i] > 0) {
+            intersection->current_lane = i;
+        }
+    }
+
+    if (intersection->current_lane == -1) {
+        // Release intersection
+        intersection->intersection_available = true;
+        intersection->lock_holder = 0;
+        intersection->lock_acquisition_time = 0;
+    }
+
+    // Several waiting movements may fit now; wake them all to re-check
+    for (int i = 0; i < MAX_LANES; i++) {
+        pthread_cond_broadcast(&intersection->condition_vars[i]);
+    }
+}
+
+// Force every lane but 'keep_lane' out of the intersection; returns a
+// bitmask of the lanes evicted. Their threads' later release is a no-op.
+int evict_intersection_holders(int keep_lane) {
+    IntersectionMutex* intersection = get_global_intersection();
+    pthread_mutex_lock(&intersection->intersection_lock);
+
+    int evicted = 0;
+    for (int i = 0; i < MAX_LANES; i++) {
+        if (i != keep_lane && intersection->lane_holders[i] > 0) {
+            intersection->lane_holders[i] = 0;
+            intersection->lane_quadrants[i] = 0;
+            evicted |= 1 << i;
+        }
+    }
+    if (evicted) {
+        settle_holders(intersection);
+    }
+
+    pthread_mutex_unlock(&intersection->intersection_lock);
+    return evicted;
+}
+
 // Acquire intersection access for a lane
 bool acquire_intersection(LaneProcess* lane) {
     if (!lane) {
@@ -79,9 +158,8 @@ bool acquire_intersection(LaneProcess* lane) {
     IntersectionMutex* intersection = get_global_intersection();
     pthread_mutex_lock(&intersection->intersection_lock);
 
-    // Wait if intersection is not available or another lane has it
-    while (!intersection->intersection_available ||
-           (intersection->current_lane != -1 && intersection->current_lane != lane->lane_id)) {
+    // Wait while another lane holds a quadrant this lane needs
+    while (conflicts_with_holders(intersection, lane)) {
 
         // Wait on this lane's condition variable
         pthread_cond_wait(&intersection->condition_vars[lane->lane_id],
@@ -89,11 +167,7 @@ bool acquire_intersection(LaneProcess* lane) {
     }
 
     // Grant intersection access to this lane
-    intersection->intersection_available = false;
-    intersection->current_lane = lane->lane_id;
-    intersection->lock_holder = pthread_self();
-    intersection->lock_acquisition_time = time(NULL);
-    intersection->active_quadrants = lane->requested_quadrants;
+    admit_lane(intersection, lane);
 
     pthread_mutex_unlock(&intersection->intersection_lock);
     return true;
@@ -109,16 +183,11 @@ bool try_acquire_intersection(LaneProcess* lane) {
     bool acquired = false;
 
     if (pthread_mutex_trylock(&intersection->intersection_lock) == 0) {
-        // Check if intersection is available
-        if (intersection->intersection_available ||
-            (intersection->current_lane == lane->lane_id)) {
+        // Check if this lane's quadrants are free
+        if (!conflicts_with_holders(intersection, lane)) {
 
             // Grant access
-            intersection->intersection_available = false;
-            intersection->current_lane = lane->lane_id;
-            intersection->lock_holder = pthread_self();
-            intersection->lock_acquisition_time = time(NULL);
-            intersection->active_quadrants = lane->requested_quadrants;
+            admit_lane(intersection, lane);
             acquired = true;
         }
 
@@ -137,19 +206,13 @@ void release_intersection(LaneProcess* lane) {
     IntersectionMutex* intersection = get_global_intersection();
     pthread_mutex_lock(&intersection->intersection_lock);
 
-    // Verify this lane holds the intersection lock
-    if (intersection->current_lane == lane->lane_id) {
-        // Release intersection
-        intersection->intersection_available = true;
-        intersection->current_lane = -1;
-        intersection->lock_holder = 0;
-        intersection->lock_acquisition_time = 0;
-        intersection->active_quadrants = 0;
-
-        // Signal all waiting lanes
-        for (int i = 0; i < 4; i++) {
-            pthread_cond_signal(&intersection->condition_vars[i]);
+    // Verify this lane is inside the intersection
+    if (intersection->lane_holders[lane->lane_id] > 0) {
+        // The lane keeps its quadrants until its last thread leaves
+        if (--intersection->lane_holders[lane->lane_id] == 0) {
+            intersection->lane_quadrants[lane->lane_id] = 0;
         }
+        settle_holders(intersection);
     }
 
     pthread_mutex_unlock(&intersection->intersection_lock);
@@ -164,8 +227,7 @@ bool is_intersection_available(LaneProcess* lane) {
     IntersectionMutex* intersection = get_global_intersection();
     pthread_mutex_lock(&intersection->intersection_lock);
 
-    bool available = intersection->intersection_available ||
-                    intersection->current_lane == lane->lane_id;
+    bool available = !conflicts_with_holders(intersection, lane);
 
     pthread_mutex_unlock(&intersection->intersection_lock);
     return available;
@@ -201,7 +263,7 @@ void signal_all_lanes() {
     IntersectionMutex* intersection = get_global_intersection();
     pthread_mutex_lock(&intersection->intersection_lock);
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < MAX_LANES; i++) {
         pthread_cond_signal(&intersection->condition_vars[i]);
     }
 
@@ -259,7 +321,7 @@ void restore_lane_priority(LaneProcess* lane, int original_priority) {
 }
 
 // Detect deadlock (simplified circular wait detection)
-bool detect_deadlock(LaneProcess lanes[4]) {
+bool detect_deadlock(LaneProcess* lanes, int num_lanes) {
     if (!lanes) {
         return false;
     }
@@ -268,18 +330,18 @@ bool detect_deadlock(LaneProcess lanes[4]) {
     // In a more complex implementation, we'd build a wait graph
     int blocked_lanes = 0;
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (is_lane_blocked(&lanes[i]) || lanes[i].state == BLOCKED) {
             blocked_lanes++;
         }
     }
 
-    // Consider deadlock if 3 or 4 lanes are blocked for extended period
-    return blocked_lanes >= 3;
+    // Consider deadlock if all but one lane (3 of 4 on a four-way) are blocked
+    return num_lanes > 1 && blocked_lanes >= num_lanes - 1;
 }
 
 // Resolve deadlock by selecting a victim lane
-void resolve_deadlock(LaneProcess lanes[4]) {
+void resolve_deadlock(LaneProcess* lanes, int num_lanes) {
     if (!lanes) {
         return;
     }
@@ -288,7 +350,7 @@ void resolve_deadlock(LaneProcess lanes[4]) {
     int victim_lane = -1;
     int lowest_priority = INT_MAX;
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (lanes[i].state == BLOCKED && lanes[i].priority < lowest_priority) {
             lowest_priority = lanes[i].priority;
             victim_lane = i;
@@ -303,7 +365,7 @@ void resolve_deadlock(LaneProcess lanes[4]) {
 }
 
 // Check for circular wait condition
-bool is_circular_wait_detected(LaneProcess lanes[4]) {
+bool is_circular_wait_detected(LaneProcess* lanes, int num_lanes) {
     if (!lanes) {
         return false;
     }
@@ -317,14 +379,14 @@ bool is_circular_wait_detected(LaneProcess lanes[4]) {
 
     // Check if multiple lanes are waiting for intersection resources
     int waiting_lanes = 0;
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (lanes[i].state == READY && lanes[i].requested_quadrants > 0) {
             waiting_lanes++;
         }
     }
 
     // Circular wait likely if multiple lanes are waiting
-    if (waiting_lanes >= 3) {
+    if (num_lanes > 1 && waiting_lanes >= num_lanes - 1) {
         circular_wait = true;
     }
 
@@ -377,7 +439,13 @@ void print_intersection_state() {
     printf("Available: %s\n", intersection->intersection_available ? "Yes" : "No");
     printf("Current Lane: %d\n", intersection->current_lane);
     printf("Lock Holder: %lu\n", (unsigned long)intersection->lock_holder);
-    printf("Active Quadrants: %d\n", intersection->active_quadrants);
+    printf("Active Quadrants: %#x\n", intersection->active_quadrants);
+    for (int i = 0; i < MAX_LANES; i++) {
+        if (intersection->lane_holders[i] > 0) {
+            printf("  Lane %d: %d inside, quadrants %#x\n", i,
+                   intersection->lane_holders[i], intersection->lane_quadrants[i]);
+        }
+    }
 
     if (intersection->lock_acquisition_time > 0) {
         time_t hold_time = time(NULL) - intersection->lock_acquisition_time;
@@ -398,16 +466,27 @@ bool validate_intersection_state() {
 
     // Check if intersection is marked as unavailable but no current lane
     if (!intersection->intersection_available && intersection->current_lane == -1) {
-        printf("ERROR: Intersection unavailable but no current lane set\n");
+        LOG_ERROR("Intersection unavailable but no current lane set");
         valid = false;
     }
 
     // Check if intersection is available but current lane is set
     if (intersection->intersection_available && intersection->current_lane != -1) {
-        printf("ERROR: Intersection available but current lane is set\n");
+        LOG_ERROR("Intersection available but current lane is set");
         valid = false;
     }
 
+    // Lanes inside the box must hold disjoint quadrants
+    int seen = 0;
+    for (int i = 0; i < MAX_LANES; i++) {
+        if (intersection->lane_quadrants[i] & seen) {
+            LOG_ERROR("Quadrants %#x held by more than one lane",
+                      intersection->lane_quadrants[i] & seen);
+            valid = false;
+        }
+        seen |= intersection->lane_quadrants[i];
+    }
+
     pthread_mutex_unlock(&intersection->intersection_lock);
     return valid;
 }
@@ -422,10 +501,14 @@ void reset_intersection_state() {
     intersection->lock_holder = 0;
     intersection->lock_acquisition_time = 0;
     intersection->active_quadrants = 0;
+    for (int i = 0; i < MAX_LANES; i++) {
+        intersection->lane_holders[i] = 0;
+        intersection->lane_quadrants[i] = 0;
+    }
 
     // Signal all waiting lanes
-    for (int i = 0; i < 4; i++) {
-        pthread_cond_signal(&intersection->condition_vars[i]);
+    for (int i = 0; i < MAX_LANES; i++) {
+        pthread_cond_broadcast(&intersection->condition_vars[i]);
     }
 
     pthread_mutex_unlock(&intersection->intersection_lock);
@@ -13,6 +13,8 @@
 #include "../include/synchronization.h"
 #include "../include/bankers_algorithm.h"
 #include "../include/traffic_mutex.h"
+#include "../include/logger.h"
+#include "../include/sim_clock.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
@@ -28,6 +30,10 @@ typedef struct {
 static EnhancedTrafficMutex g_traffic_mutex = {0};
 static bool traffic_mutex_initialized = false;
 
+static MutexPerformanceStats g_perf_stats = {0};
+
+static bool acquire_with_strategy(LaneProcess* lane);
+
 // Initialize enhanced traffic mutex system
 void init_traffic_mutex_system() {
     if (traffic_mutex_initialized) {
@@ -38,6 +44,7 @@ void init_traffic_mutex_system() {
     g_traffic_mutex.bankers = get_global_bankers_state();
     g_traffic_mutex.enhanced_mode = true;
     g_traffic_mutex.allocation_strategy = 2; // Hybrid mode
+    init_mutex_performance_monitoring();
 
     traffic_mutex_initialized = true;
 }
@@ -48,6 +55,16 @@ bool acquire_intersection_with_bankers(LaneProcess* lane) {
         return false;
     }
 
+    long long start_ns = monotonic_now_ns();
+    bool acquired = acquire_with_strategy(lane);
+    record_mutex_acquisition(acquired, false, false,
+                             (float)(monotonic_now_ns() - start_ns) / NS_PER_SEC);
+
+    return acquired;
+}
+
+// Single acquisition attempt using the configured strategy (not recorded)
+static bool acquire_with_strategy(LaneProcess* lane) {
     if (!traffic_mutex_initialized) {
         init_traffic_mutex_system();
     }
@@ -55,12 +72,12 @@ bool acquire_intersection_with_bankers(LaneProcess* lane) {
     EnhancedTrafficMutex* tm = &g_traffic_mutex;
 
     // Calculate resources needed for this lane
-    int needed_quadrants[NUM_QUADRANTS] = {0};
+    int needed_quadrants[MAX_QUADRANTS] = {0};
     calculate_needed_quadrants(lane, needed_quadrants);
 
     // Set requested quadrants in lane structure
     int requested_mask = 0;
-    for (int quad = 0; quad < NUM_QUADRANTS; quad++) {
+    for (int quad = 0; quad < MAX_QUADRANTS; quad++) {
         if (needed_quadrants[quad] > 0) {
             requested_mask |= (1 << quad);
         }
@@ -100,7 +117,7 @@ bool acquire_intersection_with_bankers(LaneProcess* lane) {
 }
 
 // Hybrid allocation strategy combining Banker's algorithm with traditional locking
-bool acquire_intersection_hybrid(LaneProcess* lane, int needed_quadrants[NUM_QUADRANTS]) {
+bool acquire_intersection_hybrid(LaneProcess* lane, int needed_quadrants[MAX_QUADRANTS]) {
     EnhancedTrafficMutex* tm = &g_traffic_mutex;
 
     // First try Banker's algorithm
@@ -118,17 +135,17 @@ bool acquire_intersection_hybrid(LaneProcess* lane, int needed_quadrants[NUM_QUA
         // Banker's algorithm says unsafe, but check if we can still proceed
         // for time-critical situations (emergency vehicles, etc.)
         if (lane->priority == 1) { // Emergency vehicle
-            printf("Emergency override: allowing lane %d despite unsafe state\n", lane->lane_id);
+            LOG_WARN("Emergency override: allowing lane %d despite unsafe state", lane->lane_id);
             return acquire_intersection(lane);
         }
 
         // Check if system is in safe state overall
         if (is_safe_state(tm->bankers)) {
-            printf("System safe, proceeding with traditional allocation for lane %d\n", lane->lane_id);
+            LOG_DEBUG("System safe, proceeding with traditional allocation for lane %d", lane->lane_id);
             return acquire_intersection(lane);
         }
 
-        printf("Allocation denied for lane %d: unsafe state detected\n", lane->lane_id);
+        LOG_INFO("Allocation denied for lane %d: unsafe state detected", lane->lane_id);
         return false;
     }
 }
@@ -159,7 +176,7 @@ void release_intersection_with_bankers(LaneProcess* lane) {
 }
 
 // Advanced deadlock detection and resolution
-bool detect_and_resolve_advanced_deadlock(LaneProcess lanes[4]) {
+bool detect_and_resolve_advanced_deadlock(LaneProcess* lanes, int num_lanes) {
     if (!lanes) {
         return false;
     }
@@ -172,26 +189,26 @@ bool detect_and_resolve_advanced_deadlock(LaneProcess lanes[4]) {
     bool deadlock_detected = false;
 
     // Check for deadlock using multiple methods
-    bool traditional_deadlock = detect_deadlock(lanes);
-    bool circular_wait = is_circular_wait_detected(lanes);
+    bool traditional_deadlock = detect_deadlock(lanes, num_lanes);
+    bool circular_wait = is_circular_wait_detected(lanes, num_lanes);
     bool bankers_unsafe = !is_safe_state(tm->bankers);
 
     if (traditional_deadlock || circular_wait || bankers_unsafe) {
         deadlock_detected = true;
-        printf("Deadlock detected - Traditional: %s, Circular Wait: %s, Banker's Unsafe: %s\n",
+        LOG_WARN("Deadlock detected - Traditional: %s, Circular Wait: %s, Banker's Unsafe: %s",
                traditional_deadlock ? "Yes" : "No",
                circular_wait ? "Yes" : "No",
                bankers_unsafe ? "Yes" : "No");
 
         // Attempt resolution
-        resolve_advanced_deadlock(lanes);
+        resolve_advanced_deadlock(lanes, num_lanes);
     }
 
     return deadlock_detected;
 }
 
 // Advanced deadlock resolution strategy
-void resolve_advanced_deadlock(LaneProcess lanes[4]) {
+void resolve_advanced_deadlock(LaneProcess* lanes, int num_lanes) {
     if (!lanes) {
         return;
     }
@@ -199,9 +216,9 @@ void resolve_advanced_deadlock(LaneProcess lanes[4]) {
     EnhancedTrafficMutex* tm = &g_traffic_mutex;
 
     // Strategy 1: Check for emergency vehicles and prioritize them
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         if (lanes[i].priority == 1 && lanes[i].state == BLOCKED) {
-            printf("Emergency deadlock resolution: prioritizing lane %d\n", i);
+            LOG_INFO("Emergency deadlock resolution: prioritizing lane %d", i);
             lanes[i].state = READY;
             signal_lane(&lanes[i]);
             return;
@@ -209,13 +226,13 @@ void resolve_advanced_deadlock(LaneProcess lanes[4]) {
     }
 
     // Strategy 2: Use Banker's algorithm to find safe sequence
-    bool finish_sequence[NUM_LANES];
+    bool finish_sequence[MAX_LANES];
     if (safety_algorithm(tm->bankers, finish_sequence)) {
-        printf("Found safe sequence using Banker's algorithm\n");
+        LOG_DEBUG("Found safe sequence using Banker's algorithm");
         // Find first lane in safe sequence that's blocked
-        for (int i = 0; i < NUM_LANES; i++) {
+        for (int i = 0; i < num_lanes; i++) {
             int lane_idx = -1;
-            for (int j = 0; j < NUM_LANES; j++) {
+            for (int j = 0; j < num_lanes; j++) {
                 if (finish_sequence[j]) {
                     lane_idx = j;
                     break;
@@ -223,7 +240,7 @@ void resolve_advanced_deadlock(LaneProcess lanes[4]) {
             }
 
             if (lane_idx != -1 && lanes[lane_idx].state == BLOCKED) {
-                printf("Unblocking lane %d as part of safe sequence\n", lane_idx);
+                LOG_INFO("Unblocking lane %d as part of safe sequence", lane_idx);
                 lanes[lane_idx].state = READY;
                 signal_lane(&lanes[lane_idx]);
                 return;
@@ -232,16 +249,16 @@ void resolve_advanced_deadlock(LaneProcess lanes[4]) {
     }
 
     // Strategy 3: Traditional victim selection (lowest priority)
-    resolve_deadlock(lanes);
+    resolve_deadlock(lanes, num_lanes);
 
     // Strategy 4: If still deadlocked, force system reset
-    if (detect_deadlock(lanes)) {
-        printf("Critical deadlock detected, performing system reset\n");
+    if (detect_deadlock(lanes, num_lanes)) {
+        LOG_ERROR("Critical deadlock detected, performing system reset");
         reset_intersection_state();
         reset_bankers_state();
 
         // Mark all lanes as ready
-        for (int i = 0; i < 4; i++) {
+        for (int i = 0; i < num_lanes; i++) {
             lanes[i].state = READY;
             signal_lane(&lanes[i]);
         }
@@ -254,20 +271,23 @@ bool acquire_intersection_with_timeout(LaneProcess* lane, int timeout_seconds) {
         return false;
     }
 
-    time_t start_time = time(NULL);
-    time_t current_time = start_time;
+    long long start_ns = monotonic_now_ns();
+    long long deadline_ns = start_ns + (long long)timeout_seconds * NS_PER_SEC;
 
-    while ((current_time - start_time) < timeout_seconds) {
-        if (acquire_intersection_with_bankers(lane)) {
+    while (monotonic_now_ns() < deadline_ns) {
+        if (acquire_with_strategy(lane)) {
+            record_mutex_acquisition(true, false, false,
+                                     (float)(monotonic_now_ns() - start_ns) / NS_PER_SEC);
             return true;
         }
 
         // Wait before retrying
         usleep(100000); // 100ms
-        current_time = time(NULL);
     }
 
-    printf("Timeout: Failed to acquire intersection for lane %d after %d seconds\n",
+    record_mutex_acquisition(false, true, false,
+                             (float)(monotonic_now_ns() - start_ns) / NS_PER_SEC);
+    LOG_WARN("Timeout: Failed to acquire intersection for lane %d after %d seconds",
            lane->lane_id, timeout_seconds);
     return false;
 }
@@ -283,108 +303,115 @@ bool acquire_intersection_with_preemption(LaneProcess* lane) {
     }
 
     EnhancedTrafficMutex* tm = &g_traffic_mutex;
-    IntersectionMutex* intersection = tm->intersection;
-
-    pthread_mutex_lock(&intersection->intersection_lock);
-
-    // Check if current lane holder has lower priority
-    if (intersection->current_lane != -1 &&
-        intersection->current_lane != lane->lane_id) {
-
-        LaneProcess* current_lane = NULL; // This would need access to the global lanes array
-        
-        // --- FIX: Suppress unused variable warning ---
-        (void)current_lane; 
-        // --- END FIX ---
-        
-        // For now, assume we can check priority
-
-        if (lane->priority < 2) { // High priority lane
-            printf("Preempting current lane for high priority lane %d\n", lane->lane_id);
-
-            // Force release of current lane
-            intersection->intersection_available = true;
-            intersection->current_lane = -1;
-            intersection->lock_holder = 0;
-
-            // Signal all lanes
-            for (int i = 0; i < 4; i++) {
-                pthread_cond_signal(&intersection->condition_vars[i]);
+    long long start_ns = monotonic_now_ns();
+
+    // A high-priority lane forces every other lane out of the box and
+    // hands their Banker's allocations back, so the acquisition below
+    // is not blocked on the quadrants it preempted
+    if (lane->priority < 2) {
+        int evicted = evict_intersection_holders(lane->lane_id);
+        if (evicted) {
+            LOG_INFO("Preempting intersection holders for high priority lane %d", lane->lane_id);
+            for (int i = 0; i < MAX_LANES; i++) {
+                if (evicted & (1 << i)) {
+                    deallocate_resources(tm->bankers, i);
+                }
             }
         }
     }
 
-    pthread_mutex_unlock(&intersection->intersection_lock);
-
     // Now try normal acquisition
-    return acquire_intersection_with_bankers(lane);
+    bool acquired = acquire_with_strategy(lane);
+    record_mutex_acquisition(acquired, false, true,
+                             (float)(monotonic_now_ns() - start_ns) / NS_PER_SEC);
+    return acquired;
 }
 
 // Performance monitoring for the mutex system
-typedef struct {
-    int total_acquisitions;
-    int successful_acquisitions;
-    int failed_acquisitions;
-    int timeouts;
-    int preemptive_acquisitions;
-    float average_wait_time;
-    time_t monitoring_start_time;
-} MutexPerformanceStats;
-
-static MutexPerformanceStats g_perf_stats = {0};
-
+// Counters are updated with atomics so any lane thread may record
 void init_mutex_performance_monitoring() {
-    g_perf_stats.total_acquisitions = 0;
-    g_perf_stats.successful_acquisitions = 0;
-    g_perf_stats.failed_acquisitions = 0;
-    g_perf_stats.timeouts = 0;
-    g_perf_stats.preemptive_acquisitions = 0;
-    g_perf_stats.average_wait_time = 0.0f;
+    __atomic_store_n(&g_perf_stats.total_acquisitions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.successful_acquisitions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.failed_acquisitions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.timeouts, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.preemptive_acquisitions, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&g_perf_stats.total_wait_ns, 0, __ATOMIC_RELAXED);
+    init_latency_histogram(&g_perf_stats.acquire_latency_ns);
     g_perf_stats.monitoring_start_time = time(NULL);
 }
 
 void record_mutex_acquisition(bool success, bool timeout, bool preemptive, float wait_time) {
-    g_perf_stats.total_acquisitions++;
+    long long wait_ns = (long long)(wait_time * NS_PER_SEC);
+
+    __atomic_fetch_add(&g_perf_stats.total_acquisitions, 1, __ATOMIC_RELAXED);
 
     if (success) {
-        g_perf_stats.successful_acquisitions++;
+        __atomic_fetch_add(&g_perf_stats.successful_acquisitions, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&g_perf_stats.total_wait_ns, wait_ns, __ATOMIC_RELAXED);
+        histogram_record(&g_perf_stats.acquire_latency_ns, wait_ns);
         if (preemptive) {
-            g_perf_stats.preemptive_acquisitions++;
+            __atomic_fetch_add(&g_perf_stats.preemptive_acquisitions, 1, __ATOMIC_RELAXED);
         }
     } else {
-        g_perf_stats.failed_acquisitions++;
+        __atomic_fetch_add(&g_perf_stats.failed_acquisitions, 1, __ATOMIC_RELAXED);
         if (timeout) {
-            g_perf_stats.timeouts++;
+            __atomic_fetch_add(&g_perf_stats.timeouts, 1, __ATOMIC_RELAXED);
         }
     }
+}
+
+// Copy of the current statistics; the latency histogram is not copied
+void get_mutex_performance_stats(MutexPerformanceStats* stats) {
+    if (!stats) {
+        return;
+    }
+
+    stats->total_acquisitions = __atomic_load_n(&g_perf_stats.total_acquisitions, __ATOMIC_RELAXED);
+    stats->successful_acquisitions = __atomic_load_n(&g_perf_stats.successful_acquisitions, __ATOMIC_RELAXED);
+    stats->failed_acquisitions = __atomic_load_n(&g_perf_stats.failed_acquisitions, __ATOMIC_RELAXED);
+    stats->timeouts = __atomic_load_n(&g_perf_stats.timeouts, __ATOMIC_RELAXED);
+    stats->preemptive_acquisitions = __atomic_load_n(&g_perf_stats.preemptive_acquisitions, __ATOMIC_RELAXED);
+    stats->total_wait_ns = __atomic_load_n(&g_perf_stats.total_wait_ns, __ATOMIC_RELAXED);
+    stats->monitoring_start_time = g_perf_stats.monitoring_start_time;
+}
+
+const LatencyHistogram* get_mutex_acquire_latency_histogram() {
+    return &g_perf_stats.acquire_latency_ns;
+}
 
-    // Update average wait time
-    if (g_perf_stats.successful_acquisitions > 0) {
-        g_perf_stats.average_wait_time =
-            (g_perf_stats.average_wait_time * (g_perf_stats.successful_acquisitions - 1) + wait_time) /
-            g_perf_stats.successful_acquisitions;
+float get_mutex_average_wait_time(const MutexPerformanceStats* stats) {
+    if (!stats || stats->successful_acquisitions == 0) {
+        return 0.0f;
     }
+    return (float)((double)stats->total_wait_ns / stats->successful_acquisitions / NS_PER_SEC);
 }
 
 void print_mutex_performance_stats() {
-    time_t monitoring_duration = time(NULL) - g_perf_stats.monitoring_start_time;
+    MutexPerformanceStats stats;
+    get_mutex_performance_stats(&stats);
+    const LatencyHistogram* latency = &g_perf_stats.acquire_latency_ns;
+    time_t monitoring_duration = time(NULL) - stats.monitoring_start_time;
 
     printf("\n=== MUTEX PERFORMANCE STATISTICS ===\n");
     printf("Monitoring Duration: %ld seconds\n", monitoring_duration);
-    printf("Total Acquisitions: %d\n", g_perf_stats.total_acquisitions);
-    printf("Successful: %d (%.1f%%)\n",
-           g_perf_stats.successful_acquisitions,
-           g_perf_stats.total_acquisitions > 0 ?
-           (float)g_perf_stats.successful_acquisitions / g_perf_stats.total_acquisitions * 100 : 0);
-    printf("Failed: %d (%.1f%%)\n",
-           g_perf_stats.failed_acquisitions,
-           g_perf_stats.total_acquisitions > 0 ?
-           (float)g_perf_stats.failed_acquisitions / g_perf_stats.total_acquisitions * 100 : 0);
-    printf("Timeouts: %d\n", g_perf_stats.timeouts);
-    printf("Preemptive Acquisitions: %d\n", g_perf_stats.preemptive_acquisitions);
-    printf("Average Wait Time: %.2f seconds\n", g_perf_stats.average_wait_time);
+    printf("Total Acquisitions: %lld\n", stats.total_acquisitions);
+    printf("Successful: %lld (%.1f%%)\n",
+           stats.successful_acquisitions,
+           stats.total_acquisitions > 0 ?
+           (float)stats.successful_acquisitions / stats.total_acquisitions * 100 : 0);
+    printf("Failed: %lld (%.1f%%)\n",
+           stats.failed_acquisitions,
+           stats.total_acquisitions > 0 ?
+           (float)stats.failed_acquisitions / stats.total_acquisitions * 100 : 0);
+    printf("Timeouts: %lld\n", stats.timeouts);
+    printf("Preemptive Acquisitions: %lld\n", stats.preemptive_acquisitions);
+    printf("Average Wait Time: %.6f seconds\n", get_mutex_average_wait_time(&stats));
+    printf("Acquire Latency p50/p99/max: %.1f / %.1f / %.1f us\n",
+           histogram_percentile(latency, 50.0) / (double)NS_PER_US,
+           histogram_percentile(latency, 99.0) / (double)NS_PER_US,
+           histogram_max(latency) / (double)NS_PER_US);
     printf("Acquisition Rate: %.2f per second\n",
-           monitoring_duration > 0 ? (float)g_perf_stats.total_acquisitions / monitoring_duration : 0);
+           monitoring_duration > 0 ? (float)stats.total_acquisitions / monitoring_duration : 0);
     printf("====================================\n\n");
 }
 
@@ -399,6 +426,15 @@ int get_allocation_strategy() {
     return traffic_mutex_initialized ? g_traffic_mutex.allocation_strategy : 0;
 }
 
+const char* get_allocation_strategy_name(int strategy) {
+    switch (strategy) {
+        case 0: return "FIFO";
+        case 1: return "Banker's";
+        case 2: return "Hybrid";
+        default: return "Unknown";
+    }
+}
+
 void set_enhanced_mode(bool enabled) {
     if (traffic_mutex_initialized) {
         g_traffic_mutex.enhanced_mode = enabled;
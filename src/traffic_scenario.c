@@ -0,0 +1,507 @@
+/*
+ * Traffic Scenario Implementation - Parsing, Baking and Arrival Sampling
+ *
+ * Parsing keeps the curves as written. Resolution evaluates every curve
+ * once per minute of the day against the geometry's approaches, so the
+ * generator's per-arrival work is a few table lookups and one logarithm.
+ *
+ * Compilation: Include traffic_scenario.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/traffic_scenario.h"
+#include "../include/sim_clock.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+
+#define SCENARIO_FILE_MAX_BYTES 16384
+#define SECONDS_PER_DAY 86400
+
+static const char movement_letters[NUM_MOVEMENTS] = {'L', 'S', 'R', 'U'};
+
+static const struct {
+    const char* name;
+    SchedulingAlgorithm algorithm;
+} policy_names[] = {
+    {"sjf", SJF}, {"multilevel", MULTILEVEL_FEEDBACK}, {"priority", PRIORITY_ROUND_ROBIN}
+};
+
+static TrafficScenario g_scenario;
+static bool scenario_active = false;
+
+// "HH:MM" -> minute of day; -1 if malformed
+static int parse_time_of_day(const char* text) {
+    int hours, minutes;
+    char extra;
+    if (sscanf(text, "%d:%d%c", &hours, &minutes, &extra) != 2 ||
+        hours < 0 || hours > 23 || minutes < 0 || minutes > 59) {
+        return -1;
+    }
+    return hours * 60 + minutes;
+}
+
+static int parse_policy_name(const char* text) {
+    for (size_t i = 0; i < sizeof(policy_names) / sizeof(policy_names[0]); i++) {
+        if (strcmp(text, policy_names[i].name) == 0) {
+            return policy_names[i].algorithm;
+        }
+    }
+    return -1;
+}
+
+// "<HH:MM> <value> ..." pairs into a curve; 'is_policy' takes algorithm names
+static bool parse_curve(ScenarioCurve* curve, char** save, bool is_policy, const char* source,
+                        int line_number) {
+    curve->num_points = 0;
+    char* time_text;
+    while ((time_text = strtok_r(NULL, " \t\r", save)) != NULL) {
+        char* value_text = strtok_r(NULL, " \t\r", save);
+        int minute = parse_time_of_day(time_text);
+        if (minute < 0 || !value_text) {
+            printf("%s:%d: expected <HH:MM> <value> pairs\n", source, line_number);
+            return false;
+        }
+
+        float value;
+        if (is_policy) {
+            value = (float)parse_policy_name(value_text);
+            if (value < 0) {
+                printf("%s:%d: unknown policy %s (sjf, multilevel, priority)\n", source,
+                       line_number, value_text);
+                return false;
+            }
+        } else {
+            char* end;
+            value = strtof(value_text, &end);
+            if (*end != '\0' || value < 0) {
+                printf("%s:%d: rate must be a non-negative number\n", source, line_number);
+                return false;
+            }
+        }
+
+        int n = curve->num_points;
+        if (n == SCENARIO_MAX_POINTS) {
+            printf("%s:%d: more than %d points\n", source, line_number, SCENARIO_MAX_POINTS);
+            return false;
+        }
+        if (n > 0 && minute <= curve->minute[n - 1]) {
+            printf("%s:%d: times must increase\n", source, line_number);
+            return false;
+        }
+        curve->minute[n] = (short)minute;
+        curve->value[n] = value;
+        curve->num_points++;
+    }
+
+    if (curve->num_points == 0) {
+        printf("%s:%d: at least one <HH:MM> <value> pair is needed\n", source, line_number);
+        return false;
+    }
+    return true;
+}
+
+static bool parse_turns(ScenarioTurns* turns, char** save, const char* source, int line_number) {
+    char* letter;
+    while ((letter = strtok_r(NULL, " \t\r", save)) != NULL) {
+        char* weight_text = strtok_r(NULL, " \t\r", save);
+        int movement = -1;
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            if (strlen(letter) == 1 && toupper((unsigned char)letter[0]) == movement_letters[m]) {
+                movement = m;
+            }
+        }
+        char* end = NULL;
+        float weight = weight_text ? strtof(weight_text, &end) : -1.0f;
+        if (movement < 0 || !weight_text || *end != '\0' || weight < 0) {
+            printf("%s:%d: expected <L|S|R|U> <weight> pairs\n", source, line_number);
+            return false;
+        }
+        turns->weight[movement] = weight;
+    }
+    return true;
+}
+
+static bool parse_scenario_line(TrafficScenario* scenario, char* line, const char* source,
+                                int line_number) {
+    char* save = NULL;
+    char* keyword = strtok_r(line, " \t\r", &save);
+
+    if (strcmp(keyword, "clock") == 0) {
+        char* start = strtok_r(NULL, " \t\r", &save);
+        char* speed = strtok_r(NULL, " \t\r", &save);
+        int minute = start ? parse_time_of_day(start) : -1;
+        if (minute < 0) {
+            printf("%s:%d: expected: clock <HH:MM> [<speed>]\n", source, line_number);
+            return false;
+        }
+        scenario->clock_start_seconds = minute * 60;
+        if (speed) {
+            scenario->clock_speed = strtof(speed, NULL);
+            if (scenario->clock_speed <= 0) {
+                printf("%s:%d: clock speed must be positive\n", source, line_number);
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (strcmp(keyword, "interpolate") == 0) {
+        char* mode = strtok_r(NULL, " \t\r", &save);
+        if (mode && strcmp(mode, "linear") == 0) {
+            scenario->step_interpolation = false;
+        } else if (mode && strcmp(mode, "step") == 0) {
+            scenario->step_interpolation = true;
+        } else {
+            printf("%s:%d: expected: interpolate linear|step\n", source, line_number);
+            return false;
+        }
+        return true;
+    }
+
+    if (strcmp(keyword, "geometry") == 0) {
+        char* spec = strtok_r(NULL, " \t\r", &save);
+        if (!spec) {
+            printf("%s:%d: expected: geometry <preset|file>\n", source, line_number);
+            return false;
+        }
+        snprintf(scenario->geometry, sizeof(scenario->geometry), "%s", spec);
+        return true;
+    }
+
+    if (strcmp(keyword, "demand") == 0 || strcmp(keyword, "turns") == 0) {
+        bool demand = keyword[0] == 'd';
+        char* approach = strtok_r(NULL, " \t\r", &save);
+        int count = demand ? scenario->num_demands : scenario->num_turns;
+        if (!approach || strlen(approach) >= GEOMETRY_NAME_LENGTH) {
+            printf("%s:%d: expected: %s <approach|*> ...\n", source, line_number, keyword);
+            return false;
+        }
+        if (count == MAX_APPROACHES + 1) {
+            printf("%s:%d: too many %s lines\n", source, line_number, keyword);
+            return false;
+        }
+        for (int i = 0; i < count; i++) {
+            const char* seen = demand ? scenario->demands[i].approach : scenario->turns[i].approach;
+            if (strcmp(seen, approach) == 0) {
+                printf("%s:%d: %s for %s given twice\n", source, line_number, keyword, approach);
+                return false;
+            }
+        }
+
+        if (demand) {
+            ScenarioDemand* entry = &scenario->demands[scenario->num_demands++];
+            snprintf(entry->approach, sizeof(entry->approach), "%s", approach);
+            return parse_curve(&entry->demand, &save, false, source, line_number);
+        }
+        ScenarioTurns* entry = &scenario->turns[scenario->num_turns++];
+        snprintf(entry->approach, sizeof(entry->approach), "%s", approach);
+        return parse_turns(entry, &save, source, line_number);
+    }
+
+    if (strcmp(keyword, "emergency") == 0) {
+        return parse_curve(&scenario->emergency, &save, false, source, line_number);
+    }
+
+    if (strcmp(keyword, "policy") == 0) {
+        return parse_curve(&scenario->policy, &save, true, source, line_number);
+    }
+
+    printf("%s:%d: unknown directive %s\n", source, line_number, keyword);
+    return false;
+}
+
+// Parse a scenario file; resolve_traffic_scenario() must follow
+bool load_traffic_scenario(TrafficScenario* scenario, const char* path) {
+    if (!scenario || !path) {
+        return false;
+    }
+
+    static char text[SCENARIO_FILE_MAX_BYTES];
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("Cannot open scenario %s\n", path);
+        return false;
+    }
+    size_t length = fread(text, 1, sizeof(text) - 1, file);
+    bool truncated = !feof(file);
+    fclose(file);
+    if (truncated) {
+        printf("%s: scenario file larger than %d bytes\n", path, SCENARIO_FILE_MAX_BYTES - 1);
+        return false;
+    }
+    text[length] = '\0';
+
+    memset(scenario, 0, sizeof(TrafficScenario));
+    snprintf(scenario->name, sizeof(scenario->name), "%s", path);
+    scenario->clock_speed = 1.0f;
+
+    int line_number = 0;
+    char* save = NULL;
+    for (char* line = strtok_r(text, "\n", &save); line; line = strtok_r(NULL, "\n", &save)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) {
+            *comment = '\0';
+        }
+        if (strspn(line, " \t\r") == strlen(line)) {
+            continue;
+        }
+        if (!parse_scenario_line(scenario, line, path, line_number)) {
+            return false;
+        }
+    }
+
+    if (scenario->num_demands == 0) {
+        printf("%s: no demand lines\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Curve value at 'minute'; the day wraps from the last point to the first
+static float evaluate_curve(const ScenarioCurve* curve, int minute, bool step) {
+    int n = curve->num_points;
+    int previous = n - 1;
+    for (int i = 0; i < n && curve->minute[i] <= minute; i++) {
+        previous = i;
+    }
+    if (step || n == 1) {
+        return curve->value[previous];
+    }
+
+    int next = (previous + 1) % n;
+    int span = (curve->minute[next] - curve->minute[previous] + SCENARIO_MINUTES) % SCENARIO_MINUTES;
+    int into = (minute - curve->minute[previous] + SCENARIO_MINUTES) % SCENARIO_MINUTES;
+    if (span == 0) {
+        return curve->value[previous];
+    }
+    return curve->value[previous] +
+           (curve->value[next] - curve->value[previous]) * (float)into / (float)span;
+}
+
+// Demand line for the approach, else the "*" one; -1 if neither
+static int find_demand(const TrafficScenario* scenario, const char* approach) {
+    int wildcard = -1;
+    for (int i = 0; i < scenario->num_demands; i++) {
+        if (strcmp(scenario->demands[i].approach, approach) == 0) {
+            return i;
+        }
+        if (strcmp(scenario->demands[i].approach, "*") == 0) {
+            wildcard = i;
+        }
+    }
+    return wildcard;
+}
+
+static int find_turns(const TrafficScenario* scenario, const char* approach) {
+    int wildcard = -1;
+    for (int i = 0; i < scenario->num_turns; i++) {
+        if (strcmp(scenario->turns[i].approach, approach) == 0) {
+            return i;
+        }
+        if (strcmp(scenario->turns[i].approach, "*") == 0) {
+            wildcard = i;
+        }
+    }
+    return wildcard;
+}
+
+// Bake the parsed scenario into per-minute and per-approach tables
+bool resolve_traffic_scenario(TrafficScenario* scenario, const IntersectionGeometry* geometry) {
+    if (!scenario || !geometry) {
+        return false;
+    }
+
+    // Every named approach must exist in the geometry
+    for (int i = 0; i < scenario->num_demands + scenario->num_turns; i++) {
+        const char* name = i < scenario->num_demands ? scenario->demands[i].approach
+                                                     : scenario->turns[i - scenario->num_demands].approach;
+        bool found = strcmp(name, "*") == 0;
+        for (int a = 0; a < geometry->num_approaches && !found; a++) {
+            found = strcmp(geometry->approaches[a].name, name) == 0;
+        }
+        if (!found) {
+            printf("%s: geometry %s has no approach %s\n", scenario->name, geometry->name, name);
+            return false;
+        }
+    }
+
+    scenario->num_approaches = geometry->num_approaches;
+    int demand_entry[MAX_APPROACHES];
+    for (int a = 0; a < geometry->num_approaches; a++) {
+        const GeometryApproach* approach = &geometry->approaches[a];
+        demand_entry[a] = find_demand(scenario, approach->name);
+
+        // Lanes of this approach carrying each movement
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            scenario->movement_lane_count[a][m] = 0;
+            for (int l = approach->first_lane; l < approach->first_lane + approach->num_lanes; l++) {
+                if (geometry->lanes[l].movements & (1 << m)) {
+                    scenario->movement_lanes[a][m][scenario->movement_lane_count[a][m]++] =
+                        (unsigned char)l;
+                }
+            }
+        }
+
+        // Turning shares, without movements the approach cannot take
+        float weight[NUM_MOVEMENTS] = {
+            [MOVEMENT_LEFT] = TURN_SHARE_LEFT,
+            [MOVEMENT_STRAIGHT] = 100 - TURN_SHARE_LEFT - TURN_SHARE_RIGHT - TURN_SHARE_U_TURN,
+            [MOVEMENT_RIGHT] = TURN_SHARE_RIGHT,
+            [MOVEMENT_U_TURN] = TURN_SHARE_U_TURN
+        };
+        int turn_entry = find_turns(scenario, approach->name);
+        if (turn_entry >= 0) {
+            memcpy(weight, scenario->turns[turn_entry].weight, sizeof(weight));
+        }
+        float total = 0.0f;
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            if (scenario->movement_lane_count[a][m] == 0) {
+                weight[m] = 0.0f;
+            }
+            total += weight[m];
+        }
+        if (total <= 0.0f) {
+            printf("%s: approach %s can take none of its turning movements\n", scenario->name,
+                   approach->name);
+            return false;
+        }
+        float running = 0.0f;
+        for (int m = 0; m < NUM_MOVEMENTS; m++) {
+            running += weight[m];
+            scenario->turn_cumulative[a][m] = (unsigned char)(100.0f * running / total + 0.5f);
+        }
+        scenario->turn_cumulative[a][NUM_MOVEMENTS - 1] = 100;
+    }
+
+    for (int minute = 0; minute < SCENARIO_MINUTES; minute++) {
+        float rate[MAX_APPROACHES] = {0};
+        float total = 0.0f;
+        for (int a = 0; a < geometry->num_approaches; a++) {
+            if (demand_entry[a] >= 0) {
+                rate[a] = evaluate_curve(&scenario->demands[demand_entry[a]].demand, minute,
+                                         scenario->step_interpolation);
+            }
+            total += rate[a];
+        }
+        scenario->total_rate[minute] = total;
+
+        float running = 0.0f;
+        for (int a = 0; a < geometry->num_approaches; a++) {
+            running += rate[a];
+            scenario->approach_cumulative[minute][a] = total > 0.0f ?
+                (unsigned short)((SCENARIO_SHARE_SCALE - 1) * running / total) : 0;
+        }
+        if (geometry->num_approaches > 0) {
+            scenario->approach_cumulative[minute][geometry->num_approaches - 1] =
+                SCENARIO_SHARE_SCALE - 1;
+        }
+
+        // Emergencies ride on arrivals: their share is the ratio of the two rates
+        float emergencies = scenario->emergency.num_points > 0 ?
+            evaluate_curve(&scenario->emergency, minute, scenario->step_interpolation) : 0.0f;
+        scenario->emergency_share[minute] = total > 0.0f ? fminf(1.0f, emergencies / total) : 0.0f;
+
+        // A policy holds until the next one, whatever the interpolation
+        scenario->policy_by_minute[minute] = scenario->policy.num_points > 0 ?
+            (signed char)evaluate_curve(&scenario->policy, minute, true) : -1;
+    }
+    return true;
+}
+
+// Install the scenario the generator samples; resolve it first
+void set_traffic_scenario(const TrafficScenario* scenario) {
+    if (!scenario) {
+        scenario_active = false;
+        return;
+    }
+    g_scenario = *scenario;
+    scenario_active = true;
+}
+
+// Active scenario, NULL when arrivals use the flat -a/-A rate
+const TrafficScenario* get_traffic_scenario() {
+    return scenario_active ? &g_scenario : NULL;
+}
+
+// Scenario time of day, in seconds, 'elapsed_ns' into the simulation
+int scenario_time_of_day(const TrafficScenario* scenario, long long elapsed_ns) {
+    double seconds = scenario->clock_start_seconds +
+                     (double)elapsed_ns / NS_PER_SEC * scenario->clock_speed;
+    return (int)fmod(seconds, SECONDS_PER_DAY);
+}
+
+// Next arrival after 'elapsed_ns'. A gap that would cross into the next
+// minute stops at the boundary with no arrival; the exponential gap is
+// memoryless, so sampling again from there is exact.
+void sample_scenario_arrival(const TrafficScenario* scenario, long long elapsed_ns,
+                             unsigned int* seed, ScenarioArrival* arrival) {
+    double day_seconds = scenario->clock_start_seconds +
+                         (double)elapsed_ns / NS_PER_SEC * scenario->clock_speed;
+    day_seconds = fmod(day_seconds, SECONDS_PER_DAY);
+    int minute = (int)(day_seconds / 60);
+
+    // Both in simulated seconds
+    double to_boundary = ((minute + 1) * 60.0 - day_seconds) / scenario->clock_speed;
+    double rate = scenario->total_rate[minute] / 3600.0 * scenario->clock_speed;
+
+    arrival->lane_id = -1;
+    arrival->emergency = false;
+    arrival->movement = MOVEMENT_STRAIGHT;
+    arrival->policy = scenario->policy_by_minute[minute];
+
+    double gap = to_boundary;
+    if (rate > 0.0) {
+        double uniform = ((double)rand_r(seed) + 1.0) / ((double)RAND_MAX + 2.0);
+        gap = -log(uniform) / rate;
+    }
+    if (gap >= to_boundary) {
+        // Land just past the boundary so the next call reads the next minute
+        arrival->gap_ns = (long long)(to_boundary * NS_PER_SEC) + 1;
+        return;
+    }
+    arrival->gap_ns = (long long)(gap * NS_PER_SEC);
+
+    // Approach a takes shares in [cumulative[a - 1], cumulative[a])
+    int share = rand_r(seed) % (SCENARIO_SHARE_SCALE - 1);
+    int approach = 0;
+    while (approach < scenario->num_approaches - 1 &&
+           share >= scenario->approach_cumulative[minute][approach]) {
+        approach++;
+    }
+
+    int roll = rand_r(seed) % 100;
+    int movement = 0;
+    while (movement < NUM_MOVEMENTS - 1 && roll >= scenario->turn_cumulative[approach][movement]) {
+        movement++;
+    }
+
+    int lanes = scenario->movement_lane_count[approach][movement];
+    arrival->movement = (VehicleMovement)movement;
+    arrival->lane_id = scenario->movement_lanes[approach][movement][rand_r(seed) % lanes];
+
+    float emergency_share = scenario->emergency_share[minute];
+    arrival->emergency = emergency_share > 0.0f &&
+                         (double)rand_r(seed) / RAND_MAX < emergency_share;
+}
+
+void print_traffic_scenario(const TrafficScenario* scenario) {
+    if (!scenario) {
+        return;
+    }
+
+    int start = scenario->clock_start_seconds / 60;
+    printf("Scenario: %s, clock %02d:%02d x%g, %s interpolation\n", scenario->name, start / 60,
+           start % 60, scenario->clock_speed, scenario->step_interpolation ? "step" : "linear");
+    printf("  hour  veh/h  emergency%%  policy\n");
+    for (int hour = 0; hour < 24; hour++) {
+        int minute = hour * 60;
+        int policy = scenario->policy_by_minute[minute];
+        printf("  %02d:00 %6.0f %10.2f  %s\n", hour, scenario->total_rate[minute],
+               scenario->emergency_share[minute] * 100.0f,
+               policy >= 0 ? get_algorithm_name((SchedulingAlgorithm)policy) : "-");
+    }
+}
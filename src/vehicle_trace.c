@@ -0,0 +1,209 @@
+/*
+ * Vehicle Trace Implementation - Per-Thread Buffers, Append-Only File
+ *
+ * A thread claims one of TRACE_MAX_THREADS static buffers on its first
+ * event and returns it when it exits (flushing what it holds). A thread
+ * that finds no free buffer drops its events and they are counted.
+ * stop_vehicle_trace() flushes the buffers still claimed; it must run after
+ * the simulation threads have been joined, as cleanup_and_exit() does.
+ *
+ * Compilation: Include vehicle_trace.h, intersection_geometry.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/vehicle_trace.h"
+#include "../include/logger.h"
+#include "../include/sim_clock.h"
+#include "../include/intersection_geometry.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+    TraceRecord records[TRACE_BUFFER_RECORDS];
+    int count;
+    int in_use;
+} TraceBuffer;
+
+typedef struct {
+    int fd;
+    bool enabled;
+    bool key_created;
+    pthread_key_t buffer_key;
+    long long start_ns;
+    long long records_written;
+    long long records_dropped;
+} VehicleTrace;
+
+static TraceBuffer g_trace_buffers[TRACE_MAX_THREADS];
+static VehicleTrace g_trace = { .fd = -1 };
+static __thread TraceBuffer* tls_trace_buffer = NULL;
+
+// Append a buffer's records with one write() so threads never interleave
+static void flush_trace_buffer(TraceBuffer* buffer) {
+    if (buffer->count == 0) {
+        return;
+    }
+
+    int fd = __atomic_load_n(&g_trace.fd, __ATOMIC_ACQUIRE);
+    if (fd >= 0) {
+        const char* data = (const char*)buffer->records;
+        size_t total = (size_t)buffer->count * sizeof(TraceRecord);
+        size_t remaining = total;
+        while (remaining > 0) {
+            ssize_t written = write(fd, data, remaining);
+            if (written < 0 && errno == EINTR) {
+                continue;
+            }
+            if (written <= 0) {
+                break;
+            }
+            data += written;
+            remaining -= (size_t)written;
+        }
+
+        // Only whole records made it; a torn last record counts as dropped
+        long long complete = (long long)((total - remaining) / sizeof(TraceRecord));
+        __atomic_fetch_add(&g_trace.records_written, complete, __ATOMIC_RELAXED);
+        if (complete < buffer->count) {
+            __atomic_fetch_add(&g_trace.records_dropped, buffer->count - complete,
+                               __ATOMIC_RELAXED);
+        }
+    }
+
+    buffer->count = 0;
+}
+
+// Thread exit: flush and hand the buffer back
+static void release_trace_buffer(void* arg) {
+    TraceBuffer* buffer = (TraceBuffer*)arg;
+    if (!buffer) {
+        return;
+    }
+
+    flush_trace_buffer(buffer);
+    __atomic_store_n(&buffer->in_use, 0, __ATOMIC_RELEASE);
+}
+
+static TraceBuffer* acquire_trace_buffer(void) {
+    if (tls_trace_buffer) {
+        return tls_trace_buffer;
+    }
+
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&g_trace_buffers[i].in_use, &expected, 1, false,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+            g_trace_buffers[i].count = 0;
+            tls_trace_buffer = &g_trace_buffers[i];
+            pthread_setspecific(g_trace.buffer_key, tls_trace_buffer);
+            return tls_trace_buffer;
+        }
+    }
+
+    return NULL;
+}
+
+// Open (or create) the trace file and enable tracing
+int start_vehicle_trace(const char* path) {
+    if (!path || g_trace.enabled) {
+        return -1;
+    }
+
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open trace file %s", path);
+        return -1;
+    }
+
+    if (!g_trace.key_created) {
+        if (pthread_key_create(&g_trace.buffer_key, release_trace_buffer) != 0) {
+            close(fd);
+            return -1;
+        }
+        g_trace.key_created = true;
+    }
+
+    // One run per file: header, then records appended until stop
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    g_trace.start_ns = monotonic_now_ns();
+
+    TraceFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, 4);
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(TraceRecord);
+    header.start_wall_ns = (int64_t)wall.tv_sec * NS_PER_SEC + wall.tv_nsec;
+    header.start_monotonic_ns = g_trace.start_ns;
+    header.num_lanes = (uint32_t)get_num_lanes();
+    strncpy(header.geometry, get_intersection_geometry()->name, sizeof(header.geometry) - 1);
+
+    if (write(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        close(fd);
+        return -1;
+    }
+
+    g_trace.records_written = 0;
+    g_trace.records_dropped = 0;
+    __atomic_store_n(&g_trace.fd, fd, __ATOMIC_RELEASE);
+    __atomic_store_n(&g_trace.enabled, true, __ATOMIC_RELEASE);
+
+    LOG_INFO("Vehicle trace enabled: %s", path);
+    return 0;
+}
+
+// Flush the remaining buffers and close the file (producers must have stopped)
+void stop_vehicle_trace() {
+    if (!__atomic_load_n(&g_trace.enabled, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    __atomic_store_n(&g_trace.enabled, false, __ATOMIC_RELEASE);
+
+    for (int i = 0; i < TRACE_MAX_THREADS; i++) {
+        if (__atomic_load_n(&g_trace_buffers[i].in_use, __ATOMIC_ACQUIRE)) {
+            flush_trace_buffer(&g_trace_buffers[i]);
+        }
+    }
+
+    int fd = __atomic_exchange_n(&g_trace.fd, -1, __ATOMIC_ACQ_REL);
+    close(fd);
+
+    LOG_INFO("Vehicle trace closed: %lld records, %lld dropped",
+             g_trace.records_written, g_trace.records_dropped);
+}
+
+bool is_vehicle_trace_enabled() {
+    return __atomic_load_n(&g_trace.enabled, __ATOMIC_ACQUIRE);
+}
+
+// Record one event into the calling thread's buffer
+void trace_vehicle_event(TraceEventType type, int vehicle_id, int lane_id, int aux, int value) {
+    if (!__atomic_load_n(&g_trace.enabled, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    TraceBuffer* buffer = acquire_trace_buffer();
+    if (!buffer) {
+        __atomic_fetch_add(&g_trace.records_dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    TraceRecord* record = &buffer->records[buffer->count++];
+    record->timestamp_ns = monotonic_now_ns() - g_trace.start_ns;
+    record->vehicle_id = vehicle_id;
+    record->type = (uint8_t)type;
+    record->lane_id = (uint8_t)lane_id;
+    record->aux = (uint16_t)aux;
+    record->value = value;
+    record->reserved = 0;
+
+    if (buffer->count == TRACE_BUFFER_RECORDS) {
+        flush_trace_buffer(buffer);
+    }
+}
@@ -3,7 +3,10 @@
  *
  * Implements ncurses-based traffic simulation visualization.
  * Manages multi-window display, color support, and real-time metrics updates.
- * Uses non-blocking input and trylock to prevent deadlocks.
+ * Uses non-blocking input; simulation state comes from the published
+ * SimSnapshot, so drawing never takes a simulation lock. Each frame is built
+ * into a cell model and only the cells that differ from the last frame are
+ * written to the screen.
  *
  * Compilation: Include visualization.h, trafficguru.h, ncurses library required
  */
@@ -11,8 +14,18 @@
 /*
  * IMPLEMENTATION NOTES:
  * - Uses ncurses for terminal UI
- * - Fixes deadlock by using pthread_mutex_trylock instead of pthread_mutex_lock
- * - Maintains stale data cache to prevent UI freezing when locks are held
+ * - Reads lanes, metrics and the algorithm from one seqlock-published
+ *   SimSnapshot per frame (see sim_snapshot.h) instead of trylock caches
+ * - Never calls wclear(): a frame is a chtype grid diffed against the
+ *   previous one, so an idle screen sends nothing but the clock
+ * - Frames are paced between 100 ms and 1 s: the interval doubles while
+ *   frames touch more than 1/8 of the screen and halves once they are small
+ * - Ctrl-L forces a full repaint for terminals that lost their contents
+ * - [G] swaps the lane and metrics regions for a Gantt view of the
+ *   execution history: one column per 2^k seconds read from the matching
+ *   level of the scheduler's GanttHistory, so a frame costs one bucket per
+ *   column however much history there is
+ * - Signal changes seen in the snapshot are added to the SignalHistory
  * - Uses non-blocking getch() via wgetch(main_window)
  * - Signal history tracks lane state changes for analysis
  */
@@ -20,7 +33,10 @@
 #define _XOPEN_SOURCE 600
 #include "../include/visualization.h"
 #include "../include/trafficguru.h"
+#include "../include/sim_clock.h"
 #include <ncurses.h>
+#include <stdarg.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <unistd.h>
@@ -29,20 +45,65 @@ static bool show_help = false;
 static bool pause_requested = false;
 
 static WINDOW *main_win = NULL;
-static WINDOW *status_win = NULL;
-static WINDOW *metrics_win = NULL;
-static WINDOW *lanes_win = NULL;
 static WINDOW *help_win = NULL;
 
-static int last_queues[NUM_LANES] = {0, 0, 0, 0};
-static int last_waits[NUM_LANES] = {0, 0, 0, 0};
-static LaneState last_states[NUM_LANES] = {WAITING, WAITING, WAITING, WAITING};
-static PerformanceMetrics last_metrics = {0};
-static bool last_emergency_mode = false;
-
-static void draw_borders(void);
-static void draw_lanes_window(LaneProcess lanes[4]);
-static void draw_metrics_window(PerformanceMetrics* metrics, SchedulingAlgorithm current_algo);
+// Frame pacing: at most one frame per interval, and only when the snapshot
+// or the clock moved. The interval backs off while frames are large (slow
+// links) and returns to the minimum once they are small again.
+#define FRAME_INTERVAL_MIN_NS (100 * NS_PER_MS)
+#define FRAME_INTERVAL_MAX_NS (1000 * NS_PER_MS)
+#define FRAME_LARGE_DIVISOR 8      // > 1/8 of the cells changed: slow down
+#define FRAME_SMALL_DIVISOR 32     // < 1/32 of the cells changed: speed up
+#define LANES_PER_COLUMN 6         // Status table rows above the legend
+
+// Screen regions, in stdscr coordinates
+typedef struct {
+    int top;
+    int left;
+    int height;
+    int width;
+} FrameRegion;
+
+// Frame model: 'cells' is the frame being built, 'shown' what was last
+// written to the screen. Only cells that differ are sent.
+typedef struct {
+    chtype* cells;
+    chtype* shown;
+    int rows;
+    int cols;
+} FrameModel;
+
+static FrameModel frame = {NULL, NULL, 0, 0};
+static bool frame_forced = true;
+static long long last_frame_ns = 0;
+static long long frame_interval_ns = FRAME_INTERVAL_MIN_NS;
+static unsigned long long last_frame_version = 0;
+static time_t last_frame_second = 0;
+
+// What the data regions last showed; reused while paused
+static SimSnapshot drawn_snapshot;
+static TimeSeriesSample drawn_recent;
+static bool drawn_recent_valid = false;
+
+// Gantt view: 2^gantt_level seconds per column, scrolled gantt_offset
+// columns back from now (0 = follow the live edge)
+static bool gantt_view = false;
+static int gantt_level = 0;
+static long long gantt_offset = 0;
+static int gantt_columns = 1;
+static GanttBucket gantt_buckets[GANTT_LEVEL_BUCKETS];
+static int last_signal_lane = -2;
+
+static bool frame_resize(int rows, int cols);
+static void frame_begin(void);
+static void frame_print(const FrameRegion* region, int row, int col, chtype attrs, const char* fmt, ...);
+static void frame_box(const FrameRegion* region, const char* title);
+static int frame_flush(void);
+static void draw_header(const SimSnapshot* snapshot, time_t now);
+static void draw_lanes_window(const FrameRegion* region, const SimSnapshot* snapshot);
+static void draw_metrics_window(const FrameRegion* region, const SimSnapshot* snapshot);
+static void draw_gantt_window(const FrameRegion* region, const SimSnapshot* snapshot, time_t now);
+static void draw_status_bar(const FrameRegion* region);
 static void show_help_screen(Visualization* viz);
 
 // Initialize visualization system
@@ -72,48 +133,50 @@ void init_visualization(Visualization* viz) {
 
     viz->main_window = main_win; // Store main window
     
-    // Create windows
     int y, x;
     getmaxyx(main_win, y, x);
     viz->screen_height = y;
     viz->screen_width = x;
-    
-    // (Window creation logic would go here, for now, we use main_win)
-    lanes_win = subwin(main_win, 15, x - 4, 3, 2);
-    metrics_win = subwin(main_win, 10, x - 4, 19, 2);
-    status_win = subwin(main_win, 3, x, y - 3, 0);
+
+    // All regions are drawn into the frame model and diffed onto stdscr
+    frame_resize(y, x);
+    frame_forced = true;
+    last_frame_ns = 0;
+    frame_interval_ns = FRAME_INTERVAL_MIN_NS;
+    last_frame_version = 0;
+    last_frame_second = 0;
+    memset(&drawn_snapshot, 0, sizeof(drawn_snapshot));
+    drawn_snapshot.current_lane = -1;
+    drawn_recent_valid = false;
+    gantt_view = false;
+    gantt_level = 0;
+    gantt_offset = 0;
+    last_signal_lane = -2;
     
     // Initialize signal history
     init_signal_history(&viz->signal_history, 100);
 
     // --- FIX: Use local static variable ---
     show_help = false;
-
-    // --- DEADLOCK FIX: Initialize stale cache ---
-    // Clear all our static cache variables to a known-good state.
-    memset(&last_metrics, 0, sizeof(PerformanceMetrics));
-    last_emergency_mode = false;
-    for (int i = 0; i < NUM_LANES; i++) {
-        last_queues[i] = 0;
-        last_waits[i] = 0;
-        last_states[i] = WAITING;
-    }
-    // --- END DEADLOCK FIX ---
 }
 
 // Destroy visualization system
 void destroy_visualization(Visualization* viz) {
     if (!viz) return;
     
-    // Clean up ncurses windows
-    delwin(lanes_win);
-    delwin(metrics_win);
-    delwin(status_win);
     if(help_win) delwin(help_win);
+    help_win = NULL;
 
     // --- NCURSES CLEANUP ---
     endwin(); // IMPORTANT: Restore terminal to normal mode
 
+    free(frame.cells);
+    free(frame.shown);
+    frame.cells = NULL;
+    frame.shown = NULL;
+    frame.rows = 0;
+    frame.cols = 0;
+
     // Clean up signal history
     destroy_signal_history(&viz->signal_history);
 }
@@ -128,6 +191,11 @@ int handle_user_input(Visualization* viz) {
     int ch = wgetch(viz->main_window); // Read a key (non-blocking)
     // --- END INPUT FREEZE FIX ---
 
+    // Any key may change what is on screen; draw the next frame right away
+    if (ch != ERR) {
+        frame_forced = true;
+    }
+
     // If help is active, any key closes it
     // --- FIX: Use local static variable ---
     if (show_help) {
@@ -137,6 +205,9 @@ int handle_user_input(Visualization* viz) {
                 delwin(help_win);
                 help_win = NULL;
             }
+            // The help window covered stdscr; let doupdate() compare every
+            // line again so the uncovered cells are resent
+            touchwin(stdscr);
             
             // --- HELP SCREEN FREEZE FIX ---
             // If pause was requested (sim was paused before 'h'), keep it paused.
@@ -182,10 +253,16 @@ int handle_user_input(Visualization* viz) {
         case 'E':
             // --- FIX: Commented out to fix build error ---
             // You can re-enable this once trigger_emergency_vehicle is in a header
-            // trigger_emergency_vehicle(&g_traffic_system->emergency_system, rand() % NUM_LANES);
+            // trigger_emergency_vehicle(&g_traffic_system->emergency_system, rand() % get_num_lanes());
             (void)0; // No-op to keep 'e' case
             break;
 
+        case 'c':
+        case 'C':
+            // Taken by the simulation thread between time slices
+            request_checkpoint();
+            break;
+
         case 'h':
         case 'H':
             // --- FIX: Use local static variable ---
@@ -199,6 +276,57 @@ int handle_user_input(Visualization* viz) {
             }
             break;
 
+        case 'g':
+        case 'G':
+            gantt_view = !gantt_view;
+            break;
+
+        case KEY_LEFT: // Scroll the Gantt view back a quarter screen
+            gantt_offset += gantt_columns / 4 > 0 ? gantt_columns / 4 : 1;
+            if (gantt_offset > GANTT_LEVEL_BUCKETS - gantt_columns) {
+                gantt_offset = GANTT_LEVEL_BUCKETS - gantt_columns;
+            }
+            if (gantt_offset < 0) {
+                gantt_offset = 0;
+            }
+            break;
+
+        case KEY_RIGHT:
+            gantt_offset -= gantt_columns / 4 > 0 ? gantt_columns / 4 : 1;
+            if (gantt_offset < 0) {
+                gantt_offset = 0;
+            }
+            break;
+
+        case KEY_END:
+            gantt_offset = 0;
+            break;
+
+        case '+': // Zoom in, keeping the right edge where it was
+        case '=':
+            if (gantt_level > 0) {
+                gantt_level--;
+                gantt_offset *= 2;
+                if (gantt_offset > GANTT_LEVEL_BUCKETS - gantt_columns) {
+                    gantt_offset = GANTT_LEVEL_BUCKETS - gantt_columns;
+                }
+                if (gantt_offset < 0) {
+                    gantt_offset = 0;
+                }
+            }
+            break;
+
+        case '-':
+            if (gantt_level < GANTT_LEVELS - 1) {
+                gantt_level++;
+                gantt_offset /= 2;
+            }
+            break;
+
+        case 12: // Ctrl-L: the terminal lost its contents, repaint everything
+            clearok(curscr, TRUE);
+            break;
+
         case ERR: // No key pressed
         default:
             return 0; // No action
@@ -206,173 +334,322 @@ int handle_user_input(Visualization* viz) {
     return ch;
 }
 
-// --- All functions below are ncurses-based display functions ---
+// --- Frame model ---
 
-static void draw_borders(void) {
-    int y, x;
-    getmaxyx(main_win, y, x);
-    
-    // --- FIX: Cleaned up garbled text ---
-    // We remove the box(main_win, 0, 0) call, as it's
-    // unnecessary and causes the garbled text on line 0.
-    // box(main_win, 0, 0); // <-- DELETED
-    // --- END FIX ---
-    
-    // Lane window
-    box(lanes_win, 0, 0);
-    mvwprintw(lanes_win, 0, 2, " Intersection Status ");
+// Size the model to the terminal; everything is resent on the next flush
+static bool frame_resize(int rows, int cols) {
+    if (rows <= 0 || cols <= 0) {
+        return false;
+    }
+
+    size_t count = (size_t)rows * (size_t)cols;
+    chtype* cells = realloc(frame.cells, count * sizeof(chtype));
+    if (!cells) {
+        return false;
+    }
+    frame.cells = cells;
+
+    chtype* shown = realloc(frame.shown, count * sizeof(chtype));
+    if (!shown) {
+        return false;
+    }
+    frame.shown = shown;
+
+    // No drawable cell is 0, so every cell differs from 'shown'
+    memset(frame.shown, 0, count * sizeof(chtype));
+    frame.rows = rows;
+    frame.cols = cols;
+    return true;
+}
 
-    // Metrics window
-    box(metrics_win, 0, 0);
-    mvwprintw(metrics_win, 0, 2, " Performance Metrics ");
+// Start a new frame from blank cells
+static void frame_begin(void) {
+    size_t count = (size_t)frame.rows * (size_t)frame.cols;
+    for (size_t i = 0; i < count; i++) {
+        frame.cells[i] = (chtype)' ';
+    }
+}
+
+static void frame_put(int row, int col, chtype cell) {
+    if (row < 0 || row >= frame.rows || col < 0 || col >= frame.cols) {
+        return;
+    }
+    frame.cells[row * frame.cols + col] = cell;
+}
+
+// printf into a region, clipped to its width like a subwindow would be
+static void frame_print(const FrameRegion* region, int row, int col, chtype attrs, const char* fmt, ...) {
+    if (row < 0 || row >= region->height || col < 0 || col >= region->width) {
+        return;
+    }
+
+    char text[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(text, sizeof(text), fmt, args);
+    va_end(args);
+
+    int screen_row = region->top + row;
+    for (int i = 0; text[i] && col + i < region->width; i++) {
+        frame_put(screen_row, region->left + col + i, (chtype)(unsigned char)text[i] | attrs);
+    }
+}
 
-    // Status bar
-    box(status_win, 0, 0);
-    mvwprintw(status_win, 0, 2, " Status & Controls ");
+// Border and title, as box() plus a title on the top edge
+static void frame_box(const FrameRegion* region, const char* title) {
+    int top = region->top;
+    int left = region->left;
+    int bottom = region->top + region->height - 1;
+    int right = region->left + region->width - 1;
+    if (region->height < 2 || region->width < 2) {
+        return;
+    }
+
+    for (int x = left + 1; x < right; x++) {
+        frame_put(top, x, ACS_HLINE);
+        frame_put(bottom, x, ACS_HLINE);
+    }
+    for (int y = top + 1; y < bottom; y++) {
+        frame_put(y, left, ACS_VLINE);
+        frame_put(y, right, ACS_VLINE);
+    }
+    frame_put(top, left, ACS_ULCORNER);
+    frame_put(top, right, ACS_URCORNER);
+    frame_put(bottom, left, ACS_LLCORNER);
+    frame_put(bottom, right, ACS_LRCORNER);
+
+    if (title) {
+        frame_print(region, 0, 2, A_NORMAL, "%s", title);
+    }
+}
+
+// Write the cells that changed since the last flush; returns how many
+static int frame_flush(void) {
+    int changed = 0;
+
+    for (int y = 0; y < frame.rows; y++) {
+        chtype* row = frame.cells + y * frame.cols;
+        chtype* shown = frame.shown + y * frame.cols;
+        for (int x = 0; x < frame.cols; x++) {
+            if (row[x] == shown[x]) {
+                continue;
+            }
+            // The bottom-right cell would scroll the screen on some terminals
+            if (y == frame.rows - 1 && x == frame.cols - 1) {
+                shown[x] = row[x];
+                continue;
+            }
+            mvaddch(y, x, row[x]);
+            shown[x] = row[x];
+            changed++;
+        }
+    }
 
-    // --- FIX: Suppress unused 'y' warning ---
-    (void)y;
+    wnoutrefresh(stdscr);
+    doupdate();
+    return changed;
 }
 
+// --- All functions below are ncurses-based display functions ---
+
 void display_real_time_status() {
+    if (!g_traffic_system) {
+        return;
+    }
+
     // --- FIX: Use local static variable ---
-    if (!g_traffic_system || show_help) {
+    if (show_help) {
         show_help_screen(&g_traffic_system->visualization);
         return; // Don't draw main UI if help is showing
     }
 
-    // --- FIX: FLICKER REMOVED ---
-    // We must manually clear the header lines
-    int max_x = getmaxx(stdscr);
-    // Clear line 1 and 2
-    attron(A_NORMAL); // Use normal attributes
-    // --- FIX: Clear line 0 as well ---
-    mvprintw(0, 0, "%*s", max_x, ""); 
-    mvprintw(1, 0, "%*s", max_x, ""); 
-    mvprintw(2, 0, "%*s", max_x, "");
+    int max_y, max_x;
+    getmaxyx(stdscr, max_y, max_x);
+    if (max_y != frame.rows || max_x != frame.cols) {
+        if (!frame_resize(max_y, max_x)) {
+            return;
+        }
+        g_traffic_system->visualization.screen_height = max_y;
+        g_traffic_system->visualization.screen_width = max_x;
+        clearok(curscr, TRUE);
+        frame_forced = true;
+    }
 
+    // One torn-free copy of the simulation for the whole frame
+    SimSnapshot snapshot;
+    if (!read_sim_snapshot(&snapshot)) {
+        memset(&snapshot, 0, sizeof(snapshot));
+        snapshot.algorithm = g_traffic_system->scheduler.algorithm;
+        snapshot.current_lane = -1;
+    }
 
-    // Get current time for display
+    // Skip the frame unless something visible moved and the interval is up
+    long long now_ns = monotonic_now_ns();
     time_t now = time(NULL);
+    bool changed = snapshot.version != last_frame_version || now != last_frame_second;
+    if (!frame_forced && (!changed || now_ns - last_frame_ns < frame_interval_ns)) {
+        return;
+    }
+
+    // --- FIX FOR PAUSE & FLICKER ---
+    // The data regions keep showing the last frame while paused.
+    if (!g_traffic_system->simulation_paused) {
+        drawn_snapshot = snapshot;
+        drawn_recent_valid = timeseries_latest(&g_traffic_system->metrics.timeseries,
+                                               TIMESERIES_10S, &drawn_recent);
+    }
+    // --- END FIX ---
+
+    // Every green change the UI sees goes into the signal history
+    if (snapshot.version != 0 && snapshot.current_lane != last_signal_lane) {
+        add_signal_event(&g_traffic_system->visualization.signal_history,
+                         snapshot.current_lane, RUNNING, now);
+        last_signal_lane = snapshot.current_lane;
+    }
+
+    FrameRegion lanes = {3, 2, 15, max_x - 4};
+    FrameRegion metrics = {19, 2, 10, max_x - 4};
+    FrameRegion gantt = {3, 2, max_y - 6, max_x - 4};
+    FrameRegion status = {max_y - 3, 0, 3, max_x};
+
+    frame_begin();
+    draw_header(&snapshot, now);
+    if (gantt_view) {
+        draw_gantt_window(&gantt, &drawn_snapshot, now);
+    } else {
+        draw_lanes_window(&lanes, &drawn_snapshot);
+        draw_metrics_window(&metrics, &drawn_snapshot);
+    }
+    draw_status_bar(&status);
+    int cells_changed = frame_flush();
+
+    // Adapt the pace to how much each frame costs to send
+    int cells_total = frame.rows * frame.cols;
+    if (cells_changed * FRAME_LARGE_DIVISOR > cells_total) {
+        frame_interval_ns *= 2;
+        if (frame_interval_ns > FRAME_INTERVAL_MAX_NS) {
+            frame_interval_ns = FRAME_INTERVAL_MAX_NS;
+        }
+    } else if (cells_changed * FRAME_SMALL_DIVISOR < cells_total) {
+        frame_interval_ns /= 2;
+        if (frame_interval_ns < FRAME_INTERVAL_MIN_NS) {
+            frame_interval_ns = FRAME_INTERVAL_MIN_NS;
+        }
+    }
+
+    frame_forced = false;
+    last_frame_ns = now_ns;
+    last_frame_version = snapshot.version;
+    last_frame_second = now;
+}
+
+// Title, clock, algorithm and elapsed time (rows 1-2)
+static void draw_header(const SimSnapshot* snapshot, time_t now) {
+    FrameRegion header = {0, 0, 3, frame.cols};
+
+    // Get current time for display
     struct tm* tm_info = localtime(&now);
     char time_str[20];
     strftime(time_str, sizeof(time_str), "%H:%M:%S", tm_info);
 
-    // --- FIX: GARBLED TEXT ---
-    // Draw borders first, THEN draw text on top
-    draw_borders();
-    
-    // Header
-    attron(A_BOLD); // Make title bold
     // --- EMOJI REMOVED ---
-    mvprintw(1, (getmaxx(stdscr) - 24) / 2, "TrafficGuru Simulation");
-    attroff(A_BOLD);
-    
-    mvprintw(2, 3, "Time: %s", time_str);
-    
-    // This read is safe because 'scheduler.algorithm' is only
-    // written by 'handle_user_input', which is on this same thread.
-    mvprintw(2, 20, "Algorithm: %s", get_algorithm_name(g_traffic_system->scheduler.algorithm));
-    
-    time_t elapsed = now - g_traffic_system->simulation_start_time;
-    time_t remaining = g_traffic_system->simulation_end_time - now;
-    mvprintw(2, max_x - 22, "Elapsed: %lds / %lds", (long)elapsed, (long)(elapsed + remaining));
-    // --- END FIX ---
+    frame_print(&header, 1, (frame.cols - 24) / 2, A_BOLD, "TrafficGuru Simulation");
 
+    frame_print(&header, 2, 3, A_NORMAL, "Time: %s", time_str);
 
-    // --- FIX FOR PAUSE & FLICKER ---
-    // We only redraw the data windows if the simulation is NOT paused.
-    // This "freezes" the screen on the last frame when you pause.
-    if(!g_traffic_system->simulation_paused) {
-        draw_lanes_window(g_traffic_system->lanes);
-        draw_metrics_window(&g_traffic_system->metrics,
-                            g_traffic_system->scheduler.algorithm);
+    // Scenario runs show the time of day their demand curves are at
+    const TrafficScenario* scenario = get_traffic_scenario();
+    if (scenario) {
+        int day_seconds = scenario_time_of_day(
+            scenario, __atomic_load_n(&g_traffic_system->scenario_elapsed_ns, __ATOMIC_RELAXED));
+        frame_print(&header, 1, 3, A_NORMAL, "Day: %02d:%02d", day_seconds / 3600,
+                    (day_seconds / 60) % 60);
     }
-    // --- END FIX ---
-    
-    // We *always* redraw the status bar.
-    wclear(status_win); // Clear status bar
-    box(status_win, 0, 0);
-    mvwprintw(status_win, 0, 2, " Status & Controls ");
 
-    // Display status bar (always draw this)
-    const char* status = g_traffic_system->simulation_paused ? "PAUSED" : "RUNNING";
-    mvwprintw(status_win, 1, 2, "STATUS: %s", status);
-    mvwprintw(status_win, 1, 20, "CONTROLS: [Q] Quit | [Space] Pause | [1-3] Algo | [H] Help");
-    
-    // --- FIX: FLICKER-FREE REFRESH ---
-    // Replace all wrefresh() calls with wnoutrefresh()
-    // and then call doupdate() once at the end.
-    
-    wnoutrefresh(stdscr); // Refresh header
-    wnoutrefresh(lanes_win);
-    wnoutrefresh(metrics_win);
-    wnoutrefresh(status_win);
-    
-    doupdate(); // Draw all changes to the screen at once
-    // --- END FIX ---
+    // Detector replays show how far into the file they are
+    if (get_detector_replay()) {
+        long long replay_seconds =
+            __atomic_load_n(&g_traffic_system->replay_elapsed_ns, __ATOMIC_RELAXED) / NS_PER_SEC;
+        frame_print(&header, 1, 3, A_NORMAL, "Replay: +%lld:%02lld:%02lld x%g", replay_seconds / 3600,
+                    (replay_seconds / 60) % 60, replay_seconds % 60, get_detector_replay_speed());
+    }
+    frame_print(&header, 2, 20, A_NORMAL, "Algorithm: %s", get_algorithm_name(snapshot->algorithm));
+
+    time_t elapsed = now - g_traffic_system->simulation_start_time;
+    time_t remaining = g_traffic_system->simulation_end_time - now;
+    frame_print(&header, 2, frame.cols - 22, A_NORMAL, "Elapsed: %lds / %lds",
+                (long)elapsed, (long)(elapsed + remaining));
 }
 
-// --- FIX: Rewritten for appealing layout ---
-static void draw_lanes_window(LaneProcess lanes[4]) {
-    wclear(lanes_win); // Clear window content
-    box(lanes_win, 0, 0);
-    mvwprintw(lanes_win, 0, 2, " Intersection Status ");
+// Geometry lane name in capitals, as the lane tables show them
+static void format_lane_label(int lane_id, char* out, size_t size) {
+    snprintf(out, size, "%s", get_lane_name(lane_id));
+    for (char* c = out; *c; c++) {
+        if (*c >= 'a' && *c <= 'z') {
+            *c = (char)(*c - 'a' + 'A');
+        }
+    }
+}
 
-    const char* lane_names[] = {"NORTH", "SOUTH", "EAST ", "WEST "};
-    char queue_str[4][10];
+// --- FIX: Rewritten for appealing layout ---
+static void draw_lanes_window(const FrameRegion* region, const SimSnapshot* snapshot) {
+    frame_box(region, " Intersection Status ");
+
+    int num_lanes = snapshot->num_lanes;
+    char lane_names[MAX_LANES][GEOMETRY_NAME_LENGTH];
+    char queue_str[MAX_LANES][10];
+    char queue_column[MAX_LANES][24];
+    int name_width = 6;
     
-    // --- Get all lane data first (to avoid holding locks while drawing) ---
-    int queues[4];
-    int waits[4];
-    LaneState states[4];
-
-    // --- DEADLOCK FIX: Use 'trylock' to update cache ---
-    for (int i = 0; i < 4; i++) {
-        // Try to get the lock. If we can't, EBUSY is returned.
-        // We DON'T wait.
-        if (pthread_mutex_trylock(&lanes[i].queue_lock) == 0) {
-            // Success! Update our cached values.
-            last_queues[i] = lanes[i].queue_length;
-            last_waits[i] = lanes[i].waiting_time;
-            last_states[i] = lanes[i].state;
-            pthread_mutex_unlock(&lanes[i].queue_lock);
+    // Lane data comes from the frame's snapshot; no lane lock is taken
+    const int* queues = snapshot->lane_queue_length;
+    const LaneState* states = snapshot->lane_state;
+
+    for (int i = 0; i < num_lanes; i++) {
+        format_lane_label(i, lane_names[i], sizeof(lane_names[i]));
+        int length = (int)strlen(lane_names[i]);
+        if (length > name_width) {
+            name_width = length;
         }
-        // Use the cached values for drawing (either new or old)
-        queues[i] = last_queues[i];
-        waits[i] = last_waits[i];
-        states[i] = last_states[i];
 
         // --- EMOJI REMOVED ---
         snprintf(queue_str[i], 10, "Q: %d", queues[i]);
-    }
 
-    // Try to get the emergency status
-    // This is protected by global_state_lock (see main.c)
-    if (pthread_mutex_trylock(&g_traffic_system->global_state_lock) == 0) {
-        last_emergency_mode = g_traffic_system->emergency_system.emergency_mode;
-        pthread_mutex_unlock(&g_traffic_system->global_state_lock);
+        // Vehicles held upstream of the lane's storage show as "+N"
+        int spilled = snapshot->lane_spillback[i];
+        if (spilled > 0) {
+            snprintf(queue_column[i], sizeof(queue_column[i]), "%d+%d", queues[i] - spilled, spilled);
+        } else {
+            snprintf(queue_column[i], sizeof(queue_column[i]), "%d", queues[i]);
+        }
     }
-    // --- END DEADLOCK FIX ---
-
 
-    // --- Draw ASCII Intersection (Left Side) ---
-        mvwprintw(lanes_win, 2, 13, "N");  // North direction label
-    mvwprintw(lanes_win, 3, 12, "%s", queue_str[LANE_NORTH]);
-    mvwprintw(lanes_win, 4, 13, "|"); // Adjusted for alignment
-    mvwprintw(lanes_win, 5, 5, "%s ---+--- %s", queue_str[LANE_WEST], queue_str[LANE_EAST]);
-        mvwprintw(lanes_win, 5, 3, "W");  // West direction label
-        mvwprintw(lanes_win, 5, 23, "E");  // East direction label
-    mvwprintw(lanes_win, 6, 13, "|"); // Adjusted for alignment
-    mvwprintw(lanes_win, 7, 12, "%s", queue_str[LANE_SOUTH]);
-        mvwprintw(lanes_win, 8, 13, "S");  // South direction label
+    // --- Draw ASCII Intersection (Left Side), four-way geometry only ---
+    int status_x_pos = 2;
+    if (strcmp(get_intersection_geometry()->name, DEFAULT_GEOMETRY) == 0) {
+        frame_print(region, 2, 13, A_NORMAL, "N");  // North direction label
+        frame_print(region, 3, 12, A_NORMAL, "%s", queue_str[LANE_NORTH]);
+        frame_print(region, 4, 13, A_NORMAL, "|"); // Adjusted for alignment
+        frame_print(region, 5, 5, A_NORMAL, "%s ---+--- %s", queue_str[LANE_WEST], queue_str[LANE_EAST]);
+        frame_print(region, 5, 3, A_NORMAL, "W");  // West direction label
+        frame_print(region, 5, 23, A_NORMAL, "E");  // East direction label
+        frame_print(region, 6, 13, A_NORMAL, "|"); // Adjusted for alignment
+        frame_print(region, 7, 12, A_NORMAL, "%s", queue_str[LANE_SOUTH]);
+        frame_print(region, 8, 13, A_NORMAL, "S");  // South direction label
+        status_x_pos = 35;
+    }
 
-    // --- Draw Status Block (Right Side) ---
-    int status_x_pos = 35;
-    mvwprintw(lanes_win, 2, status_x_pos, "LANE   | STATUS   | QUEUE ");
-    mvwprintw(lanes_win, 3, status_x_pos, "-------+----------+-------");
+    // --- Draw Status Block (Right Side), LANES_PER_COLUMN rows per column ---
+    int column_width = name_width + 23;
+    int columns = (num_lanes + LANES_PER_COLUMN - 1) / LANES_PER_COLUMN;
+    for (int c = 0; c < columns; c++) {
+        int x = status_x_pos + c * column_width;
+        frame_print(region, 2, x, A_NORMAL, "%-*s | STATUS   | QUEUE ", name_width, "LANE");
+        frame_print(region, 3, x, A_NORMAL, "%.*s+----------+-------", name_width + 1,
+                    "-----------------");
+    }
 
-    for (int i = 0; i < 4; i++) {
+    for (int i = 0; i < num_lanes; i++) {
         // Set color based on state
         int color_pair = 5; // Default white
         char state_indicator[20];
@@ -393,93 +670,210 @@ static void draw_lanes_window(LaneProcess lanes[4]) {
             snprintf(state_indicator, 20, " BLOCK");
         }
         
-        wattron(lanes_win, COLOR_PAIR(color_pair));
-        
         // Draw the formatted status line with better visual indicators
-        mvwprintw(lanes_win, 4 + i, status_x_pos, "%-6s | %-8s | %-5d", 
-                  lane_names[i], 
-                  state_indicator,        // --- NEW: Use indicator instead of state name ---
-                  queues[i]);
-        
-        wattroff(lanes_win, COLOR_PAIR(color_pair));
+        int x = status_x_pos + (i / LANES_PER_COLUMN) * column_width;
+        frame_print(region, 4 + i % LANES_PER_COLUMN, x, COLOR_PAIR(color_pair), "%-*s | %-8s | %-5s",
+                    name_width, lane_names[i], 
+                    state_indicator,        // --- NEW: Use indicator instead of state name ---
+                    queue_column[i]);
     }
     
     // --- Draw Emergency Status (Bottom) ---
-    if (last_emergency_mode) { // <-- Use cached value
-        wattron(lanes_win, A_BLINK | COLOR_PAIR(1)); // Blinking Red
+    if (snapshot->emergency_mode) {
         // --- EMOJI REMOVED ---
-        mvwprintw(lanes_win, 13, 4, "*** EMERGENCY ACTIVE ***");
-        wattroff(lanes_win, A_BLINK | COLOR_PAIR(1));
+        frame_print(region, 13, 4, A_BLINK | COLOR_PAIR(1), "*** EMERGENCY ACTIVE ***"); // Blinking Red
     }
     
     // --- NEW: Add legend for lane states ---
-    mvwprintw(lanes_win, 10, 2, "Legend:");
-    wattron(lanes_win, COLOR_PAIR(2));
-    mvwprintw(lanes_win, 11, 2, ">> RUN <<");
-    wattroff(lanes_win, COLOR_PAIR(2));
-    mvwprintw(lanes_win, 11, 12, " = Vehicle Processing (Green)");
+    frame_print(region, 10, 2, A_NORMAL, "Legend:");
+    frame_print(region, 11, 2, COLOR_PAIR(2), ">> RUN <<");
+    frame_print(region, 11, 12, A_NORMAL, " = Vehicle Processing (Green)");
     
-    wattron(lanes_win, COLOR_PAIR(3));
-    mvwprintw(lanes_win, 12, 2, "  OPEN");
-    wattroff(lanes_win, COLOR_PAIR(3));
-    mvwprintw(lanes_win, 12, 12, " = Ready for Processing (Yellow)");
+    frame_print(region, 12, 2, COLOR_PAIR(3), "  OPEN");
+    frame_print(region, 12, 12, A_NORMAL, " = Ready for Processing (Yellow)");
     
-    wattron(lanes_win, COLOR_PAIR(1));
-    mvwprintw(lanes_win, 13, 2, "  WAIT");
-    wattroff(lanes_win, COLOR_PAIR(1));
-    mvwprintw(lanes_win, 13, 12, " = Waiting for Green Light (Red)");
+    frame_print(region, 13, 2, COLOR_PAIR(1), "  WAIT");
+    frame_print(region, 13, 12, A_NORMAL, " = Waiting for Green Light (Red)");
 }
 
 // --- FIX: Renamed function ---
-static void draw_metrics_window(PerformanceMetrics* metrics, SchedulingAlgorithm current_algo) {
-    wclear(metrics_win); // Clear window content
-    box(metrics_win, 0, 0);
-    mvwprintw(metrics_win, 0, 2, " Performance Metrics ");
-
-    // --- DEADLOCK FIX: Use 'trylock' to update metrics cache ---
-    // The 'metrics' struct is protected by the 'global_state_lock'
-    // as seen in main.c's update_simulation_state()
-    if (pthread_mutex_trylock(&g_traffic_system->global_state_lock) == 0) {
-        // Success! Atomically copy the entire metrics struct.
-        last_metrics = *metrics;
-        pthread_mutex_unlock(&g_traffic_system->global_state_lock);
-    }
-    // --- END DEADLOCK FIX ---
-
-    // --- DEADLOCK FIX: Draw using the 'last_metrics' cache ---
-    mvwprintw(metrics_win, 2, 2, "Throughput : %.1f veh/min", last_metrics.vehicles_per_minute);
-    mvwprintw(metrics_win, 3, 2, "Avg Wait   : %.1fs", last_metrics.avg_wait_time);
-    mvwprintw(metrics_win, 4, 2, "Utilization: %.1f%%", last_metrics.utilization * 100);
-
-    mvwprintw(metrics_win, 2, 30, "Total Served   : %d", last_metrics.total_vehicles_processed);
-    mvwprintw(metrics_win, 4, 30, "Context Switches: %d", last_metrics.context_switches);
-
-    mvwprintw(metrics_win, 6, 2, "Emerg. Resp: %.1fs", last_metrics.emergency_response_time);
-    mvwprintw(metrics_win, 7, 2, "Deadlocks   : %d", last_metrics.deadlocks_prevented);
-    mvwprintw(metrics_win, 8, 2, "Overflows   : %d", last_metrics.queue_overflow_count);
-    // --- END DEADLOCK FIX ---
+static void draw_metrics_window(const FrameRegion* region, const SimSnapshot* snapshot) {
+    frame_box(region, " Performance Metrics ");
+
+    frame_print(region, 2, 2, A_NORMAL, "Throughput : %.1f veh/min", snapshot->vehicles_per_minute);
+    frame_print(region, 3, 2, A_NORMAL, "Avg Wait   : %.1fs", snapshot->avg_wait_time);
+    frame_print(region, 4, 2, A_NORMAL, "Utilization: %.1f%%", snapshot->utilization * 100);
+
+    frame_print(region, 2, 30, A_NORMAL, "Total Served   : %d", snapshot->total_vehicles_processed);
+    frame_print(region, 4, 30, A_NORMAL, "Context Switches: %d", snapshot->context_switches);
+
+    frame_print(region, 6, 2, A_NORMAL, "Emerg. Resp: %.1fs", snapshot->emergency_response_time);
+    frame_print(region, 7, 2, A_NORMAL, "Deadlocks   : %d", snapshot->deadlocks_prevented);
+    frame_print(region, 8, 2, A_NORMAL, "Dropped     : %d", snapshot->queue_overflow_count);
+    frame_print(region, 6, 30, A_NORMAL, "Spillback      : %d veh, %.1fs avg", snapshot->spillback_vehicles,
+                snapshot->spillback_vehicles ? snapshot->spillback_delay / snapshot->spillback_vehicles : 0.0f);
+
+    // Recent window, read lock-free from the time series
+    if (drawn_recent_valid) {
+        frame_print(region, 3, 30, A_NORMAL, "Last 10s       : %.1f veh/min", drawn_recent.vehicles_per_minute);
+        frame_print(region, 5, 30, A_NORMAL, "Last 10s p95   : %.1fs wait", drawn_recent.p95_wait);
+    }
     
-    // This read is safe, as 'current_algo' is passed by value
-    // from the main thread, which read it safely.
-    mvwprintw(metrics_win, 7, 30, "Algorithm: %s", get_algorithm_name(current_algo));
+    frame_print(region, 7, 30, A_NORMAL, "Algorithm: %s", get_algorithm_name(snapshot->algorithm));
 }
 
+// "45s", "12m30s", "3h05m"
+static void format_span(long long seconds, char* out, size_t size) {
+    if (seconds < 60) {
+        snprintf(out, size, "%llds", seconds);
+    } else if (seconds < 3600) {
+        snprintf(out, size, "%lldm%02llds", seconds / 60, seconds % 60);
+    } else {
+        snprintf(out, size, "%lldh%02lldm", seconds / 3600, (seconds % 3600) / 60);
+    }
+}
+
+// Gantt view of the execution history: a row per lane and a served row,
+// one column per level-'gantt_level' bucket. A lane green for the whole
+// column (its minimum) is drawn '#', green for part of it (its maximum)
+// '-'. The served row is scaled to the busiest column in view.
+static void draw_gantt_window(const FrameRegion* region, const SimSnapshot* snapshot, time_t now) {
+    frame_box(region, " Gantt: Lane Green Intervals ");
+
+    int num_lanes = snapshot->num_lanes;
+    int served_row = 5 + num_lanes;     // Everything below follows the lane rows
+    const char* served_ramp = " .:-=+*#%@";
+    const int ramp_top = 9;
+    const int chart_x = 11;
+
+    int columns = region->width - chart_x - 2;
+    if (columns > GANTT_LEVEL_BUCKETS) {
+        columns = GANTT_LEVEL_BUCKETS;
+    }
+    if (columns < 1 || region->height < served_row + 3) {
+        return;
+    }
+    gantt_columns = columns;
+
+    long long width = 1LL << gantt_level;
+    long long last_id = ((long long)now >> gantt_level) - gantt_offset;
+    long long first_id = last_id - columns + 1;
+    if (!gantt_read_buckets(g_traffic_system->scheduler.gantt, gantt_level,
+                            first_id, columns, gantt_buckets)) {
+        return;
+    }
+
+    int served_max = 0;
+    int peak_max = 0;
+    for (int i = 0; i < columns; i++) {
+        if (gantt_buckets[i].served > served_max) {
+            served_max = gantt_buckets[i].served;
+        }
+        if (gantt_buckets[i].served_peak > peak_max) {
+            peak_max = gantt_buckets[i].served_peak;
+        }
+    }
+
+    char scale[16], span[16], ends[16];
+    format_span(width, scale, sizeof(scale));
+    format_span(width * columns, span, sizeof(span));
+    time_t end_time = (time_t)((last_id + 1) << gantt_level);
+    strftime(ends, sizeof(ends), "%H:%M:%S", localtime(&end_time));
+    frame_print(region, 1, 2, A_NORMAL, "Scale: %s/col  Window: %s  Ends: %s%s  Served: max %d/col, peak %d/s",
+                scale, span, ends, gantt_offset == 0 ? " (live)" : "", served_max, peak_max);
+    frame_print(region, 2, 2, A_NORMAL, "[Left/Right] scroll  [+/-] zoom  [End] live  [G] dashboard");
+
+    for (int lane = 0; lane < num_lanes; lane++) {
+        int row = 4 + lane;
+        char label[GEOMETRY_NAME_LENGTH];
+        format_lane_label(lane, label, sizeof(label));
+        frame_print(region, row, 2, A_NORMAL, "%-8.8s|", label);
+        for (int i = 0; i < columns; i++) {
+            int green = gantt_buckets[i].green_seconds[lane];
+            if (green >= width) {
+                frame_print(region, row, chart_x + i, COLOR_PAIR(2) | A_BOLD, "#");
+            } else if (green > 0) {
+                frame_print(region, row, chart_x + i, COLOR_PAIR(2), "-");
+            }
+        }
+        // The slice in progress is only recorded when it ends; show it live
+        if (gantt_offset == 0 && snapshot->current_lane == lane &&
+            snapshot->lane_state[lane] == RUNNING &&
+            gantt_buckets[columns - 1].green_seconds[lane] == 0) {
+            frame_print(region, row, chart_x + columns - 1, COLOR_PAIR(2), "-");
+        }
+    }
+
+    frame_print(region, served_row, 2, A_NORMAL, "SERVED  |");
+    for (int i = 0; i < columns && served_max > 0; i++) {
+        int served = gantt_buckets[i].served;
+        int level = (served * ramp_top + served_max - 1) / served_max;
+        frame_print(region, served_row, chart_x + i, COLOR_PAIR(4), "%c", served_ramp[level]);
+    }
+
+    // Time axis: a tick and a label every 10 columns
+    frame_print(region, served_row + 1, 2, A_NORMAL, "        +");
+    for (int i = 0; i < columns; i++) {
+        bool tick = ((first_id + i) % 10) == 0;
+        frame_print(region, served_row + 1, chart_x + i, A_NORMAL, tick ? "|" : "-");
+        if (tick && i + 8 <= columns) {
+            char label[16];
+            time_t tick_time = (time_t)((first_id + i) << gantt_level);
+            strftime(label, sizeof(label), "%H:%M:%S", localtime(&tick_time));
+            frame_print(region, served_row + 2, chart_x + i, A_NORMAL, "%s", label);
+        }
+    }
 
-// Show help screen
+    frame_print(region, served_row + 4, 2, A_NORMAL, "Legend:");
+    frame_print(region, served_row + 4, 12, COLOR_PAIR(2) | A_BOLD, "#");
+    frame_print(region, served_row + 4, 13, A_NORMAL, " green for the whole column   ");
+    frame_print(region, served_row + 4, 43, COLOR_PAIR(2), "-");
+    frame_print(region, served_row + 4, 44, A_NORMAL, " green for part of it   served: '%s' low..high", served_ramp + 1);
+    frame_print(region, served_row + 5, 2, A_NORMAL, "Intervals recorded: %lld",
+                gantt_intervals_recorded(g_traffic_system->scheduler.gantt));
+
+    // Most recent signal changes, newest first
+    SignalHistory* history = &g_traffic_system->visualization.signal_history;
+    int rows = region->height - (served_row + 9);
+    if (rows > 0 && history->size > 0) {
+        frame_print(region, served_row + 7, 2, A_NORMAL, "Recent signal changes:");
+        for (int j = 0; j < rows && j < history->size; j++) {
+            int index = (history->tail - 1 - j + history->capacity) % history->capacity;
+            SignalEvent* event = &history->events[index];
+            char stamp[16];
+            strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&event->timestamp));
+            if (event->lane_id >= 0 && event->lane_id < num_lanes) {
+                char label[GEOMETRY_NAME_LENGTH];
+                format_lane_label(event->lane_id, label, sizeof(label));
+                frame_print(region, served_row + 8 + j, 4, A_NORMAL, "%s  %s green", stamp, label);
+            } else {
+                frame_print(region, served_row + 8 + j, 4, A_NORMAL, "%s  no lane green", stamp);
+            }
+        }
+    }
+}
+
+static void draw_status_bar(const FrameRegion* region) {
+    frame_box(region, " Status & Controls ");
+
+    const char* status = g_traffic_system->simulation_paused ? "PAUSED" : "RUNNING";
+    frame_print(region, 1, 2, A_NORMAL, "STATUS: %s", status);
+    frame_print(region, 1, 20, A_NORMAL, "CONTROLS: [Q] Quit | [Space] Pause | [1-3] Algo | [G] Gantt | [H] Help");
+}
+
+
+// Show help screen; its content is static, so it is drawn once per opening
 static void show_help_screen(Visualization* viz) {
-    if (!viz) return;
+    if (!viz || help_win) return;
     
     int y, x;
     getmaxyx(main_win, y, x);
     
-    // Create help window if it doesn't exist
-    if (!help_win) {
-        help_win = newwin(y - 4, x - 4, 2, 2);
-        box(help_win, 0, 0);
-        keypad(help_win, TRUE);
-    }
+    help_win = newwin(y - 4, x - 4, 2, 2);
+    if (!help_win) return;
+    keypad(help_win, TRUE);
     
-    wclear(help_win);
+    werase(help_win);
     box(help_win, 0, 0);
     // --- EMOJI REMOVED ---
     mvwprintw(help_win, 0, (x-10)/2, " HELP ");
@@ -489,11 +883,19 @@ static void show_help_screen(Visualization* viz) {
     mvwprintw(help_win, 5, 6, "[SPACE]   - Pause/Resume Simulation");
     mvwprintw(help_win, 6, 6, "[H]       - Close this Help Screen");
     mvwprintw(help_win, 7, 6, "[E]       - Trigger Emergency Vehicle");
+    mvwprintw(help_win, 8, 6, "[Ctrl-L]  - Repaint the Screen");
+    mvwprintw(help_win, 9, 6, "[G]       - Toggle the Gantt View");
+    mvwprintw(help_win, 10, 6, "[C]       - Save a Checkpoint (with --checkpoint)");
     
-    mvwprintw(help_win, 9, 4, "ALGORITHMS:");
-    mvwprintw(help_win, 10, 6, "[1]       - Shortest Job First (SJF)");
-    mvwprintw(help_win, 11, 6, "[2]       - Multilevel Feedback Queue");
-    mvwprintw(help_win, 12, 6, "[3]       - Priority Round Robin");
+    mvwprintw(help_win, 12, 4, "ALGORITHMS:");
+    mvwprintw(help_win, 13, 6, "[1]       - Shortest Job First (SJF)");
+    mvwprintw(help_win, 14, 6, "[2]       - Multilevel Feedback Queue");
+    mvwprintw(help_win, 15, 6, "[3]       - Priority Round Robin");
+
+    mvwprintw(help_win, 17, 4, "GANTT VIEW:");
+    mvwprintw(help_win, 18, 6, "[Left/Right] - Scroll Back/Forward");
+    mvwprintw(help_win, 19, 6, "[+/-]        - Zoom In/Out (1s to 34m per Column)");
+    mvwprintw(help_win, 20, 6, "[End]        - Follow the Live Edge");
 
     mvwprintw(help_win, (y-4) - 3, (x-27)/2, "Press any key to continue...");
     wrefresh(help_win);
@@ -512,6 +914,23 @@ void init_signal_history(SignalHistory* history, int capacity) {
     }
 }
 
+// Append an event, overwriting the oldest once the ring is full
+void add_signal_event(SignalHistory* history, int lane_id, int state, time_t timestamp) {
+    if (!history || !history->events || history->capacity <= 0) return;
+
+    SignalEvent* event = &history->events[history->tail];
+    event->lane_id = lane_id;
+    event->state = state;
+    event->timestamp = timestamp;
+
+    history->tail = (history->tail + 1) % history->capacity;
+    if (history->size < history->capacity) {
+        history->size++;
+    } else {
+        history->head = (history->head + 1) % history->capacity;
+    }
+}
+
 void destroy_signal_history(SignalHistory* history) {
     if (!history) return;
     if (history->events) {
@@ -0,0 +1,431 @@
+/*
+ * trafficguru-trace - Offline Analysis of Vehicle Trace Files
+ *
+ * Maps a trace written by `trafficguru --trace FILE` read-only and reports:
+ *   - the vehicle wait distribution (arrival to departure),
+ *   - per-lane throughput over fixed time buckets,
+ *   - the signal phase timeline (green start/end per lane),
+ *   - emergency detection-to-clearance times.
+ *
+ * Records are sorted by timestamp first, since the writer appends one
+ * per-thread buffer at a time. Lane queues are FIFO, so the n-th departure
+ * from a lane is matched with the n-th accepted arrival on that lane.
+ *
+ * Lane names come from the geometry the run used, which the trace header
+ * records. -G overrides it (for a geometry file that has since moved); its
+ * lane count must still match the header's.
+ *
+ * Usage: trafficguru-trace [-b SECONDS] [-t] [-G GEOMETRY] FILE
+ *
+ * Compilation: Include vehicle_trace.h and intersection_geometry.h
+ */
+
+#define _XOPEN_SOURCE 600
+#include "../include/vehicle_trace.h"
+#include "../include/intersection_geometry.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define TRACE_EMERGENCY_TYPES 4
+#define TRACE_MOVEMENTS 4
+#define NS_PER_MS 1000000LL
+#define NS_PER_SEC 1000000000LL
+
+static const char* emergency_names[] = {"none", "ambulance", "fire_truck", "police"};
+static const char* movement_names[] = {"left", "straight", "right", "u_turn"};
+
+static const TraceRecord* g_records = NULL;
+
+typedef struct {
+    long long* items;
+    int head;
+    int tail;
+    int capacity;
+} ArrivalFifo;
+
+typedef struct {
+    int lane_id;
+    long long start_ns;
+    long long end_ns;
+    bool emergency;
+} Phase;
+
+static void fifo_push(ArrivalFifo* fifo, long long value) {
+    if (fifo->tail == fifo->capacity) {
+        fifo->capacity = fifo->capacity ? fifo->capacity * 2 : 256;
+        fifo->items = realloc(fifo->items, (size_t)fifo->capacity * sizeof(long long));
+        if (!fifo->items) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    fifo->items[fifo->tail++] = value;
+}
+
+static bool fifo_pop(ArrivalFifo* fifo, long long* value) {
+    if (fifo->head == fifo->tail) {
+        return false;
+    }
+    *value = fifo->items[fifo->head++];
+    return true;
+}
+
+// Stable order: timestamp, then file position
+static int compare_record_index(const void* a, const void* b) {
+    unsigned ia = *(const unsigned*)a;
+    unsigned ib = *(const unsigned*)b;
+    long long ta = g_records[ia].timestamp_ns;
+    long long tb = g_records[ib].timestamp_ns;
+    if (ta != tb) {
+        return ta < tb ? -1 : 1;
+    }
+    return ia < ib ? -1 : (ia > ib);
+}
+
+static int compare_double(const void* a, const void* b) {
+    double da = *(const double*)a;
+    double db = *(const double*)b;
+    return (da > db) - (da < db);
+}
+
+// Nearest-rank percentile of a sorted array
+static double percentile(const double* sorted, long long count, double pct) {
+    if (count == 0) {
+        return 0.0;
+    }
+    long long rank = (long long)(pct / 100.0 * (double)count + 0.999999);
+    if (rank < 1) {
+        rank = 1;
+    }
+    if (rank > count) {
+        rank = count;
+    }
+    return sorted[rank - 1];
+}
+
+static void print_usage(const char* program_name) {
+    printf("Usage: %s [-b SECONDS] [-t] [-G GEOMETRY] FILE\n", program_name);
+    printf("  -b SECONDS   Throughput bucket width (default: 10)\n");
+    printf("  -t           Print every signal phase, not only the per-lane summary\n");
+    printf("  -G GEOMETRY  Geometry the run used, preset or file (default: from the trace)\n");
+}
+
+int main(int argc, char* argv[]) {
+    int bucket_seconds = 10;
+    bool full_timeline = false;
+    const char* geometry_spec = NULL;
+
+    int c;
+    while ((c = getopt(argc, argv, "b:tG:h")) != -1) {
+        switch (c) {
+            case 'b':
+                bucket_seconds = atoi(optarg);
+                if (bucket_seconds <= 0) {
+                    fprintf(stderr, "Invalid bucket width: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 't':
+                full_timeline = true;
+                break;
+            case 'G':
+                geometry_spec = optarg;
+                break;
+            default:
+                print_usage(argv[0]);
+                return c == 'h' ? 0 : 1;
+        }
+    }
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const char* path = argv[optind];
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror(path);
+        return 1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(TraceFileHeader)) {
+        fprintf(stderr, "%s: not a trace file (too short)\n", path);
+        close(fd);
+        return 1;
+    }
+
+    void* map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap");
+        return 1;
+    }
+
+    const TraceFileHeader* header = (const TraceFileHeader*)map;
+    if (memcmp(header->magic, TRACE_MAGIC, 4) != 0 || header->version != TRACE_VERSION ||
+        header->record_size != sizeof(TraceRecord)) {
+        fprintf(stderr, "%s: unsupported trace (magic/version/record size mismatch)\n", path);
+        munmap(map, (size_t)st.st_size);
+        return 1;
+    }
+
+    char recorded_geometry[TRACE_GEOMETRY_LENGTH + 1];
+    snprintf(recorded_geometry, sizeof(recorded_geometry), "%.*s",
+             TRACE_GEOMETRY_LENGTH, header->geometry);
+    IntersectionGeometry geometry;
+    if (!load_intersection_geometry(&geometry, geometry_spec ? geometry_spec : recorded_geometry)) {
+        if (!geometry_spec) {
+            fprintf(stderr, "%s: cannot load recorded geometry %s; give it with -G\n",
+                    path, recorded_geometry);
+        }
+        munmap(map, (size_t)st.st_size);
+        return 1;
+    }
+    if ((uint32_t)geometry.num_lanes != header->num_lanes) {
+        fprintf(stderr, "%s: recorded on %s with %u lanes, but %s has %d\n",
+                path, recorded_geometry, header->num_lanes, geometry.name, geometry.num_lanes);
+        munmap(map, (size_t)st.st_size);
+        return 1;
+    }
+    set_intersection_geometry(&geometry);
+    int num_lanes = geometry.num_lanes;
+
+    // A run killed mid-write may leave a partial record at the end
+    long long count = (long long)((size_t)st.st_size - sizeof(TraceFileHeader)) / sizeof(TraceRecord);
+    g_records = (const TraceRecord*)((const char*)map + sizeof(TraceFileHeader));
+
+    unsigned* order = malloc((size_t)(count ? count : 1) * sizeof(unsigned));
+    double* waits = malloc((size_t)(count ? count : 1) * sizeof(double));
+    Phase* phases = malloc((size_t)(count ? count : 1) * sizeof(Phase));
+    if (!order || !waits || !phases) {
+        perror("malloc");
+        return 1;
+    }
+    for (long long i = 0; i < count; i++) {
+        order[i] = (unsigned)i;
+    }
+    qsort(order, (size_t)count, sizeof(unsigned), compare_record_index);
+
+    long long end_ns = count > 0 ? g_records[order[count - 1]].timestamp_ns : 0;
+    int bucket_count = (int)(end_ns / (bucket_seconds * NS_PER_SEC)) + 1;
+    int (*throughput)[MAX_LANES] = calloc((size_t)bucket_count, sizeof(*throughput));
+    if (!throughput) {
+        perror("calloc");
+        return 1;
+    }
+
+    ArrivalFifo arrivals[MAX_LANES];
+    memset(arrivals, 0, sizeof(arrivals));
+    long long lane_arrivals[MAX_LANES] = {0};
+    long long lane_overflows[MAX_LANES] = {0};
+    long long lane_departures[MAX_LANES] = {0};
+    long long unmatched_departures = 0;
+    long long wait_count = 0;
+    double wait_sum = 0.0;
+
+    int open_phase[MAX_LANES];
+    for (int i = 0; i < num_lanes; i++) {
+        open_phase[i] = -1;
+    }
+    int phase_count = 0;
+
+    long long emergency_detected[TRACE_EMERGENCY_TYPES] = {0};
+    long long emergency_cleared[TRACE_EMERGENCY_TYPES] = {0};
+    double emergency_clear_ms[TRACE_EMERGENCY_TYPES] = {0};
+    double emergency_clear_max_ms[TRACE_EMERGENCY_TYPES] = {0};
+    long long emergency_greens = 0;
+    long long movement_departures[TRACE_MOVEMENTS] = {0};
+    double movement_wait_ms[TRACE_MOVEMENTS] = {0};
+    long long emergency_preclears = 0;
+
+    for (long long i = 0; i < count; i++) {
+        const TraceRecord* record = &g_records[order[i]];
+        int lane = record->lane_id;
+        if (lane >= num_lanes) {
+            continue;
+        }
+
+        switch (record->type) {
+            case TRACE_ARRIVAL:
+                fifo_push(&arrivals[lane], record->timestamp_ns);
+                lane_arrivals[lane]++;
+                break;
+            case TRACE_OVERFLOW:
+                lane_overflows[lane]++;
+                break;
+            case TRACE_DEPARTURE: {
+                long long arrived_ns;
+                lane_departures[lane]++;
+                if (record->aux < TRACE_MOVEMENTS) {
+                    movement_departures[record->aux]++;
+                    movement_wait_ms[record->aux] += record->value;
+                }
+                throughput[record->timestamp_ns / (bucket_seconds * NS_PER_SEC)][lane]++;
+                if (fifo_pop(&arrivals[lane], &arrived_ns)) {
+                    double wait_ms = (double)(record->timestamp_ns - arrived_ns) / NS_PER_MS;
+                    waits[wait_count++] = wait_ms;
+                    wait_sum += wait_ms;
+                } else {
+                    unmatched_departures++;
+                }
+                break;
+            }
+            case TRACE_GREEN:
+                if (open_phase[lane] >= 0) {
+                    phases[open_phase[lane]].end_ns = record->timestamp_ns;
+                }
+                phases[phase_count].lane_id = lane;
+                phases[phase_count].start_ns = record->timestamp_ns;
+                phases[phase_count].end_ns = -1;
+                phases[phase_count].emergency = record->aux != 0;
+                open_phase[lane] = phase_count++;
+                break;
+            case TRACE_GREEN_END:
+                if (open_phase[lane] >= 0) {
+                    phases[open_phase[lane]].end_ns = record->timestamp_ns;
+                    open_phase[lane] = -1;
+                }
+                break;
+            case TRACE_EMERGENCY_DETECTED:
+                if (record->aux < TRACE_EMERGENCY_TYPES) {
+                    emergency_detected[record->aux]++;
+                }
+                break;
+            case TRACE_EMERGENCY_GREEN:
+                emergency_greens++;
+                if (record->aux) {
+                    emergency_preclears++;
+                }
+                break;
+            case TRACE_EMERGENCY_CLEARED:
+                if (record->aux < TRACE_EMERGENCY_TYPES) {
+                    emergency_cleared[record->aux]++;
+                    emergency_clear_ms[record->aux] += record->value;
+                    if (record->value > emergency_clear_max_ms[record->aux]) {
+                        emergency_clear_max_ms[record->aux] = record->value;
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    // Phases still green at the end of the trace run to the last record
+    for (int i = 0; i < phase_count; i++) {
+        if (phases[i].end_ns < 0) {
+            phases[i].end_ns = end_ns;
+        }
+    }
+
+    printf("Trace: %s (%s, %d lanes)\n", path, recorded_geometry, num_lanes);
+    printf("  Records: %lld over %.1f s\n\n", count, (double)end_ns / NS_PER_SEC);
+
+    // Wait distribution
+    qsort(waits, (size_t)wait_count, sizeof(double), compare_double);
+    printf("Vehicle wait (arrival to departure, ms):\n");
+    printf("  vehicles=%lld mean=%.1f p50=%.1f p90=%.1f p95=%.1f p99=%.1f max=%.1f\n",
+           wait_count, wait_count ? wait_sum / wait_count : 0.0,
+           percentile(waits, wait_count, 50), percentile(waits, wait_count, 90),
+           percentile(waits, wait_count, 95), percentile(waits, wait_count, 99),
+           wait_count ? waits[wait_count - 1] : 0.0);
+    if (unmatched_departures > 0) {
+        printf("  (%lld departures had no traced arrival)\n", unmatched_departures);
+    }
+    printf("\n");
+
+    printf("%-8s %9s %9s %10s %9s\n", "Lane", "Arrivals", "Overflow", "Departures", "Queued");
+    for (int i = 0; i < num_lanes; i++) {
+        printf("%-8s %9lld %9lld %10lld %9d\n", get_geometry_lane_name(i), lane_arrivals[i], lane_overflows[i],
+               lane_departures[i], arrivals[i].tail - arrivals[i].head);
+    }
+    printf("\n");
+
+    printf("%-9s %10s %13s\n", "Movement", "Departures", "Mean wait(ms)");
+    for (int i = 0; i < TRACE_MOVEMENTS; i++) {
+        printf("%-9s %10lld %13.1f\n", movement_names[i], movement_departures[i],
+               movement_departures[i] ? movement_wait_ms[i] / movement_departures[i] : 0.0);
+    }
+    printf("\n");
+
+    // Per-lane throughput curve
+    printf("Throughput (departures per %d s):\n", bucket_seconds);
+    printf("%8s", "t(s)");
+    for (int i = 0; i < num_lanes; i++) {
+        printf(" %8s", get_geometry_lane_name(i));
+    }
+    printf(" %8s\n", "Total");
+    for (int b = 0; b < bucket_count; b++) {
+        int total = 0;
+        printf("%8d", b * bucket_seconds);
+        for (int i = 0; i < num_lanes; i++) {
+            printf(" %8d", throughput[b][i]);
+            total += throughput[b][i];
+        }
+        printf(" %8d\n", total);
+    }
+    printf("\n");
+
+    // Phase timeline
+    printf("Signal phases:\n");
+    printf("%-8s %7s %9s %9s %9s %9s\n", "Lane", "Phases", "Green(s)", "Mean(s)", "Max(s)", "Emergency");
+    for (int lane = 0; lane < num_lanes; lane++) {
+        int phases_on_lane = 0;
+        int emergency_phases = 0;
+        double green_total = 0.0;
+        double green_max = 0.0;
+        for (int i = 0; i < phase_count; i++) {
+            if (phases[i].lane_id != lane) {
+                continue;
+            }
+            double length = (double)(phases[i].end_ns - phases[i].start_ns) / NS_PER_SEC;
+            phases_on_lane++;
+            green_total += length;
+            if (length > green_max) {
+                green_max = length;
+            }
+            if (phases[i].emergency) {
+                emergency_phases++;
+            }
+        }
+        printf("%-8s %7d %9.1f %9.2f %9.2f %9d\n", get_geometry_lane_name(lane), phases_on_lane, green_total,
+               phases_on_lane ? green_total / phases_on_lane : 0.0, green_max, emergency_phases);
+    }
+    if (full_timeline) {
+        printf("\n%10s %10s %-8s %9s\n", "Start(s)", "End(s)", "Lane", "Length(s)");
+        for (int i = 0; i < phase_count; i++) {
+            printf("%10.3f %10.3f %-8s %9.3f%s\n",
+                   (double)phases[i].start_ns / NS_PER_SEC, (double)phases[i].end_ns / NS_PER_SEC,
+                   get_geometry_lane_name(phases[i].lane_id),
+                   (double)(phases[i].end_ns - phases[i].start_ns) / NS_PER_SEC,
+                   phases[i].emergency ? "  emergency" : "");
+        }
+    }
+    printf("\n");
+
+    // Emergency events
+    printf("Emergency vehicles (detection to clearance, ms):\n");
+    for (int type = 1; type < TRACE_EMERGENCY_TYPES; type++) {
+        printf("  %-10s detected=%lld cleared=%lld mean=%.0f max=%.0f\n", emergency_names[type],
+               emergency_detected[type], emergency_cleared[type],
+               emergency_cleared[type] ? emergency_clear_ms[type] / emergency_cleared[type] : 0.0,
+               emergency_clear_max_ms[type]);
+    }
+    printf("  Emergency greens: %lld (%lld pre-cleared)\n", emergency_greens, emergency_preclears);
+
+    for (int i = 0; i < MAX_LANES; i++) {
+        free(arrivals[i].items);
+    }
+    free(throughput);
+    free(phases);
+    free(waits);
+    free(order);
+    munmap(map, (size_t)st.st_size);
+    return 0;
+}